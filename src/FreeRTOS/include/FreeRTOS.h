@@ -282,6 +282,10 @@
     #define configUSE_DAEMON_TASK_STARTUP_HOOK    0
 #endif
 
+#ifndef configUSE_TASK_DELETE_HOOK
+    #define configUSE_TASK_DELETE_HOOK    0
+#endif
+
 #ifndef configUSE_APPLICATION_TASK_TAG
     #define configUSE_APPLICATION_TASK_TAG    0
 #endif
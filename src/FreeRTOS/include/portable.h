@@ -182,6 +182,18 @@ void vPortInitialiseBlocks( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 size_t xPortGetMinimumEverFreeHeapSize( void ) PRIVILEGED_FUNCTION;
 
+#if ( configUSE_CGROUPS == 1 )
+
+/*
+ * Get and move the cgroup charge of a block returned by pvPortMalloc(). The
+ * move fails when the block does not fit the memory limit of the new cgroup,
+ * a NULL cgroup handle leaves the block uncharged.
+ */
+    void * pvPortGetBlockCGroup( void * pv ) PRIVILEGED_FUNCTION;
+    BaseType_t xPortSetBlockCGroup( void * pv,
+                                    void * pvCGroupHandle ) PRIVILEGED_FUNCTION;
+#endif
+
 #if ( configSTACK_ALLOCATION_FROM_SEPARATE_HEAP == 1 )
     void * pvPortMallocStack( size_t xSize ) PRIVILEGED_FUNCTION;
     void vPortFreeStack( void * pv ) PRIVILEGED_FUNCTION;
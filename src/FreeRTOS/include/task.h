@@ -1496,6 +1496,23 @@ UBaseType_t uxTaskGetNumberOfTasks( void ) PRIVILEGED_FUNCTION;
  */
 char * pcTaskGetName( TaskHandle_t xTaskToQuery ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 
+/**
+ * task. h
+ * @code{c}
+ * void vTaskSetName( TaskHandle_t xTaskToName, const char * pcName );
+ * @endcode
+ *
+ * Replaces the text (human readable) name of the task referenced by the
+ * handle xTaskToName, truncated to configMAX_TASK_NAME_LEN - 1 characters as
+ * at creation.  Used to name a task that was created before it was known
+ * what it would run.
+ *
+ * \defgroup vTaskSetName vTaskSetName
+ * \ingroup TaskUtils
+ */
+void vTaskSetName( TaskHandle_t xTaskToName,
+                   const char * pcName ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+
 /**
  * task. h
  * @code{c}
@@ -1716,6 +1733,23 @@ configSTACK_DEPTH_TYPE uxTaskGetStackHighWaterMark2( TaskHandle_t xTask ) PRIVIL
 
 #endif
 
+#if ( configUSE_TASK_DELETE_HOOK != 0 )
+
+/**
+ *  task.h
+ * @code{c}
+ * void vApplicationTaskDeleteHook( TaskHandle_t xTask );
+ * @endcode
+ *
+ * This hook function is called by vTaskDelete() for every task that is deleted,
+ * including a task deleting itself, before the task is removed from the
+ * scheduler.  It is called from within a critical section, so it must not block
+ * and may only use FromISR API functions.
+ */
+    void vApplicationTaskDeleteHook( TaskHandle_t xTask ); /*lint !e526 Symbol not defined as it is an application callback. */
+
+#endif
+
 #if ( configSUPPORT_STATIC_ALLOCATION == 1 )
 
 /**
@@ -3206,6 +3240,88 @@ void vTaskInternalSetTimeOutState( TimeOut_t * const pxTimeOut ) PRIVILEGED_FUNC
 
 #endif /* portUSING_MPU_WRAPPERS */
 
+    /*-----------------------------------------------------------
+     * CGROUP SUPPORT
+     *----------------------------------------------------------*/
+#if (configUSE_CGROUPS == 1)
+
+    /**
+     * @brief Set the cgroup a task belongs to
+     * For use by cgroup.c only, which keeps the cgroup task counts in step.
+     *
+     * @param xTask Task handle (use NULL for current task)
+     * @param pxCGroupHandle Handle to the cgroup, or NULL to detach the task
+     * @return pdPASS on success, pdFAIL on failure
+     */
+    BaseType_t xTaskSetCGroup(TaskHandle_t xTask,
+                              void *pxCGroupHandle) PRIVILEGED_FUNCTION;
+
+    /**
+     * @brief Get the cgroup of a task in O(1) from its TCB
+     * Safe to call from the tick interrupt and the scheduler.
+     *
+     * @param xTask Task handle (use NULL for current task)
+     * @return CGroup handle, or NULL if not in any cgroup
+     */
+    void *pvTaskGetCGroup(TaskHandle_t xTask) PRIVILEGED_FUNCTION;
+
+    /**
+     * @brief Charge the calling task's heap allocations to another cgroup
+     * For use by cgroup.c only, see xCGroupSetMemoryChargeTarget().
+     *
+     * @param pvCGroupHandle Handle to the cgroup, or NULL to charge the
+     *                       task's own cgroup again
+     * @return The previous override, to restore when done
+     */
+    void *pvTaskSetCGroupMemoryCharge(void *pvCGroupHandle) PRIVILEGED_FUNCTION;
+
+    /**
+     * @brief Get the cgroup a task's heap allocations are charged to instead
+     * of its own cgroup
+     *
+     * @param xTask Task handle (use NULL for current task)
+     * @return CGroup handle, or NULL if the task charges its own cgroup
+     */
+    void *pvTaskGetCGroupMemoryCharge(TaskHandle_t xTask) PRIVILEGED_FUNCTION;
+
+    /**
+     * @brief Move the charge of a task's TCB and stack to another cgroup
+     * For a task created before it was known which cgroup it would run in.
+     * Statically allocated tasks have nothing on the heap to move.
+     *
+     * @param xTask Task handle (use NULL for current task)
+     * @param pvCGroupHandle Handle to the cgroup, or NULL to leave them uncharged
+     * @return pdPASS on success, pdFAIL if they do not fit the cgroup's memory
+     *         limit, the charge is then left where it was, or if xTask is NULL
+     *         and no task has been created yet
+     */
+    BaseType_t xTaskMoveCGroupMemoryCharge(TaskHandle_t xTask,
+                                           void *pvCGroupHandle) PRIVILEGED_FUNCTION;
+
+    /**
+     * @brief Get the CPU time a task has used, in configCGROUP_CYCLE_COUNTER()
+     * cycles measured when the task is switched in and out
+     *
+     * @param xTask Task handle (use NULL for current task)
+     * @return Counter cycles the task has run for since it was created, 0 if
+     *         xTask is NULL and no task has been created yet
+     */
+    uint64_t ullTaskGetCGroupRunCycles(TaskHandle_t xTask) PRIVILEGED_FUNCTION;
+
+    /**
+     * @brief Return the tasks parked on a cgroup's throttled list to the
+     * ready lists
+     * For use by cgroup.c at a period refresh or thaw. Must be called from the tick
+     * interrupt or from a critical section while the scheduler is running.
+     *
+     * @param pxThrottledList The cgroup's throttled list
+     * @return pdTRUE if a task of higher priority than the running task was
+     *         made ready, pdFALSE otherwise
+     */
+    BaseType_t xTaskCGroupUnthrottle(List_t *pxThrottledList) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_CGROUPS */
+
     /*-----------------------------------------------------------
      * PID NAMESPACE SUPPORT
      *----------------------------------------------------------*/
@@ -84,6 +84,14 @@
 #define heapALLOCATE_BLOCK( pxBlock )            ( ( pxBlock->xBlockSize ) |= heapBLOCK_ALLOCATED_BITMASK )
 #define heapFREE_BLOCK( pxBlock )                ( ( pxBlock->xBlockSize ) &= ~heapBLOCK_ALLOCATED_BITMASK )
 
+/* With cgroups enabled an allocated block records the handle of the cgroup it
+ * is charged to, so the free credits that cgroup whichever task frees the
+ * block. */
+#if ( configUSE_CGROUPS == 1 )
+    #define heapSET_BLOCK_OWNER( pxBlock, xOwner )    ( ( pxBlock )->pvOwner = ( void * ) ( xOwner ) )
+    #define heapGET_BLOCK_OWNER( pxBlock )            ( ( CGroupHandle_t ) ( ( pxBlock )->pvOwner ) )
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Allocate the memory for the heap. */
@@ -102,6 +110,9 @@ typedef struct A_BLOCK_LINK
 {
     struct A_BLOCK_LINK * pxNextFreeBlock; /**< The next free block in the list. */
     size_t xBlockSize;                     /**< The size of the free block. */
+    #if ( configUSE_CGROUPS == 1 )
+        void * pvOwner;                    /**< The cgroup an allocated block is charged to. */
+    #endif
 } BlockLink_t;
 
 /*-----------------------------------------------------------*/
@@ -147,6 +158,10 @@ void * pvPortMalloc( size_t xWantedSize )
     void * pvReturn = NULL;
     size_t xAdditionalRequiredSize;
 
+    #if ( configUSE_CGROUPS == 1 )
+        CGroupHandle_t xOwner = NULL;
+    #endif
+
     vTaskSuspendAll();
     {
         /* If this is the first call to malloc then the heap will require
@@ -162,10 +177,11 @@ void * pvPortMalloc( size_t xWantedSize )
 
 #if (configUSE_CGROUPS == 1)
         {
-          /* Check if the current task's cgroup allows this memory allocation */
-          TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
-          if (xCurrentTask != NULL) {
-            if (xCGroupCheckMemoryLimit(xCurrentTask, xWantedSize) == pdFALSE) {
+          /* Check if the cgroup charged for the current task's allocations
+           * allows this memory allocation */
+          xOwner = xCGroupGetMemoryOwner(xTaskGetCurrentTaskHandle());
+          if (xOwner != NULL) {
+            if (xCGroupCheckMemoryCharge(xOwner, xWantedSize) == pdFALSE) {
               /* Memory allocation would exceed cgroup limit */
               (void)xTaskResumeAll();
 
@@ -290,6 +306,9 @@ void * pvPortMalloc( size_t xWantedSize )
                      * by the application and has no "next" block. */
                     heapALLOCATE_BLOCK( pxBlock );
                     pxBlock->pxNextFreeBlock = NULL;
+                    #if ( configUSE_CGROUPS == 1 )
+                        heapSET_BLOCK_OWNER( pxBlock, xOwner );
+                    #endif
                     xNumberOfSuccessfulAllocations++;
                 }
                 else
@@ -312,16 +331,13 @@ void * pvPortMalloc( size_t xWantedSize )
 #if (configUSE_CGROUPS == 1)
         {
           /* Update cgroup memory usage statistics */
-          if (pvReturn != NULL) {
-            TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
-            if (xCurrentTask != NULL) {
-              /* Get the block link from the returned pointer */
-              BlockLink_t *pxAllocatedBlock =
-                  (BlockLink_t *)(((uint8_t *)pvReturn) - xHeapStructSize);
-              xCGroupUpdateMemoryUsage(
-                  xCurrentTask, (BaseType_t)(pxAllocatedBlock->xBlockSize &
-                                             ~heapBLOCK_ALLOCATED_BITMASK));
-            }
+          if ((pvReturn != NULL) && (xOwner != NULL)) {
+            /* Get the block link from the returned pointer */
+            BlockLink_t *pxAllocatedBlock =
+                (BlockLink_t *)(((uint8_t *)pvReturn) - xHeapStructSize);
+            (void)xCGroupChargeMemory(
+                xOwner, (UBaseType_t)(pxAllocatedBlock->xBlockSize &
+                                      ~heapBLOCK_ALLOCATED_BITMASK));
           }
         }
 #endif /* configUSE_CGROUPS */
@@ -367,6 +383,10 @@ void vPortFree( void * pv )
         {
             if( pxLink->pxNextFreeBlock == NULL )
             {
+                #if ( configUSE_CGROUPS == 1 )
+                    CGroupHandle_t xOwner = heapGET_BLOCK_OWNER( pxLink );
+                #endif
+
                 /* The block is being returned to the heap - it is no longer
                  * allocated. */
                 heapFREE_BLOCK( pxLink );
@@ -378,22 +398,20 @@ void vPortFree( void * pv )
 
                 vTaskSuspendAll();
                 {
-                    /* Add this block to the list of free blocks. */
-                    xFreeBytesRemaining += pxLink->xBlockSize;
-                    traceFREE( pv, pxLink->xBlockSize );
-                    prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
-                    xNumberOfSuccessfulFrees++;
-
 #if (configUSE_CGROUPS == 1)
                     {
-                      /* Update cgroup memory usage statistics (decrease) */
-                      TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
-                      if (xCurrentTask != NULL) {
-                        xCGroupUpdateMemoryUsage(
-                            xCurrentTask, -((BaseType_t)pxLink->xBlockSize));
+                      /* Credit the cgroup the block was charged to */
+                      if (xOwner != NULL) {
+                        (void)xCGroupUnchargeMemory(xOwner, (UBaseType_t)pxLink->xBlockSize);
                       }
                     }
 #endif /* configUSE_CGROUPS */
+
+                    /* Add this block to the list of free blocks. */
+                    xFreeBytesRemaining += pxLink->xBlockSize;
+                    traceFREE( pv, pxLink->xBlockSize );
+                    prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
+                    xNumberOfSuccessfulFrees++;
                 }
                 ( void ) xTaskResumeAll();
             }
@@ -410,6 +428,67 @@ void vPortFree( void * pv )
 }
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_CGROUPS == 1 )
+
+    void * pvPortGetBlockCGroup( void * pv )
+    {
+        BlockLink_t * pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+
+        return ( void * ) heapGET_BLOCK_OWNER( pxLink );
+    }
+/*-----------------------------------------------------------*/
+
+    BaseType_t xPortSetBlockCGroup( void * pv,
+                                    void * pvCGroupHandle )
+    {
+        BlockLink_t * pxLink = ( BlockLink_t * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+        CGroupHandle_t xOwner = ( CGroupHandle_t ) pvCGroupHandle;
+        CGroupHandle_t xPrevious;
+        UBaseType_t uxBlockSize;
+        BaseType_t xReturn = pdPASS;
+
+        configASSERT( heapBLOCK_IS_ALLOCATED( pxLink ) != 0 );
+        configASSERT( pxLink->pxNextFreeBlock == NULL );
+
+        uxBlockSize = ( UBaseType_t ) ( pxLink->xBlockSize & ~heapBLOCK_ALLOCATED_BITMASK );
+
+        /* Charged the same way as pvPortMalloc() and vPortFree() charge it */
+        vTaskSuspendAll();
+        {
+            xPrevious = heapGET_BLOCK_OWNER( pxLink );
+
+            if( xPrevious != xOwner )
+            {
+                if( ( xOwner != NULL ) && ( xCGroupCheckMemoryCharge( xOwner, uxBlockSize ) == pdFALSE ) )
+                {
+                    xReturn = pdFAIL;
+                }
+                else
+                {
+                    if( xPrevious != NULL )
+                    {
+                        ( void ) xCGroupUnchargeMemory( xPrevious, uxBlockSize );
+                    }
+
+                    if( xOwner != NULL )
+                    {
+                        ( void ) xCGroupChargeMemory( xOwner, uxBlockSize );
+                    }
+
+                    heapSET_BLOCK_OWNER( pxLink, xOwner );
+                }
+            }
+        }
+        ( void ) xTaskResumeAll();
+
+        return xReturn;
+    }
+
+#endif /* configUSE_CGROUPS */
+/*-----------------------------------------------------------*/
+
 size_t xPortGetFreeHeapSize( void )
 {
     return xFreeBytesRemaining;
@@ -235,8 +235,26 @@
         traceMOVED_TASK_TO_READY_STATE( pxTCB );                                                           \
         taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );                                                \
         listINSERT_END( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xStateListItem ) ); \
+        taskCGROUP_TASK_READY( pxTCB );                                                                    \
         tracePOST_MOVED_TASK_TO_READY_STATE( pxTCB );                                                      \
     } while( 0 )
+
+/*
+ * Tasks of a cgroup are also queued on the cgroup's ready list of their
+ * priority, so the weighted pick does not have to walk the ready list.
+ */
+#if ( configUSE_CGROUPS == 1 )
+    #define taskCGROUP_TASK_READY( pxTCB )                                                                 \
+    do {                                                                                                   \
+        if( ( pxTCB )->pxCGroupHandle != NULL )                                                            \
+        {                                                                                                  \
+            prvCGroupTaskReady( ( pxTCB )->pxCGroupHandle, &( ( pxTCB )->xCGroupReadyListItem ),           \
+                                ( pxTCB )->uxPriority );                                                   \
+        }                                                                                                  \
+    } while( 0 )
+#else
+    #define taskCGROUP_TASK_READY( pxTCB )
+#endif
 /*-----------------------------------------------------------*/
 
 /*
@@ -337,8 +355,14 @@ typedef struct tskTaskControlBlock       /* The old naming convention is used to
 
 #if (configUSE_CGROUPS == 1)
         void *pxCGroupHandle; /**< Handle to the cgroup this task belongs to. */
+        ListItem_t xCGroupReadyListItem; /**< Link in the cgroup's ready list of
+                                            the task's priority. */
+        void *pvCGroupMemoryCharge; /**< CGroup handle the task's heap allocations
+                                       are charged to instead, NULL for its own. */
         UBaseType_t ulCGroupTickCount; /**< Time slices used by this task in
                                           current window. */
+        uint64_t ullCGroupRunCycles; /**< configCGROUP_CYCLE_COUNTER() cycles this
+                                        task has run for. */
 #endif
 
 #if (configUSE_PID_NAMESPACE == 1)
@@ -434,6 +458,14 @@ PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended = ( UBaseType_t
 
 #endif
 
+#if ( configUSE_CGROUPS == 1 )
+
+/* configCGROUP_CYCLE_COUNTER() value when the running task was last charged
+ * for its CPU time, i.e. when it was switched in or at the last tick. */
+    PRIVILEGED_DATA static uint64_t ullCGroupChargedTime = 0U;
+
+#endif
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -586,6 +618,38 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
  */
 static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB ) PRIVILEGED_FUNCTION;
 
+/*
+ * Returns the task to run at the priority of pxSelected, the round robin pick:
+ * the next ready task of the cgroup with the lowest virtual runtime when
+ * pxSelected is in a cgroup, pxSelected itself otherwise.
+ */
+#if ( configUSE_CGROUPS == 1 )
+
+    static TCB_t * prvCGroupSelectTask( TCB_t * pxSelected ) PRIVILEGED_FUNCTION;
+
+#endif
+
+/*
+ * Moves a ready task of a throttled or frozen cgroup off the ready lists and
+ * onto the cgroup's throttled list, where it stays until xTaskCGroupUnthrottle()
+ * is called at the cgroup's next period refresh or thaw.
+ */
+#if ( configUSE_CGROUPS == 1 )
+
+    static void prvCGroupParkTask( TCB_t * pxTCB ) PRIVILEGED_FUNCTION;
+
+#endif
+
+/*
+ * Charges the cycles the running task ran for since it was last charged to
+ * the task and to its cgroup.
+ */
+#if ( configUSE_CGROUPS == 1 )
+
+    static void prvCGroupChargeCurrentTask( void ) PRIVILEGED_FUNCTION;
+
+#endif
+
 /*
  * freertos_tasks_c_additions_init() should only be called if the user definable
  * macro FREERTOS_TASKS_C_ADDITIONS_INIT() is defined, as that is the only macro
@@ -1002,7 +1066,11 @@ static void prvInitialiseNewTask( TaskFunction_t pxTaskCode,
     {
       /* Initialize cgroup fields */
       pxNewTCB->pxCGroupHandle = NULL;
+      vListInitialiseItem(&(pxNewTCB->xCGroupReadyListItem));
+      listSET_LIST_ITEM_OWNER(&(pxNewTCB->xCGroupReadyListItem), pxNewTCB);
+      pxNewTCB->pvCGroupMemoryCharge = NULL;
       pxNewTCB->ulCGroupTickCount = 0U;
+      pxNewTCB->ullCGroupRunCycles = 0U;
     }
 #endif
 
@@ -1202,6 +1270,12 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
              * being deleted. */
             pxTCB = prvGetTCBFromHandle( xTaskToDelete );
 
+            #if ( configUSE_TASK_DELETE_HOOK == 1 )
+            {
+                vApplicationTaskDeleteHook( ( TaskHandle_t ) pxTCB );
+            }
+            #endif
+
             /* Remove task from the ready/delayed list. */
             if( uxListRemove( &( pxTCB->xStateListItem ) ) == ( UBaseType_t ) 0 )
             {
@@ -1222,6 +1296,16 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
                 mtCOVERAGE_TEST_MARKER();
             }
 
+#if (configUSE_CGROUPS == 1)
+            {
+              /* Leave the cgroup so its task count stays correct and the
+               * group can be deleted once its tasks are gone. */
+              if (pxTCB->pxCGroupHandle != NULL) {
+                (void)xCGroupRemoveTask(xCGroupGetTaskGroup(pxTCB), pxTCB);
+              }
+            }
+#endif /* configUSE_CGROUPS */
+
             /* Increment the uxTaskNumber also so kernel aware debuggers can
              * detect that the task lists need re-generating.  This is done before
              * portPRE_TASK_DELETE_HOOK() as in the Windows port that macro will
@@ -1616,6 +1700,14 @@ static void prvAddNewTaskToReadyList( TCB_t * pxNewTCB )
             mtCOVERAGE_TEST_MARKER();
         }
 
+        #if ( configUSE_CGROUPS == 1 )
+        {
+            /* The cgroup queues ready tasks per priority, make sure it has a
+             * queue for the new one while memory can still be allocated. */
+            prvCGroupReserveRunQueue( prvGetTCBFromHandle( xTask )->pxCGroupHandle, uxNewPriority );
+        }
+        #endif
+
         taskENTER_CRITICAL();
         {
             /* If null is passed in here then it is the priority of the calling
@@ -2130,6 +2222,13 @@ void vTaskStartScheduler( void )
         xSchedulerRunning = pdTRUE;
         xTickCount = ( TickType_t ) configINITIAL_TICK_COUNT;
 
+        #if ( configUSE_CGROUPS == 1 )
+        {
+            /* The first task is started without a call to vTaskSwitchContext() */
+            ullCGroupChargedTime = configCGROUP_CYCLE_COUNTER();
+        }
+        #endif
+
         /* If configGENERATE_RUN_TIME_STATS is defined then the following
          * macro must be defined to configure the timer/counter used to generate
          * the run time counter time base.   NOTE:  If configGENERATE_RUN_TIME_STATS
@@ -2442,6 +2541,36 @@ char * pcTaskGetName( TaskHandle_t xTaskToQuery ) /*lint !e971 Unqualified char
 }
 /*-----------------------------------------------------------*/
 
+void vTaskSetName( TaskHandle_t xTaskToName,
+                   const char * pcName ) /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+{
+    TCB_t * pxTCB;
+    UBaseType_t x;
+
+    pxTCB = prvGetTCBFromHandle( xTaskToName );
+    configASSERT( pxTCB );
+    configASSERT( pcName );
+
+    /* xTaskGetHandle() and the trace functions read the name from other
+     * tasks, they must not see it half written. */
+    taskENTER_CRITICAL();
+    {
+        for( x = ( UBaseType_t ) 0; x < ( UBaseType_t ) configMAX_TASK_NAME_LEN - 1U; x++ )
+        {
+            pxTCB->pcTaskName[ x ] = pcName[ x ];
+
+            if( pcName[ x ] == ( char ) 0x00 )
+            {
+                break;
+            }
+        }
+
+        pxTCB->pcTaskName[ configMAX_TASK_NAME_LEN - 1 ] = '\0';
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
 #if ( INCLUDE_xTaskGetHandle == 1 )
 
     static TCB_t * prvSearchForNameWithinSingleList( List_t * pxList,
@@ -3017,10 +3146,15 @@ BaseType_t xTaskIncrementTick( void )
         }
         #endif /* configUSE_PREEMPTION */
 
-/* Update cgroup tick and check if current task needs to be throttled */
+/* Charge the tick to the running cgroup, a switch is needed when it just ran
+ * out of quota or a period refresh made higher priority tasks ready again */
 #if (configUSE_CGROUPS == 1)
     {
-      prvCGroupUpdateTick();
+      prvCGroupChargeCurrentTask();
+
+      if (prvCGroupUpdateTick() != pdFALSE) {
+        xSwitchRequired = pdTRUE;
+      }
     }
 #endif /* configUSE_CGROUPS */
   } else {
@@ -3195,10 +3329,10 @@ void vTaskSwitchContext( void )
         /* Check for stack overflow, if configured. */
         taskCHECK_FOR_STACK_OVERFLOW();
 
-/* Update cgroup usage when task switches out */
+/* Charge the CPU time of the task being switched out to its cgroup */
 #if (configUSE_CGROUPS == 1)
     {
-      prvCGroupTaskSwitchOut(pxCurrentTCB);
+      prvCGroupChargeCurrentTask();
 
       /* Update task's individual cgroup tick count */
       pxCurrentTCB->ulCGroupTickCount++;
@@ -3218,9 +3352,20 @@ void vTaskSwitchContext( void )
 
 #if (configUSE_CGROUPS == 1)
         {
-          /* Check if the selected task can run based on cgroup limits */
-          while (prvCGroupCanTaskRun(pxCurrentTCB) == pdFALSE) {
-            /* Current task cannot run due to cgroup limits, try next task */
+          /* The weighted pick takes the cgroup furthest behind from the run
+           * heap of the selected priority. A task whose cgroup is throttled or
+           * frozen leaves the ready lists until the cgroup's period refreshes
+           * or it is thawed, so each task is skipped at most once per period.
+           * The idle task is never in a cgroup, so the loop always ends. */
+          for (;;) {
+            /* Share the priority level between cgroups by CPU weight */
+            pxCurrentTCB = prvCGroupSelectTask(pxCurrentTCB);
+
+            if (prvCGroupCanTaskRun(pxCurrentTCB) != pdFALSE) {
+              break;
+            }
+
+            prvCGroupParkTask(pxCurrentTCB);
             taskSELECT_HIGHEST_PRIORITY_TASK();
           }
         }
@@ -5616,6 +5761,209 @@ static void prvAddCurrentTaskToDelayedList( TickType_t xTicksToWait,
 #endif /* portUSING_MPU_WRAPPERS */
 /*-----------------------------------------------------------*/
 
+    /*-----------------------------------------------------------
+     * CGROUP SUPPORT
+     *----------------------------------------------------------*/
+#if (configUSE_CGROUPS == 1)
+
+    BaseType_t xTaskSetCGroup(TaskHandle_t xTask, void *pxCGroupHandle) {
+      TCB_t *pxTCB;
+      BaseType_t xReturn = pdPASS;
+
+      pxTCB = prvGetTCBFromHandle(xTask);
+
+      taskENTER_CRITICAL();
+      {
+        if (pxTCB != NULL) {
+          if (pxTCB->pxCGroupHandle != NULL) {
+            /* A task leaving a throttled cgroup must not stay parked on it */
+            if (prvCGroupIsThrottledList(pxTCB->pxCGroupHandle,
+                                         listLIST_ITEM_CONTAINER(&(pxTCB->xStateListItem))) !=
+                pdFALSE) {
+              listREMOVE_ITEM(&(pxTCB->xStateListItem));
+              prvAddTaskToReadyList(pxTCB);
+            }
+
+            prvCGroupTaskUnready(pxTCB->pxCGroupHandle, &(pxTCB->xCGroupReadyListItem));
+          }
+
+          pxTCB->pxCGroupHandle = pxCGroupHandle;
+
+          /* A ready task joins the run heap of its new cgroup */
+          if ((pxCGroupHandle != NULL) &&
+              (listIS_CONTAINED_WITHIN(&(pxReadyTasksLists[pxTCB->uxPriority]),
+                                       &(pxTCB->xStateListItem)) != pdFALSE)) {
+            prvCGroupTaskReady(pxCGroupHandle, &(pxTCB->xCGroupReadyListItem),
+                               pxTCB->uxPriority);
+          }
+        } else {
+          xReturn = pdFAIL;
+        }
+      }
+      taskEXIT_CRITICAL();
+
+      return xReturn;
+    }
+
+    void *pvTaskGetCGroup(TaskHandle_t xTask) {
+      TCB_t *pxTCB;
+
+      /* Called from the tick interrupt, the context switch and the heap, so
+       * no critical section here - the handle is a single aligned pointer
+       * and is only written through xTaskSetCGroup(). */
+      pxTCB = prvGetTCBFromHandle(xTask);
+      if (pxTCB == NULL) {
+        return NULL;
+      }
+
+      return pxTCB->pxCGroupHandle;
+    }
+
+    void *pvTaskSetCGroupMemoryCharge(void *pvCGroupHandle) {
+      void *pvPrevious;
+
+      /* Before the first task is created there is nothing to charge */
+      if (pxCurrentTCB == NULL) {
+        return NULL;
+      }
+
+      /* Only the running task reads its own override, from pvPortMalloc() */
+      pvPrevious = pxCurrentTCB->pvCGroupMemoryCharge;
+      pxCurrentTCB->pvCGroupMemoryCharge = pvCGroupHandle;
+
+      return pvPrevious;
+    }
+
+    void *pvTaskGetCGroupMemoryCharge(TaskHandle_t xTask) {
+      TCB_t *pxTCB;
+
+      pxTCB = prvGetTCBFromHandle(xTask);
+      if (pxTCB == NULL) {
+        return NULL;
+      }
+
+      return pxTCB->pvCGroupMemoryCharge;
+    }
+
+    BaseType_t xTaskMoveCGroupMemoryCharge(TaskHandle_t xTask, void *pvCGroupHandle) {
+      TCB_t *pxTCB;
+      void *pvPrevious;
+
+      pxTCB = prvGetTCBFromHandle(xTask);
+      if (pxTCB == NULL) {
+        return pdFAIL;
+      }
+
+#if (tskSTATIC_AND_DYNAMIC_ALLOCATION_POSSIBLE != 0)
+      if (pxTCB->ucStaticallyAllocated != tskDYNAMICALLY_ALLOCATED_STACK_AND_TCB) {
+        return pdPASS;
+      }
+#endif
+
+      pvPrevious = pvPortGetBlockCGroup(pxTCB);
+      if (xPortSetBlockCGroup(pxTCB, pvCGroupHandle) != pdPASS) {
+        return pdFAIL;
+      }
+
+#if (configSTACK_ALLOCATION_FROM_SEPARATE_HEAP == 0)
+      /* The stack comes from the same heap, move it back with the TCB if it
+       * does not fit */
+      if (xPortSetBlockCGroup(pxTCB->pxStack, pvCGroupHandle) != pdPASS) {
+        (void)xPortSetBlockCGroup(pxTCB, pvPrevious);
+        return pdFAIL;
+      }
+#endif
+
+      return pdPASS;
+    }
+
+    uint64_t ullTaskGetCGroupRunCycles(TaskHandle_t xTask) {
+      TCB_t *pxTCB;
+      uint64_t ullReturn;
+
+      pxTCB = prvGetTCBFromHandle(xTask);
+      if (pxTCB == NULL) {
+        return 0;
+      }
+
+      taskENTER_CRITICAL();
+      {
+        ullReturn = pxTCB->ullCGroupRunCycles;
+      }
+      taskEXIT_CRITICAL();
+
+      return ullReturn;
+    }
+
+    static void prvCGroupChargeCurrentTask(void) {
+      uint64_t ullNow;
+      uint64_t ullCycles;
+
+      ullNow = configCGROUP_CYCLE_COUNTER();
+      ullCycles = ullNow - ullCGroupChargedTime;
+      ullCGroupChargedTime = ullNow;
+
+      pxCurrentTCB->ullCGroupRunCycles += ullCycles;
+      prvCGroupChargeTask(pxCurrentTCB, ullCycles);
+    }
+
+    static TCB_t *prvCGroupSelectTask(TCB_t *pxSelected) {
+      List_t *pxReadyList = &(pxReadyTasksLists[pxSelected->uxPriority]);
+      List_t *pxRunList;
+      TCB_t *pxTCB;
+
+      /* Tasks outside cgroups, or at a priority their cgroup has no run
+       * queue for, keep their round robin turn */
+      if ((pxSelected->pxCGroupHandle == NULL) ||
+          (listLIST_ITEM_CONTAINER(&(pxSelected->xCGroupReadyListItem)) == NULL)) {
+        return pxSelected;
+      }
+
+      /* Round robin within the cgroup furthest behind. Tasks that blocked
+       * since they were queued stay on the cgroup's list until they are met
+       * here, so blocking does not have to touch the heap. */
+      while ((pxRunList = prvCGroupGetRunList(pxSelected->uxPriority)) != NULL) {
+        listGET_OWNER_OF_NEXT_ENTRY(pxTCB, pxRunList);
+        if (listIS_CONTAINED_WITHIN(pxReadyList, &(pxTCB->xStateListItem)) != pdFALSE) {
+          return pxTCB;
+        }
+
+        prvCGroupTaskUnready(pxTCB->pxCGroupHandle, &(pxTCB->xCGroupReadyListItem));
+      }
+
+      return pxSelected;
+    }
+
+    static void prvCGroupParkTask(TCB_t *pxTCB) {
+      if (uxListRemove(&(pxTCB->xStateListItem)) == (UBaseType_t)0) {
+        taskRESET_READY_PRIORITY(pxTCB->uxPriority);
+      }
+      prvCGroupTaskUnready(pxTCB->pxCGroupHandle, &(pxTCB->xCGroupReadyListItem));
+
+      listINSERT_END(prvCGroupGetThrottledList(pxTCB->pxCGroupHandle),
+                     &(pxTCB->xStateListItem));
+    }
+
+    BaseType_t xTaskCGroupUnthrottle(List_t *pxThrottledList) {
+      TCB_t *pxTCB;
+      BaseType_t xSwitchRequired = pdFALSE;
+
+      while (listLIST_IS_EMPTY(pxThrottledList) == pdFALSE) {
+        pxTCB = listGET_OWNER_OF_HEAD_ENTRY(pxThrottledList);
+        listREMOVE_ITEM(&(pxTCB->xStateListItem));
+        prvAddTaskToReadyList(pxTCB);
+
+        if (pxTCB->uxPriority > pxCurrentTCB->uxPriority) {
+          xSwitchRequired = pdTRUE;
+        }
+      }
+
+      return xSwitchRequired;
+    }
+
+#endif /* configUSE_CGROUPS */
+    /*-----------------------------------------------------------*/
+
     /*-----------------------------------------------------------
      * PID NAMESPACE SUPPORT
      *----------------------------------------------------------*/
@@ -22,11 +22,13 @@
 #define	configUSE_NEWLIB_REENTRANT		 0
 #define	configUSE_QUEUE_SETS			  1
 #define	configUSE_TASK_NOTIFICATIONS		  1
+#define	configTASK_NOTIFICATION_ARRAY_ENTRIES	  3 /* 1: xContainerWait(), 2: syscalls */
 #define	configUSE_STATS_FORMATTING_FUNCTIONS	  1
 #define	configUSE_IDLE_HOOK			 0
 #define	configUSE_TICK_HOOK			 0
 #define	configUSE_MALLOC_FAILED_HOOK		  1
 #define	configUSE_DAEMON_TASK_STARTUP_HOOK	 0
+#define	configUSE_TASK_DELETE_HOOK		  1 /* Reports container exits */
 #define	configUSE_TIMERS			  1
 #define	FREERTOS_TIMER_TICK_TRACE		 0
 
@@ -38,7 +40,7 @@
 #define	configMAX_TASK_NAME_LEN			10
 #define	configQUEUE_REGISTRY_SIZE		10
 #define	configCHECK_FOR_STACK_OVERFLOW		2
-#define	configNUM_THREAD_LOCAL_STORAGE_POINTERS	0x0
+#define	configNUM_THREAD_LOCAL_STORAGE_POINTERS	0x1
 #define	configUSE_TASK_FPU_SUPPORT		0x1
 #define	configTIMER_TASK_PRIORITY		(configMAX_PRIORITIES-1)
 #define	configTIMER_QUEUE_LENGTH		10
@@ -90,7 +92,7 @@ void FreeRTOS_SetupTickInterrupt(void);
 
 /* CGroup configuration */
 #define configUSE_CGROUPS 1
-#define configMAX_CGROUPS 8
+#define configCGROUP_POOL_CHUNK_SIZE 8
 #define configMAX_CGROUP_NAME_LEN 16
 
 /* PID Namespace configuration */
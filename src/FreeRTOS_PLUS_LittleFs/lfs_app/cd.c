@@ -1,14 +1,10 @@
+#include "crt.h"
 #include "lfs.h"
 #include "projdefs.h"
 #include "syscall.h"
 
 FreeRTOS_GOT_t *got = get_got();
 
-// Simple string copy implementation for standalone executable
-static void string_copy(char *dest, const char *src) {
-    while ((*dest++ = *src++) != '\0');
-}
-
 int main(char* path) {
     lfs_dir_t dir;
     char dest_dir[configMAX_PATH_LEN];
@@ -17,7 +13,7 @@ int main(char* path) {
     if (path[0] == '\0') {
         return pdFAIL;
     } else {
-        string_copy(dest_dir, path);
+        crt_strlcpy(dest_dir, path, sizeof(dest_dir));
     }
     got->freertos_syscalls->pwd(dest_dir);
     ret = lfs_ops.dir_open(&dir, dest_dir);
@@ -0,0 +1,47 @@
+#ifndef LFS_APP_CRT_H
+#define LFS_APP_CRT_H
+
+#include <stddef.h>
+
+/*
+ * Helpers shared by the container programs. They are built once as /lib/libcrt.so, which the
+ * kernel loads a single time (see elf_library_load()); every program then links against that
+ * copy instead of carrying its own.
+ *
+ * Programs calling these must be relocatable: build them as ET_REL objects, or link them -pie
+ * against libcrt.so. The loader resolves the names at load time like any kernel export.
+ *
+ * Build the library with
+ *   aarch64-none-elf-gcc -O2 -shared -fPIC -nostdlib -Wl,-z,now -Wl,-z,relro \
+ *       -Wl,-z,max-page-size=4096 -o libcrt.so libcrt.c
+ * and copy it to /lib/libcrt.so. The page size keeps the linker from padding the image to
+ * 64 KB segment boundaries, which the loader would allocate as memory.
+ *
+ * There is no MMU to give each program its own copy of library data, so the library keeps
+ * none: the loader rejects a library with writable data outside RELRO. All state lives in
+ * buffers the caller passes in.
+ */
+
+/* Write a string to the console */
+void crt_puts(const char *str);
+
+/* Write value as 0x followed by 16 upper case hex digits */
+void crt_print_hex(unsigned long value);
+
+/* Write value in decimal */
+void crt_print_int(int value);
+
+/* Parse an optionally negative decimal number, stopping at the first non digit */
+int crt_atoi(const char *str);
+
+/* Write value in decimal to str, which must hold 12 bytes; returns str */
+char *crt_itoa(int value, char *str);
+
+/* Copy src to dest of size bytes, truncating if needed; returns the length of src */
+size_t crt_strlcpy(char *dest, const char *src, size_t size);
+
+/* Join dir and name with a single '/' into dest of size bytes; returns 0, or -1 if it does
+ * not fit */
+int crt_path_join(char *dest, size_t size, const char *dir, const char *name);
+
+#endif /* LFS_APP_CRT_H */
@@ -0,0 +1,113 @@
+#include "crt.h"
+
+/* Console output exported by the kernel */
+extern void uart_puts(const char *str);
+
+void crt_puts(const char *str) {
+    uart_puts(str);
+}
+
+void crt_print_hex(unsigned long value) {
+    char hex_str[19];
+    char *ptr = hex_str;
+    int i;
+
+    *ptr++ = '0';
+    *ptr++ = 'x';
+
+    for (i = 15; i >= 0; i--) {
+        unsigned char nibble = (value >> (i * 4)) & 0xF;
+        if (nibble < 10)
+            *ptr++ = '0' + nibble;
+        else
+            *ptr++ = 'A' + (nibble - 10);
+    }
+    *ptr = '\0';
+
+    uart_puts(hex_str);
+}
+
+void crt_print_int(int value) {
+    char num_str[12];
+
+    uart_puts(crt_itoa(value, num_str));
+}
+
+int crt_atoi(const char *str) {
+    int result = 0;
+    int sign = 1;
+
+    if (*str == '-') {
+        sign = -1;
+        str++;
+    }
+
+    while (*str >= '0' && *str <= '9') {
+        result = result * 10 + (*str - '0');
+        str++;
+    }
+
+    return result * sign;
+}
+
+char *crt_itoa(int value, char *str) {
+    char temp[11];
+    unsigned int num = (unsigned int)value;
+    int i = 0;
+    int pos = 0;
+
+    /* Negate as unsigned so INT_MIN does not overflow */
+    if (value < 0) {
+        str[pos++] = '-';
+        num = 0U - num;
+    }
+
+    do {
+        temp[i++] = '0' + (num % 10);
+        num /= 10;
+    } while (num > 0);
+
+    /* Reverse */
+    while (i > 0) {
+        str[pos++] = temp[--i];
+    }
+    str[pos] = '\0';
+
+    return str;
+}
+
+size_t crt_strlcpy(char *dest, const char *src, size_t size) {
+    size_t len = 0;
+
+    while (src[len] != '\0') {
+        if (len + 1 < size) {
+            dest[len] = src[len];
+        }
+        len++;
+    }
+    if (size > 0) {
+        dest[(len < size) ? len : size - 1] = '\0';
+    }
+
+    return len;
+}
+
+int crt_path_join(char *dest, size_t size, const char *dir, const char *name) {
+    size_t len = crt_strlcpy(dest, dir, size);
+
+    if (len >= size) {
+        return -1;
+    }
+    /* Add / if needed */
+    if (len == 0 || dest[len - 1] != '/') {
+        if (len + 1 >= size) {
+            return -1;
+        }
+        dest[len++] = '/';
+    }
+    if (crt_strlcpy(dest + len, name, size - len) >= size - len) {
+        return -1;
+    }
+
+    return 0;
+}
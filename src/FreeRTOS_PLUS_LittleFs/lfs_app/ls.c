@@ -1,29 +1,9 @@
+#include "crt.h"
 #include "lfs.h"
 #include "syscall.h"
 
 FreeRTOS_GOT_t* got = get_got();
 
-// Simple hex to string conversion for debugging
-static void print_hex(unsigned long value) {
-    char hex_str[20];
-    char* ptr = hex_str;
-    int i;
-    
-    *ptr++ = '0';
-    *ptr++ = 'x';
-    
-    for (i = 15; i >= 0; i--) {
-        unsigned char nibble = (value >> (i * 4)) & 0xF;
-        if (nibble < 10)
-            *ptr++ = '0' + nibble;
-        else
-            *ptr++ = 'A' + (nibble - 10);
-    }
-    *ptr = '\0';
-    
-    got->freertos_syscalls->uart_puts(hex_str);
-}
-
 int main(char* path) {
     (void) path;
     lfs_dir_t dir;
@@ -34,36 +14,36 @@ int main(char* path) {
     /* Debug output */
     got->freertos_syscalls->uart_puts("=== LS Debug Start ===\r\n");
     got->freertos_syscalls->uart_puts("got address: ");
-    print_hex((unsigned long)got);
+    crt_print_hex((unsigned long)got);
     got->freertos_syscalls->uart_puts("\r\n");
     
     got->freertos_syscalls->uart_puts("got->freertos_syscalls: ");
-    print_hex((unsigned long)got->freertos_syscalls);
+    crt_print_hex((unsigned long)got->freertos_syscalls);
     got->freertos_syscalls->uart_puts("\r\n");
     
     if (got->freertos_syscalls != NULL) {
         got->freertos_syscalls->uart_puts("syscalls->uart_puts: ");
-        print_hex((unsigned long)got->freertos_syscalls->uart_puts);
+        crt_print_hex((unsigned long)got->freertos_syscalls->uart_puts);
         got->freertos_syscalls->uart_puts("\r\n");
         
         got->freertos_syscalls->uart_puts("syscalls->pwd: ");
-        print_hex((unsigned long)got->freertos_syscalls->pwd);
+        crt_print_hex((unsigned long)got->freertos_syscalls->pwd);
         got->freertos_syscalls->uart_puts("\r\n");
         
         got->freertos_syscalls->uart_puts("syscalls->set_pwd: ");
-        print_hex((unsigned long)got->freertos_syscalls->set_pwd);
+        crt_print_hex((unsigned long)got->freertos_syscalls->set_pwd);
         got->freertos_syscalls->uart_puts("\r\n");
     }
     
     got->freertos_syscalls->uart_puts("got->get_lfs_ops: ");
-    print_hex((unsigned long)got->get_lfs_ops);
+    crt_print_hex((unsigned long)got->get_lfs_ops);
     got->freertos_syscalls->uart_puts("\r\n");
     
     got->freertos_syscalls->uart_puts("Calling get_lfs_ops()...\r\n");
     lfs_ops_ptr = got->get_lfs_ops();
     
     got->freertos_syscalls->uart_puts("get_lfs_ops() returned: ");
-    print_hex((unsigned long)lfs_ops_ptr);
+    crt_print_hex((unsigned long)lfs_ops_ptr);
     got->freertos_syscalls->uart_puts("\r\n");
     
     if (lfs_ops_ptr == NULL) {
@@ -132,26 +112,7 @@ int main(char* path) {
     
     got->freertos_syscalls->uart_puts("=== LS Debug End ===\r\n");
     got->freertos_syscalls->uart_puts("Total entries: ");
-    // Simple number to string
-    if (entry_count == 0) {
-        got->freertos_syscalls->uart_puts("0");
-    } else {
-        char num_str[12];
-        int i = 0;
-        int temp = entry_count;
-        while (temp > 0) {
-            num_str[i++] = '0' + (temp % 10);
-            temp /= 10;
-        }
-        // Reverse
-        for (int j = 0; j < i / 2; j++) {
-            char t = num_str[j];
-            num_str[j] = num_str[i - 1 - j];
-            num_str[i - 1 - j] = t;
-        }
-        num_str[i] = '\0';
-        got->freertos_syscalls->uart_puts(num_str);
-    }
+    crt_print_int(entry_count);
     got->freertos_syscalls->uart_puts("\r\n");
     
     lfs_ops.dir_close(&dir);
@@ -0,0 +1,21 @@
+#include "crt.h"
+#include "projdefs.h"
+#include "syscall.h"
+
+// Uses the delay entry added in syscall ABI 1.1, older kernels refuse to load the program
+FREERTOS_SYSCALL_ABI_NOTE();
+
+FreeRTOS_GOT_t* got = get_got();
+
+int main(char* arg) {
+    int ms = crt_atoi(arg);
+
+    if (arg[0] == '\0' || ms < 0) {
+        crt_puts("usage: sleep <milliseconds>\r\n");
+        return pdFAIL;
+    }
+
+    // The task blocks until the delay ends, other containers get the CPU meanwhile
+    got->freertos_syscalls->delay(pdMS_TO_TICKS((TickType_t)ms));
+    return pdPASS;
+}
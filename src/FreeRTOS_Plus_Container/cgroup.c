@@ -34,196 +34,660 @@
  * PRIVATE DATA
  *----------------------------------------------------------*/
 
-/* Simple task-to-cgroup mapping table */
-typedef struct {
-    TaskHandle_t   xTask;
-    CGroupHandle_t xCGroup;
-} TaskCGroupMap_t;
-
-/* Array to store all cgroups */
-static CGroup_t xCGroups[configMAX_CGROUPS];
-
-/* Bitmap to track which cgroup slots are in use */
-static UBaseType_t uxCGroupBitmap = 0U;
-
-/* Task to CGroup mapping */
-static TaskCGroupMap_t xTaskCGroupMap[configMAX_CGROUPS * 8];
-static UBaseType_t     uxMapCount = 0U;
+/* Number of pool chunks. Chunk n holds configCGROUP_POOL_CHUNK_SIZE << n
+ * cgroups, so the directory never has to be reallocated and cgroups never
+ * move once allocated. */
+#define cgroupPOOL_MAX_CHUNKS (32U)
+
+/* Handles are the pool index + 1 in the low bits and the generation of the
+ * cgroup in the high bits, so looking a handle up is O(1) and a handle to a
+ * deleted cgroup does not match the generation of the reused cgroup */
+#define cgroupHANDLE_INDEX_BITS (32U)
+#define cgroupHANDLE_INDEX_MASK ((((uintptr_t)1U) << cgroupHANDLE_INDEX_BITS) - 1U)
+
+/* Slots of the period timer wheel, a power of two. Only throttled cgroups are
+ * on the wheel, in the slot of the tick their period ends, so the tick only
+ * looks at the cgroups whose period ends now. Periods of cgroups that are not
+ * throttled roll over when their runtime is next charged. */
+#define cgroupPERIOD_WHEEL_SLOTS (64U)
+#define cgroupPERIOD_WHEEL_MASK ((TickType_t)(cgroupPERIOD_WHEEL_SLOTS - 1U))
+
+/* Pool chunks allocated so far */
+static CGroup_t *pxCGroupChunks[cgroupPOOL_MAX_CHUNKS];
+static UBaseType_t uxCGroupChunkCount = 0U;
+
+/* Number of cgroups in the allocated chunks */
+static UBaseType_t uxCGroupPoolSize = 0U;
+
+/* Deleted and never used cgroups, linked through pxNextFree */
+static CGroup_t *pxFreeCGroups = NULL;
+
+/* Active cgroups */
+static List_t xActiveCGroups;
+
+/* Throttled cgroups by the tick their period ends, see cgroupPERIOD_WHEEL_SLOTS */
+static List_t xPeriodWheel[cgroupPERIOD_WHEEL_SLOTS];
+
+/* configCGROUP_CYCLE_COUNTER() cycles per kernel tick, set by the first
+ * xCGroupCreate() */
+static uint64_t ullCyclesPerTick = 0U;
+
+/* uxRunHeapIndex of a run queue that is not in the run heap of its priority */
+#define cgroupNOT_QUEUED ((UBaseType_t)-1)
+
+/* Cgroups with ready tasks at each priority, a binary min-heap on virtual
+ * runtime so the context switch finds the cgroup furthest behind in O(1) and a
+ * charge re-sorts it in O(log n). The heap of priority p starts at
+ * pxRunHeaps[p * uxRunHeapCapacity], every heap has room for the whole pool. */
+static CGroup_t  **pxRunHeaps = NULL;
+static UBaseType_t uxRunHeapCapacity = 0U;
+static UBaseType_t uxRunHeapLength[configMAX_PRIORITIES];
+
+/* Lowest virtual runtime picked at each priority. A cgroup that was idle is
+ * pulled up close to it when it joins the heap again, so it cannot monopolise
+ * the priority level with the virtual runtime it did not use while idle. */
+static uint64_t ullVirtualRuntimeFloor[configMAX_PRIORITIES];
+
+/* Membership lives in the TCB (pxCGroupHandle), so resolving a task's cgroup
+ * is a single load on the tick, context switch and heap paths. */
 
 /*-----------------------------------------------------------
  * PRIVATE FUNCTION PROTOTYPES
  *----------------------------------------------------------*/
 
-static BaseType_t prvFindFreeCGroupSlot(void);
-static BaseType_t prvGetCGroupIndex(CGroupHandle_t xCGroup);
-static CGroup_t  *prvGetCGroupFromTask(TaskHandle_t xTask);
-static BaseType_t prvAddTaskToMap(TaskHandle_t xTask, CGroupHandle_t xCGroup);
-static BaseType_t prvRemoveTaskFromMap(TaskHandle_t xTask);
-static void       prvUpdateCpuWindow(CGroup_t *pxCGroup);
-static void       prvCalculatePenalty(CGroup_t *pxCGroup);
+static void          *prvAllocUncharged(size_t xSize);
+static BaseType_t     prvGrowCGroupPool(void);
+static CGroup_t      *prvGetCGroupFromIndex(UBaseType_t uxIndex);
+static CGroup_t      *prvGetCGroupFromHandle(CGroupHandle_t xCGroup);
+static CGroupHandle_t prvGetHandle(const CGroup_t *pxCGroup);
+static void           prvReleaseCGroup(CGroup_t *pxCGroup);
+static CGroup_t   *prvGetCGroupFromTask(TaskHandle_t xTask);
+static void        prvRaiseMemoryEvent(CGroup_t   *pxCGroup,
+                                       UBaseType_t ulEvent,
+                                       UBaseType_t ulMemoryUsed);
+static UBaseType_t prvGetSizeBucket(UBaseType_t ulSize);
+static void        prvChargeMemory(CGroup_t *pxCGroup, UBaseType_t ulSize, BaseType_t xRaiseEvents);
+static void        prvUnchargeMemory(CGroup_t *pxCGroup, UBaseType_t ulSize);
+static BaseType_t  prvMemoryFits(CGroup_t *pxCGroup, UBaseType_t ulSize);
+static void        prvRefreshCachedLimits(CGroup_t *pxCGroup);
+static void        prvRefreshHierarchy(void);
+static UBaseType_t prvGetSubtreeHeight(CGroup_t *pxRoot);
+static UBaseType_t prvQuotaToTicks(UBaseType_t ulCpuQuota, TickType_t xPeriod);
+static void        prvSetCpuQuota(CGroup_t *pxCGroup, UBaseType_t ulCpuQuota);
+static BaseType_t  prvIsHeld(const CGroup_t *pxCGroup);
+static BaseType_t  prvUnthrottle(CGroup_t *pxCGroup);
+static void        prvRollCpuPeriod(CGroup_t *pxCGroup, TickType_t xCurrentTime);
+static void        prvArmPeriodTimer(CGroup_t *pxCGroup);
+static void        prvRunHeapPlace(UBaseType_t uxPriority, UBaseType_t uxSlot, CGroup_t *pxCGroup);
+static void        prvRunHeapSiftUp(UBaseType_t uxPriority, UBaseType_t uxSlot);
+static void        prvRunHeapSiftDown(UBaseType_t uxPriority, UBaseType_t uxSlot);
+static void        prvRunHeapRemove(UBaseType_t uxPriority, CGroup_t *pxCGroup);
+static void        prvRunHeapRequeue(CGroup_t *pxCGroup);
+static BaseType_t  prvReserveRunQueue(CGroup_t *pxCGroup, UBaseType_t uxPriority);
 
 /* Integration functions called by FreeRTOS kernel */
-void       prvCGroupTaskSwitchOut(TaskHandle_t xTask);
-BaseType_t prvCGroupCanTaskRun(TaskHandle_t xTask);
-void       prvCGroupUpdateTick(void);
+void         prvCGroupChargeTask(TaskHandle_t xTask, uint64_t ullCycles);
+BaseType_t   prvCGroupCanTaskRun(TaskHandle_t xTask);
+BaseType_t   prvCGroupUpdateTick(void);
+List_t      *prvCGroupGetThrottledList(void *pxCGroupHandle);
+BaseType_t   prvCGroupIsThrottledList(void *pxCGroupHandle, const List_t *pxList);
+void         prvCGroupTaskReady(void *pxCGroupHandle, ListItem_t *pxReadyItem, UBaseType_t uxPrio);
+void         prvCGroupTaskUnready(void *pxCGroupHandle, ListItem_t *pxReadyItem);
+List_t      *prvCGroupGetRunList(UBaseType_t uxPriority);
+void         prvCGroupReserveRunQueue(void *pxCGroupHandle, UBaseType_t uxPriority);
 
 /*-----------------------------------------------------------
  * PRIVATE FUNCTIONS
  *----------------------------------------------------------*/
 
-static BaseType_t prvFindFreeCGroupSlot(void) {
-    BaseType_t xIndex;
+/* Memory shared by all cgroups is not charged to whichever task happens to
+ * trigger its allocation */
+static void *prvAllocUncharged(size_t xSize) {
+    CGroupHandle_t xPrevious = xCGroupSetMemoryChargeTarget(CGROUP_CHARGE_NONE);
+    void          *pvMemory = pvPortMalloc(xSize);
+
+    (void)xCGroupSetMemoryChargeTarget(xPrevious);
+    return pvMemory;
+}
+
+static BaseType_t prvGrowCGroupPool(void) {
+    CGroup_t   *pxChunk;
+    CGroup_t  **pxNewHeaps;
+    CGroup_t  **pxOldHeaps;
+    UBaseType_t uxChunkSize;
+    UBaseType_t uxIndex;
+    UBaseType_t uxPriority;
 
-    for (xIndex = 0; xIndex < configMAX_CGROUPS; xIndex++) {
-        if ((uxCGroupBitmap & (1U << xIndex)) == 0U) {
-            return xIndex;
+    uxChunkSize = (UBaseType_t)configCGROUP_POOL_CHUNK_SIZE << uxCGroupChunkCount;
+
+    /* Every index must still fit a handle */
+    if ((uxCGroupChunkCount >= cgroupPOOL_MAX_CHUNKS) ||
+        ((uxCGroupPoolSize + uxChunkSize) >= (UBaseType_t)cgroupHANDLE_INDEX_MASK)) {
+        return pdFAIL;
+    }
+
+    /* Run heaps with room for every cgroup of the grown pool */
+    pxNewHeaps = (CGroup_t **)prvAllocUncharged((uxCGroupPoolSize + uxChunkSize) *
+                                                configMAX_PRIORITIES * sizeof(CGroup_t *));
+    if (pxNewHeaps == NULL) {
+        return pdFAIL;
+    }
+
+    /* Chunks are never freed, so the pointer can be aligned up in place */
+    pxChunk = (CGroup_t *)prvAllocUncharged((uxChunkSize * sizeof(CGroup_t)) +
+                                            (configCGROUP_CACHE_LINE_SIZE - 1U));
+    if (pxChunk == NULL) {
+        vPortFree(pxNewHeaps);
+        return pdFAIL;
+    }
+    pxChunk = (CGroup_t *)(((uintptr_t)pxChunk + (configCGROUP_CACHE_LINE_SIZE - 1U)) &
+                           ~((uintptr_t)configCGROUP_CACHE_LINE_SIZE - 1U));
+
+    /* Hand the new cgroups out from the lowest index */
+    for (uxIndex = uxChunkSize; uxIndex > 0U; uxIndex--) {
+        pxChunk[uxIndex - 1U].uxIndex = uxCGroupPoolSize + uxIndex - 1U;
+        pxChunk[uxIndex - 1U].uxGeneration = 0U;
+        pxChunk[uxIndex - 1U].xActive = pdFALSE;
+        pxChunk[uxIndex - 1U].pxNextFree = pxFreeCGroups;
+        pxFreeCGroups = &pxChunk[uxIndex - 1U];
+    }
+
+    pxCGroupChunks[uxCGroupChunkCount] = pxChunk;
+    uxCGroupChunkCount++;
+    uxCGroupPoolSize += uxChunkSize;
+
+    /* Neither the tick nor the context switch uses the heaps while the
+     * scheduler is suspended. Cgroups keep their slot in the heap. */
+    for (uxPriority = 0U; uxPriority < configMAX_PRIORITIES; uxPriority++) {
+        for (uxIndex = 0U; uxIndex < uxRunHeapLength[uxPriority]; uxIndex++) {
+            pxNewHeaps[(uxPriority * uxCGroupPoolSize) + uxIndex] =
+                pxRunHeaps[(uxPriority * uxRunHeapCapacity) + uxIndex];
         }
     }
+    pxOldHeaps = pxRunHeaps;
+    pxRunHeaps = pxNewHeaps;
+    uxRunHeapCapacity = uxCGroupPoolSize;
 
-    return -1;
+    if (pxOldHeaps != NULL) {
+        vPortFree(pxOldHeaps);
+    }
+
+    return pdPASS;
 }
 
-static BaseType_t prvGetCGroupIndex(CGroupHandle_t xCGroup) {
-    BaseType_t xIndex;
+static CGroup_t *prvGetCGroupFromIndex(UBaseType_t uxIndex) {
+    UBaseType_t uxChunk;
+    UBaseType_t uxFirst;
 
-    if (xCGroup == NULL) {
-        return -1;
+    /* Chunk n starts at index configCGROUP_POOL_CHUNK_SIZE * (2^n - 1), so
+     * the chunk is the highest bit set in index / chunk size + 1 */
+    uxChunk = (uxIndex / (UBaseType_t)configCGROUP_POOL_CHUNK_SIZE) + 1U;
+    uxChunk = (UBaseType_t)(63 - __builtin_clzll((unsigned long long)uxChunk));
+    uxFirst = (UBaseType_t)configCGROUP_POOL_CHUNK_SIZE * ((((UBaseType_t)1U) << uxChunk) - 1U);
+
+    return &pxCGroupChunks[uxChunk][uxIndex - uxFirst];
+}
+
+static CGroup_t *prvGetCGroupFromHandle(CGroupHandle_t xCGroup) {
+    uintptr_t   uxHandle;
+    UBaseType_t uxIndex;
+    CGroup_t   *pxCGroup;
+
+    uxHandle = (uintptr_t)xCGroup;
+    if ((uxHandle & cgroupHANDLE_INDEX_MASK) == 0U) {
+        return NULL;
     }
 
-    for (xIndex = 0; xIndex < configMAX_CGROUPS; xIndex++) {
-        if (&xCGroups[xIndex] == (CGroup_t *)xCGroup) {
-            return xIndex;
-        }
+    uxIndex = (UBaseType_t)(uxHandle & cgroupHANDLE_INDEX_MASK) - 1U;
+    if (uxIndex >= uxCGroupPoolSize) {
+        return NULL;
+    }
+
+    pxCGroup = prvGetCGroupFromIndex(uxIndex);
+    if ((pxCGroup->xActive == pdFALSE) ||
+        (pxCGroup->uxGeneration != (UBaseType_t)(uxHandle >> cgroupHANDLE_INDEX_BITS))) {
+        return NULL;
     }
 
-    return -1;
+    return pxCGroup;
 }
 
-static CGroup_t *prvGetCGroupFromTask(TaskHandle_t xTask) {
-    UBaseType_t ux;
+static CGroupHandle_t prvGetHandle(const CGroup_t *pxCGroup) {
+    if (pxCGroup == NULL) {
+        return NULL;
+    }
+
+    return (CGroupHandle_t)(((uintptr_t)pxCGroup->uxGeneration << cgroupHANDLE_INDEX_BITS) |
+                            (uintptr_t)(pxCGroup->uxIndex + 1U));
+}
+
+static void prvReleaseCGroup(CGroup_t *pxCGroup) {
+    /* Handles still held to the cgroup no longer match it */
+    pxCGroup->uxGeneration = (pxCGroup->uxGeneration + 1U) & (UBaseType_t)cgroupHANDLE_INDEX_MASK;
+
+    pxCGroup->pxNextFree = pxFreeCGroups;
+    pxFreeCGroups = pxCGroup;
+}
 
+static CGroup_t *prvGetCGroupFromTask(TaskHandle_t xTask) {
     if (xTask == NULL) {
         return NULL;
     }
 
-    /* Search the mapping table */
-    for (ux = 0; ux < uxMapCount; ux++) {
-        if (xTaskCGroupMap[ux].xTask == xTask) {
-            return (CGroup_t *)xTaskCGroupMap[ux].xCGroup;
+    return (CGroup_t *)pvTaskGetCGroup(xTask);
+}
+
+static void
+prvRaiseMemoryEvent(CGroup_t *pxCGroup, UBaseType_t ulEvent, UBaseType_t ulMemoryUsed) {
+    CGroupMemoryEventCallback_t pxCallback;
+    TaskHandle_t                xTask;
+
+    pxCallback = pxCGroup->xMemoryEvents.pxCallback;
+    if (pxCallback != NULL) {
+        pxCallback(prvGetHandle(pxCGroup), ulEvent, ulMemoryUsed,
+                   pxCGroup->xMemoryEvents.pvContext);
+    }
+
+    xTask = pxCGroup->xMemoryEvents.xTask;
+    if (xTask != NULL) {
+        (void)xTaskNotify(xTask, (uint32_t)ulEvent, eSetBits);
+    }
+}
+
+static UBaseType_t prvGetSizeBucket(UBaseType_t ulSize) {
+    UBaseType_t uxBucket;
+
+    if (ulSize <= (((UBaseType_t)1U) << CGROUP_MEMORY_HISTOGRAM_MIN_SHIFT)) {
+        return 0U;
+    }
+
+    /* Bucket n holds sizes up to 1 << (MIN_SHIFT + n), found from the highest
+     * bit set in ulSize - 1 */
+    uxBucket = (UBaseType_t)(64 - __builtin_clzll((unsigned long long)(ulSize - 1U))) -
+               CGROUP_MEMORY_HISTOGRAM_MIN_SHIFT;
+
+    return (uxBucket < CGROUP_MEMORY_HISTOGRAM_BUCKETS) ? uxBucket
+                                                        : (CGROUP_MEMORY_HISTOGRAM_BUCKETS - 1U);
+}
+
+static void prvChargeMemory(CGroup_t *pxCGroup, UBaseType_t ulSize, BaseType_t xRaiseEvents) {
+    UBaseType_t ulNewUsage;
+    UBaseType_t ulPeak;
+    UBaseType_t ulSoftLimit;
+
+    /* Charge the cgroup and every ancestor. Lock-free so the heap path never
+     * enters a critical section. */
+    for (; pxCGroup != NULL; pxCGroup = pxCGroup->pxParent) {
+        ulNewUsage = __atomic_add_fetch(&pxCGroup->xMemoryLimits.ulMemoryUsed, ulSize,
+                                        __ATOMIC_RELAXED);
+
+        /* Only the charge that crosses the soft limit raises the event, so it
+         * fires once each time usage rises above it */
+        ulSoftLimit = pxCGroup->xMemoryLimits.ulSoftLimit;
+        if ((ulNewUsage > ulSoftLimit) && ((ulNewUsage - ulSize) <= ulSoftLimit)) {
+            (void)__atomic_add_fetch(&pxCGroup->xMemoryLimits.ulHighEvents, 1U,
+                                     __ATOMIC_RELAXED);
+            if (xRaiseEvents != pdFALSE) {
+                prvRaiseMemoryEvent(pxCGroup, CGROUP_MEMORY_EVENT_HIGH, ulNewUsage);
+            }
+        }
+
+        ulPeak = __atomic_load_n(&pxCGroup->xMemoryLimits.ulMemoryPeak, __ATOMIC_RELAXED);
+        while (ulNewUsage > ulPeak) {
+            if (__atomic_compare_exchange_n(&pxCGroup->xMemoryLimits.ulMemoryPeak, &ulPeak,
+                                            ulNewUsage, pdFALSE, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
         }
     }
+}
+
+static void prvUnchargeMemory(CGroup_t *pxCGroup, UBaseType_t ulSize) {
+    UBaseType_t ulUsed;
+    UBaseType_t ulNewUsage;
 
-    return NULL;
+    for (; pxCGroup != NULL; pxCGroup = pxCGroup->pxParent) {
+        ulUsed = __atomic_load_n(&pxCGroup->xMemoryLimits.ulMemoryUsed, __ATOMIC_RELAXED);
+        do {
+            /* Clamp at zero, usage may have been reset by xCGroupResetMemoryStats() */
+            ulNewUsage = (ulSize > ulUsed) ? 0U : (ulUsed - ulSize);
+        } while (!__atomic_compare_exchange_n(&pxCGroup->xMemoryLimits.ulMemoryUsed, &ulUsed,
+                                              ulNewUsage, pdFALSE, __ATOMIC_RELAXED,
+                                              __ATOMIC_RELAXED));
+    }
 }
 
-static BaseType_t prvAddTaskToMap(TaskHandle_t xTask, CGroupHandle_t xCGroup) {
-    if (uxMapCount >= (configMAX_CGROUPS * 8)) {
-        return pdFAIL;
+static BaseType_t prvMemoryFits(CGroup_t *pxCGroup, UBaseType_t ulSize) {
+    CGroup_t   *pxLevel;
+    UBaseType_t ulUsed;
+
+    /* Nothing limits the cgroup or any ancestor */
+    if (pxCGroup->xMemoryLimits.ulEffectiveLimit == CGROUP_NO_LIMIT) {
+        return pdTRUE;
     }
 
-    /* Check if task is already mapped */
-    if (prvGetCGroupFromTask(xTask) != NULL) {
-        return pdFAIL;
+    /* Ancestors are charged at least as much as their children, so going over
+     * the lowest limit in the tree with this cgroup's usage alone already
+     * fails without looking at the ancestors */
+    ulUsed = __atomic_load_n(&pxCGroup->xMemoryLimits.ulMemoryUsed, __ATOMIC_RELAXED);
+    if ((ulUsed + ulSize) > pxCGroup->xMemoryLimits.ulEffectiveLimit) {
+        return pdFALSE;
     }
 
-    xTaskCGroupMap[uxMapCount].xTask = xTask;
-    xTaskCGroupMap[uxMapCount].xCGroup = xCGroup;
-    uxMapCount++;
+    /* That also covers this cgroup's own limit, check the limited ancestors */
+    for (pxLevel = pxCGroup->pxMemoryLimitParent; pxLevel != NULL;
+         pxLevel = pxLevel->pxMemoryLimitParent) {
+        ulUsed = __atomic_load_n(&pxLevel->xMemoryLimits.ulMemoryUsed, __ATOMIC_RELAXED);
+        if ((ulUsed + ulSize) > pxLevel->xMemoryLimits.ulMemoryLimit) {
+            return pdFALSE;
+        }
+    }
 
-    return pdPASS;
+    return pdTRUE;
 }
 
-static BaseType_t prvRemoveTaskFromMap(TaskHandle_t xTask) {
-    UBaseType_t ux;
+static void prvRefreshCachedLimits(CGroup_t *pxCGroup) {
+    CGroup_t   *pxAncestor;
+    UBaseType_t ulLimit;
+
+    /* Cache what the heap path needs from the ancestors, so it does not walk
+     * the tree */
+    pxCGroup->uxDepth = 0U;
+    pxCGroup->pxMemoryLimitParent = NULL;
+    ulLimit = pxCGroup->xMemoryLimits.ulMemoryLimit;
 
-    /* Find and remove the mapping */
-    for (ux = 0; ux < uxMapCount; ux++) {
-        if (xTaskCGroupMap[ux].xTask == xTask) {
-            /* Move the last entry to fill the gap */
-            if (ux < (uxMapCount - 1)) {
-                xTaskCGroupMap[ux] = xTaskCGroupMap[uxMapCount - 1];
+    for (pxAncestor = pxCGroup->pxParent; pxAncestor != NULL; pxAncestor = pxAncestor->pxParent) {
+        pxCGroup->uxDepth++;
+
+        if (pxAncestor->xMemoryLimits.ulMemoryLimit != CGROUP_NO_LIMIT) {
+            if (pxCGroup->pxMemoryLimitParent == NULL) {
+                pxCGroup->pxMemoryLimitParent = pxAncestor;
+            }
+
+            if (pxAncestor->xMemoryLimits.ulMemoryLimit < ulLimit) {
+                ulLimit = pxAncestor->xMemoryLimits.ulMemoryLimit;
             }
-            uxMapCount--;
-            return pdPASS;
         }
     }
 
-    return pdFAIL;
+    pxCGroup->xMemoryLimits.ulEffectiveLimit = ulLimit;
 }
 
-static void prvUpdateCpuWindow(CGroup_t *pxCGroup) {
-    TickType_t xCurrentTime;
+static void prvRefreshHierarchy(void) {
+    ListItem_t *pxItem;
 
-    if (pxCGroup == NULL) {
-        return;
+    /* The tree or a memory limit changed, refresh every cgroup that may be
+     * below it */
+    for (pxItem = listGET_HEAD_ENTRY(&xActiveCGroups);
+         pxItem != listGET_END_MARKER(&xActiveCGroups); pxItem = listGET_NEXT(pxItem)) {
+        prvRefreshCachedLimits((CGroup_t *)listGET_LIST_ITEM_OWNER(pxItem));
     }
+}
 
-    xCurrentTime = xTaskGetTickCount();
+static UBaseType_t prvGetSubtreeHeight(CGroup_t *pxRoot) {
+    ListItem_t *pxItem;
+    CGroup_t   *pxCGroup;
+    UBaseType_t uxLevels;
+    UBaseType_t uxHeight = 0U;
+
+    /* Number of levels below pxRoot */
+    for (pxItem = listGET_HEAD_ENTRY(&xActiveCGroups);
+         pxItem != listGET_END_MARKER(&xActiveCGroups); pxItem = listGET_NEXT(pxItem)) {
+        uxLevels = 0U;
+        for (pxCGroup = (CGroup_t *)listGET_LIST_ITEM_OWNER(pxItem);
+             (pxCGroup != NULL) && (pxCGroup != pxRoot); pxCGroup = pxCGroup->pxParent) {
+            uxLevels++;
+        }
 
-    /* Check if we need to start a new time window */
-    if ((xCurrentTime - pxCGroup->xCpuLimits.xWindowStartTime) >=
-        pxCGroup->xCpuLimits.xWindowDuration) {
-        /* Calculate penalty for the ending window */
-        prvCalculatePenalty(pxCGroup);
-
-        /* Start new window */
-        pxCGroup->xCpuLimits.xWindowStartTime = xCurrentTime;
-        pxCGroup->xCpuLimits.ulTicksUsed = 0U;
-
-        /* Reduce penalty slices if any */
-        if (pxCGroup->xCpuLimits.ulPenaltyTicksLeft > 0U) {
-            pxCGroup->xCpuLimits.ulPenaltyTicksLeft =
-                (pxCGroup->xCpuLimits.ulPenaltyTicksLeft > 1U)
-                    ? (pxCGroup->xCpuLimits.ulPenaltyTicksLeft - 1U)
-                    : 0U;
+        if ((pxCGroup == pxRoot) && (uxLevels > uxHeight)) {
+            uxHeight = uxLevels;
         }
     }
+
+    return uxHeight;
 }
 
-static void prvCalculatePenalty(CGroup_t *pxCGroup) {
-    UBaseType_t ulExcess;
+static UBaseType_t prvQuotaToTicks(UBaseType_t ulCpuQuota, TickType_t xPeriod) {
+    UBaseType_t ulTicks;
 
-    if (pxCGroup == NULL) {
+    if (ulCpuQuota >= CGROUP_CPU_QUOTA_MAX) {
+        return CGROUP_NO_LIMIT;
+    }
+
+    /* ulCpuQuota is a percentage * 100 of each period, always allow one tick
+     * so a small quota does not starve the cgroup completely */
+    ulTicks = ((UBaseType_t)xPeriod * ulCpuQuota) / CGROUP_CPU_QUOTA_MAX;
+
+    return (ulTicks > 0U) ? ulTicks : 1U;
+}
+
+static void prvSetCpuQuota(CGroup_t *pxCGroup, UBaseType_t ulCpuQuota) {
+    pxCGroup->xCpuLimits.ulCpuQuota = ulCpuQuota;
+    pxCGroup->xCpuLimits.ulTicksQuota =
+        prvQuotaToTicks(ulCpuQuota, pxCGroup->xCpuLimits.xWindowDuration);
+
+    /* The quota is enforced in counter cycles, ticks are kept for reporting */
+    if (pxCGroup->xCpuLimits.ulTicksQuota == CGROUP_NO_LIMIT) {
+        pxCGroup->xCpuLimits.ullCyclesQuota = (uint64_t)CGROUP_NO_LIMIT;
+    } else {
+        pxCGroup->xCpuLimits.ullCyclesQuota =
+            ((uint64_t)pxCGroup->xCpuLimits.xWindowDuration * ullCyclesPerTick * ulCpuQuota) /
+            CGROUP_CPU_QUOTA_MAX;
+    }
+}
+
+static BaseType_t prvIsHeld(const CGroup_t *pxCGroup) {
+    /* Tasks below the cgroup may not run, they park on its throttled list */
+    return ((pxCGroup->xThrottled != pdFALSE) || (pxCGroup->xFrozen != pdFALSE)) ? pdTRUE
+                                                                                 : pdFALSE;
+}
+
+static BaseType_t prvUnthrottle(CGroup_t *pxCGroup) {
+    if (pxCGroup->xThrottled == pdFALSE) {
+        return pdFALSE;
+    }
+
+    pxCGroup->xThrottled = pdFALSE;
+    if (listLIST_ITEM_CONTAINER(&(pxCGroup->xPeriodListItem)) != NULL) {
+        (void)uxListRemove(&(pxCGroup->xPeriodListItem));
+    }
+
+    /* A frozen cgroup keeps its tasks parked until it is thawed */
+    if (pxCGroup->xFrozen != pdFALSE) {
+        return pdFALSE;
+    }
+
+    /* Re-queue the tasks parked by the scheduler while throttled */
+    return xTaskCGroupUnthrottle(&(pxCGroup->xThrottledList));
+}
+
+static void prvRollCpuPeriod(CGroup_t *pxCGroup, TickType_t xCurrentTime) {
+    if ((xCurrentTime - pxCGroup->xCpuLimits.xWindowStartTime) <
+        pxCGroup->xCpuLimits.xWindowDuration) {
         return;
     }
 
-    /* Check if quota was exceeded */
+    pxCGroup->xCpuLimits.xWindowStartTime = xCurrentTime;
+    pxCGroup->xCpuLimits.ulTicksUsed = 0U;
+
+    /* Start a new period, runtime beyond the quota is only noticed at the next
+     * tick, so carry the overrun into the new period to keep the share exact */
     if ((pxCGroup->xCpuLimits.ulTicksQuota != CGROUP_NO_LIMIT) &&
-        (pxCGroup->xCpuLimits.ulTicksUsed > pxCGroup->xCpuLimits.ulTicksQuota)) {
-        ulExcess = pxCGroup->xCpuLimits.ulTicksUsed - pxCGroup->xCpuLimits.ulTicksQuota;
+        (pxCGroup->xCpuLimits.ullCyclesUsed > pxCGroup->xCpuLimits.ullCyclesQuota)) {
+        pxCGroup->xCpuLimits.ullCyclesUsed -= pxCGroup->xCpuLimits.ullCyclesQuota;
+    } else {
+        pxCGroup->xCpuLimits.ullCyclesUsed = 0U;
+    }
+}
+
+static void prvArmPeriodTimer(CGroup_t *pxCGroup) {
+    TickType_t xPeriodEnd;
+
+    /* Wake the cgroup in the tick its period ends */
+    xPeriodEnd = pxCGroup->xCpuLimits.xWindowStartTime + pxCGroup->xCpuLimits.xWindowDuration;
+    listSET_LIST_ITEM_VALUE(&(pxCGroup->xPeriodListItem), xPeriodEnd);
+    vListInsertEnd(&xPeriodWheel[xPeriodEnd & cgroupPERIOD_WHEEL_MASK],
+                   &(pxCGroup->xPeriodListItem));
+}
+
+static void prvRunHeapPlace(UBaseType_t uxPriority, UBaseType_t uxSlot, CGroup_t *pxCGroup) {
+    pxRunHeaps[(uxPriority * uxRunHeapCapacity) + uxSlot] = pxCGroup;
+    pxCGroup->pxRunQueues[uxPriority]->uxRunHeapIndex = uxSlot;
+}
+
+static void prvRunHeapSiftUp(UBaseType_t uxPriority, UBaseType_t uxSlot) {
+    CGroup_t  **pxHeap = &pxRunHeaps[uxPriority * uxRunHeapCapacity];
+    CGroup_t   *pxCGroup = pxHeap[uxSlot];
+    UBaseType_t uxParent;
+
+    while (uxSlot > 0U) {
+        uxParent = (uxSlot - 1U) / 2U;
+        if (pxHeap[uxParent]->xCpuLimits.ullVirtualRuntime <=
+            pxCGroup->xCpuLimits.ullVirtualRuntime) {
+            break;
+        }
+        prvRunHeapPlace(uxPriority, uxSlot, pxHeap[uxParent]);
+        uxSlot = uxParent;
+    }
+    prvRunHeapPlace(uxPriority, uxSlot, pxCGroup);
+}
 
-        /* Apply penalty: penalize configCGROUP_CPU_PENALTY_FACTOR times the excess */
-        pxCGroup->xCpuLimits.ulPenaltyTicksLeft +=
-            (ulExcess * configCGROUP_CPU_WINDOW_DURATION / pxCGroup->xCpuLimits.ulTicksQuota);
+static void prvRunHeapSiftDown(UBaseType_t uxPriority, UBaseType_t uxSlot) {
+    CGroup_t  **pxHeap = &pxRunHeaps[uxPriority * uxRunHeapCapacity];
+    CGroup_t   *pxCGroup = pxHeap[uxSlot];
+    UBaseType_t uxLength = uxRunHeapLength[uxPriority];
+    UBaseType_t uxChild;
+
+    for (;;) {
+        uxChild = (uxSlot * 2U) + 1U;
+        if (uxChild >= uxLength) {
+            break;
+        }
+        if (((uxChild + 1U) < uxLength) && (pxHeap[uxChild + 1U]->xCpuLimits.ullVirtualRuntime <
+                                            pxHeap[uxChild]->xCpuLimits.ullVirtualRuntime)) {
+            uxChild++;
+        }
+        if (pxHeap[uxChild]->xCpuLimits.ullVirtualRuntime >=
+            pxCGroup->xCpuLimits.ullVirtualRuntime) {
+            break;
+        }
+        prvRunHeapPlace(uxPriority, uxSlot, pxHeap[uxChild]);
+        uxSlot = uxChild;
+    }
+    prvRunHeapPlace(uxPriority, uxSlot, pxCGroup);
+}
+
+static void prvRunHeapRemove(UBaseType_t uxPriority, CGroup_t *pxCGroup) {
+    UBaseType_t uxSlot = pxCGroup->pxRunQueues[uxPriority]->uxRunHeapIndex;
+    CGroup_t   *pxLast;
+
+    pxCGroup->pxRunQueues[uxPriority]->uxRunHeapIndex = cgroupNOT_QUEUED;
+    uxRunHeapLength[uxPriority]--;
+    if (uxSlot == uxRunHeapLength[uxPriority]) {
+        return;
+    }
+
+    /* Move the last cgroup into the hole, it may belong above or below it */
+    pxLast = pxRunHeaps[(uxPriority * uxRunHeapCapacity) + uxRunHeapLength[uxPriority]];
+    prvRunHeapPlace(uxPriority, uxSlot, pxLast);
+    prvRunHeapSiftUp(uxPriority, uxSlot);
+    prvRunHeapSiftDown(uxPriority, pxLast->pxRunQueues[uxPriority]->uxRunHeapIndex);
+}
+
+static void prvRunHeapRequeue(CGroup_t *pxCGroup) {
+    CGroupRunQueue_t *pxQueue;
+    UBaseType_t       uxPriority;
+
+    /* The virtual runtime only grows, so the cgroup can only move down */
+    for (uxPriority = 0U; uxPriority < configMAX_PRIORITIES; uxPriority++) {
+        pxQueue = pxCGroup->pxRunQueues[uxPriority];
+        if ((pxQueue != NULL) && (pxQueue->uxRunHeapIndex != cgroupNOT_QUEUED)) {
+            prvRunHeapSiftDown(uxPriority, pxQueue->uxRunHeapIndex);
+        }
     }
 }
 
+static BaseType_t prvReserveRunQueue(CGroup_t *pxCGroup, UBaseType_t uxPriority) {
+    CGroupRunQueue_t *pxQueue;
+
+    if ((uxPriority >= (UBaseType_t)configMAX_PRIORITIES) ||
+        (pxCGroup->pxRunQueues[uxPriority] != NULL)) {
+        return pdPASS;
+    }
+
+    /* Allocated outside the critical section, the kernel only ever finds a
+     * complete queue */
+    pxQueue = (CGroupRunQueue_t *)prvAllocUncharged(sizeof(CGroupRunQueue_t));
+    if (pxQueue == NULL) {
+        return pdFAIL;
+    }
+    vListInitialise(&(pxQueue->xReadyList));
+    pxQueue->uxRunHeapIndex = cgroupNOT_QUEUED;
+    pxQueue->uxPriority = uxPriority;
+
+    portENTER_CRITICAL();
+    if ((pxCGroup->xActive != pdFALSE) && (pxCGroup->pxRunQueues[uxPriority] == NULL)) {
+        pxCGroup->pxRunQueues[uxPriority] = pxQueue;
+        pxQueue = NULL;
+    }
+    portEXIT_CRITICAL();
+
+    if (pxQueue != NULL) {
+        vPortFree(pxQueue);
+    }
+
+    return pdPASS;
+}
+
 /*-----------------------------------------------------------
  * PUBLIC FUNCTIONS
  *----------------------------------------------------------*/
 
 CGroupHandle_t
 xCGroupCreate(const char *const pcGroupName, UBaseType_t ulMemoryLimit, UBaseType_t ulCpuQuota) {
-    BaseType_t  xIndex;
+    return xCGroupCreateChild(NULL, pcGroupName, ulMemoryLimit, ulCpuQuota);
+}
+
+CGroupHandle_t xCGroupCreateChild(CGroupHandle_t    xParent,
+                                  const char *const pcGroupName,
+                                  UBaseType_t       ulMemoryLimit,
+                                  UBaseType_t       ulCpuQuota) {
     CGroup_t   *pxNewCGroup;
+    CGroup_t   *pxParent = NULL;
     UBaseType_t uxLength;
     TickType_t  xCurrentTime;
 
     configASSERT(pcGroupName != NULL);
 
-    /* Find a free cgroup slot */
-    portENTER_CRITICAL();
-    xIndex = prvFindFreeCGroupSlot();
-    if (xIndex < 0) {
-        portEXIT_CRITICAL();
-        return NULL;
+    if (xParent != NULL) {
+        pxParent = prvGetCGroupFromHandle(xParent);
+        if (pxParent == NULL) {
+            return NULL;
+        }
     }
 
-    /* Mark this slot as used */
-    uxCGroupBitmap |= (1U << xIndex);
-    portEXIT_CRITICAL();
+    if (ullCyclesPerTick == 0U) {
+        ullCyclesPerTick = configCGROUP_CYCLE_FREQUENCY() / configTICK_RATE_HZ;
+    }
 
-    pxNewCGroup = &xCGroups[xIndex];
+    /* Take a cgroup from the pool, growing the pool when it is empty. Only
+     * tasks create and delete cgroups, so suspending the scheduler is enough
+     * to keep the free list consistent while the heap is used. */
+    vTaskSuspendAll();
+    if (pxFreeCGroups == NULL) {
+        (void)prvGrowCGroupPool();
+    }
+
+    pxNewCGroup = pxFreeCGroups;
+    if (pxNewCGroup != NULL) {
+        pxFreeCGroups = pxNewCGroup->pxNextFree;
+    }
+    (void)xTaskResumeAll();
+
+    if (pxNewCGroup == NULL) {
+        return NULL;
+    }
 
     /* Initialize the cgroup structure */
     uxLength = 0;
@@ -237,58 +701,203 @@ xCGroupCreate(const char *const pcGroupName, UBaseType_t ulMemoryLimit, UBaseTyp
     pxNewCGroup->xMemoryLimits.ulMemoryLimit = ulMemoryLimit;
     pxNewCGroup->xMemoryLimits.ulMemoryUsed = 0U;
     pxNewCGroup->xMemoryLimits.ulMemoryPeak = 0U;
+    pxNewCGroup->xMemoryLimits.ulEffectiveLimit = ulMemoryLimit;
+    pxNewCGroup->xMemoryLimits.ulSoftLimit = CGROUP_NO_LIMIT;
+    pxNewCGroup->xMemoryLimits.ulFailCount = 0U;
+    pxNewCGroup->xMemoryLimits.ulHighEvents = 0U;
+    for (uxLength = 0U; uxLength < CGROUP_MEMORY_HISTOGRAM_BUCKETS; uxLength++) {
+        pxNewCGroup->xMemoryLimits.ulSizeHistogram[uxLength] = 0U;
+    }
+    pxNewCGroup->xMemoryEvents.pxCallback = NULL;
+    pxNewCGroup->xMemoryEvents.pvContext = NULL;
+    pxNewCGroup->xMemoryEvents.xTask = NULL;
 
-    /* Initialize CPU limits with tick-based quota enforcement */
+    /* Initialize CPU limits with quota per period enforcement */
     xCurrentTime = xTaskGetTickCount();
-    pxNewCGroup->xCpuLimits.ulCpuQuota = ulCpuQuota;
     pxNewCGroup->xCpuLimits.ulTicksUsed = 0U;
-    /* Calculate max ticks per window based on CPU quota percentage */
-    pxNewCGroup->xCpuLimits.ulTicksQuota =
-        (ulCpuQuota == CGROUP_CPU_QUOTA_MAX) ? CGROUP_NO_LIMIT : ulCpuQuota;
-    pxNewCGroup->xCpuLimits.ulPenaltyTicksLeft = 0U;
+    pxNewCGroup->xCpuLimits.ulThrottleCount = 0U;
     pxNewCGroup->xCpuLimits.xWindowStartTime = xCurrentTime;
     pxNewCGroup->xCpuLimits.xWindowDuration = configCGROUP_CPU_WINDOW_DURATION;
-
-    /* Initialize task list */
+    pxNewCGroup->xCpuLimits.ullCyclesUsed = 0U;
+    pxNewCGroup->xCpuLimits.ullTotalCycles = 0U;
+    pxNewCGroup->xCpuLimits.ulCpuWeight = CGROUP_CPU_WEIGHT_DEFAULT;
+    /* Pulled up to the floor of a priority when its first task becomes ready */
+    pxNewCGroup->xCpuLimits.ullVirtualRuntime = 0U;
+    prvSetCpuQuota(pxNewCGroup, ulCpuQuota);
+
+    /* Initialize task lists */
     vListInitialise(&(pxNewCGroup->xTaskList));
+    vListInitialise(&(pxNewCGroup->xThrottledList));
+    for (uxLength = 0U; uxLength < configMAX_PRIORITIES; uxLength++) {
+        pxNewCGroup->pxRunQueues[uxLength] = NULL;
+    }
+    pxNewCGroup->xThrottled = pdFALSE;
+    pxNewCGroup->xFrozen = pdFALSE;
     pxNewCGroup->uxTaskCount = 0U;
+    pxNewCGroup->pxParent = NULL;
+    pxNewCGroup->pxMemoryLimitParent = NULL;
+    pxNewCGroup->uxChildCount = 0U;
+    pxNewCGroup->uxDepth = 0U;
+
+    /* Link below the parent, which may have been deleted since it was checked */
+    portENTER_CRITICAL();
+    if (pxParent != NULL) {
+        if ((pxParent->xActive == pdFALSE) ||
+            ((pxParent->uxDepth + 1U) >= (UBaseType_t)configCGROUP_MAX_DEPTH)) {
+            prvReleaseCGroup(pxNewCGroup);
+            portEXIT_CRITICAL();
+            return NULL;
+        }
+
+        pxNewCGroup->pxParent = pxParent;
+        pxParent->uxChildCount++;
+    }
+
+    prvRefreshCachedLimits(pxNewCGroup);
+
+    if (!listLIST_IS_INITIALISED(&xActiveCGroups)) {
+        for (uxLength = 0U; uxLength < cgroupPERIOD_WHEEL_SLOTS; uxLength++) {
+            vListInitialise(&xPeriodWheel[uxLength]);
+        }
+        vListInitialise(&xActiveCGroups);
+    }
+
+    vListInitialiseItem(&(pxNewCGroup->xPeriodListItem));
+    listSET_LIST_ITEM_OWNER(&(pxNewCGroup->xPeriodListItem), pxNewCGroup);
+    vListInitialiseItem(&(pxNewCGroup->xActiveListItem));
+    listSET_LIST_ITEM_OWNER(&(pxNewCGroup->xActiveListItem), pxNewCGroup);
+    vListInsertEnd(&xActiveCGroups, &(pxNewCGroup->xActiveListItem));
     pxNewCGroup->xActive = pdTRUE;
+    portEXIT_CRITICAL();
 
-    return (CGroupHandle_t)pxNewCGroup;
+    return prvGetHandle(pxNewCGroup);
 }
 
 BaseType_t xCGroupDelete(CGroupHandle_t xCGroup) {
-    BaseType_t xIndex;
-    CGroup_t  *pxCGroup;
+    CGroup_t         *pxCGroup;
+    CGroupRunQueue_t *pxRunQueues[configMAX_PRIORITIES];
+    UBaseType_t       uxPriority;
 
     if (xCGroup == NULL) {
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
-    xIndex = prvGetCGroupIndex(xCGroup);
+    portENTER_CRITICAL();
 
-    if (xIndex < 0) {
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        portEXIT_CRITICAL();
         return pdFAIL;
     }
 
-    portENTER_CRITICAL();
-
     /* Check if cgroup is empty */
-    if (pxCGroup->uxTaskCount > 0U) {
+    if ((pxCGroup->uxTaskCount > 0U) || (pxCGroup->uxChildCount > 0U)) {
         portEXIT_CRITICAL();
         return pdFAIL;
     }
 
-    /* Mark as inactive and free the slot */
+    /* Memory still charged to the cgroup no longer counts for its ancestors */
+    if (pxCGroup->pxParent != NULL) {
+        prvUnchargeMemory(pxCGroup->pxParent, pxCGroup->xMemoryLimits.ulMemoryUsed);
+        pxCGroup->pxParent->uxChildCount--;
+        pxCGroup->pxParent = NULL;
+    }
+
+    /* Mark as inactive and return it to the pool */
+    if (listLIST_ITEM_CONTAINER(&(pxCGroup->xPeriodListItem)) != NULL) {
+        (void)uxListRemove(&(pxCGroup->xPeriodListItem));
+    }
+    (void)uxListRemove(&(pxCGroup->xActiveListItem));
     pxCGroup->xActive = pdFALSE;
-    uxCGroupBitmap &= ~(1U << xIndex);
+
+    /* Without tasks the run queues are empty and out of the run heaps */
+    for (uxPriority = 0U; uxPriority < configMAX_PRIORITIES; uxPriority++) {
+        pxRunQueues[uxPriority] = pxCGroup->pxRunQueues[uxPriority];
+        pxCGroup->pxRunQueues[uxPriority] = NULL;
+    }
+    prvReleaseCGroup(pxCGroup);
+
+    portEXIT_CRITICAL();
+
+    for (uxPriority = 0U; uxPriority < configMAX_PRIORITIES; uxPriority++) {
+        if (pxRunQueues[uxPriority] != NULL) {
+            vPortFree(pxRunQueues[uxPriority]);
+        }
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xCGroupFreeze(CGroupHandle_t xCGroup) {
+    CGroup_t  *pxCGroup;
+    BaseType_t xYieldRequired;
+
+    portENTER_CRITICAL();
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        portEXIT_CRITICAL();
+        return pdFAIL;
+    }
+
+    /* The scheduler parks the tasks below the cgroup instead of running them,
+     * so all of them stop at once without walking them here */
+    pxCGroup->xFrozen = pdTRUE;
+
+    /* A task freezing its own cgroup stops right away */
+    xYieldRequired = (prvCGroupCanTaskRun(xTaskGetCurrentTaskHandle()) == pdFALSE) ? pdTRUE
+                                                                                  : pdFALSE;
 
     portEXIT_CRITICAL();
 
+    if (xYieldRequired != pdFALSE) {
+        taskYIELD();
+    }
+
     return pdPASS;
 }
 
+BaseType_t xCGroupThaw(CGroupHandle_t xCGroup) {
+    CGroup_t  *pxCGroup;
+    BaseType_t xYieldRequired = pdFALSE;
+
+    portENTER_CRITICAL();
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        portEXIT_CRITICAL();
+        return pdFAIL;
+    }
+
+    /* Re-queue the parked tasks, unless the quota still holds them. Tasks
+     * still held by a frozen ancestor are parked again when selected. */
+    if (pxCGroup->xFrozen != pdFALSE) {
+        pxCGroup->xFrozen = pdFALSE;
+        if (pxCGroup->xThrottled == pdFALSE) {
+            xYieldRequired = xTaskCGroupUnthrottle(&(pxCGroup->xThrottledList));
+        }
+    }
+
+    portEXIT_CRITICAL();
+
+    if (xYieldRequired != pdFALSE) {
+        taskYIELD();
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xCGroupIsFrozen(CGroupHandle_t xCGroup) {
+    CGroup_t *pxCGroup;
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        return pdFALSE;
+    }
+
+    return pxCGroup->xFrozen;
+}
+
 BaseType_t xCGroupAddTask(CGroupHandle_t xCGroup, TaskHandle_t xTask) {
     CGroup_t  *pxCGroup;
     BaseType_t xResult;
@@ -297,145 +906,265 @@ BaseType_t xCGroupAddTask(CGroupHandle_t xCGroup, TaskHandle_t xTask) {
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+
+    if (pxCGroup == NULL) {
+        return pdFAIL;
+    }
+
+    /* Queue the task in the cgroup at its priority */
+    if (prvReserveRunQueue(pxCGroup, uxTaskPriorityGet(xTask)) != pdPASS) {
+        return pdFAIL;
+    }
+
+    portENTER_CRITICAL();
+
+    /* A task can only belong to one cgroup at a time */
+    if (prvGetCGroupFromTask(xTask) != NULL) {
+        xResult = pdFAIL;
+    } else {
+        xResult = xTaskSetCGroup(xTask, pxCGroup);
+        if (xResult == pdPASS) {
+            pxCGroup->uxTaskCount++;
+        }
+    }
+
+    portEXIT_CRITICAL();
+
+    return xResult;
+}
+
+BaseType_t xCGroupRemoveTask(CGroupHandle_t xCGroup, TaskHandle_t xTask) {
+    CGroup_t  *pxCGroup;
+    CGroup_t  *pxCurrentCGroup;
+    BaseType_t xResult;
+
+    if ((xCGroup == NULL) || (xTask == NULL)) {
+        return pdFAIL;
+    }
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        return pdFAIL;
+    }
+
+    portENTER_CRITICAL();
+
+    /* Check if task is in this cgroup */
+    pxCurrentCGroup = prvGetCGroupFromTask(xTask);
+    if (pxCurrentCGroup != pxCGroup) {
+        portEXIT_CRITICAL();
+        return pdFAIL;
+    }
+
+    /* Detach the task */
+    xResult = xTaskSetCGroup(xTask, NULL);
+    if (xResult == pdPASS) {
+        pxCGroup->uxTaskCount--;
+    }
+
+    portEXIT_CRITICAL();
+
+    return xResult;
+}
+
+BaseType_t xCGroupCheckMemoryLimit(TaskHandle_t xTask, UBaseType_t ulSize) {
+    if (xTask == NULL) {
+        return pdTRUE;
+    }
+
+    return xCGroupCheckMemoryCharge(xCGroupGetMemoryOwner(xTask), ulSize);
+}
+
+BaseType_t xCGroupUpdateMemoryUsage(TaskHandle_t xTask, BaseType_t lMemoryDelta) {
+    CGroupHandle_t xOwner;
+
+    if (xTask == NULL) {
+        return pdPASS;
+    }
+
+    xOwner = xCGroupGetMemoryOwner(xTask);
+    if (xOwner == NULL) {
+        /* Task not in any cgroup */
+        return pdPASS;
+    }
+
+    if (lMemoryDelta > 0) {
+        /* Memory allocation */
+        return xCGroupChargeMemory(xOwner, (UBaseType_t)lMemoryDelta);
+    }
+
+    /* Memory deallocation */
+    return xCGroupUnchargeMemory(xOwner, (UBaseType_t)(-lMemoryDelta));
+}
+
+CGroupHandle_t xCGroupGetMemoryOwner(TaskHandle_t xTask) {
+    CGroupHandle_t xOwner;
+
+    if (xTask == NULL) {
+        return NULL;
+    }
+
+    /* Allocations made on behalf of another cgroup, e.g. a container's stack
+     * and TCB created by the container manager */
+    xOwner = (CGroupHandle_t)pvTaskGetCGroupMemoryCharge(xTask);
+    if (xOwner == CGROUP_CHARGE_NONE) {
+        return NULL;
+    }
+    if ((xOwner != NULL) && (prvGetCGroupFromHandle(xOwner) != NULL)) {
+        return xOwner;
+    }
+
+    return prvGetHandle(prvGetCGroupFromTask(xTask));
+}
 
-    if (pxCGroup->xActive == pdFALSE) {
-        return pdFAIL;
-    }
+CGroupHandle_t xCGroupSetMemoryChargeTarget(CGroupHandle_t xCGroup) {
+    return (CGroupHandle_t)pvTaskSetCGroupMemoryCharge((void *)xCGroup);
+}
 
-    portENTER_CRITICAL();
+BaseType_t xCGroupCheckMemoryCharge(CGroupHandle_t xCGroup, UBaseType_t ulSize) {
+    CGroup_t *pxCGroup;
 
-    /* Add task to mapping */
-    xResult = prvAddTaskToMap(xTask, xCGroup);
-    if (xResult == pdPASS) {
-        pxCGroup->uxTaskCount++;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        /* Not charged to any cgroup, allow allocation */
+        return pdTRUE;
     }
 
-    portEXIT_CRITICAL();
+    /* Check the limits of the cgroup and its ancestors */
+    if (prvMemoryFits(pxCGroup, ulSize) == pdFALSE) {
+        (void)__atomic_add_fetch(&pxCGroup->xMemoryLimits.ulFailCount, 1U, __ATOMIC_RELAXED);
+        prvRaiseMemoryEvent(pxCGroup, CGROUP_MEMORY_EVENT_MAX,
+                            __atomic_load_n(&pxCGroup->xMemoryLimits.ulMemoryUsed,
+                                            __ATOMIC_RELAXED));
+        return pdFALSE;
+    }
 
-    return xResult;
+    return pdTRUE;
 }
 
-BaseType_t xCGroupRemoveTask(CGroupHandle_t xCGroup, TaskHandle_t xTask) {
-    CGroup_t  *pxCGroup;
-    CGroup_t  *pxCurrentCGroup;
-    BaseType_t xResult;
+BaseType_t xCGroupChargeMemory(CGroupHandle_t xCGroup, UBaseType_t ulSize) {
+    CGroup_t *pxCGroup;
 
-    if ((xCGroup == NULL) || (xTask == NULL)) {
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
+    (void)__atomic_add_fetch(&pxCGroup->xMemoryLimits.ulSizeHistogram[prvGetSizeBucket(ulSize)],
+                             1U, __ATOMIC_RELAXED);
+    prvChargeMemory(pxCGroup, ulSize, pdTRUE);
 
-    portENTER_CRITICAL();
+    return pdPASS;
+}
 
-    /* Check if task is in this cgroup */
-    pxCurrentCGroup = prvGetCGroupFromTask(xTask);
-    if (pxCurrentCGroup != pxCGroup) {
-        portEXIT_CRITICAL();
-        return pdFAIL;
-    }
+BaseType_t xCGroupSetMemorySoftLimit(CGroupHandle_t xCGroup, UBaseType_t ulSoftLimit) {
+    CGroup_t *pxCGroup;
 
-    /* Remove task from mapping */
-    xResult = prvRemoveTaskFromMap(xTask);
-    if (xResult == pdPASS) {
-        pxCGroup->uxTaskCount--;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        return pdFAIL;
     }
 
+    portENTER_CRITICAL();
+    pxCGroup->xMemoryLimits.ulSoftLimit = ulSoftLimit;
     portEXIT_CRITICAL();
 
-    return xResult;
+    return pdPASS;
 }
 
-BaseType_t xCGroupCheckMemoryLimit(TaskHandle_t xTask, UBaseType_t ulSize) {
-    CGroup_t   *pxCGroup;
-    UBaseType_t ulNewUsage;
-
-    if (xTask == NULL) {
-        return pdTRUE;
-    }
+BaseType_t xCGroupSetMemoryEventCallback(CGroupHandle_t              xCGroup,
+                                         CGroupMemoryEventCallback_t pxCallback,
+                                         void                       *pvContext) {
+    CGroup_t *pxCGroup;
 
-    pxCGroup = prvGetCGroupFromTask(xTask);
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
     if (pxCGroup == NULL) {
-        /* Task not in any cgroup, allow allocation */
-        return pdTRUE;
-    }
-
-    /* Check if there's a memory limit */
-    if (pxCGroup->xMemoryLimits.ulMemoryLimit == CGROUP_NO_LIMIT) {
-        return pdTRUE;
+        return pdFAIL;
     }
 
-    ulNewUsage = pxCGroup->xMemoryLimits.ulMemoryUsed + ulSize;
+    /* The heap reads the callback with the scheduler suspended, never see a
+     * new callback with the old context */
+    vTaskSuspendAll();
+    pxCGroup->xMemoryEvents.pxCallback = pxCallback;
+    pxCGroup->xMemoryEvents.pvContext = pvContext;
+    (void)xTaskResumeAll();
 
-    return (ulNewUsage <= pxCGroup->xMemoryLimits.ulMemoryLimit) ? pdTRUE : pdFALSE;
+    return pdPASS;
 }
 
-BaseType_t xCGroupUpdateMemoryUsage(TaskHandle_t xTask, BaseType_t lMemoryDelta) {
+BaseType_t xCGroupSetMemoryEventTask(CGroupHandle_t xCGroup, TaskHandle_t xTask) {
     CGroup_t *pxCGroup;
 
-    if (xTask == NULL) {
-        return pdPASS;
-    }
-
-    pxCGroup = prvGetCGroupFromTask(xTask);
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
     if (pxCGroup == NULL) {
-        /* Task not in any cgroup */
-        return pdPASS;
+        return pdFAIL;
     }
 
-    portENTER_CRITICAL();
+    vTaskSuspendAll();
+    pxCGroup->xMemoryEvents.xTask = xTask;
+    (void)xTaskResumeAll();
 
-    if (lMemoryDelta > 0) {
-        /* Memory allocation */
-        pxCGroup->xMemoryLimits.ulMemoryUsed += (UBaseType_t)lMemoryDelta;
-        if (pxCGroup->xMemoryLimits.ulMemoryUsed > pxCGroup->xMemoryLimits.ulMemoryPeak) {
-            pxCGroup->xMemoryLimits.ulMemoryPeak = pxCGroup->xMemoryLimits.ulMemoryUsed;
-        }
-    } else {
-        /* Memory deallocation */
-        UBaseType_t ulDealloc = (UBaseType_t)(-lMemoryDelta);
-        if (ulDealloc > pxCGroup->xMemoryLimits.ulMemoryUsed) {
-            pxCGroup->xMemoryLimits.ulMemoryUsed = 0U;
-        } else {
-            pxCGroup->xMemoryLimits.ulMemoryUsed -= ulDealloc;
-        }
+    return pdPASS;
+}
+
+BaseType_t xCGroupUnchargeMemory(CGroupHandle_t xCGroup, UBaseType_t ulSize) {
+    CGroup_t *pxCGroup;
+
+    /* A cgroup deleted since the charge already gave its usage back */
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        return pdFAIL;
     }
 
-    portEXIT_CRITICAL();
+    prvUnchargeMemory(pxCGroup, ulSize);
 
     return pdPASS;
 }
 
 BaseType_t
 xCGroupGetStats(CGroupHandle_t xCGroup, MemoryLimits_t *pxMemoryLimits, CpuLimits_t *pxCpuLimits) {
-    CGroup_t *pxCGroup;
+    CGroup_t   *pxCGroup;
+    UBaseType_t uxBucket;
 
     if ((xCGroup == NULL) || (pxMemoryLimits == NULL) || (pxCpuLimits == NULL)) {
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
 
-    if (pxCGroup->xActive == pdFALSE) {
+    if (pxCGroup == NULL) {
         return pdFAIL;
     }
 
     portENTER_CRITICAL();
 
-    /* Update CPU window */
-    prvUpdateCpuWindow(pxCGroup);
+    /* The period of a cgroup that did not run may have ended since */
+    prvRollCpuPeriod(pxCGroup, xTaskGetTickCount());
 
     /* Copy memory statistics */
     pxMemoryLimits->ulMemoryLimit = pxCGroup->xMemoryLimits.ulMemoryLimit;
     pxMemoryLimits->ulMemoryUsed = pxCGroup->xMemoryLimits.ulMemoryUsed;
     pxMemoryLimits->ulMemoryPeak = pxCGroup->xMemoryLimits.ulMemoryPeak;
+    pxMemoryLimits->ulEffectiveLimit = pxCGroup->xMemoryLimits.ulEffectiveLimit;
+    pxMemoryLimits->ulSoftLimit = pxCGroup->xMemoryLimits.ulSoftLimit;
+    pxMemoryLimits->ulFailCount = pxCGroup->xMemoryLimits.ulFailCount;
+    pxMemoryLimits->ulHighEvents = pxCGroup->xMemoryLimits.ulHighEvents;
+    for (uxBucket = 0U; uxBucket < CGROUP_MEMORY_HISTOGRAM_BUCKETS; uxBucket++) {
+        pxMemoryLimits->ulSizeHistogram[uxBucket] =
+            pxCGroup->xMemoryLimits.ulSizeHistogram[uxBucket];
+    }
 
     /* Copy CPU statistics */
     pxCpuLimits->ulCpuQuota = pxCGroup->xCpuLimits.ulCpuQuota;
     pxCpuLimits->ulTicksUsed = pxCGroup->xCpuLimits.ulTicksUsed;
+    pxCpuLimits->ullCyclesUsed = pxCGroup->xCpuLimits.ullCyclesUsed;
+    pxCpuLimits->ullCyclesQuota = pxCGroup->xCpuLimits.ullCyclesQuota;
+    pxCpuLimits->ullTotalCycles = pxCGroup->xCpuLimits.ullTotalCycles;
+    pxCpuLimits->ulCpuWeight = pxCGroup->xCpuLimits.ulCpuWeight;
+    pxCpuLimits->ullVirtualRuntime = pxCGroup->xCpuLimits.ullVirtualRuntime;
     pxCpuLimits->ulTicksQuota = pxCGroup->xCpuLimits.ulTicksQuota;
-    pxCpuLimits->ulPenaltyTicksLeft = pxCGroup->xCpuLimits.ulPenaltyTicksLeft;
+    pxCpuLimits->ulThrottleCount = pxCGroup->xCpuLimits.ulThrottleCount;
     pxCpuLimits->xWindowStartTime = pxCGroup->xCpuLimits.xWindowStartTime;
     pxCpuLimits->xWindowDuration = pxCGroup->xCpuLimits.xWindowDuration;
 
@@ -451,29 +1180,31 @@ BaseType_t xCGroupSetMemoryLimit(CGroupHandle_t xCGroup, UBaseType_t ulMemoryLim
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
 
-    if (pxCGroup->xActive == pdFALSE) {
+    if (pxCGroup == NULL) {
         return pdFAIL;
     }
 
     portENTER_CRITICAL();
     pxCGroup->xMemoryLimits.ulMemoryLimit = ulMemoryLimit;
+    prvRefreshHierarchy();
     portEXIT_CRITICAL();
 
     return pdPASS;
 }
 
 BaseType_t xCGroupSetCpuQuota(CGroupHandle_t xCGroup, UBaseType_t ulCpuQuota) {
-    CGroup_t *pxCGroup;
+    CGroup_t  *pxCGroup;
+    BaseType_t xYieldRequired = pdFALSE;
 
     if (xCGroup == NULL) {
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
 
-    if (pxCGroup->xActive == pdFALSE) {
+    if (pxCGroup == NULL) {
         return pdFAIL;
     }
 
@@ -483,15 +1214,159 @@ BaseType_t xCGroupSetCpuQuota(CGroupHandle_t xCGroup, UBaseType_t ulCpuQuota) {
     }
 
     portENTER_CRITICAL();
-    pxCGroup->xCpuLimits.ulCpuQuota = ulCpuQuota;
-    /* Recalculate quota in ticks based on CPU quota percentage */
-    pxCGroup->xCpuLimits.ulTicksQuota =
-        (ulCpuQuota == CGROUP_CPU_QUOTA_MAX) ? CGROUP_NO_LIMIT : ulCpuQuota;
+    prvSetCpuQuota(pxCGroup, ulCpuQuota);
+
+    /* A raised quota may give a throttled cgroup runtime back in this period */
+    if ((pxCGroup->xCpuLimits.ulTicksQuota == CGROUP_NO_LIMIT) ||
+        (pxCGroup->xCpuLimits.ullCyclesUsed < pxCGroup->xCpuLimits.ullCyclesQuota)) {
+        xYieldRequired = prvUnthrottle(pxCGroup);
+    }
+    portEXIT_CRITICAL();
+
+    if (xYieldRequired != pdFALSE) {
+        taskYIELD();
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xCGroupSetCpuWeight(CGroupHandle_t xCGroup, UBaseType_t ulCpuWeight) {
+    CGroup_t *pxCGroup;
+
+    if (xCGroup == NULL) {
+        return pdFAIL;
+    }
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+
+    if (pxCGroup == NULL) {
+        return pdFAIL;
+    }
+
+    /* Validate CPU weight range */
+    if ((ulCpuWeight < CGROUP_CPU_WEIGHT_MIN) || (ulCpuWeight > CGROUP_CPU_WEIGHT_MAX)) {
+        return pdFAIL;
+    }
+
+    portENTER_CRITICAL();
+    pxCGroup->xCpuLimits.ulCpuWeight = ulCpuWeight;
+    portEXIT_CRITICAL();
+
+    return pdPASS;
+}
+
+BaseType_t xCGroupSetParent(CGroupHandle_t xCGroup, CGroupHandle_t xParent) {
+    CGroup_t   *pxCGroup;
+    CGroup_t   *pxParent = NULL;
+    CGroup_t   *pxOldParent;
+    CGroup_t   *pxAncestor;
+    UBaseType_t uxDepth;
+    UBaseType_t ulUsed;
+
+    portENTER_CRITICAL();
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (xParent != NULL) {
+        pxParent = prvGetCGroupFromHandle(xParent);
+    }
+
+    if ((pxCGroup == NULL) || ((xParent != NULL) && (pxParent == NULL))) {
+        portEXIT_CRITICAL();
+        return pdFAIL;
+    }
+
+    pxOldParent = pxCGroup->pxParent;
+    if (pxOldParent == pxParent) {
+        portEXIT_CRITICAL();
+        return pdPASS;
+    }
+
+    /* A cgroup cannot move below itself or one of its children */
+    for (pxAncestor = pxParent; pxAncestor != NULL; pxAncestor = pxAncestor->pxParent) {
+        if (pxAncestor == pxCGroup) {
+            portEXIT_CRITICAL();
+            return pdFAIL;
+        }
+    }
+
+    uxDepth = (pxParent != NULL) ? (pxParent->uxDepth + 1U) : 0U;
+    if ((uxDepth + prvGetSubtreeHeight(pxCGroup)) >= (UBaseType_t)configCGROUP_MAX_DEPTH) {
+        portEXIT_CRITICAL();
+        return pdFAIL;
+    }
+
+    /* Move the charged memory, the new ancestors must have room for it */
+    ulUsed = pxCGroup->xMemoryLimits.ulMemoryUsed;
+    prvUnchargeMemory(pxOldParent, ulUsed);
+    if ((pxParent != NULL) && (prvMemoryFits(pxParent, ulUsed) == pdFALSE)) {
+        prvChargeMemory(pxOldParent, ulUsed, pdFALSE);
+        portEXIT_CRITICAL();
+        return pdFAIL;
+    }
+    prvChargeMemory(pxParent, ulUsed, pdFALSE);
+
+    if (pxOldParent != NULL) {
+        pxOldParent->uxChildCount--;
+    }
+    if (pxParent != NULL) {
+        pxParent->uxChildCount++;
+    }
+    pxCGroup->pxParent = pxParent;
+
+    prvRefreshHierarchy();
+
+    portEXIT_CRITICAL();
+
+    return pdPASS;
+}
+
+CGroupHandle_t xCGroupGetParent(CGroupHandle_t xCGroup) {
+    CGroup_t *pxCGroup;
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+    if (pxCGroup == NULL) {
+        return NULL;
+    }
+
+    return prvGetHandle(pxCGroup->pxParent);
+}
+
+BaseType_t xCGroupGetCpuTime(CGroupHandle_t xCGroup, uint64_t *pullCpuTimeUs) {
+    CGroup_t *pxCGroup;
+    uint64_t  ullCycles;
+
+    if ((xCGroup == NULL) || (pullCpuTimeUs == NULL)) {
+        return pdFAIL;
+    }
+
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
+
+    if (pxCGroup == NULL) {
+        return pdFAIL;
+    }
+
+    portENTER_CRITICAL();
+    ullCycles = pxCGroup->xCpuLimits.ullTotalCycles;
     portEXIT_CRITICAL();
 
+    *pullCpuTimeUs = ullCGroupCyclesToMicroseconds(ullCycles);
+
     return pdPASS;
 }
 
+uint64_t ullCGroupCyclesToMicroseconds(uint64_t ullCycles) {
+    uint64_t ullFrequency;
+
+    ullFrequency = configCGROUP_CYCLE_FREQUENCY();
+    if (ullFrequency == 0U) {
+        return 0U;
+    }
+
+    /* Split to avoid overflowing ullCycles * 1000000 on long runtimes */
+    return ((ullCycles / ullFrequency) * 1000000U) +
+           (((ullCycles % ullFrequency) * 1000000U) / ullFrequency);
+}
+
 CGroupHandle_t xCGroupGetTaskGroup(TaskHandle_t xTask) {
     CGroup_t *pxCGroup;
 
@@ -501,7 +1376,7 @@ CGroupHandle_t xCGroupGetTaskGroup(TaskHandle_t xTask) {
 
     pxCGroup = prvGetCGroupFromTask(xTask);
 
-    return (CGroupHandle_t)pxCGroup;
+    return prvGetHandle(pxCGroup);
 }
 
 BaseType_t xCGroupGetMemoryInfo(CGroupHandle_t xCGroup,
@@ -515,9 +1390,9 @@ BaseType_t xCGroupGetMemoryInfo(CGroupHandle_t xCGroup,
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
 
-    if (pxCGroup->xActive == pdFALSE) {
+    if (pxCGroup == NULL) {
         return pdFAIL;
     }
 
@@ -531,15 +1406,16 @@ BaseType_t xCGroupGetMemoryInfo(CGroupHandle_t xCGroup,
 }
 
 BaseType_t xCGroupResetMemoryStats(CGroupHandle_t xCGroup) {
-    CGroup_t *pxCGroup;
+    CGroup_t   *pxCGroup;
+    UBaseType_t uxBucket;
 
     if (xCGroup == NULL) {
         return pdFAIL;
     }
 
-    pxCGroup = (CGroup_t *)xCGroup;
+    pxCGroup = prvGetCGroupFromHandle(xCGroup);
 
-    if (pxCGroup->xActive == pdFALSE) {
+    if (pxCGroup == NULL) {
         return pdFAIL;
     }
 
@@ -547,23 +1423,42 @@ BaseType_t xCGroupResetMemoryStats(CGroupHandle_t xCGroup) {
     /* Reset current usage but keep the limit */
     pxCGroup->xMemoryLimits.ulMemoryUsed = 0U;
     pxCGroup->xMemoryLimits.ulMemoryPeak = 0U;
+    pxCGroup->xMemoryLimits.ulFailCount = 0U;
+    pxCGroup->xMemoryLimits.ulHighEvents = 0U;
+    for (uxBucket = 0U; uxBucket < CGROUP_MEMORY_HISTOGRAM_BUCKETS; uxBucket++) {
+        pxCGroup->xMemoryLimits.ulSizeHistogram[uxBucket] = 0U;
+    }
     portEXIT_CRITICAL();
 
     return pdPASS;
 }
 
+UBaseType_t uxCGroupGetCount(void) {
+    UBaseType_t uxCount = 0U;
+
+    portENTER_CRITICAL();
+    if (listLIST_IS_INITIALISED(&xActiveCGroups)) {
+        uxCount = listCURRENT_LIST_LENGTH(&xActiveCGroups);
+    }
+    portEXIT_CRITICAL();
+
+    return uxCount;
+}
+
 UBaseType_t xCGroupGetTotalMemoryUsage(void) {
-    BaseType_t  xIndex;
+    ListItem_t *pxItem;
     CGroup_t   *pxCGroup;
     UBaseType_t ulTotalUsage = 0U;
 
     portENTER_CRITICAL();
 
-    /* Sum up memory usage from all active cgroups */
-    for (xIndex = 0; xIndex < configMAX_CGROUPS; xIndex++) {
-        if ((uxCGroupBitmap & (1U << xIndex)) != 0U) {
-            pxCGroup = &xCGroups[xIndex];
-            if (pxCGroup->xActive == pdTRUE) {
+    /* Sum up memory usage from all active top level cgroups, their usage
+     * already includes the usage of the child cgroups */
+    if (listLIST_IS_INITIALISED(&xActiveCGroups)) {
+        for (pxItem = listGET_HEAD_ENTRY(&xActiveCGroups);
+             pxItem != listGET_END_MARKER(&xActiveCGroups); pxItem = listGET_NEXT(pxItem)) {
+            pxCGroup = (CGroup_t *)listGET_LIST_ITEM_OWNER(pxItem);
+            if (pxCGroup->pxParent == NULL) {
                 ulTotalUsage += pxCGroup->xMemoryLimits.ulMemoryUsed;
             }
         }
@@ -578,21 +1473,39 @@ UBaseType_t xCGroupGetTotalMemoryUsage(void) {
  * INTEGRATION FUNCTIONS
  *----------------------------------------------------------*/
 
-void prvCGroupTaskSwitchOut(TaskHandle_t xTask) {
-    CGroup_t *pxCGroup;
-
-    if (xTask == NULL) {
-        return;
-    }
+void prvCGroupChargeTask(TaskHandle_t xTask, uint64_t ullCycles) {
+    CGroup_t  *pxCGroup;
+    TickType_t xCurrentTime;
 
     pxCGroup = prvGetCGroupFromTask(xTask);
     if (pxCGroup == NULL) {
         return;
     }
 
-    /* Now that we're using tick-based accounting, the tick usage
-     * is updated in prvCGroupUpdateTick() for the currently running task */
-    /* This function is kept for potential future extensions */
+    xCurrentTime = xTaskGetTickCount();
+
+    /* Weights share a priority level between the cgroups tasks belong to */
+    pxCGroup->xCpuLimits.ullVirtualRuntime +=
+        (ullCycles * CGROUP_CPU_WEIGHT_DEFAULT) / pxCGroup->xCpuLimits.ulCpuWeight;
+    prvRunHeapRequeue(pxCGroup);
+
+    /* The runtime counts against the quota of the cgroup and every ancestor */
+    for (; pxCGroup != NULL; pxCGroup = pxCGroup->pxParent) {
+        prvRollCpuPeriod(pxCGroup, xCurrentTime);
+
+        pxCGroup->xCpuLimits.ullCyclesUsed += ullCycles;
+        pxCGroup->xCpuLimits.ullTotalCycles += ullCycles;
+
+        /* Out of quota, the scheduler parks the tasks below it from the next
+         * selection */
+        if ((pxCGroup->xThrottled == pdFALSE) &&
+            (pxCGroup->xCpuLimits.ulTicksQuota != CGROUP_NO_LIMIT) &&
+            (pxCGroup->xCpuLimits.ullCyclesUsed >= pxCGroup->xCpuLimits.ullCyclesQuota)) {
+            pxCGroup->xThrottled = pdTRUE;
+            pxCGroup->xCpuLimits.ulThrottleCount++;
+            prvArmPeriodTimer(pxCGroup);
+        }
+    }
 }
 
 BaseType_t prvCGroupCanTaskRun(TaskHandle_t xTask) {
@@ -608,55 +1521,166 @@ BaseType_t prvCGroupCanTaskRun(TaskHandle_t xTask) {
         return pdTRUE;
     }
 
-    /* Only check current state, don't update window here */
-    /* Window updates are handled centrally in prvCGroupUpdateTick() */
+    /* Throttling is decided when runtime is charged, the scheduler parks the
+     * tasks of a throttled cgroup, or of a cgroup below a throttled ancestor,
+     * until the period of the throttled cgroup refreshes. Frozen cgroups park
+     * their tasks the same way until they are thawed. */
+    for (; pxCGroup != NULL; pxCGroup = pxCGroup->pxParent) {
+        if (prvIsHeld(pxCGroup) != pdFALSE) {
+            return pdFALSE;
+        }
+    }
+
+    return pdTRUE;
+}
+
+List_t *prvCGroupGetThrottledList(void *pxCGroupHandle) {
+    CGroup_t *pxCGroup;
 
-    /* Check if task is in penalty period */
-    if (pxCGroup->xCpuLimits.ulPenaltyTicksLeft > 0U) {
-        return pdFALSE;
+    /* Park on the cgroup that stops the task, its refresh or thaw re-queues
+     * the task */
+    for (pxCGroup = (CGroup_t *)pxCGroupHandle; pxCGroup != NULL; pxCGroup = pxCGroup->pxParent) {
+        if (prvIsHeld(pxCGroup) != pdFALSE) {
+            return &(pxCGroup->xThrottledList);
+        }
     }
 
-    /* Check if current window has exceeded quota */
-    if ((pxCGroup->xCpuLimits.ulTicksQuota != CGROUP_NO_LIMIT) &&
-        (pxCGroup->xCpuLimits.ulTicksUsed >= pxCGroup->xCpuLimits.ulTicksQuota)) {
-        return pdFALSE;
+    return &(((CGroup_t *)pxCGroupHandle)->xThrottledList);
+}
+
+BaseType_t prvCGroupIsThrottledList(void *pxCGroupHandle, const List_t *pxList) {
+    CGroup_t *pxCGroup;
+
+    for (pxCGroup = (CGroup_t *)pxCGroupHandle; pxCGroup != NULL; pxCGroup = pxCGroup->pxParent) {
+        if (pxList == &(pxCGroup->xThrottledList)) {
+            return pdTRUE;
+        }
     }
 
-    return pdTRUE;
+    return pdFALSE;
+}
+
+void prvCGroupTaskReady(void *pxCGroupHandle, ListItem_t *pxReadyItem, UBaseType_t uxPriority) {
+    CGroup_t         *pxCGroup = (CGroup_t *)pxCGroupHandle;
+    CGroupRunQueue_t *pxQueue = pxCGroup->pxRunQueues[uxPriority];
+    uint64_t          ullFloor = ullVirtualRuntimeFloor[uxPriority];
+
+    /* Still queued from before it last left the ready lists */
+    if ((pxQueue != NULL) && (listLIST_ITEM_CONTAINER(pxReadyItem) == &(pxQueue->xReadyList))) {
+        return;
+    }
+    prvCGroupTaskUnready(pxCGroupHandle, pxReadyItem);
+
+    /* No queue at this priority, the task keeps its round robin turn */
+    if (pxQueue == NULL) {
+        return;
+    }
+
+    listINSERT_END(&(pxQueue->xReadyList), pxReadyItem);
+    if (pxQueue->uxRunHeapIndex != cgroupNOT_QUEUED) {
+        return;
+    }
+
+    /* An idle cgroup may lag the floor by one tick only */
+    if ((ullFloor > ullCyclesPerTick) &&
+        (pxCGroup->xCpuLimits.ullVirtualRuntime < (ullFloor - ullCyclesPerTick))) {
+        pxCGroup->xCpuLimits.ullVirtualRuntime = ullFloor - ullCyclesPerTick;
+        prvRunHeapRequeue(pxCGroup);
+    }
+
+    prvRunHeapPlace(uxPriority, uxRunHeapLength[uxPriority], pxCGroup);
+    uxRunHeapLength[uxPriority]++;
+    prvRunHeapSiftUp(uxPriority, pxQueue->uxRunHeapIndex);
+}
+
+void prvCGroupTaskUnready(void *pxCGroupHandle, ListItem_t *pxReadyItem) {
+    CGroup_t   *pxCGroup = (CGroup_t *)pxCGroupHandle;
+    List_t     *pxList = listLIST_ITEM_CONTAINER(pxReadyItem);
+    UBaseType_t uxPriority;
+
+    if (pxList == NULL) {
+        return;
+    }
+
+    /* The ready list is the first member of its run queue */
+    uxPriority = ((CGroupRunQueue_t *)pxList)->uxPriority;
+    if (uxListRemove(pxReadyItem) == (UBaseType_t)0) {
+        prvRunHeapRemove(uxPriority, pxCGroup);
+    }
+}
+
+List_t *prvCGroupGetRunList(UBaseType_t uxPriority) {
+    CGroup_t *pxCGroup;
+
+    if (uxRunHeapLength[uxPriority] == 0U) {
+        return NULL;
+    }
+
+    pxCGroup = pxRunHeaps[uxPriority * uxRunHeapCapacity];
+    if (pxCGroup->xCpuLimits.ullVirtualRuntime > ullVirtualRuntimeFloor[uxPriority]) {
+        ullVirtualRuntimeFloor[uxPriority] = pxCGroup->xCpuLimits.ullVirtualRuntime;
+    }
+
+    return &(pxCGroup->pxRunQueues[uxPriority]->xReadyList);
+}
+
+void prvCGroupReserveRunQueue(void *pxCGroupHandle, UBaseType_t uxPriority) {
+    if (pxCGroupHandle != NULL) {
+        /* Without the queue the task is scheduled by plain round robin */
+        (void)prvReserveRunQueue((CGroup_t *)pxCGroupHandle, uxPriority);
+    }
 }
 
-void prvCGroupUpdateTick(void) {
-    BaseType_t   xIndex;
-    CGroup_t    *pxCGroup;
-    TaskHandle_t xCurrentTask;
-    CGroup_t    *pxCurrentTaskCGroup;
+BaseType_t prvCGroupUpdateTick(void) {
+    List_t     *pxSlot;
+    ListItem_t *pxItem;
+    ListItem_t *pxNext;
+    CGroup_t   *pxCGroup;
+    TickType_t  xCurrentTime;
+    BaseType_t  xSwitchRequired = pdFALSE;
+
+    /* The running task was already charged its cycles by the kernel, count
+     * the tick for reporting and switch away if that used up a quota */
+    for (pxCGroup = prvGetCGroupFromTask(xTaskGetCurrentTaskHandle()); pxCGroup != NULL;
+         pxCGroup = pxCGroup->pxParent) {
+        pxCGroup->xCpuLimits.ulTicksUsed++;
 
-    /* Get the currently running task and update its cgroup's tick usage */
-    xCurrentTask = xTaskGetCurrentTaskHandle();
-    if (xCurrentTask != NULL) {
-        pxCurrentTaskCGroup = prvGetCGroupFromTask(xCurrentTask);
-        if (pxCurrentTaskCGroup != NULL) {
-            /* Increment tick usage for the currently running task's cgroup */
-            pxCurrentTaskCGroup->xCpuLimits.ulTicksUsed++;
+        if (prvIsHeld(pxCGroup) != pdFALSE) {
+            xSwitchRequired = pdTRUE;
         }
     }
 
-    /* Update all active cgroups - check windows less frequently to avoid constant resets */
-    /* Only check windows every 10 ticks to reduce overhead and provide stable statistics */
-    for (xIndex = 0; xIndex < configMAX_CGROUPS; xIndex++) {
-        if ((uxCGroupBitmap & (1U << xIndex)) != 0U) {
-            pxCGroup = &xCGroups[xIndex];
-            if (pxCGroup->xActive == pdTRUE) {
-                /* Update CPU window for this cgroup */
-                prvUpdateCpuWindow(pxCGroup);
+    /* No cgroup was created yet */
+    if (!listLIST_IS_INITIALISED(&xActiveCGroups)) {
+        return xSwitchRequired;
+    }
 
-                /* Reduce penalty if in penalty period */
-                if (pxCGroup->xCpuLimits.ulPenaltyTicksLeft > 0U) {
-                    pxCGroup->xCpuLimits.ulPenaltyTicksLeft--;
-                }
+    /* Refresh the throttled cgroups whose period ends now and re-queue their
+     * tasks. The slot also holds cgroups whose period ends a whole number of
+     * wheel turns later, those stay. */
+    xCurrentTime = xTaskGetTickCount();
+    pxSlot = &xPeriodWheel[xCurrentTime & cgroupPERIOD_WHEEL_MASK];
+    pxItem = listGET_HEAD_ENTRY(pxSlot);
+    while (pxItem != listGET_END_MARKER(pxSlot)) {
+        pxNext = listGET_NEXT(pxItem);
+
+        if ((xCurrentTime - listGET_LIST_ITEM_VALUE(pxItem)) < (portMAX_DELAY / 2U)) {
+            pxCGroup = (CGroup_t *)listGET_LIST_ITEM_OWNER(pxItem);
+            (void)uxListRemove(pxItem);
+            prvRollCpuPeriod(pxCGroup, xCurrentTime);
+
+            if (pxCGroup->xCpuLimits.ullCyclesUsed >= pxCGroup->xCpuLimits.ullCyclesQuota) {
+                /* Still in debt, stay throttled for this period */
+                prvArmPeriodTimer(pxCGroup);
+            } else if (prvUnthrottle(pxCGroup) != pdFALSE) {
+                xSwitchRequired = pdTRUE;
             }
         }
+
+        pxItem = pxNext;
     }
+
+    return xSwitchRequired;
 }
 
 #endif /* configUSE_CGROUPS == 1 */
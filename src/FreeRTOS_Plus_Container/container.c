@@ -18,6 +18,7 @@
 
 #ifdef configUSE_FILESYSTEM
 #include "file_system.h"
+#include "image_cache.h"
 #include "syscall.h"
 #endif
 
@@ -33,13 +34,171 @@ static SemaphoreHandle_t xContainerMutex = NULL;
 static TaskHandle_t      xContainerDaemonHandle = NULL;
 static uint32_t          ulNextContainerID = 1;
 
-static void container_wrap_function(void *param) {
-    ELF_WRAP *wrap = (ELF_WRAP *)param;
+/* Container registry: ID and name hash tables sharing one allocation and one bucket count. Both
+ * index the same containers as pxContainerList and are protected by xContainerMutex. */
+static Container_t **pxRegistryByID = NULL;
+static Container_t **pxRegistryByName = NULL;
+static uint32_t      ulRegistryBuckets = 0;
+static uint32_t      ulContainerCount = 0;
 
-    elf_load_and_run(wrap->elf_data, wrap->elf_size);
-    while (1) {
-        vTaskDelay(1000);
+/* Containers whose task is gone but whose exit the daemon has not handled yet. Pushed by
+ * vApplicationTaskDeleteHook() and popped with the container mutex held, both in a critical
+ * section. */
+static Container_t *pxExitedList = NULL;
+
+#ifdef configUSE_FILESYSTEM
+/* Serializes the one-shot load of CONTAINER_RUNTIME_LIBRARY, see prvLoadRuntimeLibrary() */
+static SemaphoreHandle_t xRuntimeLibraryMutex = NULL;
+static BaseType_t        xRuntimeLibraryTried = pdFALSE;
+#endif
+
+/* A parked container task and its wrapper parameters, see xContainerPoolSetSize() */
+typedef struct {
+    TaskHandle_t xTask;
+    void        *pvParams;
+} ContainerSlot_t;
+
+static ContainerSlot_t xPoolSlots[CONTAINER_POOL_MAX_SLOTS]; /* Parked slots come first */
+static UBaseType_t     uxPoolFree = 0;                        /* Parked slots in xPoolSlots */
+static UBaseType_t     uxPoolTarget = CONTAINER_POOL_SIZE;    /* Slots the daemon keeps parked */
+
+static void prvPoolFill(void);
+
+/* A task blocked in xContainerWait(), linked on the container it waits for */
+typedef struct ContainerWaiter {
+    TaskHandle_t            xTask;
+    volatile BaseType_t     xDone;   /* Set with the container mutex held when the wait ends */
+    BaseType_t              xResult; /* pdPASS if the container exited, pdFAIL if it was deleted */
+    struct ContainerWaiter *pxNext;
+} ContainerWaiter_t;
+
+#if (configUSE_TASK_DELETE_HOOK != 1)
+#error "Containers need configUSE_TASK_DELETE_HOOK set to 1 to notice task exits"
+#endif
+
+#if (configNUM_THREAD_LOCAL_STORAGE_POINTERS <= CONTAINER_TLS_INDEX)
+#error "configNUM_THREAD_LOCAL_STORAGE_POINTERS has no slot for CONTAINER_TLS_INDEX"
+#endif
+
+#if (configTASK_NOTIFICATION_ARRAY_ENTRIES <= CONTAINER_WAIT_NOTIFY_INDEX)
+#error "configTASK_NOTIFICATION_ARRAY_ENTRIES has no entry for CONTAINER_WAIT_NOTIFY_INDEX"
+#endif
+
+#if (CONTAINER_POOL_SIZE > CONTAINER_POOL_MAX_SLOTS)
+#error "CONTAINER_POOL_SIZE is larger than CONTAINER_POOL_MAX_SLOTS"
+#endif
+
+/* FNV-1a over the name as stored in Container_t, so long names hash like their truncated copy */
+static uint32_t prvHashName(const char *pcName) {
+    uint32_t ulHash = 2166136261UL;
+    size_t   xIndex;
+
+    for (xIndex = 0; xIndex < sizeof(((Container_t *)0)->pcContainerName) - 1; xIndex++) {
+        if (pcName[xIndex] == '\0') {
+            break;
+        }
+        ulHash ^= (uint8_t)pcName[xIndex];
+        ulHash *= 16777619UL;
+    }
+
+    return ulHash;
+}
+
+static void prvRegistryLink(Container_t *pxContainer) {
+    uint32_t ulMask = ulRegistryBuckets - 1;
+
+    pxContainer->pxNextByID = pxRegistryByID[pxContainer->ulContainerID & ulMask];
+    pxRegistryByID[pxContainer->ulContainerID & ulMask] = pxContainer;
+    pxContainer->pxNextByName = pxRegistryByName[pxContainer->ulNameHash & ulMask];
+    pxRegistryByName[pxContainer->ulNameHash & ulMask] = pxContainer;
+}
+
+/* Allocate bucket arrays of the given size and rehash every registered container into them.
+ * On allocation failure the current tables are kept, lookups just walk longer chains. */
+static BaseType_t prvRegistryResize(uint32_t ulBuckets) {
+    Container_t **pxBuckets;
+    Container_t  *pxContainer;
+
+    pxBuckets = (Container_t **)pvPortMalloc(2 * ulBuckets * sizeof(Container_t *));
+    if (pxBuckets == NULL) {
+        return pdFAIL;
+    }
+    memset(pxBuckets, 0, 2 * ulBuckets * sizeof(Container_t *));
+
+    if (pxRegistryByID != NULL) {
+        vPortFree(pxRegistryByID);
+    }
+    pxRegistryByID = pxBuckets;
+    pxRegistryByName = pxBuckets + ulBuckets;
+    ulRegistryBuckets = ulBuckets;
+
+    /* Relink oldest first so every chain keeps the newest container at its head, as inserting
+     * does, and a duplicated name keeps resolving to the most recently created container */
+    pxContainer = pxContainerList;
+    while (pxContainer != NULL && pxContainer->pxNext != NULL) {
+        pxContainer = pxContainer->pxNext;
+    }
+    while (pxContainer != NULL) {
+        prvRegistryLink(pxContainer);
+        pxContainer = pxContainer->pxPrev;
+    }
+
+    return pdPASS;
+}
+
+/* Add a container to the list and both hash tables. Called with xContainerMutex held. */
+static void prvRegistryInsert(Container_t *pxContainer) {
+    pxContainer->ulNameHash = prvHashName(pxContainer->pcContainerName);
+
+    pxContainer->pxPrev = NULL;
+    pxContainer->pxNext = pxContainerList;
+    if (pxContainerList != NULL) {
+        pxContainerList->pxPrev = pxContainer;
+    }
+    pxContainerList = pxContainer;
+    ulContainerCount++;
+
+    /* Keep the load factor at or below one */
+    if (ulContainerCount > ulRegistryBuckets) {
+        if (prvRegistryResize(ulRegistryBuckets * 2) == pdPASS) {
+            return; /* The rehash linked the new container too */
+        }
+    }
+    prvRegistryLink(pxContainer);
+}
+
+/* Remove a container from the list and both hash tables. Called with xContainerMutex held. */
+static void prvRegistryRemove(Container_t *pxContainer) {
+    uint32_t      ulMask = ulRegistryBuckets - 1;
+    Container_t **ppxLink;
+
+    ppxLink = &pxRegistryByID[pxContainer->ulContainerID & ulMask];
+    while (*ppxLink != NULL && *ppxLink != pxContainer) {
+        ppxLink = &(*ppxLink)->pxNextByID;
+    }
+    if (*ppxLink != NULL) {
+        *ppxLink = pxContainer->pxNextByID;
+    }
+
+    ppxLink = &pxRegistryByName[pxContainer->ulNameHash & ulMask];
+    while (*ppxLink != NULL && *ppxLink != pxContainer) {
+        ppxLink = &(*ppxLink)->pxNextByName;
+    }
+    if (*ppxLink != NULL) {
+        *ppxLink = pxContainer->pxNextByName;
+    }
+
+    if (pxContainer->pxPrev != NULL) {
+        pxContainer->pxPrev->pxNext = pxContainer->pxNext;
+    } else {
+        pxContainerList = pxContainer->pxNext;
+    }
+    if (pxContainer->pxNext != NULL) {
+        pxContainer->pxNext->pxPrev = pxContainer->pxPrev;
     }
+    pxContainer->pxNext = NULL;
+    pxContainer->pxPrev = NULL;
+    ulContainerCount--;
 }
 
 /* Helper function to convert uint32_t to string */
@@ -68,144 +227,407 @@ static void uint32_to_string(uint32_t value, char *buffer) {
     buffer[i] = '\0';
 }
 #ifdef configUSE_FILESYSTEM
-static int get_elf_by_name(ELF_WRAP *wrap, const char *name) {
-    FileSystem_t  *pxFS;
+/* An ELF file open for elf_load_and_run_stream() */
+typedef struct {
     LittleFSOps_t *lfs_ops;
     lfs_file_t     file;
-    char           file_path[128];
-    int            ret;
-    lfs_soff_t     file_size;
-    unsigned char *elf_buffer;
+    BaseType_t     xOpen;
+} ContainerElfFile_t;
 
-    if (wrap == NULL || name == NULL) {
-        return pdFAIL;
+static int prvElfFileRead(void *user, size_t offset, void *buf, size_t size) {
+    ContainerElfFile_t *pxFile = (ContainerElfFile_t *)user;
+
+    if (pxFile->lfs_ops->file_seek(&pxFile->file, (lfs_soff_t)offset, LFS_SEEK_SET) < 0) {
+        return -1;
     }
+    return (int)pxFile->lfs_ops->file_read(&pxFile->file, buf, (lfs_size_t)size);
+}
+
+/* Called by the loader once it has read everything, before the program runs */
+static void prvElfFileDone(void *user) {
+    ContainerElfFile_t *pxFile = (ContainerElfFile_t *)user;
+
+    if (pxFile->xOpen != pdFALSE) {
+        pxFile->lfs_ops->file_close(&pxFile->file);
+        pxFile->xOpen = pdFALSE;
+    }
+}
+
+/* Load and run an ELF file straight from the file system. Only the loaded program is held in
+ * memory, the loader reads headers, sections and tables from the file as it needs them. The
+ * program memory is recorded under pvOwner, see elf_release_owner(). */
+static BaseType_t prvElfRunFile(const char *pcPath, const void *pvOwner) {
+    FileSystem_t      *pxFS;
+    ContainerElfFile_t xFile;
+    ELF_READER         xReader;
+    lfs_soff_t         file_size;
 
-    /* Get file system instance */
     pxFS = pxGetFileSystem();
     if (pxFS == NULL || pxFS->fs_ops == NULL) {
         xil_printf("File system not initialized\r\n");
         return pdFAIL;
     }
+    xFile.lfs_ops = (LittleFSOps_t *)pxFS->fs_ops;
 
-    lfs_ops = (LittleFSOps_t *)pxFS->fs_ops;
+    if (xFile.lfs_ops->file_open(&xFile.file, pcPath, LFS_O_RDONLY) < 0) {
+        xil_printf("Failed to open ELF file: %s\r\n", pcPath);
+        return pdFAIL;
+    }
+    xFile.xOpen = pdTRUE;
+
+    file_size = xFile.lfs_ops->file_size(&xFile.file);
+    if (file_size <= 0) {
+        xil_printf("Invalid ELF file size\r\n");
+        prvElfFileDone(&xFile);
+        return pdFAIL;
+    }
+
+    xReader.read = prvElfFileRead;
+    xReader.done = prvElfFileDone;
+    xReader.user = &xFile;
+    xReader.size = (size_t)file_size;
+    xReader.owner = pvOwner;
+    (void)elf_load_and_run_stream(&xReader);
+
+    /* The loader closes the file before running the program, this only covers its failures */
+    prvElfFileDone(&xFile);
+    return pdPASS;
+}
+#else
+extern unsigned char data[];
+extern size_t data_size;
+static int get_elf_by_name(ELF_WRAP *wrap, const char *name) {
+    wrap->elf_data = data;
+    wrap->elf_size = data_size;
+    return pdTRUE;
+}
+#endif
+
+/* Get the container's image, containers running the same program share one cached copy */
+static BaseType_t prvContainerGetImage(Container_t *pxContainer) {
+#ifdef configUSE_FILESYSTEM
+    char file_path[sizeof(pxContainer->elfName) + 1];
 
-    /* build full path*/
     file_path[0] = '/';
-    strcpy(&file_path[1], name);
-#ifdef MY_DEBUG
-    // 输出/根目录所有文件信息（ls）
-    {
-        lfs_dir_t       dir;
-        struct lfs_info info;
-        int             res;
-
-        xil_printf("Listing root directory:\r\n");
-        res = lfs_ops->dir_open(&dir, "/");
-        if (res < 0) {
-            xil_printf("Failed to open root directory\r\n");
-            return pdFAIL;
-        }
+    strcpy(&file_path[1], pxContainer->elfName);
+    pxContainer->pvImage =
+        xImageCacheAcquire(file_path, &pxContainer->pucImage, &pxContainer->xImageSize);
+    if (pxContainer->pvImage == NULL) {
+        return pdFAIL;
+    }
+#else
+    ELF_WRAP wrap;
 
-        while (1) {
-            res = lfs_ops->dir_read(&dir, &info);
-            if (res < 0) {
-                xil_printf("Failed to read directory entry\r\n");
-                lfs_ops->dir_close(&dir);
-                return pdFAIL;
-            }
-            if (res == 0) {
-                /* End of directory */
-                break;
-            }
+    if (get_elf_by_name(&wrap, pxContainer->elfName) != pdPASS) {
+        return pdFAIL;
+    }
+    pxContainer->pucImage = wrap.elf_data;
+    pxContainer->xImageSize = wrap.elf_size;
+#endif
+    return pdPASS;
+}
+
+/* Drop the container's reference to its image */
+static void prvContainerFreeImage(Container_t *pxContainer) {
+#ifdef configUSE_FILESYSTEM
+    vImageCacheRelease((ImageHandle_t)pxContainer->pvImage);
+#endif
+    pxContainer->pvImage = NULL;
+    pxContainer->pucImage = NULL;
+    pxContainer->xImageSize = 0;
+}
+
+/* Header in front of each block a program allocates through the syscall table */
+typedef struct ContainerAlloc {
+    struct ContainerAlloc  *pxNext;
+    struct ContainerAlloc  *pxPrev;
+    struct ContainerAlloc **ppxList; /* List the block is on */
+    uintptr_t               uxTag;   /* containerALLOC_TAG() while the block is allocated */
+} ContainerAlloc_t;
+
+/* Tag binding a header to its address and list, so a pointer the program forged or already freed
+ * is refused without searching the list */
+#define containerALLOC_TAG(pxBlock, ppxList)                                                       \
+    ((uintptr_t)(pxBlock) ^ (uintptr_t)(ppxList) ^ (uintptr_t)0x43414C4CU)
+
+/* Header size rounded up so programs still get portBYTE_ALIGNMENT aligned memory */
+#define containerALLOC_HEADER_SIZE                                                                 \
+    ((sizeof(ContainerAlloc_t) + portBYTE_ALIGNMENT - 1) & ~((size_t)portBYTE_ALIGNMENT_MASK))
+
+/* Blocks of programs running outside any container, such as the run command */
+static ContainerAlloc_t *pxUnownedAllocations = NULL;
+
+/* List holding the blocks of the calling task, found through its thread local storage */
+static ContainerAlloc_t **prvAllocationList(void) {
+    Container_t *pxContainer =
+        (Container_t *)pvTaskGetThreadLocalStoragePointer(NULL, CONTAINER_TLS_INDEX);
+
+    return (pxContainer != NULL) ? &pxContainer->pxAllocations : &pxUnownedAllocations;
+}
+
+void *pvContainerMalloc(size_t xSize) {
+    ContainerAlloc_t **ppxList;
+    ContainerAlloc_t  *pxBlock;
 
-            xil_printf("%s %s\r\n", (info.type == LFS_TYPE_DIR) ? "DIR" : "FILE", info.name);
+    if (xSize == 0 || xSize > SIZE_MAX - containerALLOC_HEADER_SIZE) {
+        return NULL;
+    }
+
+    /* Allocate and link without a task switch, a task deleted in between would leak the block */
+    vTaskSuspendAll();
+    ppxList = prvAllocationList();
+    pxBlock = (ContainerAlloc_t *)pvPortMalloc(containerALLOC_HEADER_SIZE + xSize);
+    if (pxBlock != NULL) {
+        pxBlock->ppxList = ppxList;
+        pxBlock->uxTag = containerALLOC_TAG(pxBlock, ppxList);
+        pxBlock->pxPrev = NULL;
+        pxBlock->pxNext = *ppxList;
+        if (*ppxList != NULL) {
+            (*ppxList)->pxPrev = pxBlock;
         }
+        *ppxList = pxBlock;
+    }
+    (void)xTaskResumeAll();
+
+    return (pxBlock != NULL) ? (uint8_t *)pxBlock + containerALLOC_HEADER_SIZE : NULL;
+}
+
+void vContainerFree(void *pv) {
+    ContainerAlloc_t **ppxList;
+    ContainerAlloc_t  *pxBlock;
 
-        lfs_ops->dir_close(&dir);
+    if (pv == NULL || ((uintptr_t)pv & portBYTE_ALIGNMENT_MASK) != 0 ||
+        (uintptr_t)pv < containerALLOC_HEADER_SIZE) {
+        return;
     }
-#endif
+    pxBlock = (ContainerAlloc_t *)((uint8_t *)pv - containerALLOC_HEADER_SIZE);
 
-    /* Try to open the file */
-    ret = lfs_ops->file_open(&file, file_path, LFS_O_RDONLY);
-    if (ret < 0) {
-        xil_printf("Failed to open ELF file: %s\r\n", file_path);
-        return pdFAIL;
+    /* The pointer comes from the program, only free blocks tagged for the caller's own list */
+    vTaskSuspendAll();
+    ppxList = prvAllocationList();
+    if (pxBlock->ppxList == ppxList && pxBlock->uxTag == containerALLOC_TAG(pxBlock, ppxList)) {
+        if (pxBlock->pxPrev != NULL) {
+            pxBlock->pxPrev->pxNext = pxBlock->pxNext;
+        } else {
+            *ppxList = pxBlock->pxNext;
+        }
+        if (pxBlock->pxNext != NULL) {
+            pxBlock->pxNext->pxPrev = pxBlock->pxPrev;
+        }
+        pxBlock->uxTag = 0;
+        vPortFree(pxBlock);
     }
+    (void)xTaskResumeAll();
+}
 
-    /* Get file size */
-    file_size = lfs_ops->file_size(&file);
-    if (file_size <= 0) {
-        xil_printf("Invalid ELF file size\r\n");
-        lfs_ops->file_close(&file);
-        return pdFAIL;
+/* Free the blocks the container's program left allocated. Its task must be gone. */
+static void prvContainerFreeAllocations(Container_t *pxContainer) {
+    ContainerAlloc_t *pxBlock;
+
+    while (pxContainer->pxAllocations != NULL) {
+        pxBlock = pxContainer->pxAllocations;
+        pxContainer->pxAllocations = pxBlock->pxNext;
+        vPortFree(pxBlock);
     }
+}
 
-    /* Allocate memory for ELF data */
-    elf_buffer = (unsigned char *)pvPortMalloc((size_t)file_size);
-    if (elf_buffer == NULL) {
-        xil_printf("Failed to allocate memory for ELF\r\n");
-        lfs_ops->file_close(&file);
+#ifdef configUSE_FILESYSTEM
+/* Load a shared runtime library. The path is resolved against the caller's root and the library
+ * memory is charged to the caller, so this runs in system tasks, never in a container. */
+BaseType_t xContainerLoadLibrary(const char *pcPath) {
+    ImageHandle_t  xImage;
+    const uint8_t *pucData;
+    size_t         xSize;
+    int            lResult;
+
+    if (pcPath == NULL) {
         return pdFAIL;
     }
 
-    /* Read file content */
-    ret = lfs_ops->file_read(&file, elf_buffer, (lfs_size_t)file_size);
-    if (ret != file_size) {
-        xil_printf("Failed to read ELF file\r\n");
-        vPortFree(elf_buffer);
-        lfs_ops->file_close(&file);
+    /* The loader copies what it needs, the file is only held while it loads */
+    xImage = xImageCacheAcquire(pcPath, &pucData, &xSize);
+    if (xImage == NULL) {
         return pdFAIL;
     }
+    lResult = elf_library_load(pcPath, pucData, xSize);
+    vImageCacheRelease(xImage);
 
-    /* Assign to wrap structure */
-    wrap->elf_data = (const uint8_t *)elf_buffer;
-    wrap->elf_size = (unsigned int)file_size;
+    return (lResult == ELF_SUCCESS) ? pdPASS : pdFAIL;
+}
 
-    /* Close file */
-    lfs_ops->file_close(&file);
+/* Load CONTAINER_RUNTIME_LIBRARY once the file system is up, from the task starting the first
+ * container. Other starters wait on the mutex until the load is done, so no program is linked
+ * against a half loaded library. A missing library is not an error, programs then carry their
+ * own helpers. */
+static void prvLoadRuntimeLibrary(void) {
+    LittleFSOps_t  *lfs_ops;
+    struct lfs_info info;
 
-    xil_printf("Loaded ELF from: %s (%llu bytes)\r\n", file_path, (unsigned long long)file_size);
+    if (xSemaphoreTake(xRuntimeLibraryMutex, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
 
-    return pdPASS;
+    lfs_ops = pxGetLfsOps();
+    if (xRuntimeLibraryTried == pdFALSE && lfs_ops != NULL) {
+        xRuntimeLibraryTried = pdTRUE;
+        if (lfs_ops->stat(CONTAINER_RUNTIME_LIBRARY, &info) >= 0 &&
+            xContainerLoadLibrary(CONTAINER_RUNTIME_LIBRARY) != pdPASS) {
+            xil_printf("WARNING: Failed to load runtime library %s\r\n",
+                       CONTAINER_RUNTIME_LIBRARY);
+        }
+    }
+
+    xSemaphoreGive(xRuntimeLibraryMutex);
 }
+#endif
+
+/* Default container function, runs the container's ELF program. Returning ends the container
+ * task, see vContainerTaskWrapper(). */
+static void container_wrap_function(void *param) {
+    Container_t *pxContainer = (Container_t *)param;
+
+#ifdef configUSE_FILESYSTEM
+    /* Stream the program from its file when images are not cached, or when the cache cannot hold
+     * a copy. The file is read again on every start. */
+    if (pxContainer->pucImage == NULL &&
+        (CONTAINER_STREAM_IMAGES == 1 || prvContainerGetImage(pxContainer) != pdPASS)) {
+        char file_path[sizeof(pxContainer->elfName) + 1];
+
+        file_path[0] = '/';
+        strcpy(&file_path[1], pxContainer->elfName);
+        if (prvElfRunFile(file_path, pxContainer) != pdPASS) {
+            pxContainer->eExitState = CONTAINER_STATE_ERROR;
+        }
+        return;
+    }
 #else
-extern unsigned char data[];
-extern size_t data_size;
-static int get_elf_by_name(ELF_WRAP *wrap, const char *name) {
-    wrap->elf_data = data;
-    wrap->elf_size = data_size;
-    return pdTRUE;
+    /* Get the image on the first start only, later starts reuse it */
+    if (pxContainer->pucImage == NULL && prvContainerGetImage(pxContainer) != pdPASS) {
+        /* Failed to load ELF - cannot proceed */
+        pxContainer->eExitState = CONTAINER_STATE_ERROR;
+        return;
+    }
+#endif
+
+#ifdef configUSE_FILESYSTEM
+    /* The first start of a cached image leaves the relocated program with it, later starts copy
+     * that instead of relocating again */
+    elf_load_and_run_prepared(pxContainer->pucImage, pxContainer->xImageSize, pxContainer,
+                              pxImageCachePrepared((ImageHandle_t)pxContainer->pvImage));
+#else
+    elf_load_and_run_owned(pxContainer->pucImage, pxContainer->xImageSize, pxContainer);
+#endif
+}
+
+/* Called by vTaskDelete() for every task, in a critical section. A container task carries its
+ * container in thread local storage; queue the container for the daemon and wake it. */
+void vApplicationTaskDeleteHook(TaskHandle_t xTask) {
+    Container_t *pxContainer;
+
+    pxContainer = (Container_t *)pvTaskGetThreadLocalStoragePointer(xTask, CONTAINER_TLS_INDEX);
+    if (pxContainer == NULL || pxContainer->xExitPending != pdFALSE) {
+        return;
+    }
+
+    pxContainer->xExitPending = pdTRUE;
+    pxContainer->pxNextExited = pxExitedList;
+    pxExitedList = pxContainer;
+
+    if (xContainerDaemonHandle != NULL) {
+        vTaskNotifyGiveFromISR(xContainerDaemonHandle, NULL);
+    }
 }
+
+/* End the wait of every xContainerWait() caller. Called with xContainerMutex held. */
+static void prvWakeWaiters(Container_t *pxContainer, BaseType_t xResult) {
+    ContainerWaiter_t *pxWaiter = pxContainer->pxWaiters;
+    ContainerWaiter_t *pxNextWaiter;
+
+    pxContainer->pxWaiters = NULL;
+    while (pxWaiter != NULL) {
+        pxNextWaiter = pxWaiter->pxNext;
+        pxWaiter->xResult = xResult;
+        pxWaiter->xDone = pdTRUE;
+        (void)xTaskNotifyGiveIndexed(pxWaiter->xTask, CONTAINER_WAIT_NOTIFY_INDEX);
+        pxWaiter = pxNextWaiter;
+    }
+}
+
+/* Move a container whose task is gone to its exit state. Called with xContainerMutex held. */
+static void prvContainerReap(Container_t *pxContainer) {
+    Container_t **ppxLink;
+
+    taskENTER_CRITICAL();
+    ppxLink = &pxExitedList;
+    while (*ppxLink != NULL && *ppxLink != pxContainer) {
+        ppxLink = &(*ppxLink)->pxNextExited;
+    }
+    if (*ppxLink != NULL) {
+        *ppxLink = pxContainer->pxNextExited;
+    }
+    pxContainer->pxNextExited = NULL;
+    pxContainer->xExitPending = pdFALSE;
+    taskEXIT_CRITICAL();
+
+#if (configUSE_CGROUPS == 1)
+    /* Do not freeze the task of the next start */
+    if ((pxContainer->eState == CONTAINER_STATE_PAUSED) && (pxContainer->xCGroup != NULL)) {
+        (void)xCGroupThaw(pxContainer->xCGroup);
+    }
 #endif
 
-/* Container daemon task */
-void vContainerDaemonTask(void *pvParameters) {
-    TickType_t       xLastWakeTime;
-    const TickType_t xFrequency = pdMS_TO_TICKS(1000); /* Check every second */
+    /* A task deleted while its program ran never returned from the loader, free the program
+     * memory here. The heap credits it back to the container's cgroup. */
+    elf_release_owner(pxContainer);
+    prvContainerFreeAllocations(pxContainer);
+    vPortFree(pxContainer->pvTaskParams);
+    pxContainer->pvTaskParams = NULL;
 
-    (void)pvParameters;
+    pxContainer->eState = pxContainer->eExitState;
+    pxContainer->xTaskHandle = NULL;
+    prvWakeWaiters(pxContainer, pdPASS);
+}
+
+/* Look up a container with any exit of its task already handled, so callers never act on a task
+ * that is gone. Called with xContainerMutex held. */
+static Container_t *prvContainerGet(uint32_t ulContainerID) {
+    Container_t *pxContainer = pxContainerGetByID(ulContainerID);
+
+    if (pxContainer != NULL && pxContainer->xExitPending != pdFALSE) {
+        prvContainerReap(pxContainer);
+    }
+
+    return pxContainer;
+}
+
+/* Delete the task of a running or paused container. Called with xContainerMutex held. */
+static void prvContainerStop(Container_t *pxContainer) {
+    /* With the scheduler suspended the task cannot exit on its own while it is deleted */
+    vTaskSuspendAll();
+    if (pxContainer->xExitPending == pdFALSE) {
+        pxContainer->eExitState = CONTAINER_STATE_STOPPED;
+        vTaskDelete(pxContainer->xTaskHandle);
+    }
+    (void)xTaskResumeAll();
 
-    xLastWakeTime = xTaskGetTickCount();
+    /* The delete hook queued the exit, handle it here rather than in the daemon */
+    prvContainerReap(pxContainer);
+}
+
+/* Container daemon task, handles container exits as the delete hook reports them */
+void vContainerDaemonTask(void *pvParameters) {
+    (void)pvParameters;
 
     for (;;) {
-        /* Wait for the next cycle */
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        /* Check container health and manage lifecycle */
         if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
-            Container_t *pxContainer = pxContainerList;
-            while (pxContainer != NULL) {
-                if (pxContainer->eState == CONTAINER_STATE_RUNNING &&
-                    pxContainer->xTaskHandle != NULL) {
-                    /* Check if task is still running */
-                    if (eTaskGetState(pxContainer->xTaskHandle) == eDeleted) {
-                        pxContainer->eState = CONTAINER_STATE_STOPPED;
-                        pxContainer->xTaskHandle = NULL;
-                    }
-                }
-                pxContainer = pxContainer->pxNext;
+            while (pxExitedList != NULL) {
+                prvContainerReap(pxExitedList);
             }
+
+            /* Replace the slots xContainerStart() took */
+            prvPoolFill();
             xSemaphoreGive(xContainerMutex);
         }
     }
@@ -224,13 +646,40 @@ BaseType_t xContainerManagerInit(void) {
         return pdFAIL;
     }
 
+#ifdef configUSE_FILESYSTEM
+    xRuntimeLibraryMutex = xSemaphoreCreateMutex();
+    if (xRuntimeLibraryMutex == NULL) {
+        vSemaphoreDelete(xContainerMutex);
+        return pdFAIL;
+    }
+#endif
+
+    /* Allocate the registry hash tables */
+    if (prvRegistryResize(CONTAINER_REGISTRY_MIN_BUCKETS) != pdPASS) {
+#ifdef configUSE_FILESYSTEM
+        vSemaphoreDelete(xRuntimeLibraryMutex);
+#endif
+        vSemaphoreDelete(xContainerMutex);
+        return pdFAIL;
+    }
+
     /* Create container daemon task */
     if (xTaskCreate(vContainerDaemonTask, "ContainerDaemon", CONTAINER_DAEMON_STACK_SIZE, NULL,
                     CONTAINER_DAEMON_PRIORITY, &xContainerDaemonHandle) != pdPASS) {
+        vPortFree(pxRegistryByID);
+        pxRegistryByID = NULL;
+        pxRegistryByName = NULL;
+        ulRegistryBuckets = 0;
+#ifdef configUSE_FILESYSTEM
+        vSemaphoreDelete(xRuntimeLibraryMutex);
+#endif
         vSemaphoreDelete(xContainerMutex);
         return pdFAIL;
     }
 
+    /* Park the first pool slots, nothing else uses the container manager yet */
+    prvPoolFill();
+
     return pdPASS;
 }
 
@@ -277,14 +726,28 @@ BaseType_t xContainerCreateWithLimits(const char *pcName,
     pxNewContainer->ulStackSize = ulStackSize;
     pxNewContainer->uxPriority = uxPriority;
     pxNewContainer->ulMemoryLimit = ulMemoryLimit;
+    pxNewContainer->ulMemorySoftLimit = 0;
     pxNewContainer->ulCpuQuota = ulCpuQuota;
+    pxNewContainer->ulCpuWeight = 0;
     pxNewContainer->xCGroup = NULL;
     pxNewContainer->xPidNamespace = NULL;
     pxNewContainer->xIpcNamespace = NULL;
     pxNewContainer->pxNext = NULL;
+    pxNewContainer->pxPrev = NULL;
+    pxNewContainer->pxNextByID = NULL;
+    pxNewContainer->pxNextByName = NULL;
+    pxNewContainer->ulNameHash = 0;
     pxNewContainer->pxFunction = container_wrap_function;
     pxNewContainer->pvParameters = NULL;
-    pxNewContainer->xReadySemaphore = NULL;
+    pxNewContainer->pucImage = NULL;
+    pxNewContainer->xImageSize = 0;
+    pxNewContainer->pvImage = NULL;
+    pxNewContainer->pxAllocations = NULL;
+    pxNewContainer->pvTaskParams = NULL;
+    pxNewContainer->eExitState = CONTAINER_STATE_STOPPED;
+    pxNewContainer->xExitPending = pdFALSE;
+    pxNewContainer->pxNextExited = NULL;
+    pxNewContainer->pxWaiters = NULL;
     strcpy(pxNewContainer->elfName, elfName);
     const char *prefix_path = "/var/container/";
     char        idstr[12];
@@ -305,10 +768,16 @@ BaseType_t xContainerCreateWithLimits(const char *pcName,
 #if (configUSE_CGROUPS == 1)
     {
         /* Use appropriate defaults for unspecified limits */
-        UBaseType_t ulMemLimit =
-            (ulMemoryLimit > 0) ? ulMemoryLimit : 8192; /* Default 8KB like LowQuota example */
+        UBaseType_t ulStackWords =
+            (ulStackSize > CONTAINER_POOL_STACK_SIZE) ? ulStackSize : CONTAINER_POOL_STACK_SIZE;
+        UBaseType_t ulMemLimit = ulStackWords * sizeof(StackType_t) + CONTAINER_TASK_OVERHEAD +
+                                 CONTAINER_DEFAULT_PROGRAM_MEMORY;
+
+        if (ulMemoryLimit > 0) {
+            ulMemLimit = ulMemoryLimit;
+        }
         UBaseType_t ulCpuLimit =
-            (ulCpuQuota > 0) ? ulCpuQuota : 100; /* Default 100 ticks like examples */
+            (ulCpuQuota > 0) ? ulCpuQuota : 1000; /* Default 10% of each period */
 
         pxNewContainer->xCGroup = xCGroupCreate(pcCGroupName, ulMemLimit, ulCpuLimit);
         pxNewContainer->ulMemoryLimit = ulMemLimit;
@@ -338,10 +807,9 @@ BaseType_t xContainerCreateWithLimits(const char *pcName,
     }
 #endif
 
-    /* Add to container list */
+    /* Add to container registry */
     if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
-        pxNewContainer->pxNext = pxContainerList;
-        pxContainerList = pxNewContainer;
+        prvRegistryInsert(pxNewContainer);
         xSemaphoreGive(xContainerMutex);
         return pdPASS;
     }
@@ -374,47 +842,44 @@ typedef struct {
     Container_t        *pxContainer;
     ContainerFunction_t pxOriginalFunction;
     void               *pvOriginalParameters;
-    ELF_WRAP            wrap;
 } ContainerTaskParams_t;
 
+/* End the container task, vApplicationTaskDeleteHook() reports the exit to the daemon. The
+ * parameters are freed when the exit is reaped, like those of a task deleted from outside. */
+static void prvContainerTaskExit(ContainerTaskParams_t *pxParams, ContainerState_t eExitState) {
+    pxParams->pxContainer->eExitState = eExitState;
+    vTaskDelete(NULL);
+}
+
 static void vContainerTaskWrapper(void *pvParameters) {
     ContainerTaskParams_t *pxParams = (ContainerTaskParams_t *)pvParameters;
-    Container_t           *pxContainer = pxParams->pxContainer;
-    ContainerFunction_t    pxOriginalFunction = pxParams->pxOriginalFunction;
-    void                  *pvOriginalParameters = pxParams->pvOriginalParameters;
+    Container_t           *pxContainer;
 
-    /* Wait for container isolation setup to complete before proceeding */
-    if (pxContainer->xReadySemaphore != NULL) {
-        xSemaphoreTake(pxContainer->xReadySemaphore, portMAX_DELAY);
-        /* Delete the semaphore after use - no longer needed */
-        vSemaphoreDelete(pxContainer->xReadySemaphore);
-        pxContainer->xReadySemaphore = NULL;
-    }
+    /* Wait until xContainerStart() has bound the task to a container and finished the isolation
+     * setup. Pooled tasks are parked here until a container takes them. */
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    pxContainer = pxParams->pxContainer;
+
+    /* Verify that all isolation mechanisms are in place before running user code */
+    TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
+    (void)xCurrentTask;
 
-/* CRITICAL: Apply IPC namespace isolation - following ipcnamespace_example pattern */
 #if (configUSE_IPC_NAMESPACE == 1)
-    if (pxContainer->xIpcNamespace != NULL) {
-        BaseType_t xIpcResult = xIpcNamespaceSetTaskNamespace(NULL, pxContainer->xIpcNamespace);
-        if (xIpcResult != pdPASS) {
-            /* IPC namespace application failed - this is critical for isolation */
-            /* Task should terminate as it cannot provide proper isolation */
-            pxContainer->eState = CONTAINER_STATE_ERROR;
-            vTaskDelete(NULL); /* Delete self */
-            return;
-        }
+    /* Verify IPC namespace membership */
+    if ((pxContainer->xIpcNamespace != NULL) &&
+        (xIpcNamespaceGetTaskNamespace(xCurrentTask) != pxContainer->xIpcNamespace)) {
+        prvContainerTaskExit(pxParams, CONTAINER_STATE_ERROR);
+        return;
     }
 #endif
 
-/* Verify that all isolation mechanisms are in place before running user code */
 #if (configUSE_CGROUPS == 1)
     /* Verify CGroup membership */
-    TaskHandle_t xCurrentTask = xTaskGetCurrentTaskHandle();
     if (pxContainer->xCGroup != NULL) {
         CGroupHandle_t xTaskCGroup = xCGroupGetTaskGroup(xCurrentTask);
         if (xTaskCGroup != pxContainer->xCGroup) {
             /* CGroup isolation verification failed */
-            pxContainer->eState = CONTAINER_STATE_ERROR;
-            vTaskDelete(NULL);
+            prvContainerTaskExit(pxParams, CONTAINER_STATE_ERROR);
             return;
         }
     }
@@ -426,8 +891,7 @@ static void vContainerTaskWrapper(void *pvParameters) {
         PidNamespaceHandle_t xTaskNamespace = xPidNamespaceGetTaskNamespace(xCurrentTask);
         if (xTaskNamespace != pxContainer->xPidNamespace) {
             /* PID namespace isolation verification failed */
-            pxContainer->eState = CONTAINER_STATE_ERROR;
-            vTaskDelete(NULL);
+            prvContainerTaskExit(pxParams, CONTAINER_STATE_ERROR);
             return;
         }
     }
@@ -436,122 +900,234 @@ static void vContainerTaskWrapper(void *pvParameters) {
 #ifdef configUSE_FILESYSTEM
     // chroot to container root fs if needed
     if (xTaskChroot(pxContainer->pcRootPath) != pdPASS) {
-        pxContainer->eState = CONTAINER_STATE_ERROR;
 #ifdef MY_DEBUG
         xil_printf("ERROR: Failed to chroot to %s\r\n", pxContainer->pcRootPath);
 #endif
-        vTaskDelete(NULL);
+        prvContainerTaskExit(pxParams, CONTAINER_STATE_ERROR);
         return;
     }
 #endif
-    // Load ELF from file system
-    if (get_elf_by_name(&pxParams->wrap, pxContainer->elfName) != pdPASS) {
-        /* Failed to load ELF - cannot proceed */
-        pxContainer->eState = CONTAINER_STATE_ERROR;
-        vTaskDelete(NULL);
-        return;
-    }
     /* All isolation mechanisms verified - now call the original function */
-    pxOriginalFunction(pvOriginalParameters);
-    vPortFree(pxParams);
-    for(;;) {
-        
+    pxParams->pxOriginalFunction(pxParams->pvOriginalParameters);
+
+    /* The container function has completed, it may have reported an error */
+    prvContainerTaskExit(pxParams, pxContainer->eExitState);
+}
+
+/* Park tasks until the pool holds uxPoolTarget slots. Called with xContainerMutex held. */
+static void prvPoolFill(void) {
+    ContainerTaskParams_t *pxParams;
+    TaskHandle_t           xTask;
+
+    while (uxPoolFree < uxPoolTarget) {
+        pxParams = (ContainerTaskParams_t *)pvPortMalloc(sizeof(ContainerTaskParams_t));
+        if (pxParams == NULL) {
+            break;
+        }
+        memset(pxParams, 0, sizeof(ContainerTaskParams_t));
+
+        if (xTaskCreate(vContainerTaskWrapper, "CtSlot", CONTAINER_POOL_STACK_SIZE, pxParams,
+                        CONTAINER_POOL_PRIORITY, &xTask) != pdPASS) {
+            vPortFree(pxParams);
+            break;
+        }
+
+        xPoolSlots[uxPoolFree].xTask = xTask;
+        xPoolSlots[uxPoolFree].pvParams = pxParams;
+        uxPoolFree++;
     }
-    /* If we reach here, the container function has completed */
-    /* Mark container as stopped */
-    pxContainer->eState = CONTAINER_STATE_STOPPED;
-    pxContainer->xTaskHandle = NULL;
 }
 
+/* Put a container task in the container's cgroup and IPC namespace. The task is still blocked in
+ * vContainerTaskWrapper(), so it runs no code outside them. Called with xContainerMutex held. */
+static BaseType_t prvContainerBindTask(Container_t *pxContainer, TaskHandle_t xTask) {
+#if (configUSE_CGROUPS == 1)
+    if ((pxContainer->xCGroup != NULL) && (xCGroupAddTask(pxContainer->xCGroup, xTask) != pdPASS)) {
+        return pdFAIL;
+    }
+#endif
+
+#if (configUSE_IPC_NAMESPACE == 1)
+    if ((pxContainer->xIpcNamespace != NULL) &&
+        (xIpcNamespaceSetTaskNamespace(xTask, pxContainer->xIpcNamespace) != pdPASS)) {
+        return pdFAIL;
+    }
+#endif
+
+    (void)pxContainer;
+    (void)xTask;
+    return pdPASS;
+}
+
+/* Turn a parked task into the container's task before it is released, so it ends up as a created
+ * task would: its TCB and stack charged to the container cgroup, in the PID namespace, the cgroup
+ * and the IPC namespace, named after the container and at its priority. A slot that cannot be
+ * bound is deleted and the caller creates the task instead. Called with xContainerMutex held. */
+static BaseType_t prvPoolTake(Container_t *pxContainer, ContainerTaskParams_t **ppxParams) {
+    ContainerSlot_t *pxSlot;
+    BaseType_t       xResult = pdPASS;
+
+    if ((uxPoolFree == 0) || (pxContainer->ulStackSize > CONTAINER_POOL_STACK_SIZE)) {
+        return pdFAIL;
+    }
+
+    uxPoolFree--;
+    pxSlot = &xPoolSlots[uxPoolFree];
+
+    /* Let the daemon replace the slot */
+    (void)xTaskNotifyGive(xContainerDaemonHandle);
+
+#if (configUSE_CGROUPS == 1)
+    if (pxContainer->xCGroup != NULL) {
+        xResult = xTaskMoveCGroupMemoryCharge(pxSlot->xTask, pxContainer->xCGroup);
+    }
+#endif
+
+#if (configUSE_PID_NAMESPACE == 1)
+    if ((xResult == pdPASS) && (pxContainer->xPidNamespace != NULL)) {
+        xResult = xPidNamespaceAddTask(pxContainer->xPidNamespace, pxSlot->xTask);
+    }
+#endif
+
+    if (xResult == pdPASS) {
+        xResult = prvContainerBindTask(pxContainer, pxSlot->xTask);
+    }
+
+    if (xResult != pdPASS) {
+        vTaskDelete(pxSlot->xTask);
+        vPortFree(pxSlot->pvParams);
+        return pdFAIL;
+    }
+
+    vTaskSetName(pxSlot->xTask, pxContainer->pcContainerName);
+    vTaskPrioritySet(pxSlot->xTask, pxContainer->uxPriority);
+    pxContainer->xTaskHandle = pxSlot->xTask;
+    *ppxParams = (ContainerTaskParams_t *)pxSlot->pvParams;
+
+    return pdPASS;
+}
+
+/* Create the task of a container. Called with xContainerMutex held. */
+static BaseType_t prvContainerCreateTask(Container_t           *pxContainer,
+                                         ContainerTaskParams_t *pxParams) {
+    BaseType_t xResult;
+
+#if (configUSE_CGROUPS == 1)
+    /* Charge the container task's TCB and stack to the container cgroup rather
+     * than to the cgroup of the task starting it */
+    CGroupHandle_t xPreviousChargeTarget = xCGroupSetMemoryChargeTarget(pxContainer->xCGroup);
+#endif
+
+/* Create task for container - ensuring proper namespace application */
+#if (configUSE_PID_NAMESPACE == 1)
+    /* Create task in PID namespace if available - following pidnamespace_example pattern */
+    if (pxContainer->xPidNamespace != NULL) {
+        xResult = xTaskCreateInNamespace(pxContainer->xPidNamespace, vContainerTaskWrapper,
+                                         pxContainer->pcContainerName, pxContainer->ulStackSize,
+                                         pxParams, pxContainer->uxPriority,
+                                         &pxContainer->xTaskHandle);
+    } else
+#endif
+    {
+        /* Fallback to regular task creation */
+        xResult = xTaskCreate(vContainerTaskWrapper, pxContainer->pcContainerName,
+                              pxContainer->ulStackSize, pxParams, pxContainer->uxPriority,
+                              &pxContainer->xTaskHandle);
+    }
+
+#if (configUSE_CGROUPS == 1)
+    (void)xCGroupSetMemoryChargeTarget(xPreviousChargeTarget);
+#endif
+
+    if ((xResult == pdPASS) &&
+        (prvContainerBindTask(pxContainer, pxContainer->xTaskHandle) != pdPASS)) {
+        vTaskDelete(pxContainer->xTaskHandle);
+        pxContainer->xTaskHandle = NULL;
+        xResult = pdFAIL;
+    }
+
+    return xResult;
+}
+
+/* Set how many pre-created tasks the pool keeps parked, 0 disables the pool. The pool is filled
+ * or drained before returning. */
+BaseType_t xContainerPoolSetSize(UBaseType_t uxSlots) {
+    if (uxSlots > CONTAINER_POOL_MAX_SLOTS) {
+        return pdFAIL;
+    }
+
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) != pdTRUE) {
+        return pdFAIL;
+    }
+
+    uxPoolTarget = uxSlots;
+    while (uxPoolFree > uxPoolTarget) {
+        uxPoolFree--;
+        vTaskDelete(xPoolSlots[uxPoolFree].xTask);
+        vPortFree(xPoolSlots[uxPoolFree].pvParams);
+    }
+    prvPoolFill();
+
+    xSemaphoreGive(xContainerMutex);
+    return pdPASS;
+}
+
+/* Get the number of parked tasks in the pool */
+UBaseType_t uxContainerPoolGetFree(void) { return uxPoolFree; }
+
 /* Start a container */
 BaseType_t xContainerStart(uint32_t ulContainerID) {
     Container_t           *pxContainer;
     BaseType_t             xResult = pdFAIL;
-    ContainerTaskParams_t *pxTaskParams;
+    ContainerTaskParams_t *pxTaskParams = NULL;
+#ifdef MY_DEBUG
     xil_printf("Starting container...\r\n");
+#endif
+
+#ifdef configUSE_FILESYSTEM
+    /* Before the program links against it, and outside the container mutex: loading reads the
+     * file. Waits while another starter is loading it. */
+    prvLoadRuntimeLibrary();
+#endif
 
     if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
-        pxContainer = pxContainerGetByID(ulContainerID);
+        pxContainer = prvContainerGet(ulContainerID);
         if (pxContainer != NULL && pxContainer->eState == CONTAINER_STATE_STOPPED) {
-            /* Allocate parameters for wrapper function */
-            pxTaskParams = (ContainerTaskParams_t *)pvPortMalloc(sizeof(ContainerTaskParams_t));
-            if (pxTaskParams == NULL) {
-                xSemaphoreGive(xContainerMutex);
-                xil_printf("ERROR: Failed to allocate task parameters.\r\n");
-                return pdFAIL;
-            }
-
-            pxTaskParams->pxContainer = pxContainer;
-            pxTaskParams->pxOriginalFunction = pxContainer->pxFunction;
-            pxTaskParams->pvOriginalParameters = &pxTaskParams->wrap;
-            pxTaskParams->wrap.elf_data = NULL;
-            pxTaskParams->wrap.elf_size = 0;
-
-            /* Create a binary semaphore to synchronize task startup */
-            pxContainer->xReadySemaphore = xSemaphoreCreateBinary();
-            if (pxContainer->xReadySemaphore == NULL) {
-                vPortFree(pxTaskParams);
-                xSemaphoreGive(xContainerMutex);
-                xil_printf("ERROR: Failed to create ready semaphore.\r\n");
-                return pdFAIL;
-            }
+            /* Take a parked task from the pool, create one if none fits */
+            xResult = prvPoolTake(pxContainer, &pxTaskParams);
+            if (xResult != pdPASS) {
+                /* Allocate parameters for wrapper function */
+                pxTaskParams =
+                    (ContainerTaskParams_t *)pvPortMalloc(sizeof(ContainerTaskParams_t));
+                if (pxTaskParams == NULL) {
+                    xSemaphoreGive(xContainerMutex);
+                    xil_printf("ERROR: Failed to allocate task parameters.\r\n");
+                    return pdFAIL;
+                }
 
-/* Create task for container - ensuring proper namespace application */
-#if (configUSE_PID_NAMESPACE == 1)
-            /* Create task in PID namespace if available - following pidnamespace_example pattern */
-            if (pxContainer->xPidNamespace != NULL) {
-                xResult = xTaskCreateInNamespace(
-                    pxContainer->xPidNamespace, vContainerTaskWrapper, pxContainer->pcContainerName,
-                    pxContainer->ulStackSize, pxTaskParams, pxContainer->uxPriority,
-                    &pxContainer->xTaskHandle);
-            } else
-#endif
-            {
-                /* Fallback to regular task creation */
-                xResult = xTaskCreate(vContainerTaskWrapper, pxContainer->pcContainerName,
-                                      pxContainer->ulStackSize, pxTaskParams,
-                                      pxContainer->uxPriority, &pxContainer->xTaskHandle);
+                xResult = prvContainerCreateTask(pxContainer, pxTaskParams);
             }
 
             if (xResult == pdPASS) {
-/* CRITICAL: Apply all isolation mechanisms to the newly created task */
+                pxTaskParams->pxContainer = pxContainer;
+                pxTaskParams->pxOriginalFunction = pxContainer->pxFunction;
+                pxTaskParams->pvOriginalParameters = pxContainer;
+                pxContainer->pvTaskParams = pxTaskParams;
 
-/* 1. Add task to CGroup FIRST - following cgroup_example pattern */
-#if (configUSE_CGROUPS == 1)
-                if (pxContainer->xCGroup != NULL && pxContainer->xTaskHandle != NULL) {
-                    BaseType_t xCGroupResult =
-                        xCGroupAddTask(pxContainer->xCGroup, pxContainer->xTaskHandle);
-                    if (xCGroupResult != pdPASS) {
-                        /* CGroup application failed - this is serious for resource isolation */
-                        pxContainer->eState = CONTAINER_STATE_ERROR;
-                        vTaskDelete(pxContainer->xTaskHandle);
-                        pxContainer->xTaskHandle = NULL;
-                        if (pxContainer->xReadySemaphore != NULL) {
-                            vSemaphoreDelete(pxContainer->xReadySemaphore);
-                            pxContainer->xReadySemaphore = NULL;
-                        }
-                        vPortFree(pxTaskParams);
-                        xSemaphoreGive(xContainerMutex);
-                        xil_printf("ERROR: Failed to add task to CGroup.\r\n");
-                        return pdFAIL;
-                    }
-                }
-#endif
+                /* The task is already in the container's namespaces and cgroup */
 
-                /* 3. IPC namespace will be applied by the wrapper function when task starts */
-                /* This is correct since IPC namespace must be set from within the task context */
+                /* Let the delete hook find the container once the task is gone */
+                pxContainer->eExitState = CONTAINER_STATE_STOPPED;
+                vTaskSetThreadLocalStoragePointer(pxContainer->xTaskHandle, CONTAINER_TLS_INDEX,
+                                                  pxContainer);
 
                 pxContainer->eState = CONTAINER_STATE_RUNNING;
 
-                /* All isolation setup complete - release the semaphore to let task proceed */
-                xSemaphoreGive(pxContainer->xReadySemaphore);
+                /* All isolation setup complete - notify the task to proceed */
+                (void)xTaskNotifyGive(pxContainer->xTaskHandle);
             } else {
-                /* Task creation failed, free parameters and semaphore */
+                /* Task creation failed, free parameters */
                 xil_printf("ERROR: Failed to create container task.\r\n");
-                if (pxContainer->xReadySemaphore != NULL) {
-                    vSemaphoreDelete(pxContainer->xReadySemaphore);
-                    pxContainer->xReadySemaphore = NULL;
-                }
                 vPortFree(pxTaskParams);
             }
         }
@@ -560,7 +1136,9 @@ BaseType_t xContainerStart(uint32_t ulContainerID) {
         xil_printf("ERROR: Failed to acquire container mutex.\r\n");
     }
 
+#ifdef MY_DEBUG
     xil_printf("Container start result: %d\r\n", (int)xResult);
+#endif
     return xResult;
 }
 
@@ -570,13 +1148,10 @@ BaseType_t xContainerStop(uint32_t ulContainerID) {
     BaseType_t   xResult = pdFAIL;
 
     if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
-        pxContainer = pxContainerGetByID(ulContainerID);
-        if (pxContainer != NULL && pxContainer->eState == CONTAINER_STATE_RUNNING) {
-            /* For now, just mark as stopped. In a full implementation,
-               you would gracefully stop the task with vTaskDelete */
-            pxContainer->eState = CONTAINER_STATE_STOPPED;
-            vTaskDelete(pxContainer->xTaskHandle);
-            pxContainer->xTaskHandle = NULL;
+        pxContainer = prvContainerGet(ulContainerID);
+        if (pxContainer != NULL && (pxContainer->eState == CONTAINER_STATE_RUNNING ||
+                                    pxContainer->eState == CONTAINER_STATE_PAUSED)) {
+            prvContainerStop(pxContainer);
             xResult = pdPASS;
         }
         xSemaphoreGive(xContainerMutex);
@@ -585,109 +1160,235 @@ BaseType_t xContainerStop(uint32_t ulContainerID) {
     return xResult;
 }
 
+/* Pause a container, its tasks keep their state and the loaded program */
+BaseType_t xContainerPause(uint32_t ulContainerID) {
+    Container_t *pxContainer;
+    BaseType_t   xResult = pdFAIL;
+
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
+        pxContainer = prvContainerGet(ulContainerID);
+        if (pxContainer != NULL && pxContainer->eState == CONTAINER_STATE_RUNNING) {
+#if (configUSE_CGROUPS == 1)
+            if (pxContainer->xCGroup != NULL) {
+                /* The freezer stops every task of the container at once */
+                xResult = xCGroupFreeze(pxContainer->xCGroup);
+            } else
+#endif
+            {
+                /* No CGroup, the container only has its main task */
+                vTaskSuspend(pxContainer->xTaskHandle);
+                xResult = pdPASS;
+            }
+
+            if (xResult == pdPASS) {
+                pxContainer->eState = CONTAINER_STATE_PAUSED;
+            }
+        }
+        xSemaphoreGive(xContainerMutex);
+    }
+
+    return xResult;
+}
+
+/* Resume a container paused with xContainerPause() */
+BaseType_t xContainerResume(uint32_t ulContainerID) {
+    Container_t *pxContainer;
+    BaseType_t   xResult = pdFAIL;
+
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
+        pxContainer = prvContainerGet(ulContainerID);
+        if (pxContainer != NULL && pxContainer->eState == CONTAINER_STATE_PAUSED) {
+#if (configUSE_CGROUPS == 1)
+            if (pxContainer->xCGroup != NULL) {
+                xResult = xCGroupThaw(pxContainer->xCGroup);
+            } else
+#endif
+            {
+                vTaskResume(pxContainer->xTaskHandle);
+                xResult = pdPASS;
+            }
+
+            if (xResult == pdPASS) {
+                pxContainer->eState = CONTAINER_STATE_RUNNING;
+            }
+        }
+        xSemaphoreGive(xContainerMutex);
+    }
+
+    return xResult;
+}
+
 /* Delete a container - following cleanup patterns from examples */
 BaseType_t xContainerDelete(uint32_t ulContainerID) {
-    Container_t *pxContainer, *pxPrevContainer = NULL;
+    Container_t *pxContainer;
     BaseType_t   xResult = pdFAIL;
 
     if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
-        /* Find the container in the list */
-        pxContainer = pxContainerList;
-        while (pxContainer != NULL) {
-            if (pxContainer->ulContainerID == ulContainerID) {
-                /* Make sure container is stopped first */
-                if (pxContainer->eState == CONTAINER_STATE_RUNNING) {
-                    /* Stop the container first */
-                    xContainerStop(ulContainerID);
-                }
+        pxContainer = prvContainerGet(ulContainerID);
+        if (pxContainer != NULL) {
+            /* Make sure container is stopped first */
+            if (pxContainer->eState == CONTAINER_STATE_RUNNING ||
+                pxContainer->eState == CONTAINER_STATE_PAUSED) {
+                /* Stop the container first */
+                prvContainerStop(pxContainer);
+            }
 
-                /* Remove from list */
-                if (pxPrevContainer == NULL) {
-                    pxContainerList = pxContainer->pxNext;
-                } else {
-                    pxPrevContainer->pxNext = pxContainer->pxNext;
-                }
+            /* Remove from registry, nobody can wait for the container any more */
+            prvRegistryRemove(pxContainer);
+            prvWakeWaiters(pxContainer, pdFAIL);
+
+            /* Free the image while its cgroup still exists to take the uncharge */
+            prvContainerFreeImage(pxContainer);
+
+#if (configUSE_IPC_NAMESPACE == 1)
+            /* Queues and semaphores the program created through the syscall table, also charged
+             * to the cgroup */
+            if (pxContainer->xIpcNamespace != NULL) {
+                (void)uxIpcNamespaceDeleteObjects(pxContainer->xIpcNamespace);
+            }
+#endif
+            /* Memory the program allocated through the syscall table, charged the same way */
+            prvContainerFreeAllocations(pxContainer);
 
 /* Cleanup resources - following cgroup_example and pidnamespace_example cleanup patterns */
 #if (configUSE_CGROUPS == 1)
-                if (pxContainer->xCGroup != NULL) {
-                    xCGroupDelete(pxContainer->xCGroup);
-                    pxContainer->xCGroup = NULL;
-                }
+            if (pxContainer->xCGroup != NULL) {
+                xCGroupDelete(pxContainer->xCGroup);
+                pxContainer->xCGroup = NULL;
+            }
+#endif
+
+#if (configUSE_PID_NAMESPACE == 1)
+            if (pxContainer->xPidNamespace != NULL) {
+                xPidNamespaceDelete(pxContainer->xPidNamespace);
+                pxContainer->xPidNamespace = NULL;
+            }
 #endif
 
-#if (configUSE_PID_NAMESPACE == 1)
-                if (pxContainer->xPidNamespace != NULL) {
-                    xPidNamespaceDelete(pxContainer->xPidNamespace);
-                    pxContainer->xPidNamespace = NULL;
-                }
-#endif
+#if (configUSE_IPC_NAMESPACE == 1)
+            if (pxContainer->xIpcNamespace != NULL) {
+                xIpcNamespaceDelete(pxContainer->xIpcNamespace);
+                pxContainer->xIpcNamespace = NULL;
+            }
+#endif
+
+            /* Free container memory */
+            vPortFree(pxContainer);
+            xResult = pdPASS;
+        }
+        xSemaphoreGive(xContainerMutex);
+    }
+
+    return xResult;
+}
+
+/* Block until a running or paused container has stopped, by exit, fault or xContainerStop().
+ * Returns pdPASS once the container is stopped or in error, pdFAIL on timeout or if the container
+ * does not exist or is deleted while waiting. */
+BaseType_t xContainerWait(uint32_t ulContainerID, TickType_t xTicksToWait) {
+    Container_t      *pxContainer;
+    ContainerWaiter_t xWaiter;
+    TimeOut_t         xTimeOut;
+
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) != pdTRUE) {
+        return pdFAIL;
+    }
+
+    pxContainer = prvContainerGet(ulContainerID);
+    if (pxContainer == NULL) {
+        xSemaphoreGive(xContainerMutex);
+        return pdFAIL;
+    }
+    if (pxContainer->eState != CONTAINER_STATE_RUNNING &&
+        pxContainer->eState != CONTAINER_STATE_PAUSED) {
+        xSemaphoreGive(xContainerMutex);
+        return pdPASS;
+    }
+    if (xTicksToWait == 0) {
+        xSemaphoreGive(xContainerMutex);
+        return pdFAIL;
+    }
+
+    /* Drop a notification left over from an earlier wait that timed out */
+    (void)ulTaskNotifyTakeIndexed(CONTAINER_WAIT_NOTIFY_INDEX, pdTRUE, 0);
+
+    xWaiter.xTask = xTaskGetCurrentTaskHandle();
+    xWaiter.xDone = pdFALSE;
+    xWaiter.xResult = pdFAIL;
+    xWaiter.pxNext = pxContainer->pxWaiters;
+    pxContainer->pxWaiters = &xWaiter;
+    xSemaphoreGive(xContainerMutex);
 
-#if (configUSE_IPC_NAMESPACE == 1)
-                if (pxContainer->xIpcNamespace != NULL) {
-                    xIpcNamespaceDelete(pxContainer->xIpcNamespace);
-                    pxContainer->xIpcNamespace = NULL;
-                }
-#endif
+    vTaskSetTimeOutState(&xTimeOut);
+    for (;;) {
+        (void)ulTaskNotifyTakeIndexed(CONTAINER_WAIT_NOTIFY_INDEX, pdTRUE, xTicksToWait);
+        if (xWaiter.xDone != pdFALSE || xTaskCheckForTimeOut(&xTimeOut, &xTicksToWait) != pdFALSE) {
+            break;
+        }
+    }
 
-                /* Free container memory */
-                vPortFree(pxContainer);
-                xResult = pdPASS;
-                break;
+    /* Leave the waiter list if the wait timed out, the container still exists in that case */
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
+        if (xWaiter.xDone == pdFALSE) {
+            ContainerWaiter_t **ppxLink = &pxContainer->pxWaiters;
+
+            while (*ppxLink != NULL && *ppxLink != &xWaiter) {
+                ppxLink = &(*ppxLink)->pxNext;
+            }
+            if (*ppxLink != NULL) {
+                *ppxLink = xWaiter.pxNext;
             }
-            pxPrevContainer = pxContainer;
-            pxContainer = pxContainer->pxNext;
         }
         xSemaphoreGive(xContainerMutex);
     }
 
-    return xResult;
+    return xWaiter.xResult;
 }
 
 /* Get container by ID */
 Container_t *pxContainerGetByID(uint32_t ulContainerID) {
-    Container_t *pxContainer = pxContainerList;
+    Container_t *pxContainer;
+
+    if (ulRegistryBuckets == 0) {
+        return NULL;
+    }
 
+    pxContainer = pxRegistryByID[ulContainerID & (ulRegistryBuckets - 1)];
     while (pxContainer != NULL) {
         if (pxContainer->ulContainerID == ulContainerID) {
             return pxContainer;
         }
-        pxContainer = pxContainer->pxNext;
+        pxContainer = pxContainer->pxNextByID;
     }
 
     return NULL;
 }
 
-/* Get container by name */
+/* Get container by name, matching the whole name rather than a prefix */
 Container_t *pxContainerGetByName(const char *pcName) {
-    Container_t *pxContainer = pxContainerList;
+    Container_t *pxContainer;
+    uint32_t     ulHash;
 
-    if (pcName == NULL) {
+    if (pcName == NULL || ulRegistryBuckets == 0) {
         return NULL;
     }
 
+    ulHash = prvHashName(pcName);
+    pxContainer = pxRegistryByName[ulHash & (ulRegistryBuckets - 1)];
     while (pxContainer != NULL) {
-        if (strncmp(pxContainer->pcContainerName, pcName, strlen(pcName)) == 0) {
+        if (pxContainer->ulNameHash == ulHash &&
+            strncmp(pxContainer->pcContainerName, pcName,
+                    sizeof(pxContainer->pcContainerName) - 1) == 0) {
             return pxContainer;
         }
-        pxContainer = pxContainer->pxNext;
+        pxContainer = pxContainer->pxNextByName;
     }
 
     return NULL;
 }
 
 /* Get container count */
-uint32_t ulContainerGetCount(void) {
-    Container_t *pxContainer = pxContainerList;
-    uint32_t     ulCount = 0;
-
-    while (pxContainer != NULL) {
-        ulCount++;
-        pxContainer = pxContainer->pxNext;
-    }
-
-    return ulCount;
-}
+uint32_t ulContainerGetCount(void) { return ulContainerCount; }
 
 /* Get container list */
 Container_t *pxContainerGetList(void) { return pxContainerList; }
@@ -697,13 +1398,14 @@ Container_t *pxContainerGetList(void) { return pxContainerList; }
 /* Container create command */
 BaseType_t
 xContainerCreateCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
-    const char *pcParameter1, *pcParameter2, *pcParameter3, *pcParameter4;
+    const char *pcParameter1, *pcParameter2, *pcParameter3, *pcParameter4, *pcParameter5;
     BaseType_t  lParameterStringLength1, lParameterStringLength2, lParameterStringLength3,
-        lParameterStringLength4;
+        lParameterStringLength4, lParameterStringLength5;
     char     pcContainerName[32];
     char     elfName[64];
     uint32_t ulMemoryLimit = 0;
     uint32_t ulCpuQuota = 0;
+    uint32_t ulCpuWeight = 0;
 
     /* Ensure pcWriteBuffer is initialized. */
     *pcWriteBuffer = '\0';
@@ -717,7 +1419,8 @@ xContainerCreateCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char
 
     if (pcParameter1 == NULL) {
         strcpy(pcWriteBuffer,
-            "Usage: container-create <image> <program> [memory_limit_kb] [cpu_quota_percent]\r\n");
+            "Usage: container-create <image> <program> [memory_limit_kb] [cpu_quota_percent] "
+            "[cpu_weight]\r\n");
         return pdFALSE;
     }
 
@@ -736,7 +1439,8 @@ xContainerCreateCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char
     pcParameter2 = FreeRTOS_CLIGetParameter(pcCommandString, 2, &lParameterStringLength2);
     if (pcParameter2 == NULL) {
         strcpy(pcWriteBuffer,
-            "Usage: container-create <image> <program> [memory_limit_kb] [cpu_quota_percent]\r\n");
+            "Usage: container-create <image> <program> [memory_limit_kb] [cpu_quota_percent] "
+            "[cpu_weight]\r\n");
         return pdFALSE;
     }
 
@@ -765,6 +1469,13 @@ xContainerCreateCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char
         ulCpuQuota = (uint32_t)atoi(pcParameter4) * 100; /* Convert percentage to quota units */
     }
 
+    /* Obtain optional CPU weight parameter */
+    pcParameter5 = FreeRTOS_CLIGetParameter(pcCommandString, 5, &lParameterStringLength5);
+
+    if (pcParameter5 != NULL) {
+        ulCpuWeight = (uint32_t)atoi(pcParameter5);
+    }
+
     /* Create container with resource limits */
     BaseType_t xResult =
         xContainerCreateWithLimits(pcContainerName, elfName, configMINIMAL_STACK_SIZE * 2,
@@ -775,6 +1486,15 @@ xContainerCreateCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char
             "Failed to create container '%s'.\r\n", pcContainerName);
         return pdFALSE;
     }
+
+    if ((ulCpuWeight > 0) &&
+        (xContainerSetCpuWeight(ulNextContainerID - 1, ulCpuWeight) != pdPASS)) {
+        snprintf(pcWriteBuffer, xWriteBufferLen,
+            "Invalid CPU weight %lu for container '%s'.\r\n", (unsigned long)ulCpuWeight,
+            pcContainerName);
+        xContainerDelete(ulNextContainerID - 1);
+        return pdFALSE;
+    }
 #ifdef configUSE_FILESYSTEM
     char image_path[256];
     /* Manual initialization to avoid memset */
@@ -967,16 +1687,203 @@ xContainerStopCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *p
     return pdFALSE;
 }
 
+/* Container pause command */
+BaseType_t
+xContainerPauseCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    const char *pcParameter;
+    BaseType_t  lParameterStringLength;
+    uint32_t    ulContainerID;
+
+    /* Ensure pcWriteBuffer is initialized. */
+    *pcWriteBuffer = '\0';
+
+    /* Obtain the parameter string. */
+    pcParameter =
+        FreeRTOS_CLIGetParameter(pcCommandString,        /* The command string itself. */
+                                 1,                      /* Return the first parameter. */
+                                 &lParameterStringLength /* Store the parameter string length. */
+        );
+
+    if (pcParameter != NULL) {
+        ulContainerID = (uint32_t)atoi(pcParameter);
+
+        if (xContainerPause(ulContainerID) == pdPASS) {
+            snprintf(pcWriteBuffer, xWriteBufferLen,
+                "Container %lu paused successfully.\r\n",
+                (unsigned long)ulContainerID);
+        } else {
+            snprintf(pcWriteBuffer, xWriteBufferLen,
+                "Failed to pause container %lu. It may not be running or does not exist.\r\n",
+                (unsigned long)ulContainerID);
+        }
+    } else {
+        strcpy(pcWriteBuffer, "Usage: container-pause <id>\r\n");
+    }
+
+    return pdFALSE;
+}
+
+/* Container resume command */
+BaseType_t
+xContainerResumeCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    const char *pcParameter;
+    BaseType_t  lParameterStringLength;
+    uint32_t    ulContainerID;
+
+    /* Ensure pcWriteBuffer is initialized. */
+    *pcWriteBuffer = '\0';
+
+    /* Obtain the parameter string. */
+    pcParameter =
+        FreeRTOS_CLIGetParameter(pcCommandString,        /* The command string itself. */
+                                 1,                      /* Return the first parameter. */
+                                 &lParameterStringLength /* Store the parameter string length. */
+        );
+
+    if (pcParameter != NULL) {
+        ulContainerID = (uint32_t)atoi(pcParameter);
+
+        if (xContainerResume(ulContainerID) == pdPASS) {
+            snprintf(pcWriteBuffer, xWriteBufferLen,
+                "Container %lu resumed successfully.\r\n",
+                (unsigned long)ulContainerID);
+        } else {
+            snprintf(pcWriteBuffer, xWriteBufferLen,
+                "Failed to resume container %lu. It may not be paused or does not exist.\r\n",
+                (unsigned long)ulContainerID);
+        }
+    } else {
+        strcpy(pcWriteBuffer, "Usage: container-resume <id>\r\n");
+    }
+
+    return pdFALSE;
+}
+
+/* Container stats command */
+BaseType_t
+xContainerStatsCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    const char *pcParameter;
+    BaseType_t  lParameterStringLength;
+    uint32_t    ulContainerID;
+    uint32_t    ulMemoryUsed;
+    uint64_t    ullCpuTimeUs;
+    int         iOffset;
+
+    /* Ensure pcWriteBuffer is initialized. */
+    *pcWriteBuffer = '\0';
+
+    /* Obtain the parameter string. */
+    pcParameter =
+        FreeRTOS_CLIGetParameter(pcCommandString,        /* The command string itself. */
+                                 1,                      /* Return the first parameter. */
+                                 &lParameterStringLength /* Store the parameter string length. */
+        );
+
+    if (pcParameter == NULL) {
+        strcpy(pcWriteBuffer, "Usage: container-stats <id>\r\n");
+        return pdFALSE;
+    }
+
+    ulContainerID = (uint32_t)atoi(pcParameter);
+
+    if (xContainerGetStats(ulContainerID, &ulMemoryUsed, &ullCpuTimeUs) != pdPASS) {
+        snprintf(pcWriteBuffer, xWriteBufferLen, "Container %lu does not exist.\r\n",
+            (unsigned long)ulContainerID);
+        return pdFALSE;
+    }
+
+    iOffset = snprintf(pcWriteBuffer, xWriteBufferLen,
+        "Container %lu\r\n"
+        "  Memory used:\t%lu bytes\r\n"
+        "  CPU time:\t%lu.%06lu s\r\n",
+        (unsigned long)ulContainerID, (unsigned long)ulMemoryUsed,
+        (unsigned long)(ullCpuTimeUs / 1000000U), (unsigned long)(ullCpuTimeUs % 1000000U));
+
+#if (configUSE_CGROUPS == 1)
+    if ((iOffset > 0) && ((size_t)iOffset < xWriteBufferLen) &&
+        (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE)) {
+        Container_t   *pxContainer = pxContainerGetByID(ulContainerID);
+        MemoryLimits_t xMemoryLimits;
+        CpuLimits_t    xCpuLimits;
+
+        if ((pxContainer != NULL) && (pxContainer->xCGroup != NULL) &&
+            (xCGroupGetStats(pxContainer->xCGroup, &xMemoryLimits, &xCpuLimits) == pdPASS)) {
+            UBaseType_t uxBucket;
+            UBaseType_t ulBound;
+            const char *pcFormat;
+            int         iLength;
+
+            /* Memory pressure, to size the limits from */
+            iLength = snprintf(pcWriteBuffer + iOffset, xWriteBufferLen - (size_t)iOffset,
+                "  Memory peak:\t%lu bytes\r\n"
+                "  Failcount:\t%lu\r\n"
+                "  High events:\t%lu\r\n"
+                "  Alloc sizes:",
+                (unsigned long)xMemoryLimits.ulMemoryPeak,
+                (unsigned long)xMemoryLimits.ulFailCount,
+                (unsigned long)xMemoryLimits.ulHighEvents);
+
+            /* Only the sizes that were seen, as <=bytes:count */
+            for (uxBucket = 0U; uxBucket <= CGROUP_MEMORY_HISTOGRAM_BUCKETS; uxBucket++) {
+                if ((iLength < 0) || ((size_t)(iOffset + iLength) >= xWriteBufferLen)) {
+                    break;
+                }
+                iOffset += iLength;
+
+                if (uxBucket == CGROUP_MEMORY_HISTOGRAM_BUCKETS) {
+                    iLength = snprintf(pcWriteBuffer + iOffset, xWriteBufferLen - (size_t)iOffset,
+                        "\r\n");
+                } else if (xMemoryLimits.ulSizeHistogram[uxBucket] > 0U) {
+                    ulBound = ((UBaseType_t)1U) << (CGROUP_MEMORY_HISTOGRAM_MIN_SHIFT + uxBucket);
+                    pcFormat = " <=%lu:%lu";
+                    if (uxBucket == (CGROUP_MEMORY_HISTOGRAM_BUCKETS - 1U)) {
+                        /* The last bucket holds everything larger */
+                        ulBound >>= 1;
+                        pcFormat = " >%lu:%lu";
+                    }
+                    iLength = snprintf(pcWriteBuffer + iOffset, xWriteBufferLen - (size_t)iOffset,
+                        pcFormat, (unsigned long)ulBound,
+                        (unsigned long)xMemoryLimits.ulSizeHistogram[uxBucket]);
+                } else {
+                    iLength = 0;
+                }
+            }
+
+            if ((iLength > 0) && ((size_t)(iOffset + iLength) < xWriteBufferLen)) {
+                iOffset += iLength;
+            }
+
+            if (xCpuLimits.ulTicksQuota == CGROUP_NO_LIMIT) {
+                snprintf(pcWriteBuffer + iOffset, xWriteBufferLen - (size_t)iOffset,
+                    "  Period used:\t%lu us (no quota)\r\n",
+                    (unsigned long)ullCGroupCyclesToMicroseconds(xCpuLimits.ullCyclesUsed));
+            } else {
+                snprintf(pcWriteBuffer + iOffset, xWriteBufferLen - (size_t)iOffset,
+                    "  Period used:\t%lu us of %lu us\r\n"
+                    "  Throttled:\t%lu periods\r\n",
+                    (unsigned long)ullCGroupCyclesToMicroseconds(xCpuLimits.ullCyclesUsed),
+                    (unsigned long)ullCGroupCyclesToMicroseconds(xCpuLimits.ullCyclesQuota),
+                    (unsigned long)xCpuLimits.ulThrottleCount);
+            }
+        }
+        xSemaphoreGive(xContainerMutex);
+    }
+#endif
+
+    return pdFALSE;
+}
+
 /* Container run command */
 BaseType_t
 xContainerRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
-    const char *pcParameter1, *pcParameter2, *pcParameter3, *pcParameter4;
+    const char *pcParameter1, *pcParameter2, *pcParameter3, *pcParameter4, *pcParameter5;
     BaseType_t  lParameterStringLength1, lParameterStringLength2, lParameterStringLength3,
-        lParameterStringLength4;
+        lParameterStringLength4, lParameterStringLength5;
     char     pcContainerName[32];
     char     elfName[64];
     uint32_t ulMemoryLimit = 0;
     uint32_t ulCpuQuota = 0;
+    uint32_t ulCpuWeight = 0;
 
     /* Ensure pcWriteBuffer is initialized. */
     *pcWriteBuffer = '\0';
@@ -990,7 +1897,8 @@ xContainerRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pc
 
     if (pcParameter1 == NULL) {
         strcpy(pcWriteBuffer,
-            "Usage: container-run <image> <program> [memory_limit_kb] [cpu_quota_percent]\r\n");
+            "Usage: container-run <image> <program> [memory_limit_kb] [cpu_quota_percent] "
+            "[cpu_weight]\r\n");
         return pdFALSE;
     }
 
@@ -1012,7 +1920,8 @@ xContainerRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pc
         );
     if (pcParameter2 == NULL) {
         strcpy(pcWriteBuffer,
-            "Usage: container-run <image> <program> [memory_limit_kb] [cpu_quota_percent]\r\n");
+            "Usage: container-run <image> <program> [memory_limit_kb] [cpu_quota_percent] "
+            "[cpu_weight]\r\n");
         return pdFALSE;
     }
     /* Copy the ELF name */
@@ -1040,6 +1949,13 @@ xContainerRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pc
         ulCpuQuota = (uint32_t)atoi(pcParameter4) * 100; /* Convert percentage to quota units */
     }
 
+    /* Obtain optional CPU weight parameter */
+    pcParameter5 = FreeRTOS_CLIGetParameter(pcCommandString, 5, &lParameterStringLength5);
+
+    if (pcParameter5 != NULL) {
+        ulCpuWeight = (uint32_t)atoi(pcParameter5);
+    }
+
     /* Create container with resource limits */
     BaseType_t xResult =
         xContainerCreateWithLimits(pcContainerName, elfName, configMINIMAL_STACK_SIZE * 2,
@@ -1050,6 +1966,15 @@ xContainerRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pc
             "Failed to create container '%s'.\r\n", pcContainerName);
         return pdFALSE;
     }
+
+    if ((ulCpuWeight > 0) &&
+        (xContainerSetCpuWeight(ulNextContainerID - 1, ulCpuWeight) != pdPASS)) {
+        snprintf(pcWriteBuffer, xWriteBufferLen,
+            "Invalid CPU weight %lu for container '%s'.\r\n", (unsigned long)ulCpuWeight,
+            pcContainerName);
+        xContainerDelete(ulNextContainerID - 1);
+        return pdFALSE;
+    }
 #ifdef configUSE_FILESYSTEM
     char image_path[256];
     /* Manual initialization to avoid memset */
@@ -1402,7 +2327,9 @@ BaseType_t xRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *
     const char  *pcParameter;
     BaseType_t   lParameterStringLength;
     char         pcFilePath[256];
+#ifndef configUSE_FILESYSTEM
     ELF_WRAP     wrap;
+#endif
 
     /* Ensure pcWriteBuffer is initialized. */
     *pcWriteBuffer = '\0';
@@ -1422,6 +2349,23 @@ BaseType_t xRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *
     strncpy(pcFilePath, pcParameter, lParameterStringLength);
     pcFilePath[lParameterStringLength] = '\0';
 
+#ifdef configUSE_FILESYSTEM
+    /* Stream the ELF from the file, the whole file is never held in memory */
+    if (pcFilePath[0] != '/') {
+        if ((size_t)lParameterStringLength + 1 >= sizeof(pcFilePath)) {
+            strcpy(pcWriteBuffer, "File path too long\r\n");
+            return pdFALSE;
+        }
+        memmove(&pcFilePath[1], pcFilePath, (size_t)lParameterStringLength + 1);
+        pcFilePath[0] = '/';
+    }
+    if (prvElfRunFile(pcFilePath, NULL) != pdPASS) {
+        snprintf(pcWriteBuffer, xWriteBufferLen,
+            "Failed to load ELF file: %s\r\n", pcFilePath);
+    }
+
+    return pdFALSE;
+#else
     /* Load ELF file */
     if (get_elf_by_name(&wrap, pcFilePath) != pdPASS) {
         snprintf(pcWriteBuffer, xWriteBufferLen,
@@ -1439,6 +2383,7 @@ BaseType_t xRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *
     vPortFree((void *)wrap.elf_data);
 
     return pdFALSE;
+#endif
 }
 
 #ifdef configUSE_FILESYSTEM
@@ -1566,13 +2511,81 @@ BaseType_t xPwdCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *
     return pdFALSE;
 }
 
+/* Image cache command - Show image cache statistics */
+static BaseType_t
+prvImageCacheCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    ImageCacheStats_t xStats;
+
+    (void)pcCommandString;
+
+    vImageCacheGetStats(&xStats);
+    snprintf(pcWriteBuffer, xWriteBufferLen,
+             "Images: %lu (%lu in use), %lu bytes\r\nRelocated: %lu, %lu bytes\r\n"
+             "Hits: %lu  Misses: %lu  Evictions: %lu\r\n",
+             (unsigned long)xStats.uxEntries, (unsigned long)xStats.uxReferenced,
+             (unsigned long)xStats.xBytes, (unsigned long)xStats.uxPrepared,
+             (unsigned long)xStats.xPreparedBytes, (unsigned long)xStats.ulHits,
+             (unsigned long)xStats.ulMisses, (unsigned long)xStats.ulEvictions);
+
+    return pdFALSE;
+}
+
+/* Library command - List shared runtime libraries, or load one */
+static BaseType_t
+prvContainerLibCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString) {
+    ELF_LIBRARY_INFO xInfo[4];
+    const char      *pcParameter;
+    BaseType_t       lParameterStringLength;
+    char             pcPath[ELF_LIBRARY_NAME_MAX];
+    size_t           xCount;
+    size_t           xIndex;
+    size_t           xLen = 0;
+
+    pcParameter = FreeRTOS_CLIGetParameter(pcCommandString, 1, &lParameterStringLength);
+    if (pcParameter != NULL) {
+        if ((size_t)lParameterStringLength >= sizeof(pcPath)) {
+            snprintf(pcWriteBuffer, xWriteBufferLen, "Library path too long\r\n");
+            return pdFALSE;
+        }
+        memcpy(pcPath, pcParameter, (size_t)lParameterStringLength);
+        pcPath[lParameterStringLength] = '\0';
+        snprintf(pcWriteBuffer, xWriteBufferLen,
+                 (xContainerLoadLibrary(pcPath) == pdPASS) ? "Loaded %s\r\n"
+                                                           : "Failed to load %s\r\n",
+                 pcPath);
+        return pdFALSE;
+    }
+
+    xCount = elf_get_libraries(xInfo, sizeof(xInfo) / sizeof(xInfo[0]));
+    *pcWriteBuffer = '\0';
+    if (xCount == 0) {
+        snprintf(pcWriteBuffer, xWriteBufferLen, "No libraries loaded\r\n");
+        return pdFALSE;
+    }
+    for (xIndex = 0; xIndex < xCount && xIndex < sizeof(xInfo) / sizeof(xInfo[0]); xIndex++) {
+        if (xLen < xWriteBufferLen) {
+            xLen += (size_t)snprintf(pcWriteBuffer + xLen, xWriteBufferLen - xLen,
+                                     "%s at %lx, %lu bytes, %lu symbols\r\n", xInfo[xIndex].name,
+                                     (unsigned long)(uintptr_t)xInfo[xIndex].memory,
+                                     (unsigned long)xInfo[xIndex].size,
+                                     (unsigned long)xInfo[xIndex].symbols);
+        }
+    }
+    if (xCount > xIndex && xLen < xWriteBufferLen) {
+        snprintf(pcWriteBuffer + xLen, xWriteBufferLen - xLen, "... %lu more\r\n",
+                 (unsigned long)(xCount - xIndex));
+    }
+
+    return pdFALSE;
+}
+
 #endif
 
 /* CLI command definitions */
 static const CLI_Command_Definition_t xContainerCreateCmd = {
     "container-create",
-    "\r\ncontainer-create <name> [memory_limit_kb] [cpu_quota_percent]:\r\n Creates a new "
-    "container with optional resource limits\r\n",
+    "\r\ncontainer-create <name> [memory_limit_kb] [cpu_quota_percent] [cpu_weight]:\r\n Creates a "
+    "new container with optional resource limits\r\n",
     xContainerCreateCommand, -1 /* Variable number of parameters */
 };
 
@@ -1590,10 +2603,26 @@ static const CLI_Command_Definition_t xContainerStopCmd = {
     "container-stop", "\r\ncontainer-stop <id>:\r\n Stops the container with the specified ID\r\n",
     xContainerStopCommand, 1};
 
+static const CLI_Command_Definition_t xContainerPauseCmd = {
+    "container-pause",
+    "\r\ncontainer-pause <id>:\r\n Freezes all tasks of the container with the specified ID\r\n",
+    xContainerPauseCommand, 1};
+
+static const CLI_Command_Definition_t xContainerResumeCmd = {
+    "container-resume",
+    "\r\ncontainer-resume <id>:\r\n Resumes the paused container with the specified ID\r\n",
+    xContainerResumeCommand, 1};
+
+static const CLI_Command_Definition_t xContainerStatsCmd = {
+    "container-stats",
+    "\r\ncontainer-stats <id>:\r\n Shows memory and CPU time used by the container with the "
+    "specified ID\r\n",
+    xContainerStatsCommand, 1};
+
 static const CLI_Command_Definition_t xContainerRunCmd = {
     "container-run",
-    "\r\ncontainer-run <image> <program> [memory_limit_kb] [cpu_quota_percent]:\r\n Creates and starts a "
-    "new container with optional resource limits\r\n",
+    "\r\ncontainer-run <image> <program> [memory_limit_kb] [cpu_quota_percent] [cpu_weight]:\r\n "
+    "Creates and starts a new container with optional resource limits\r\n",
     xContainerRunCommand, -1 /* Variable number of parameters */
 };
 
@@ -1631,6 +2660,17 @@ static const CLI_Command_Definition_t xLsCmd = {
 static const CLI_Command_Definition_t xPwdCmd = {
     "pwd", "\r\npwd:\r\n Print the current working directory\r\n",
     xPwdCommand, 0};
+
+static const CLI_Command_Definition_t xImageCacheCmd = {
+    "image-cache", "\r\nimage-cache:\r\n Show program image cache statistics\r\n",
+    prvImageCacheCommand, 0};
+
+static const CLI_Command_Definition_t xContainerLibCmd = {
+    "container-lib",
+    "\r\ncontainer-lib [library_path]:\r\n Load a shared runtime library, or list the loaded "
+    "ones\r\n",
+    prvContainerLibCommand, -1 /* Variable number of parameters (0 or 1) */
+};
 #endif
 
 /* Register container CLI commands */
@@ -1639,6 +2679,9 @@ void vRegisterContainerCLICommands(void) {
     FreeRTOS_CLIRegisterCommand(&xContainerListCmd);
     FreeRTOS_CLIRegisterCommand(&xContainerStartCmd);
     FreeRTOS_CLIRegisterCommand(&xContainerStopCmd);
+    FreeRTOS_CLIRegisterCommand(&xContainerPauseCmd);
+    FreeRTOS_CLIRegisterCommand(&xContainerResumeCmd);
+    FreeRTOS_CLIRegisterCommand(&xContainerStatsCmd);
     FreeRTOS_CLIRegisterCommand(&xContainerRunCmd);
     FreeRTOS_CLIRegisterCommand(&xContainerDeleteCmd);
     FreeRTOS_CLIRegisterCommand(&xRunCmd);
@@ -1648,6 +2691,8 @@ void vRegisterContainerCLICommands(void) {
     FreeRTOS_CLIRegisterCommand(&xContainerImageCmd);
     FreeRTOS_CLIRegisterCommand(&xLsCmd);
     FreeRTOS_CLIRegisterCommand(&xPwdCmd);
+    FreeRTOS_CLIRegisterCommand(&xImageCacheCmd);
+    FreeRTOS_CLIRegisterCommand(&xContainerLibCmd);
 #endif
 }
 
@@ -1679,6 +2724,33 @@ BaseType_t xContainerSetMemoryLimit(uint32_t ulContainerID, uint32_t ulMemoryLim
     return xResult;
 }
 
+/* Set the memory soft limit of a container, 0 removes it */
+BaseType_t xContainerSetMemorySoftLimit(uint32_t ulContainerID, uint32_t ulSoftLimit) {
+    Container_t *pxContainer;
+    BaseType_t   xResult = pdFAIL;
+
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
+        pxContainer = pxContainerGetByID(ulContainerID);
+        if (pxContainer != NULL) {
+            pxContainer->ulMemorySoftLimit = ulSoftLimit;
+
+#if (configUSE_CGROUPS == 1)
+            if (pxContainer->xCGroup != NULL) {
+                xResult = xCGroupSetMemorySoftLimit(
+                    pxContainer->xCGroup, (ulSoftLimit > 0) ? ulSoftLimit : CGROUP_NO_LIMIT);
+            } else {
+                xResult = pdPASS; /* No CGroup, but we updated the container limit */
+            }
+#else
+            xResult = pdPASS;
+#endif
+        }
+        xSemaphoreGive(xContainerMutex);
+    }
+
+    return xResult;
+}
+
 /* Set CPU quota for a container */
 BaseType_t xContainerSetCpuQuota(uint32_t ulContainerID, uint32_t ulCpuQuota) {
     Container_t *pxContainer;
@@ -1705,18 +2777,66 @@ BaseType_t xContainerSetCpuQuota(uint32_t ulContainerID, uint32_t ulCpuQuota) {
     return xResult;
 }
 
+/* Set CPU weight for a container */
+BaseType_t xContainerSetCpuWeight(uint32_t ulContainerID, uint32_t ulCpuWeight) {
+    Container_t *pxContainer;
+    BaseType_t   xResult = pdFAIL;
+
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
+        pxContainer = pxContainerGetByID(ulContainerID);
+        if (pxContainer != NULL) {
+#if (configUSE_CGROUPS == 1)
+            if (pxContainer->xCGroup != NULL) {
+                xResult = xCGroupSetCpuWeight(pxContainer->xCGroup, ulCpuWeight);
+            } else {
+                xResult = pdPASS; /* No CGroup, but we updated the container weight */
+            }
+#else
+            xResult = pdPASS;
+#endif
+            if (xResult == pdPASS) {
+                pxContainer->ulCpuWeight = ulCpuWeight;
+            }
+        }
+        xSemaphoreGive(xContainerMutex);
+    }
+
+    return xResult;
+}
+
+/* Place a container's cgroup below a parent cgroup, e.g. a per tenant cgroup
+ * whose limits are shared by all of the tenant's containers */
+BaseType_t xContainerSetParentCGroup(uint32_t ulContainerID, CGroupHandle_t xParent) {
+    Container_t *pxContainer;
+    BaseType_t   xResult = pdFAIL;
+
+    if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
+        pxContainer = pxContainerGetByID(ulContainerID);
+        if (pxContainer != NULL) {
+#if (configUSE_CGROUPS == 1)
+            if (pxContainer->xCGroup != NULL) {
+                xResult = xCGroupSetParent(pxContainer->xCGroup, xParent);
+            }
+#endif
+        }
+        xSemaphoreGive(xContainerMutex);
+    }
+
+    return xResult;
+}
+
 /* Get container statistics */
 BaseType_t
-xContainerGetStats(uint32_t ulContainerID, uint32_t *pulMemoryUsed, uint32_t *pulCpuUsage) {
+xContainerGetStats(uint32_t ulContainerID, uint32_t *pulMemoryUsed, uint64_t *pullCpuTimeUs) {
     Container_t *pxContainer;
     BaseType_t   xResult = pdFAIL;
 
-    if (pulMemoryUsed == NULL || pulCpuUsage == NULL) {
+    if (pulMemoryUsed == NULL || pullCpuTimeUs == NULL) {
         return pdFAIL;
     }
 
     *pulMemoryUsed = 0;
-    *pulCpuUsage = 0;
+    *pullCpuTimeUs = 0;
 
     if (xSemaphoreTake(xContainerMutex, portMAX_DELAY) == pdTRUE) {
         pxContainer = pxContainerGetByID(ulContainerID);
@@ -1728,7 +2848,8 @@ xContainerGetStats(uint32_t ulContainerID, uint32_t *pulMemoryUsed, uint32_t *pu
 
                 if (xCGroupGetStats(pxContainer->xCGroup, &xMemoryLimits, &xCpuLimits) == pdPASS) {
                     *pulMemoryUsed = xMemoryLimits.ulMemoryUsed;
-                    *pulCpuUsage = xCpuLimits.ulTicksUsed;
+                    /* Cycle accurate CPU time measured at context switches */
+                    *pullCpuTimeUs = ullCGroupCyclesToMicroseconds(xCpuLimits.ullTotalCycles);
                     xResult = pdPASS;
                 }
             } else
@@ -7,6 +7,7 @@
 
 #ifdef configUSE_FILESYSTEM
 #include "file_system.h"
+#include "image_cache.h"
 #include "lfs.h"
 
 #ifdef MY_DEBUG
@@ -281,6 +282,16 @@ BaseType_t xContainerUnpackImage(const char *pcImagePath, uint32_t ulContainerID
         }
 
         lfs_ops->file_close(&output_file);
+
+        /* Tag the file with its content digest so replicas share one cached image */
+        if (ullFileSize > 0) {
+            uint8_t aucDigest[IMAGE_CACHE_DIGEST_LEN];
+
+            vImageCacheDigest(pucBuffer, (size_t)ullFileSize, aucDigest);
+            (void)lfs_ops->setattr(acFilePath, IMAGE_CACHE_ATTR_HASH, aucDigest,
+                                   sizeof(aucDigest));
+        }
+
         vPortFree(pucBuffer);
         pucBuffer = NULL;
     }
@@ -0,0 +1,490 @@
+/*
+ * FreeRTOS CGroup Benchmark
+ * Measures how much the cgroup layer adds to the context switch and to
+ * pvPortMalloc()/vPortFree() as more tasks become cgroup members.
+ *
+ * For each step the benchmark adds suspended filler tasks to the cgroup and
+ * then times:
+ *  - a yield ping-pong between two tasks of the cgroup (two switches per round)
+ *  - a 64 byte pvPortMalloc()/vPortFree() pair from a task of the cgroup
+ *
+ * Times are read from the ARM generic timer (CNTVCT_EL0). With O(1) cgroup
+ * lookup both columns should stay flat as the task count grows.
+ *
+ * The weight benchmark runs busy tasks of two cgroups at the same priority:
+ * one task with weight 2048 against four tasks with weight 1024. Round robin
+ * per task would give the first cgroup 20%, the weights ask for 66%.
+ *
+ * The pool stress test keeps a few hundred cgroups alive while it deletes and
+ * recreates thousands of them. It checks that handles to deleted cgroups are
+ * rejected after their cgroup was reused, and reports the create and delete
+ * cost as the pool grows.
+ *
+ * The tick benchmark times the cgroup work of the tick interrupt, the
+ * prvCGroupUpdateTick() hook, as the number of cgroups grows. Only cgroups
+ * whose throttled period ends in the tick are visited, so the cost should not
+ * depend on the number of cgroups.
+ */
+
+#include "cgroup_benchmark.h"
+#include "FreeRTOS.h"
+#include "cgroup.h"
+#include "task.h"
+#include "xil_printf.h"
+#include <stdint.h>
+
+#if (configUSE_CGROUPS == 1)
+
+#define BENCH_SWITCH_ROUNDS 1000U
+#define BENCH_MALLOC_ROUNDS 1000U
+#define BENCH_MALLOC_SIZE 64U
+#define BENCH_MAX_FILLERS 60U
+
+#define BENCH_WEIGHT_RUN_MS 3000U
+#define BENCH_WEIGHT_HEAVY 2048U
+#define BENCH_WEIGHT_LIGHT 1024U
+#define BENCH_WEIGHT_LIGHT_TASKS 4U
+
+#define BENCH_POOL_LIVE 256U
+#define BENCH_POOL_CHURN 4096U
+
+#define BENCH_TICK_ROUNDS 1000U
+#define BENCH_TICK_MAX_CGROUPS 1024U
+
+#define BENCH_DRIVER_PRIORITY (configMAX_PRIORITIES - 1)
+#define BENCH_PAIR_PRIORITY (configMAX_PRIORITIES - 2)
+
+/* Filler task counts measured, kept below the old 8 cgroups * 8 tasks map
+ * size so runs before and after the O(1) lookup can be compared */
+static const UBaseType_t uxBenchTaskCounts[] = {0U, 15U, 30U, BENCH_MAX_FILLERS};
+
+static CGroupHandle_t xBenchCGroup = NULL;
+static TaskHandle_t   xBenchDriver = NULL;
+static TaskHandle_t   xFillerTasks[BENCH_MAX_FILLERS];
+static uint64_t       ullSwitchCounts = 0U;
+static CGroupHandle_t xPoolCGroups[BENCH_POOL_LIVE];
+
+/* Cgroup counts the tick hook is timed at */
+static const UBaseType_t uxBenchTickCGroups[] = {0U, 64U, 256U, BENCH_TICK_MAX_CGROUPS};
+static CGroupHandle_t    xTickCGroups[BENCH_TICK_MAX_CGROUPS];
+
+/*-----------------------------------------------------------*/
+
+static inline uint64_t prvReadCounter(void) {
+    uint64_t ullValue;
+
+    __asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(ullValue) : : "memory");
+    return ullValue;
+}
+
+static inline uint64_t prvReadCounterFrequency(void) {
+    uint64_t ullValue;
+
+    __asm volatile("mrs %0, cntfrq_el0" : "=r"(ullValue));
+    return ullValue;
+}
+
+static unsigned long prvCountsToNs(uint64_t ullCounts, uint64_t ullFrequency) {
+    if (ullFrequency == 0U) {
+        return 0UL;
+    }
+
+    return (unsigned long)((ullCounts * 1000000000ULL) / ullFrequency);
+}
+
+/*-----------------------------------------------------------*/
+
+/* Member task that never runs, it only makes the cgroup bigger */
+static void vBenchFillerTask(void *pvParameters) {
+    (void)pvParameters;
+
+    for (;;) {
+        vTaskSuspend(NULL);
+    }
+}
+
+/* Yield partner of the timed task */
+static void vBenchYieldTask(void *pvParameters) {
+    (void)pvParameters;
+
+    for (;;) {
+        taskYIELD();
+    }
+}
+
+/* Timed side of the yield ping-pong */
+static void vBenchTimedYieldTask(void *pvParameters) {
+    UBaseType_t uxRound;
+    uint64_t    ullStart;
+
+    (void)pvParameters;
+
+    ullStart = prvReadCounter();
+    for (uxRound = 0U; uxRound < BENCH_SWITCH_ROUNDS; uxRound++) {
+        taskYIELD();
+    }
+    ullSwitchCounts = prvReadCounter() - ullStart;
+
+    xTaskNotifyGive(xBenchDriver);
+    vTaskSuspend(NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvMeasureSwitch(void) {
+    TaskHandle_t xYieldTask = NULL;
+    TaskHandle_t xTimedTask = NULL;
+
+    if (xTaskCreate(vBenchYieldTask, "BenchY", configMINIMAL_STACK_SIZE * 2, NULL,
+                    BENCH_PAIR_PRIORITY, &xYieldTask) != pdPASS) {
+        return 0U;
+    }
+
+    if (xTaskCreate(vBenchTimedYieldTask, "BenchT", configMINIMAL_STACK_SIZE * 2, NULL,
+                    BENCH_PAIR_PRIORITY, &xTimedTask) != pdPASS) {
+        vTaskDelete(xYieldTask);
+        return 0U;
+    }
+
+    (void)xCGroupAddTask(xBenchCGroup, xYieldTask);
+    (void)xCGroupAddTask(xBenchCGroup, xTimedTask);
+
+    /* The pair only runs once the driver blocks here */
+    ullSwitchCounts = 0U;
+    (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    vTaskDelete(xTimedTask);
+    vTaskDelete(xYieldTask);
+
+    /* Two context switches per round */
+    return ullSwitchCounts / (2U * BENCH_SWITCH_ROUNDS);
+}
+
+static uint64_t prvMeasureMalloc(void) {
+    UBaseType_t uxRound;
+    uint64_t    ullStart;
+    uint64_t    ullTotal;
+    void       *pvBlock;
+    TaskHandle_t xSelf = xTaskGetCurrentTaskHandle();
+
+    if (xCGroupAddTask(xBenchCGroup, xSelf) != pdPASS) {
+        return 0U;
+    }
+
+    ullStart = prvReadCounter();
+    for (uxRound = 0U; uxRound < BENCH_MALLOC_ROUNDS; uxRound++) {
+        pvBlock = pvPortMalloc(BENCH_MALLOC_SIZE);
+        vPortFree(pvBlock);
+    }
+    ullTotal = prvReadCounter() - ullStart;
+
+    (void)xCGroupRemoveTask(xBenchCGroup, xSelf);
+
+    return ullTotal / BENCH_MALLOC_ROUNDS;
+}
+
+/*-----------------------------------------------------------*/
+
+static void vCGroupBenchmarkTask(void *pvParameters) {
+    UBaseType_t uxStep;
+    UBaseType_t uxFillers = 0U;
+    uint64_t    ullFrequency;
+    uint64_t    ullSwitch;
+    uint64_t    ullMalloc;
+
+    (void)pvParameters;
+
+    ullFrequency = prvReadCounterFrequency();
+
+    xBenchCGroup = xCGroupCreate("bench", CGROUP_NO_LIMIT, CGROUP_CPU_QUOTA_MAX);
+    if (xBenchCGroup == NULL) {
+        xil_printf("cgroup-bench: failed to create cgroup\r\n");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    xil_printf("cgroup-bench: counter %lu Hz\r\n", (unsigned long)ullFrequency);
+    xil_printf("Tasks\tSwitch (cnt/ns)\tMalloc+Free (cnt/ns)\r\n");
+
+    for (uxStep = 0U; uxStep < sizeof(uxBenchTaskCounts) / sizeof(uxBenchTaskCounts[0]);
+         uxStep++) {
+        /* Grow the cgroup with suspended member tasks */
+        while (uxFillers < uxBenchTaskCounts[uxStep]) {
+            if (xTaskCreate(vBenchFillerTask, "BenchF", configMINIMAL_STACK_SIZE, NULL,
+                            tskIDLE_PRIORITY + 1, &xFillerTasks[uxFillers]) != pdPASS) {
+                break;
+            }
+            vTaskSuspend(xFillerTasks[uxFillers]);
+            (void)xCGroupAddTask(xBenchCGroup, xFillerTasks[uxFillers]);
+            uxFillers++;
+        }
+
+        ullSwitch = prvMeasureSwitch();
+        ullMalloc = prvMeasureMalloc();
+
+        xil_printf("%lu\t%lu/%lu\t\t%lu/%lu\r\n", (unsigned long)uxFillers,
+                   (unsigned long)ullSwitch, prvCountsToNs(ullSwitch, ullFrequency),
+                   (unsigned long)ullMalloc, prvCountsToNs(ullMalloc, ullFrequency));
+    }
+
+    /* Deleting a task also removes it from its cgroup */
+    while (uxFillers > 0U) {
+        uxFillers--;
+        vTaskDelete(xFillerTasks[uxFillers]);
+    }
+
+    (void)xCGroupDelete(xBenchCGroup);
+    xBenchCGroup = NULL;
+
+    xil_printf("cgroup-bench: done\r\n");
+    vTaskDelete(NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+/* CPU bound member task for the weight benchmark */
+static void vBenchSpinTask(void *pvParameters) {
+    volatile UBaseType_t uxSpins = 0U;
+
+    (void)pvParameters;
+
+    for (;;) {
+        uxSpins++;
+    }
+}
+
+static void vCGroupWeightBenchmarkTask(void *pvParameters) {
+    CGroupHandle_t xHeavy;
+    CGroupHandle_t xLight;
+    TaskHandle_t   xSpinTasks[1U + BENCH_WEIGHT_LIGHT_TASKS];
+    UBaseType_t    uxTasks = 0U;
+    uint64_t       ullHeavyUs = 0U;
+    uint64_t       ullLightUs = 0U;
+    uint64_t       ullTotalUs;
+
+    (void)pvParameters;
+
+    xHeavy = xCGroupCreate("heavy", CGROUP_NO_LIMIT, CGROUP_CPU_QUOTA_MAX);
+    xLight = xCGroupCreate("light", CGROUP_NO_LIMIT, CGROUP_CPU_QUOTA_MAX);
+    if ((xHeavy == NULL) || (xLight == NULL) ||
+        (xCGroupSetCpuWeight(xHeavy, BENCH_WEIGHT_HEAVY) != pdPASS) ||
+        (xCGroupSetCpuWeight(xLight, BENCH_WEIGHT_LIGHT) != pdPASS)) {
+        xil_printf("cgroup-weight: failed to set up cgroups\r\n");
+        goto cleanup;
+    }
+
+    /* The spinners only run once the driver blocks below */
+    while (uxTasks < (1U + BENCH_WEIGHT_LIGHT_TASKS)) {
+        if (xTaskCreate(vBenchSpinTask, "BenchW", configMINIMAL_STACK_SIZE, NULL,
+                        BENCH_PAIR_PRIORITY, &xSpinTasks[uxTasks]) != pdPASS) {
+            xil_printf("cgroup-weight: failed to create tasks\r\n");
+            goto cleanup;
+        }
+        (void)xCGroupAddTask((uxTasks == 0U) ? xHeavy : xLight, xSpinTasks[uxTasks]);
+        uxTasks++;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(BENCH_WEIGHT_RUN_MS));
+
+    (void)xCGroupGetCpuTime(xHeavy, &ullHeavyUs);
+    (void)xCGroupGetCpuTime(xLight, &ullLightUs);
+
+    ullTotalUs = ullHeavyUs + ullLightUs;
+    if (ullTotalUs > 0U) {
+        xil_printf("Cgroup\tWeight\tTasks\tCPU us\t\tShare\tExpected\r\n");
+        xil_printf("heavy\t%lu\t1\t%lu\t%lu%%\t%lu%%\r\n", (unsigned long)BENCH_WEIGHT_HEAVY,
+                   (unsigned long)ullHeavyUs, (unsigned long)((ullHeavyUs * 100U) / ullTotalUs),
+                   (unsigned long)((BENCH_WEIGHT_HEAVY * 100U) /
+                                   (BENCH_WEIGHT_HEAVY + BENCH_WEIGHT_LIGHT)));
+        xil_printf("light\t%lu\t%lu\t%lu\t%lu%%\t%lu%%\r\n", (unsigned long)BENCH_WEIGHT_LIGHT,
+                   (unsigned long)BENCH_WEIGHT_LIGHT_TASKS, (unsigned long)ullLightUs,
+                   (unsigned long)((ullLightUs * 100U) / ullTotalUs),
+                   (unsigned long)((BENCH_WEIGHT_LIGHT * 100U) /
+                                   (BENCH_WEIGHT_HEAVY + BENCH_WEIGHT_LIGHT)));
+    }
+
+cleanup:
+    /* Deleting a task also removes it from its cgroup */
+    while (uxTasks > 0U) {
+        uxTasks--;
+        vTaskDelete(xSpinTasks[uxTasks]);
+    }
+
+    if (xHeavy != NULL) {
+        (void)xCGroupDelete(xHeavy);
+    }
+    if (xLight != NULL) {
+        (void)xCGroupDelete(xLight);
+    }
+
+    xil_printf("cgroup-weight: done\r\n");
+    vTaskDelete(NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+static void vCGroupPoolStressTask(void *pvParameters) {
+    CGroupHandle_t xStale;
+    UBaseType_t    uxBaseCount;
+    UBaseType_t    uxLive = 0U;
+    UBaseType_t    uxRound;
+    UBaseType_t    uxSlot;
+    UBaseType_t    uxErrors = 0U;
+    uint64_t       ullStart;
+    uint64_t       ullCreate;
+    uint64_t       ullChurn;
+    uint64_t       ullFrequency;
+
+    (void)pvParameters;
+
+    ullFrequency = prvReadCounterFrequency();
+    uxBaseCount = uxCGroupGetCount();
+
+    /* Grow the pool well past the old fixed table */
+    ullStart = prvReadCounter();
+    while (uxLive < BENCH_POOL_LIVE) {
+        xPoolCGroups[uxLive] = xCGroupCreate("pool", CGROUP_NO_LIMIT, CGROUP_CPU_QUOTA_MAX);
+        if (xPoolCGroups[uxLive] == NULL) {
+            xil_printf("cgroup-pool: create failed at %lu cgroups\r\n", (unsigned long)uxLive);
+            goto cleanup;
+        }
+        uxLive++;
+    }
+    ullCreate = (prvReadCounter() - ullStart) / BENCH_POOL_LIVE;
+
+    if (uxCGroupGetCount() != (uxBaseCount + BENCH_POOL_LIVE)) {
+        uxErrors++;
+    }
+
+    /* Delete and recreate, the new cgroup reuses the deleted one so the old
+     * handle must be rejected from then on */
+    ullStart = prvReadCounter();
+    for (uxRound = 0U; uxRound < BENCH_POOL_CHURN; uxRound++) {
+        uxSlot = (uxRound * 7U) % BENCH_POOL_LIVE;
+        xStale = xPoolCGroups[uxSlot];
+
+        if (xCGroupDelete(xStale) != pdPASS) {
+            uxErrors++;
+        }
+
+        xPoolCGroups[uxSlot] = xCGroupCreate("pool", CGROUP_NO_LIMIT, CGROUP_CPU_QUOTA_MAX);
+        if (xPoolCGroups[uxSlot] == NULL) {
+            xil_printf("cgroup-pool: create failed in round %lu\r\n", (unsigned long)uxRound);
+            uxLive--;
+            xPoolCGroups[uxSlot] = xPoolCGroups[uxLive];
+            goto cleanup;
+        }
+
+        if ((xPoolCGroups[uxSlot] == xStale) || (xCGroupDelete(xStale) != pdFAIL) ||
+            (xCGroupSetCpuQuota(xStale, CGROUP_CPU_QUOTA_MAX) != pdFAIL) ||
+            (xCGroupAddTask(xStale, xTaskGetCurrentTaskHandle()) != pdFAIL)) {
+            uxErrors++;
+        }
+    }
+    ullChurn = (prvReadCounter() - ullStart) / BENCH_POOL_CHURN;
+
+    xil_printf("cgroup-pool: %lu cgroups, create %lu ns, delete+create %lu ns, %lu errors\r\n",
+               (unsigned long)uxCGroupGetCount(), prvCountsToNs(ullCreate, ullFrequency),
+               prvCountsToNs(ullChurn, ullFrequency), (unsigned long)uxErrors);
+
+cleanup:
+    while (uxLive > 0U) {
+        uxLive--;
+        (void)xCGroupDelete(xPoolCGroups[uxLive]);
+    }
+
+    if (uxCGroupGetCount() != uxBaseCount) {
+        xil_printf("cgroup-pool: %lu cgroups left behind\r\n",
+                   (unsigned long)(uxCGroupGetCount() - uxBaseCount));
+    }
+
+    xil_printf("cgroup-pool: done\r\n");
+    vTaskDelete(NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+static void vCGroupTickBenchmarkTask(void *pvParameters) {
+    UBaseType_t uxStep;
+    UBaseType_t uxCGroups = 0U;
+    UBaseType_t uxRound;
+    uint64_t    ullStart;
+    uint64_t    ullTotal;
+    uint64_t    ullMax;
+    uint64_t    ullCounts;
+    uint64_t    ullFrequency;
+
+    (void)pvParameters;
+
+    ullFrequency = prvReadCounterFrequency();
+
+    xil_printf("CGroups\tTick hook avg (cnt/ns)\tmax (cnt/ns)\r\n");
+
+    for (uxStep = 0U; uxStep < sizeof(uxBenchTickCGroups) / sizeof(uxBenchTickCGroups[0]);
+         uxStep++) {
+        /* Idle cgroups with a quota, the old tick walked all of them */
+        while (uxCGroups < uxBenchTickCGroups[uxStep]) {
+            xTickCGroups[uxCGroups] = xCGroupCreate("tick", CGROUP_NO_LIMIT, 5000U);
+            if (xTickCGroups[uxCGroups] == NULL) {
+                xil_printf("cgroup-tick: create failed at %lu cgroups\r\n",
+                           (unsigned long)uxCGroups);
+                goto cleanup;
+            }
+            uxCGroups++;
+        }
+
+        /* Run the hook the way the tick interrupt does, with interrupts masked */
+        ullTotal = 0U;
+        ullMax = 0U;
+        for (uxRound = 0U; uxRound < BENCH_TICK_ROUNDS; uxRound++) {
+            taskENTER_CRITICAL();
+            ullStart = prvReadCounter();
+            (void)prvCGroupUpdateTick();
+            ullCounts = prvReadCounter() - ullStart;
+            taskEXIT_CRITICAL();
+
+            ullTotal += ullCounts;
+            if (ullCounts > ullMax) {
+                ullMax = ullCounts;
+            }
+        }
+        ullTotal /= BENCH_TICK_ROUNDS;
+
+        xil_printf("%lu\t%lu/%lu\t\t\t%lu/%lu\r\n", (unsigned long)uxCGroups,
+                   (unsigned long)ullTotal, prvCountsToNs(ullTotal, ullFrequency),
+                   (unsigned long)ullMax, prvCountsToNs(ullMax, ullFrequency));
+    }
+
+cleanup:
+    while (uxCGroups > 0U) {
+        uxCGroups--;
+        (void)xCGroupDelete(xTickCGroups[uxCGroups]);
+    }
+
+    xil_printf("cgroup-tick: done\r\n");
+    vTaskDelete(NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+void vCGroupBenchmarkStart(void) {
+    (void)xTaskCreate(vCGroupBenchmarkTask, "CGBench", configMINIMAL_STACK_SIZE * 4, NULL,
+                      BENCH_DRIVER_PRIORITY, &xBenchDriver);
+}
+
+void vCGroupWeightBenchmarkStart(void) {
+    (void)xTaskCreate(vCGroupWeightBenchmarkTask, "CGWeight", configMINIMAL_STACK_SIZE * 4, NULL,
+                      BENCH_DRIVER_PRIORITY, NULL);
+}
+
+void vCGroupPoolStressStart(void) {
+    (void)xTaskCreate(vCGroupPoolStressTask, "CGPool", configMINIMAL_STACK_SIZE * 4, NULL,
+                      BENCH_DRIVER_PRIORITY, NULL);
+}
+
+void vCGroupTickBenchmarkStart(void) {
+    (void)xTaskCreate(vCGroupTickBenchmarkTask, "CGTick", configMINIMAL_STACK_SIZE * 4, NULL,
+                      BENCH_DRIVER_PRIORITY, NULL);
+}
+
+#endif /* configUSE_CGROUPS == 1 */
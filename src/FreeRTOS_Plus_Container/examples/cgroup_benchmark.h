@@ -0,0 +1,67 @@
+/*
+ * CGroup Benchmark Header
+ * Measures cgroup overhead on the scheduler, heap and tick paths, the CPU
+ * split achieved by cgroup weights, and stresses the cgroup pool
+ */
+
+#ifndef CGROUP_BENCHMARK_H
+#define CGROUP_BENCHMARK_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#if (configUSE_CGROUPS == 1)
+
+/**
+ * @brief Start the cgroup benchmark task
+ *
+ * Reports context switch and pvPortMalloc/vPortFree cost, in ARM generic
+ * timer counts, against the number of tasks that are members of cgroups.
+ * Results are printed on the console when the run completes.
+ */
+void vCGroupBenchmarkStart(void);
+
+/**
+ * @brief Start the cgroup CPU weight benchmark task
+ *
+ * Runs busy tasks of two cgroups with different weights and task counts at
+ * the same priority, then prints the CPU split each cgroup achieved next to
+ * the split its weight asks for.
+ */
+void vCGroupWeightBenchmarkStart(void);
+
+/**
+ * @brief Start the cgroup pool stress task
+ *
+ * Creates and deletes thousands of cgroups while a few hundred stay alive,
+ * checks that handles to deleted cgroups are rejected, and prints the create
+ * and delete cost.
+ */
+void vCGroupPoolStressStart(void);
+
+/**
+ * @brief Start the cgroup tick benchmark task
+ *
+ * Times the cgroup work done by the tick interrupt against the number of
+ * cgroups that exist.
+ */
+void vCGroupTickBenchmarkStart(void);
+
+#else
+
+    #define vCGroupBenchmarkStart()                                                                \
+        do {                                                                                       \
+        } while (0)
+    #define vCGroupWeightBenchmarkStart()                                                          \
+        do {                                                                                       \
+        } while (0)
+    #define vCGroupPoolStressStart()                                                               \
+        do {                                                                                       \
+        } while (0)
+    #define vCGroupTickBenchmarkStart()                                                            \
+        do {                                                                                       \
+        } while (0)
+
+#endif /* configUSE_CGROUPS == 1 */
+
+#endif /* CGROUP_BENCHMARK_H */
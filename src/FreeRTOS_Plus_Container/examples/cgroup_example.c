@@ -85,7 +85,7 @@ static void vMonitorTask(void *pvParameters) {
                 /* Display CPU and Memory statistics */
                 volatile UBaseType_t ulHighQuotaUsed = xCpuStats.ulTicksUsed;
                 volatile UBaseType_t ulHighQuotaLimit = xCpuStats.ulTicksQuota;
-                volatile UBaseType_t ulHighPenalty = xCpuStats.ulPenaltyTicksLeft;
+                volatile UBaseType_t ulHighThrottled = xCpuStats.ulThrottleCount;
                 volatile UBaseType_t ulHighMemUsed = xMemoryStats.ulMemoryUsed;
                 volatile UBaseType_t ulHighMemLimit = xMemoryStats.ulMemoryLimit;
                 volatile UBaseType_t ulHighMemPeak = xMemoryStats.ulMemoryPeak;
@@ -95,8 +95,8 @@ static void vMonitorTask(void *pvParameters) {
                 uart_puthex(ulHighQuotaUsed);
                 uart_puts(", Limit: ");
                 uart_puthex(ulHighQuotaLimit);
-                uart_puts(", Penalty: ");
-                uart_puthex(ulHighPenalty);
+                uart_puts(", Throttled: ");
+                uart_puthex(ulHighThrottled);
                 uart_puts("\nMEM - Used: ");
                 uart_puthex(ulHighMemUsed);
                 uart_puts(", Limit: ");
@@ -112,7 +112,7 @@ static void vMonitorTask(void *pvParameters) {
             if (xCGroupGetStats(xLowQuotaCGroup, &xMemoryStats, &xCpuStats) == pdPASS) {
                 volatile UBaseType_t ulLowQuotaUsed = xCpuStats.ulTicksUsed;
                 volatile UBaseType_t ulLowQuotaLimit = xCpuStats.ulTicksQuota;
-                volatile UBaseType_t ulLowPenalty = xCpuStats.ulPenaltyTicksLeft;
+                volatile UBaseType_t ulLowThrottled = xCpuStats.ulThrottleCount;
                 volatile UBaseType_t ulLowMemUsed = xMemoryStats.ulMemoryUsed;
                 volatile UBaseType_t ulLowMemLimit = xMemoryStats.ulMemoryLimit;
                 volatile UBaseType_t ulLowMemPeak = xMemoryStats.ulMemoryPeak;
@@ -122,8 +122,8 @@ static void vMonitorTask(void *pvParameters) {
                 uart_puthex(ulLowQuotaUsed);
                 uart_puts(", Limit: ");
                 uart_puthex(ulLowQuotaLimit);
-                uart_puts(", Penalty: ");
-                uart_puthex(ulLowPenalty);
+                uart_puts(", Throttled: ");
+                uart_puthex(ulLowThrottled);
                 uart_puts("\nMEM - Used: ");
                 uart_puthex(ulLowMemUsed);
                 uart_puts(", Limit: ");
@@ -208,12 +208,12 @@ void vCGroupAutomaticExampleInit(void) {
     uart_puts("Creating CGroups...\n");
 
     /* Create high quota cgroup (70% CPU, 16KB memory limit) */
-    xHighQuotaCGroup = xCGroupCreate("HighQuota", 16384, 300);
+    xHighQuotaCGroup = xCGroupCreate("HighQuota", 16384, 7000);
     configASSERT(xHighQuotaCGroup != NULL);
     uart_puts("HighQuota CGroup created with 16KB memory limit\n");
 
     /* Create low quota cgroup (20% CPU, 8KB memory limit) */
-    xLowQuotaCGroup = xCGroupCreate("LowQuota", 8192, 20);
+    xLowQuotaCGroup = xCGroupCreate("LowQuota", 8192, 2000);
     configASSERT(xLowQuotaCGroup != NULL);
     uart_puts("LowQuota CGroup created with 8KB memory limit\n");
 
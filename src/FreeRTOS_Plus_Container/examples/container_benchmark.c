@@ -0,0 +1,489 @@
+/*
+ * FreeRTOS Container Benchmark
+ * Measures the container registry as the number of containers grows.
+ *
+ * For each step the benchmark creates containers named "bench<n>" until the
+ * step count is reached, then times:
+ *  - xContainerCreateWithLimits() for the containers added in the step
+ *  - pxContainerGetByID() and pxContainerGetByName() for every container
+ *  - xContainerDelete() of every container, on the last step only
+ *
+ * Create and delete include the cgroup of each container. The PID and IPC
+ * namespace pools are small, so past the first few containers creation runs
+ * without namespaces, which the container manager tolerates.
+ *
+ * Names are chosen so that "bench1" is a prefix of "bench10" and "bench100";
+ * a name lookup returning any container but the one asked for is an error.
+ *
+ * Times are read from the ARM generic timer (CNTVCT_EL0). With the hashed
+ * registry the lookup columns should stay flat as the container count grows.
+ *
+ * The start benchmark measures the time from xContainerStart() until the
+ * program's main() is entered, as stamped by the loader just before it jumps
+ * to the entry, so the task start, the image lookup and the ELF load are all
+ * part of the figures. Give it a program whose main() returns 0 at once. Each
+ * run starts a freshly created container, first with the task pool disabled,
+ * so every start creates its task, then with the pool filled before each start.
+ *
+ * The image cache benchmark times getting a program image from the file
+ * system (cold) against getting it from the cache (warm), and compares the
+ * heap used by several references to the image with the size of one copy.
+ *
+ * The load benchmark times elf_load_and_run_prepared() on a cached image:
+ * cold starts relocate the program and keep the relocated copy, warm starts
+ * copy it and redo only the relocations that depend on the load address.
+ * Plain elf_load_and_run_owned() is timed as the baseline. The program runs
+ * in the benchmark task, give it a main() that returns 0 at once. Next to the
+ * start times it prints the rate the loader wrote program memory at, from the
+ * loader's own statistics, which stop the clock before main() is entered.
+ */
+
+#include "container_benchmark.h"
+#include "FreeRTOS.h"
+#include "container.h"
+#include "elf_loader.h"
+#include "image_cache.h"
+#include "task.h"
+#include "xil_printf.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define BENCH_REGISTRY_MAX 4096U
+#define BENCH_REGISTRY_STACK 1024U
+#define BENCH_REGISTRY_MEMORY 4096U
+#define BENCH_REGISTRY_CPU 1000U
+
+#define BENCH_START_RUNS 100U
+#define BENCH_IMAGE_REPLICAS 8U
+#define BENCH_LOAD_RUNS 20U
+
+#define BENCH_DRIVER_PRIORITY (configMAX_PRIORITIES - 1)
+#define BENCH_CONTAINER_PRIORITY (configMAX_PRIORITIES - 2)
+
+/* Container counts measured */
+static const UBaseType_t uxBenchRegistrySteps[] = {16U, 256U, 1024U, BENCH_REGISTRY_MAX};
+
+static uint32_t ulBenchIDs[BENCH_REGISTRY_MAX];
+
+static const char *pcBenchStartProgram = NULL;
+static uint64_t    ullStartLatency[BENCH_START_RUNS];
+
+/*-----------------------------------------------------------*/
+
+static inline uint64_t prvReadCounter(void) {
+    uint64_t ullValue;
+
+    __asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(ullValue) : : "memory");
+    return ullValue;
+}
+
+static inline uint64_t prvReadCounterFrequency(void) {
+    uint64_t ullValue;
+
+    __asm volatile("mrs %0, cntfrq_el0" : "=r"(ullValue));
+    return ullValue;
+}
+
+static unsigned long prvCountsToNs(uint64_t ullCounts, uint64_t ullFrequency) {
+    if (ullFrequency == 0U) {
+        return 0UL;
+    }
+
+    return (unsigned long)((ullCounts * 1000000000ULL) / ullFrequency);
+}
+
+static void prvBenchName(char *pcName, size_t xLength, UBaseType_t uxIndex) {
+    (void)snprintf(pcName, xLength, "bench%lu", (unsigned long)uxIndex);
+}
+
+/*-----------------------------------------------------------*/
+
+static void vContainerRegistryBenchmarkTask(void *pvParameters) {
+    Container_t *pxContainer;
+    char         pcName[16];
+    UBaseType_t  uxStep;
+    UBaseType_t  uxCount = 0U;
+    UBaseType_t  uxStepStart;
+    UBaseType_t  uxIndex;
+    UBaseType_t  uxErrors = 0U;
+    uint32_t     ulBaseCount;
+    uint64_t     ullStart;
+    uint64_t     ullCreate;
+    uint64_t     ullByID;
+    uint64_t     ullByName;
+    uint64_t     ullDelete;
+    uint64_t     ullFrequency;
+
+    (void)pvParameters;
+
+    ullFrequency = prvReadCounterFrequency();
+    ulBaseCount = ulContainerGetCount();
+
+    xil_printf("Containers\tCreate (ns)\tBy ID (ns)\tBy name (ns)\r\n");
+
+    for (uxStep = 0U; uxStep < sizeof(uxBenchRegistrySteps) / sizeof(uxBenchRegistrySteps[0]);
+         uxStep++) {
+        /* Grow to the step count, names are formatted outside the timed region */
+        uxStepStart = uxCount;
+        ullCreate = 0U;
+        while (uxCount < uxBenchRegistrySteps[uxStep]) {
+            prvBenchName(pcName, sizeof(pcName), uxCount);
+
+            ullStart = prvReadCounter();
+            if (xContainerCreateWithLimits(pcName, "bench", BENCH_REGISTRY_STACK,
+                                           tskIDLE_PRIORITY + 1, BENCH_REGISTRY_MEMORY,
+                                           BENCH_REGISTRY_CPU) != pdPASS) {
+                xil_printf("container-bench: create failed at %lu containers\r\n",
+                           (unsigned long)uxCount);
+                goto cleanup;
+            }
+            ullCreate += prvReadCounter() - ullStart;
+
+            pxContainer = pxContainerGetByName(pcName);
+            if (pxContainer == NULL) {
+                xil_printf("container-bench: '%s' not found after create\r\n", pcName);
+                goto cleanup;
+            }
+            ulBenchIDs[uxCount] = pxContainer->ulContainerID;
+            uxCount++;
+        }
+        ullCreate /= (uxCount - uxStepStart);
+
+        if (ulContainerGetCount() != (ulBaseCount + uxCount)) {
+            uxErrors++;
+        }
+
+        /* Look every container up by ID */
+        ullStart = prvReadCounter();
+        for (uxIndex = 0U; uxIndex < uxCount; uxIndex++) {
+            pxContainer = pxContainerGetByID(ulBenchIDs[uxIndex]);
+            if ((pxContainer == NULL) || (pxContainer->ulContainerID != ulBenchIDs[uxIndex])) {
+                uxErrors++;
+            }
+        }
+        ullByID = (prvReadCounter() - ullStart) / uxCount;
+
+        /* Look every container up by name, the name is formatted outside the timed region */
+        ullByName = 0U;
+        for (uxIndex = 0U; uxIndex < uxCount; uxIndex++) {
+            prvBenchName(pcName, sizeof(pcName), uxIndex);
+
+            ullStart = prvReadCounter();
+            pxContainer = pxContainerGetByName(pcName);
+            ullByName += prvReadCounter() - ullStart;
+
+            if ((pxContainer == NULL) || (pxContainer->ulContainerID != ulBenchIDs[uxIndex])) {
+                uxErrors++;
+            }
+        }
+        ullByName /= uxCount;
+
+        xil_printf("%lu\t\t%lu\t\t%lu\t\t%lu\r\n", (unsigned long)uxCount,
+                   prvCountsToNs(ullCreate, ullFrequency), prvCountsToNs(ullByID, ullFrequency),
+                   prvCountsToNs(ullByName, ullFrequency));
+    }
+
+    /* Names that were never created, or are a prefix of one that was, must not match */
+    if ((pxContainerGetByName("bench") != NULL) || (pxContainerGetByName("bench1x") != NULL)) {
+        uxErrors++;
+    }
+
+    /* Delete in creation order, the oldest containers sit at the tail of the list */
+    ullStart = prvReadCounter();
+    for (uxIndex = 0U; uxIndex < uxCount; uxIndex++) {
+        if (xContainerDelete(ulBenchIDs[uxIndex]) != pdPASS) {
+            uxErrors++;
+        }
+    }
+    ullDelete = (prvReadCounter() - ullStart) / uxCount;
+    uxCount = 0U;
+
+    xil_printf("container-bench: delete %lu ns, %lu errors\r\n",
+               prvCountsToNs(ullDelete, ullFrequency), (unsigned long)uxErrors);
+
+cleanup:
+    while (uxCount > 0U) {
+        uxCount--;
+        (void)xContainerDelete(ulBenchIDs[uxCount]);
+    }
+
+    if (ulContainerGetCount() != ulBaseCount) {
+        xil_printf("container-bench: %lu containers left behind\r\n",
+                   (unsigned long)(ulContainerGetCount() - ulBaseCount));
+    }
+
+    xil_printf("container-bench: done\r\n");
+    vTaskDelete(NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+/* Start BENCH_START_RUNS containers one after the other and record their latency */
+static BaseType_t prvMeasureStart(BaseType_t xPooled) {
+    Container_t   *pxContainer;
+    ELF_LOAD_STATS xStats;
+    UBaseType_t    uxRun;
+    uint64_t       ullStart;
+    uint32_t       ulLoads;
+    uint32_t       ulID;
+
+    for (uxRun = 0U; uxRun < BENCH_START_RUNS; uxRun++) {
+        /* Let the daemon put back the slot the previous start took */
+        while ((xPooled != pdFALSE) && (uxContainerPoolGetFree() == 0U)) {
+            vTaskDelay(1);
+        }
+
+        if (xContainerCreateWithLimits("benchstart", pcBenchStartProgram,
+                                       configMINIMAL_STACK_SIZE * 2, BENCH_CONTAINER_PRIORITY,
+                                       BENCH_REGISTRY_MEMORY, BENCH_REGISTRY_CPU) != pdPASS) {
+            xil_printf("container-start: create failed in run %lu\r\n", (unsigned long)uxRun);
+            return pdFAIL;
+        }
+        pxContainer = pxContainerGetByName("benchstart");
+        if (pxContainer == NULL) {
+            return pdFAIL;
+        }
+        ulID = pxContainer->ulContainerID;
+
+        elf_get_load_stats(&xStats);
+        ulLoads = xStats.loads;
+
+        ullStart = prvReadCounter();
+        if (xContainerStart(ulID) != pdPASS) {
+            xil_printf("container-start: start failed in run %lu\r\n", (unsigned long)uxRun);
+            (void)xContainerDelete(ulID);
+            return pdFAIL;
+        }
+        (void)xContainerWait(ulID, portMAX_DELAY);
+        (void)xContainerDelete(ulID);
+
+        /* The program ran to completion, the loader stamped the jump to its entry */
+        elf_get_load_stats(&xStats);
+        if (xStats.loads == ulLoads) {
+            xil_printf("container-start: %s did not run in run %lu\r\n", pcBenchStartProgram,
+                       (unsigned long)uxRun);
+            return pdFAIL;
+        }
+        ullStartLatency[uxRun] = xStats.last_entry - ullStart;
+    }
+
+    return pdPASS;
+}
+
+static void prvPrintStartLatency(const char *pcLabel, uint64_t ullFrequency) {
+    UBaseType_t uxIndex;
+    UBaseType_t uxSorted;
+    uint64_t    ullValue;
+
+    /* Insertion sort, the run count is small */
+    for (uxSorted = 1U; uxSorted < BENCH_START_RUNS; uxSorted++) {
+        ullValue = ullStartLatency[uxSorted];
+        uxIndex = uxSorted;
+        while ((uxIndex > 0U) && (ullStartLatency[uxIndex - 1U] > ullValue)) {
+            ullStartLatency[uxIndex] = ullStartLatency[uxIndex - 1U];
+            uxIndex--;
+        }
+        ullStartLatency[uxIndex] = ullValue;
+    }
+
+    xil_printf("%s\t%lu\t%lu\t%lu\t%lu\r\n", pcLabel,
+               prvCountsToNs(ullStartLatency[BENCH_START_RUNS / 2U], ullFrequency),
+               prvCountsToNs(ullStartLatency[(BENCH_START_RUNS * 90U) / 100U], ullFrequency),
+               prvCountsToNs(ullStartLatency[(BENCH_START_RUNS * 99U) / 100U], ullFrequency),
+               prvCountsToNs(ullStartLatency[BENCH_START_RUNS - 1U], ullFrequency));
+}
+
+static void vContainerStartBenchmarkTask(void *pvParameters) {
+    uint64_t ullFrequency;
+
+    (void)pvParameters;
+
+    ullFrequency = prvReadCounterFrequency();
+
+    xil_printf("Start to main (ns)\tp50\tp90\tp99\tmax\r\n");
+
+    if ((xContainerPoolSetSize(0U) == pdPASS) && (prvMeasureStart(pdFALSE) == pdPASS)) {
+        prvPrintStartLatency("no pool\t\t", ullFrequency);
+    }
+
+    if ((xContainerPoolSetSize(CONTAINER_POOL_SIZE > 0U ? CONTAINER_POOL_SIZE : 1U) == pdPASS) &&
+        (prvMeasureStart(pdTRUE) == pdPASS)) {
+        prvPrintStartLatency("pool\t\t", ullFrequency);
+    }
+
+    (void)xContainerPoolSetSize(CONTAINER_POOL_SIZE);
+
+    xil_printf("container-start: done\r\n");
+    vTaskDelete(NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+#ifdef configUSE_FILESYSTEM
+static const char *pcBenchImagePath = NULL;
+
+static void vImageCacheBenchmarkTask(void *pvParameters) {
+    ImageHandle_t  xImages[BENCH_IMAGE_REPLICAS];
+    const uint8_t *pucData;
+    size_t         xSize = 0U;
+    size_t         xHeapBefore;
+    uint64_t       ullFrequency;
+    uint64_t       ullCold;
+    uint64_t       ullWarm;
+    UBaseType_t    uxIndex;
+
+    (void)pvParameters;
+
+    ullFrequency = prvReadCounterFrequency();
+
+    /* Start from an empty cache so the first acquire reads the file */
+    (void)xImageCacheTrim(0U);
+    xHeapBefore = xPortGetFreeHeapSize();
+
+    ullCold = prvReadCounter();
+    xImages[0] = xImageCacheAcquire(pcBenchImagePath, &pucData, &xSize);
+    ullCold = prvReadCounter() - ullCold;
+    if (xImages[0] == NULL) {
+        xil_printf("image-bench: cannot read %s\r\n", pcBenchImagePath);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    ullWarm = prvReadCounter();
+    for (uxIndex = 1U; uxIndex < BENCH_IMAGE_REPLICAS; uxIndex++) {
+        xImages[uxIndex] = xImageCacheAcquire(pcBenchImagePath, &pucData, &xSize);
+    }
+    ullWarm = (prvReadCounter() - ullWarm) / (BENCH_IMAGE_REPLICAS - 1U);
+
+    xil_printf("Image %s (%lu bytes)\r\n", pcBenchImagePath, (unsigned long)xSize);
+    xil_printf("cold acquire (ns)\t%lu\r\n", prvCountsToNs(ullCold, ullFrequency));
+    xil_printf("warm acquire (ns)\t%lu\r\n", prvCountsToNs(ullWarm, ullFrequency));
+    xil_printf("heap for %lu references\t%lu bytes (%lu without sharing)\r\n",
+               (unsigned long)BENCH_IMAGE_REPLICAS,
+               (unsigned long)(xHeapBefore - xPortGetFreeHeapSize()),
+               (unsigned long)(xSize * BENCH_IMAGE_REPLICAS));
+
+    for (uxIndex = 0U; uxIndex < BENCH_IMAGE_REPLICAS; uxIndex++) {
+        vImageCacheRelease(xImages[uxIndex]);
+    }
+
+    xil_printf("image-bench: done\r\n");
+    vTaskDelete(NULL);
+}
+
+void vImageCacheBenchmarkStart(const char *pcPath) {
+    pcBenchImagePath = pcPath;
+    (void)xTaskCreate(vImageCacheBenchmarkTask, "ImgBench", configMINIMAL_STACK_SIZE * 4, NULL,
+                      BENCH_DRIVER_PRIORITY, NULL);
+}
+
+/*-----------------------------------------------------------*/
+
+static const char *pcBenchLoadPath = NULL;
+
+/* Bytes per second the loader wrote program memory at between two snapshots of its statistics */
+static unsigned long prvLoadRate(const ELF_LOAD_STATS *pxBefore, const ELF_LOAD_STATS *pxAfter) {
+    uint64_t ullCounts = pxAfter->counts - pxBefore->counts;
+
+    if (ullCounts == 0U) {
+        return 0UL;
+    }
+    return (unsigned long)(((pxAfter->bytes - pxBefore->bytes) * pxAfter->frequency) / ullCounts);
+}
+
+static void vElfLoadBenchmarkTask(void *pvParameters) {
+    ImageHandle_t  xImage;
+    ELF_PREPARED   xPrepared = NULL;
+    ELF_LOAD_STATS xStats[4];
+    const uint8_t *pucData;
+    size_t         xSize = 0U;
+    uint64_t       ullFrequency;
+    uint64_t       ullPlain = 0U;
+    uint64_t       ullCold = 0U;
+    uint64_t       ullWarm = 0U;
+    uint64_t       ullStart;
+    UBaseType_t    uxIndex;
+    int            iResult = ELF_SUCCESS;
+
+    (void)pvParameters;
+
+    ullFrequency = prvReadCounterFrequency();
+
+    xImage = xImageCacheAcquire(pcBenchLoadPath, &pucData, &xSize);
+    if (xImage == NULL) {
+        xil_printf("load-bench: cannot read %s\r\n", pcBenchLoadPath);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    elf_get_load_stats(&xStats[0]);
+    for (uxIndex = 0U; uxIndex < BENCH_LOAD_RUNS && iResult >= ELF_SUCCESS; uxIndex++) {
+        ullStart = prvReadCounter();
+        iResult = elf_load_and_run_owned(pucData, xSize, NULL);
+        ullPlain += prvReadCounter() - ullStart;
+    }
+    elf_get_load_stats(&xStats[1]);
+
+    /* Drop the relocated copy after every cold start so the next one builds it again */
+    for (uxIndex = 0U; uxIndex < BENCH_LOAD_RUNS && iResult >= ELF_SUCCESS; uxIndex++) {
+        elf_prepared_free(xPrepared);
+        xPrepared = NULL;
+        ullStart = prvReadCounter();
+        iResult = elf_load_and_run_prepared(pucData, xSize, NULL, &xPrepared);
+        ullCold += prvReadCounter() - ullStart;
+    }
+    elf_get_load_stats(&xStats[2]);
+
+    for (uxIndex = 0U; uxIndex < BENCH_LOAD_RUNS && iResult >= ELF_SUCCESS; uxIndex++) {
+        ullStart = prvReadCounter();
+        iResult = elf_load_and_run_prepared(pucData, xSize, NULL, &xPrepared);
+        ullWarm += prvReadCounter() - ullStart;
+    }
+    elf_get_load_stats(&xStats[3]);
+
+    if (iResult < ELF_SUCCESS) {
+        xil_printf("load-bench: %s failed to run (%d)\r\n", pcBenchLoadPath, iResult);
+    } else {
+        xil_printf("Program %s (%lu bytes)\r\n", pcBenchLoadPath, (unsigned long)xSize);
+        xil_printf("Mean of %lu\tns\tload bytes/s\r\n", (unsigned long)BENCH_LOAD_RUNS);
+        xil_printf("plain load\t%lu\t%lu\r\n",
+                   prvCountsToNs(ullPlain / BENCH_LOAD_RUNS, ullFrequency),
+                   prvLoadRate(&xStats[0], &xStats[1]));
+        xil_printf("cold start\t%lu\t%lu\r\n",
+                   prvCountsToNs(ullCold / BENCH_LOAD_RUNS, ullFrequency),
+                   prvLoadRate(&xStats[1], &xStats[2]));
+        if (xPrepared != NULL) {
+            xil_printf("warm start\t%lu\t%lu\r\n",
+                       prvCountsToNs(ullWarm / BENCH_LOAD_RUNS, ullFrequency),
+                       prvLoadRate(&xStats[2], &xStats[3]));
+            xil_printf("relocated copy\t%lu bytes\r\n",
+                       (unsigned long)elf_prepared_size(xPrepared));
+        } else {
+            xil_printf("warm start\tnot available, program cannot be prepared\r\n");
+        }
+    }
+
+    elf_prepared_free(xPrepared);
+    vImageCacheRelease(xImage);
+
+    xil_printf("load-bench: done\r\n");
+    vTaskDelete(NULL);
+}
+
+void vElfLoadBenchmarkStart(const char *pcPath) {
+    pcBenchLoadPath = pcPath;
+    (void)xTaskCreate(vElfLoadBenchmarkTask, "LoadBench", configMINIMAL_STACK_SIZE * 8, NULL,
+                      BENCH_DRIVER_PRIORITY, NULL);
+}
+#endif
+
+void vContainerRegistryBenchmarkStart(void) {
+    (void)xTaskCreate(vContainerRegistryBenchmarkTask, "CtBench", configMINIMAL_STACK_SIZE * 4,
+                      NULL, BENCH_DRIVER_PRIORITY, NULL);
+}
+
+void vContainerStartBenchmarkStart(const char *pcElfName) {
+    pcBenchStartProgram = pcElfName;
+    (void)xTaskCreate(vContainerStartBenchmarkTask, "CtStart", configMINIMAL_STACK_SIZE * 4,
+                      NULL, BENCH_DRIVER_PRIORITY, NULL);
+}
@@ -0,0 +1,61 @@
+/*
+ * Container Benchmark Header
+ * Measures the container registry: create, lookup and delete throughput
+ * against the number of containers that exist, and container start latency
+ * with and without the pre-created task pool, program image loads
+ * with and without the image cache, and cold against warm program starts
+ */
+
+#ifndef CONTAINER_BENCHMARK_H
+#define CONTAINER_BENCHMARK_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief Start the container registry benchmark task
+ *
+ * Creates thousands of containers, times lookups by ID and by name and the
+ * delete of every container, and checks that name lookups only return exact
+ * matches. Results are printed on the console when the run completes.
+ */
+void vContainerRegistryBenchmarkStart(void);
+
+/**
+ * @brief Start the container start latency benchmark task
+ *
+ * Starts a container many times with the task pool disabled and then with
+ * the pool filled, and prints percentiles of the time from xContainerStart()
+ * to the program's main() being entered.
+ *
+ * @param pcElfName Program the containers run, as given to xContainerCreate(),
+ *                  its main() should return 0 at once
+ */
+void vContainerStartBenchmarkStart(const char *pcElfName);
+
+#ifdef configUSE_FILESYSTEM
+/**
+ * @brief Start the image cache benchmark task
+ *
+ * Times a cold acquire of a program image, which reads the file, against
+ * warm acquires served from the cache, and prints the heap used by several
+ * references to the image next to what separate copies would take.
+ *
+ * @param pcPath Path of an ELF file, must stay valid while the task runs
+ */
+void vImageCacheBenchmarkStart(const char *pcPath);
+
+/**
+ * @brief Start the ELF load benchmark task
+ *
+ * Runs a program many times with a plain load, with cold starts that
+ * relocate it and keep the relocated copy, and with warm starts from that
+ * copy, and prints the mean time and load rate of each. The program runs
+ * in the benchmark task, so its main() should return 0 at once.
+ *
+ * @param pcPath Path of an ET_REL ELF file, must stay valid while the task runs
+ */
+void vElfLoadBenchmarkStart(const char *pcPath);
+#endif
+
+#endif /* CONTAINER_BENCHMARK_H */
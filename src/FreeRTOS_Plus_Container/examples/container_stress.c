@@ -0,0 +1,182 @@
+/*
+ * FreeRTOS Container Stress Test
+ * Loads one ELF program in many containers at the same time.
+ *
+ * The driver runs above the containers, so every container is created and
+ * started before the first of them runs; they then load and run side by side,
+ * time sliced at one priority. While they run the driver samples the programs
+ * held by the ELF loader and checks that:
+ *  - no two programs share program memory
+ *  - no container holds more than one program
+ *
+ * Each container is waited for up to STRESS_RUN_TICKS. Containers still
+ * running then are stopped, which frees their program through the daemon
+ * instead of the loader returning. After every container is deleted the
+ * loader must hold no program. The heap in use is printed next to the value
+ * before the run; the container task pool refills in the background, so a
+ * small difference is expected.
+ *
+ * Give the program enough work to still be running at the first sample, a
+ * program that returns at once only exercises the load and release paths.
+ */
+
+#include "container_stress.h"
+#include "FreeRTOS.h"
+#include "container.h"
+#include "elf_loader.h"
+#include "image_cache.h"
+#include "task.h"
+#include "xil_printf.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define STRESS_CONTAINERS 32U
+#define STRESS_MEMORY (64U * 1024U)
+#define STRESS_CPU 1000U
+#define STRESS_SAMPLES 50U
+#define STRESS_RUN_TICKS pdMS_TO_TICKS(10000)
+
+#define STRESS_DRIVER_PRIORITY (configMAX_PRIORITIES - 1)
+#define STRESS_CONTAINER_PRIORITY (tskIDLE_PRIORITY + 1)
+
+static const char *pcStressElfName = NULL;
+
+static uint32_t      ulStressIDs[STRESS_CONTAINERS];
+static ELF_LOAD_INFO xStressLoads[STRESS_CONTAINERS * 2U];
+
+/*-----------------------------------------------------------*/
+
+/* Count program memory shared between loads and containers holding more than one load */
+static UBaseType_t prvCheckLoads(size_t xCount) {
+    UBaseType_t uxErrors = 0U;
+    size_t      xFirst;
+    size_t      xSecond;
+
+    for (xFirst = 0U; xFirst < xCount; xFirst++) {
+        for (xSecond = xFirst + 1U; xSecond < xCount; xSecond++) {
+            const ELF_LOAD_INFO *pxA = &xStressLoads[xFirst];
+            const ELF_LOAD_INFO *pxB = &xStressLoads[xSecond];
+
+            if (pxA->owner != NULL && pxA->owner == pxB->owner) {
+                xil_printf("container-stress: container %s holds two programs\r\n",
+                           ((const Container_t *)pxA->owner)->pcContainerName);
+                uxErrors++;
+            }
+            if (pxA->memory != NULL && pxB->memory != NULL &&
+                pxA->memory < pxB->memory + pxB->size && pxB->memory < pxA->memory + pxA->size) {
+                xil_printf("container-stress: program memory at %lx and %lx overlaps\r\n",
+                           (unsigned long)(uintptr_t)pxA->memory,
+                           (unsigned long)(uintptr_t)pxB->memory);
+                uxErrors++;
+            }
+        }
+    }
+
+    return uxErrors;
+}
+
+static void vContainerStressTask(void *pvParameters) {
+    Container_t *pxContainer;
+    char         pcName[16];
+    UBaseType_t  uxCount = 0U;
+    UBaseType_t  uxIndex;
+    UBaseType_t  uxErrors = 0U;
+    UBaseType_t  uxFailed = 0U;
+    UBaseType_t  uxStopped = 0U;
+    size_t       xLoads;
+    size_t       xPeak = 0U;
+    size_t       xHeapBefore;
+    TickType_t   xWait = STRESS_RUN_TICKS;
+    TimeOut_t    xTimeOut;
+
+    (void)pvParameters;
+
+    if (elf_get_loads(NULL, 0U) != 0U) {
+        xil_printf("container-stress: programs already loaded, results include them\r\n");
+    }
+    xHeapBefore = xPortGetFreeHeapSize();
+
+    for (uxCount = 0U; uxCount < STRESS_CONTAINERS; uxCount++) {
+        (void)snprintf(pcName, sizeof(pcName), "stress%lu", (unsigned long)uxCount);
+        if (xContainerCreateWithLimits(pcName, pcStressElfName, configMINIMAL_STACK_SIZE * 2,
+                                       STRESS_CONTAINER_PRIORITY, STRESS_MEMORY,
+                                       STRESS_CPU) != pdPASS) {
+            xil_printf("container-stress: create failed at %lu containers\r\n",
+                       (unsigned long)uxCount);
+            break;
+        }
+        pxContainer = pxContainerGetByName(pcName);
+        if (pxContainer == NULL) {
+            break;
+        }
+        ulStressIDs[uxCount] = pxContainer->ulContainerID;
+    }
+
+    /* Nothing runs until the driver blocks, every load starts in the same window */
+    for (uxIndex = 0U; uxIndex < uxCount; uxIndex++) {
+        if (xContainerStart(ulStressIDs[uxIndex]) != pdPASS) {
+            xil_printf("container-stress: start of stress%lu failed\r\n", (unsigned long)uxIndex);
+            uxFailed++;
+        }
+    }
+
+    for (uxIndex = 0U; uxIndex < STRESS_SAMPLES; uxIndex++) {
+        vTaskDelay(1);
+        xLoads = elf_get_loads(xStressLoads, STRESS_CONTAINERS * 2U);
+        if (xLoads > STRESS_CONTAINERS * 2U) {
+            xLoads = STRESS_CONTAINERS * 2U;
+        }
+        if (xLoads > xPeak) {
+            xPeak = xLoads;
+        }
+        uxErrors += prvCheckLoads(xLoads);
+        if (xLoads == 0U) {
+            break;
+        }
+    }
+
+    /* One deadline for all containers, xTaskCheckForTimeOut() counts the wait down */
+    vTaskSetTimeOutState(&xTimeOut);
+    for (uxIndex = 0U; uxIndex < uxCount; uxIndex++) {
+        (void)xTaskCheckForTimeOut(&xTimeOut, &xWait);
+        if (xContainerWait(ulStressIDs[uxIndex], xWait) != pdPASS) {
+            (void)xContainerStop(ulStressIDs[uxIndex]);
+            uxStopped++;
+        }
+        pxContainer = pxContainerGetByID(ulStressIDs[uxIndex]);
+        if (pxContainer != NULL && pxContainer->eState == CONTAINER_STATE_ERROR) {
+            uxFailed++;
+        }
+    }
+
+    for (uxIndex = 0U; uxIndex < uxCount; uxIndex++) {
+        (void)xContainerDelete(ulStressIDs[uxIndex]);
+    }
+
+#ifdef configUSE_FILESYSTEM
+    /* The cached image is not a leak, leave it out of the heap figure */
+    (void)xImageCacheTrim(0U);
+#endif
+
+    xLoads = elf_get_loads(NULL, 0U);
+    if (xLoads != 0U) {
+        xil_printf("container-stress: %lu programs left in the loader\r\n", (unsigned long)xLoads);
+        uxErrors++;
+    }
+
+    xil_printf("container-stress: %lu containers, peak %lu concurrent programs, %lu stopped\r\n",
+               (unsigned long)uxCount, (unsigned long)xPeak, (unsigned long)uxStopped);
+    xil_printf("container-stress: heap free %lu before, %lu after\r\n", (unsigned long)xHeapBefore,
+               (unsigned long)xPortGetFreeHeapSize());
+    xil_printf("container-stress: %s, %lu isolation errors, %lu failed containers\r\n",
+               (uxErrors == 0U && uxFailed == 0U) ? "PASS" : "FAIL", (unsigned long)uxErrors,
+               (unsigned long)uxFailed);
+
+    vTaskDelete(NULL);
+}
+
+void vContainerStressStart(const char *pcElfName) {
+    pcStressElfName = pcElfName;
+    (void)xTaskCreate(vContainerStressTask, "CtStress", configMINIMAL_STACK_SIZE * 4, NULL,
+                      STRESS_DRIVER_PRIORITY, NULL);
+}
@@ -0,0 +1,26 @@
+/*
+ * Container Stress Test Header
+ * Runs many containers loading the same ELF program at once and checks that
+ * their program memory never overlaps and is all released afterwards
+ */
+
+#ifndef CONTAINER_STRESS_H
+#define CONTAINER_STRESS_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief Start the concurrent load stress task
+ *
+ * Creates dozens of containers running the same program, starts them all
+ * before any of them is scheduled so their loads interleave, and samples the
+ * programs the ELF loader holds while they run. Containers still running at
+ * the end of the run are stopped. Results are printed on the console when the
+ * run completes.
+ *
+ * @param pcElfName Program run by every container, must stay valid while the task runs
+ */
+void vContainerStressStart(const char *pcElfName);
+
+#endif /* CONTAINER_STRESS_H */
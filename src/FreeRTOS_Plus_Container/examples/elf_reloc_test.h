@@ -0,0 +1,24 @@
+/*
+ * ELF Relocation Self-Test Header
+ * Loads an embedded relocatable object that exercises every AArch64
+ * relocation type the ELF loader supports and checks the relocated code
+ */
+
+#ifndef ELF_RELOC_TEST_H
+#define ELF_RELOC_TEST_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief Start the relocation self-test task
+ *
+ * The task loads and runs the object built from apps/reloc_test.S with
+ * elf_load_and_run(). The program checks each relocated instruction and data
+ * word against an independently computed value and returns pdPASS, or
+ * 100 + the number of the failing check. The result is printed on the console
+ * and the task deletes itself.
+ */
+void vElfRelocationTestStart(void);
+
+#endif /* ELF_RELOC_TEST_H */
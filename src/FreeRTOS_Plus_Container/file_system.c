@@ -1,6 +1,8 @@
 #include "FreeRTOS.h"
 #include "FreeRTOSConfig.h"
+#include "container.h"
 #include "file_system.h"
+#include "image_cache.h"
 #include "task.h"
 
 #ifdef configUSE_LITTLEFS
@@ -83,6 +85,19 @@ static const char *fs_build_full_path(const char *path, char *full_path, size_t
     return full_path;
 }
 
+/**
+ * @brief Check whether the calling task runs a container program
+ *
+ * Only the kernel writes IMAGE_CACHE_ATTR_HASH. A program able to set it could
+ * label its own file with the digest of another program.
+ *
+ * @return pdTRUE for a container task
+ */
+static BaseType_t fs_caller_is_container(void) {
+    return (pvTaskGetThreadLocalStoragePointer(NULL, CONTAINER_TLS_INDEX) != NULL) ? pdTRUE
+                                                                                  : pdFALSE;
+}
+
 /*-----------------------------------------------------------
  * WRAPPER FUNCTIONS - Forward declarations
  *----------------------------------------------------------*/
@@ -302,6 +317,7 @@ static int fs_remove_wrapper(const char *path) {
     if (fs == NULL || fs->pvFsContext == NULL) return LFS_ERR_INVAL;
     const char *full_path = fs_build_full_path(path, tmp_path, configMAX_PATH_LEN);
     if (full_path == NULL) return LFS_ERR_INVAL;
+    vImageCacheInvalidate(full_path);
     return lfs_remove((lfs_t *)fs->pvFsContext, full_path);
 }
 
@@ -318,6 +334,9 @@ static int fs_rename_wrapper(const char *oldpath, const char *newpath) {
     
     if (old_full == NULL || new_full == NULL) return LFS_ERR_INVAL;
     
+    /* Both names stop referring to what the image cache holds for them */
+    vImageCacheInvalidate(old_full);
+    vImageCacheInvalidate(new_full);
     return lfs_rename((lfs_t *)fs->pvFsContext, old_full, new_full);
 }
 #endif
@@ -344,6 +363,7 @@ static int fs_setattr_wrapper(const char *path,
                               uint8_t type, const void *buffer, lfs_size_t size) {
     FileSystem_t *fs = pxGetFileSystem();
     if (fs == NULL || fs->pvFsContext == NULL) return LFS_ERR_INVAL;
+    if (type == IMAGE_CACHE_ATTR_HASH && fs_caller_is_container() == pdTRUE) return LFS_ERR_INVAL;
     const char *full_path = fs_build_full_path(path, tmp_path, configMAX_PATH_LEN);
     if (full_path == NULL) return LFS_ERR_INVAL;
     return lfs_setattr((lfs_t *)fs->pvFsContext, full_path, type, buffer, size);
@@ -365,6 +385,13 @@ static int fs_file_open_wrapper(lfs_file_t *file,
     if (fs == NULL || fs->pvFsContext == NULL) return LFS_ERR_INVAL;
     const char *full_path = fs_build_full_path(path, tmp_path, configMAX_PATH_LEN);
     if (full_path == NULL) return LFS_ERR_INVAL;
+#ifndef LFS_READONLY
+    /* Content written through this handle no longer matches a cached image */
+    if (flags & LFS_O_WRONLY) {
+        (void)lfs_removeattr((lfs_t *)fs->pvFsContext, full_path, IMAGE_CACHE_ATTR_HASH);
+        vImageCacheInvalidate(full_path);
+    }
+#endif
     return lfs_file_open((lfs_t *)fs->pvFsContext, file, full_path, flags);
 }
 #endif
@@ -374,8 +401,23 @@ static int fs_file_opencfg_wrapper(lfs_file_t *file,
                                    const struct lfs_file_config *config) {
     FileSystem_t *fs = pxGetFileSystem();
     if (fs == NULL || fs->pvFsContext == NULL) return LFS_ERR_INVAL;
+#ifndef LFS_READONLY
+    /* Attributes in the configuration are written back when the file is closed */
+    if (config != NULL && (flags & LFS_O_WRONLY) && fs_caller_is_container() == pdTRUE) {
+        for (lfs_size_t i = 0; i < config->attr_count; i++) {
+            if (config->attrs[i].type == IMAGE_CACHE_ATTR_HASH) return LFS_ERR_INVAL;
+        }
+    }
+#endif
     const char *full_path = fs_build_full_path(path, tmp_path, configMAX_PATH_LEN);
     if (full_path == NULL) return LFS_ERR_INVAL;
+#ifndef LFS_READONLY
+    /* Content written through this handle no longer matches a cached image */
+    if (flags & LFS_O_WRONLY) {
+        (void)lfs_removeattr((lfs_t *)fs->pvFsContext, full_path, IMAGE_CACHE_ATTR_HASH);
+        vImageCacheInvalidate(full_path);
+    }
+#endif
     return lfs_file_opencfg((lfs_t *)fs->pvFsContext, file, full_path, flags, config);
 }
 
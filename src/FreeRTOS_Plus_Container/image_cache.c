@@ -0,0 +1,543 @@
+/*
+ * Program image cache for FreeRTOS containers
+ * Copyright (C) 2025
+ */
+
+#include "image_cache.h"
+
+#ifdef configUSE_FILESYSTEM
+#include "cgroup.h"
+#include "file_system.h"
+#include "lfs.h"
+#include "semphr.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef MY_DEBUG
+#include "xil_printf.h"
+#endif
+
+/* Image data starts at this alignment after the entry header */
+#define IMAGE_CACHE_DATA_ALIGN (16U)
+
+/* A cached file. Header, image data and the absolute path share one allocation. Fields other than
+ * the data are protected by xImageCacheMutex. */
+struct ImageCacheEntry {
+    struct ImageCacheEntry *pxNext;
+    uint8_t                *pucData;
+    size_t                  xSize;
+    size_t                  xAllocSize; /* Bytes of the whole allocation */
+    uint8_t                 aucDigest[IMAGE_CACHE_DIGEST_LEN];
+    BaseType_t              xHasHash;   /* Digest checked against the data, else keyed by pcPath */
+    BaseType_t              xStale;     /* File changed, unlinked and freed on the last release */
+    UBaseType_t             uxRefCount;
+    uint32_t                ulLastUse;  /* Stamp of the last acquire, oldest is evicted first */
+    char                   *pcPath;     /* NULL if the path did not fit, only for hashed entries */
+    ELF_PREPARED            xPrepared;  /* Relocated program for warm starts, set by the loader */
+};
+
+static SemaphoreHandle_t       xImageCacheMutex = NULL;
+static struct ImageCacheEntry *pxImageCache = NULL;
+static uint32_t                ulUseStamp = 0;
+static size_t                  xIdleBytes = 0; /* Bytes of entries with no references */
+static ImageCacheStats_t       xCacheStats;
+
+/* Create the cache mutex on first use. Called before the scheduler starts or from tasks, the
+ * critical section only guards against two tasks creating it at once. */
+static BaseType_t prvImageCacheLock(void) {
+    if (xImageCacheMutex == NULL) {
+        SemaphoreHandle_t xMutex = xSemaphoreCreateMutex();
+
+        if (xMutex == NULL) {
+            return pdFAIL;
+        }
+
+        taskENTER_CRITICAL();
+        if (xImageCacheMutex == NULL) {
+            xImageCacheMutex = xMutex;
+            xMutex = NULL;
+        }
+        taskEXIT_CRITICAL();
+
+        if (xMutex != NULL) {
+            vSemaphoreDelete(xMutex);
+        }
+    }
+
+    return xSemaphoreTake(xImageCacheMutex, portMAX_DELAY);
+}
+
+static void prvImageCacheUnlock(void) {
+    xSemaphoreGive(xImageCacheMutex);
+}
+
+/* SHA-256 (FIPS 180-4). Entries with equal digests share one image, so the digest must not let
+ * a crafted file pass for another program. */
+static const uint32_t ulSha256K[64] = {
+    0x428a2f98U, 0x71374491U, 0xb5c0fbcfU, 0xe9b5dba5U, 0x3956c25bU, 0x59f111f1U, 0x923f82a4U,
+    0xab1c5ed5U, 0xd807aa98U, 0x12835b01U, 0x243185beU, 0x550c7dc3U, 0x72be5d74U, 0x80deb1feU,
+    0x9bdc06a7U, 0xc19bf174U, 0xe49b69c1U, 0xefbe4786U, 0x0fc19dc6U, 0x240ca1ccU, 0x2de92c6fU,
+    0x4a7484aaU, 0x5cb0a9dcU, 0x76f988daU, 0x983e5152U, 0xa831c66dU, 0xb00327c8U, 0xbf597fc7U,
+    0xc6e00bf3U, 0xd5a79147U, 0x06ca6351U, 0x14292967U, 0x27b70a85U, 0x2e1b2138U, 0x4d2c6dfcU,
+    0x53380d13U, 0x650a7354U, 0x766a0abbU, 0x81c2c92eU, 0x92722c85U, 0xa2bfe8a1U, 0xa81a664bU,
+    0xc24b8b70U, 0xc76c51a3U, 0xd192e819U, 0xd6990624U, 0xf40e3585U, 0x106aa070U, 0x19a4c116U,
+    0x1e376c08U, 0x2748774cU, 0x34b0bcb5U, 0x391c0cb3U, 0x4ed8aa4aU, 0x5b9cca4fU, 0x682e6ff3U,
+    0x748f82eeU, 0x78a5636fU, 0x84c87814U, 0x8cc70208U, 0x90befffaU, 0xa4506cebU, 0xbef9a3f7U,
+    0xc67178f2U};
+
+#define prvRotr(x, n) (((x) >> (n)) | ((x) << (32U - (n))))
+
+static void prvSha256Block(uint32_t *pulState, const uint8_t *pucBlock) {
+    uint32_t ulW[64];
+    uint32_t a, b, c, d, e, f, g, h, t1, t2;
+    size_t   i;
+
+    for (i = 0; i < 16; i++) {
+        ulW[i] = ((uint32_t)pucBlock[i * 4] << 24) | ((uint32_t)pucBlock[i * 4 + 1] << 16) |
+                 ((uint32_t)pucBlock[i * 4 + 2] << 8) | (uint32_t)pucBlock[i * 4 + 3];
+    }
+    for (i = 16; i < 64; i++) {
+        ulW[i] = ulW[i - 16] + ulW[i - 7] +
+                 (prvRotr(ulW[i - 15], 7) ^ prvRotr(ulW[i - 15], 18) ^ (ulW[i - 15] >> 3)) +
+                 (prvRotr(ulW[i - 2], 17) ^ prvRotr(ulW[i - 2], 19) ^ (ulW[i - 2] >> 10));
+    }
+
+    a = pulState[0];
+    b = pulState[1];
+    c = pulState[2];
+    d = pulState[3];
+    e = pulState[4];
+    f = pulState[5];
+    g = pulState[6];
+    h = pulState[7];
+    for (i = 0; i < 64; i++) {
+        t1 = h + (prvRotr(e, 6) ^ prvRotr(e, 11) ^ prvRotr(e, 25)) + ((e & f) ^ (~e & g)) +
+             ulSha256K[i] + ulW[i];
+        t2 = (prvRotr(a, 2) ^ prvRotr(a, 13) ^ prvRotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    pulState[0] += a;
+    pulState[1] += b;
+    pulState[2] += c;
+    pulState[3] += d;
+    pulState[4] += e;
+    pulState[5] += f;
+    pulState[6] += g;
+    pulState[7] += h;
+}
+
+void vImageCacheDigest(const uint8_t *pucData, size_t xSize, uint8_t *pucDigest) {
+    uint32_t ulState[8] = {0x6a09e667U, 0xbb67ae85U, 0x3c6ef372U, 0xa54ff53aU,
+                           0x510e527fU, 0x9b05688cU, 0x1f83d9abU, 0x5be0cd19U};
+    uint8_t  aucTail[128];
+    uint64_t ullBits = (uint64_t)xSize * 8U;
+    size_t   xDone = xSize & ~(size_t)63U;
+    size_t   xTail = xSize - xDone;
+    size_t   xTailLen;
+    size_t   i;
+
+    for (i = 0; i < xDone; i += 64) {
+        prvSha256Block(ulState, &pucData[i]);
+    }
+
+    /* The last partial block, the 0x80 marker and the bit length take one or two blocks */
+    xTailLen = (xTail < 56) ? 64 : 128;
+    memset(aucTail, 0, sizeof(aucTail));
+    memcpy(aucTail, &pucData[xDone], xTail);
+    aucTail[xTail] = 0x80U;
+    for (i = 0; i < 8; i++) {
+        aucTail[xTailLen - 1 - i] = (uint8_t)(ullBits >> (i * 8));
+    }
+    for (i = 0; i < xTailLen; i += 64) {
+        prvSha256Block(ulState, &aucTail[i]);
+    }
+
+    for (i = 0; i < 8; i++) {
+        pucDigest[i * 4] = (uint8_t)(ulState[i] >> 24);
+        pucDigest[i * 4 + 1] = (uint8_t)(ulState[i] >> 16);
+        pucDigest[i * 4 + 2] = (uint8_t)(ulState[i] >> 8);
+        pucDigest[i * 4 + 3] = (uint8_t)ulState[i];
+    }
+}
+
+/* Build the absolute path of pcPath as seen by the calling task */
+static BaseType_t prvAbsolutePath(const char *pcPath, char *pcBuffer, size_t xBufferLen) {
+    char   acRoot[configMAX_PATH_LEN];
+    size_t xRootLen;
+    int    lLen;
+
+    if (pvTaskGetRootPath(NULL, acRoot) != pdTRUE) {
+        acRoot[0] = '\0';
+    }
+
+    /* Drop the trailing slash of the root, the path brings its own */
+    xRootLen = strnlen(acRoot, sizeof(acRoot) - 1);
+    if (xRootLen > 0 && acRoot[xRootLen - 1] == '/') {
+        xRootLen--;
+    }
+    acRoot[xRootLen] = '\0';
+
+    lLen = snprintf(pcBuffer, xBufferLen, "%s%s%s", acRoot, (pcPath[0] == '/') ? "" : "/", pcPath);
+    return (lLen > 0 && (size_t)lLen < xBufferLen) ? pdPASS : pdFAIL;
+}
+
+static struct ImageCacheEntry *prvImageCacheFind(BaseType_t     xHasHash,
+                                                 const uint8_t *pucDigest,
+                                                 const char    *pcPath,
+                                                 size_t         xSize) {
+    struct ImageCacheEntry *pxEntry;
+
+    for (pxEntry = pxImageCache; pxEntry != NULL; pxEntry = pxEntry->pxNext) {
+        if (pxEntry->xSize != xSize || pxEntry->xHasHash != xHasHash) {
+            continue;
+        }
+        if (xHasHash != pdFALSE
+                ? memcmp(pxEntry->aucDigest, pucDigest, IMAGE_CACHE_DIGEST_LEN) == 0
+                : (pxEntry->pcPath != NULL && strcmp(pxEntry->pcPath, pcPath) == 0)) {
+            return pxEntry;
+        }
+    }
+
+    return NULL;
+}
+
+static void prvImageCacheUnlink(struct ImageCacheEntry *pxEntry) {
+    struct ImageCacheEntry **ppxLink = &pxImageCache;
+
+    while (*ppxLink != NULL && *ppxLink != pxEntry) {
+        ppxLink = &(*ppxLink)->pxNext;
+    }
+    if (*ppxLink != NULL) {
+        *ppxLink = pxEntry->pxNext;
+    }
+}
+
+/* Bytes an entry holds, its relocated program included. The loader only attaches one while the
+ * entry is referenced, so the value does not change while the entry counts as idle. */
+static size_t prvImageCacheEntryBytes(const struct ImageCacheEntry *pxEntry) {
+    return pxEntry->xAllocSize + elf_prepared_size(pxEntry->xPrepared);
+}
+
+/* Free an unlinked entry */
+static void prvImageCacheFree(struct ImageCacheEntry *pxEntry) {
+    elf_prepared_free(pxEntry->xPrepared);
+    vPortFree(pxEntry);
+}
+
+/* Free unreferenced entries, least recently used first, until xBytes are freed. 0 frees them
+ * all. Called with the cache mutex held. */
+static size_t prvImageCacheEvict(size_t xBytes) {
+    struct ImageCacheEntry *pxEntry;
+    struct ImageCacheEntry *pxOldest;
+    size_t                  xFreed = 0;
+
+    while (xBytes == 0 || xFreed < xBytes) {
+        pxOldest = NULL;
+        for (pxEntry = pxImageCache; pxEntry != NULL; pxEntry = pxEntry->pxNext) {
+            if (pxEntry->uxRefCount == 0 &&
+                (pxOldest == NULL || (int32_t)(pxEntry->ulLastUse - pxOldest->ulLastUse) < 0)) {
+                pxOldest = pxEntry;
+            }
+        }
+        if (pxOldest == NULL) {
+            break;
+        }
+
+        prvImageCacheUnlink(pxOldest);
+        xIdleBytes -= prvImageCacheEntryBytes(pxOldest);
+        xCacheStats.xBytes -= pxOldest->xSize;
+        xCacheStats.uxEntries--;
+        xCacheStats.ulEvictions++;
+        xFreed += prvImageCacheEntryBytes(pxOldest);
+        prvImageCacheFree(pxOldest);
+    }
+
+    return xFreed;
+}
+
+/* Evict what exceeds the idle budget, and everything idle while the heap is low */
+static void prvImageCacheBalance(void) {
+    if (xPortGetFreeHeapSize() < configIMAGE_CACHE_LOW_HEAP_BYTES) {
+        (void)prvImageCacheEvict(0);
+    } else if (xIdleBytes > configIMAGE_CACHE_MAX_BYTES) {
+        (void)prvImageCacheEvict(xIdleBytes - configIMAGE_CACHE_MAX_BYTES);
+    }
+}
+
+/* Allocate cache memory without charging the caller's cgroup */
+static void *prvImageCacheAlloc(size_t xSize) {
+    CGroupHandle_t xPrevious = xCGroupSetMemoryChargeTarget(CGROUP_CHARGE_NONE);
+    void          *pvMemory = pvPortMalloc(xSize);
+
+    (void)xCGroupSetMemoryChargeTarget(xPrevious);
+    return pvMemory;
+}
+
+/* Allocate an entry for a file and read it. The copy is shared by every container running the
+ * program and outlives the first one, so it is not charged to any cgroup. Called without the
+ * cache mutex: a container task stopped during the read must not leave the mutex held.
+ * pucDigest is the digest the file's attribute claims. The entry is keyed by it only if the data
+ * read matches, otherwise by pcKeyPath; NULL is returned if neither key is available. */
+static struct ImageCacheEntry *prvImageCacheLoad(LittleFSOps_t *lfs_ops,
+                                                 const char    *pcPath,
+                                                 const char    *pcKeyPath,
+                                                 const uint8_t *pucDigest,
+                                                 size_t         xSize) {
+    struct ImageCacheEntry *pxEntry;
+    size_t                  xHeader;
+    size_t                  xPathLen = (pcKeyPath != NULL) ? strlen(pcKeyPath) + 1 : 0;
+    size_t                  xAllocSize;
+    lfs_file_t              file;
+    lfs_ssize_t             lRead;
+
+    xHeader = (sizeof(*pxEntry) + IMAGE_CACHE_DATA_ALIGN - 1) &
+              ~(size_t)(IMAGE_CACHE_DATA_ALIGN - 1);
+    xAllocSize = xHeader + xSize + xPathLen;
+
+    pxEntry = (struct ImageCacheEntry *)prvImageCacheAlloc(xAllocSize);
+    if (pxEntry == NULL && xImageCacheTrim(0) > 0) {
+        pxEntry = (struct ImageCacheEntry *)prvImageCacheAlloc(xAllocSize);
+    }
+    if (pxEntry == NULL) {
+        return NULL;
+    }
+
+    memset(pxEntry, 0, sizeof(*pxEntry));
+    pxEntry->pucData = (uint8_t *)pxEntry + xHeader;
+    pxEntry->xSize = xSize;
+    pxEntry->xAllocSize = xAllocSize;
+    if (pcKeyPath != NULL) {
+        pxEntry->pcPath = (char *)pxEntry->pucData + xSize;
+        memcpy(pxEntry->pcPath, pcKeyPath, xPathLen);
+    }
+
+    if (lfs_ops->file_open(&file, pcPath, LFS_O_RDONLY) < 0) {
+        vPortFree(pxEntry);
+        return NULL;
+    }
+    lRead = lfs_ops->file_read(&file, pxEntry->pucData, (lfs_size_t)xSize);
+    lfs_ops->file_close(&file);
+
+    if (lRead != (lfs_ssize_t)xSize) {
+        vPortFree(pxEntry);
+        return NULL;
+    }
+
+    /* Anyone able to write the file could have set the attribute, only trust it if it matches */
+    if (pucDigest != NULL) {
+        vImageCacheDigest(pxEntry->pucData, xSize, pxEntry->aucDigest);
+        pxEntry->xHasHash =
+            (memcmp(pxEntry->aucDigest, pucDigest, IMAGE_CACHE_DIGEST_LEN) == 0) ? pdTRUE : pdFALSE;
+    }
+    if (pxEntry->xHasHash == pdFALSE && pcKeyPath == NULL) {
+        vPortFree(pxEntry);
+        return NULL;
+    }
+
+    return pxEntry;
+}
+
+ImageHandle_t xImageCacheAcquire(const char *pcPath, const uint8_t **ppucData, size_t *pxSize) {
+    FileSystem_t           *pxFS;
+    LittleFSOps_t          *lfs_ops;
+    struct lfs_info         info;
+    struct ImageCacheEntry *pxEntry;
+    struct ImageCacheEntry *pxCached;
+    uint8_t                 aucDigest[IMAGE_CACHE_DIGEST_LEN];
+    BaseType_t              xHasHash;
+    BaseType_t              xHasPath;
+    char                    acKeyPath[configMAX_PATH_LEN];
+
+    if (pcPath == NULL || ppucData == NULL || pxSize == NULL) {
+        return NULL;
+    }
+    acKeyPath[0] = '\0';
+
+    pxFS = pxGetFileSystem();
+    if (pxFS == NULL || pxFS->fs_ops == NULL) {
+        return NULL;
+    }
+    lfs_ops = (LittleFSOps_t *)pxFS->fs_ops;
+
+    /* Identify the file, its metadata is all that is read on a hit */
+    if (lfs_ops->stat(pcPath, &info) < 0 || info.type != LFS_TYPE_REG || info.size == 0) {
+        return NULL;
+    }
+    /* Attributes of another size, such as the 32-bit hashes older images carry, do not count */
+    xHasHash = (lfs_ops->getattr(pcPath, IMAGE_CACHE_ATTR_HASH, aucDigest, sizeof(aucDigest)) ==
+                (lfs_ssize_t)sizeof(aucDigest))
+                   ? pdTRUE
+                   : pdFALSE;
+    xHasPath = prvAbsolutePath(pcPath, acKeyPath, sizeof(acKeyPath));
+    if (xHasHash == pdFALSE && xHasPath != pdPASS) {
+        return NULL;
+    }
+
+    if (prvImageCacheLock() != pdPASS) {
+        return NULL;
+    }
+    pxEntry = prvImageCacheFind(xHasHash, aucDigest, acKeyPath, (size_t)info.size);
+    if (pxEntry != NULL) {
+        if (pxEntry->uxRefCount == 0) {
+            xIdleBytes -= prvImageCacheEntryBytes(pxEntry);
+        }
+        xCacheStats.ulHits++;
+    } else {
+        xCacheStats.ulMisses++;
+        if (xPortGetFreeHeapSize() < (size_t)info.size + configIMAGE_CACHE_LOW_HEAP_BYTES) {
+            (void)prvImageCacheEvict(0);
+        }
+        prvImageCacheUnlock();
+
+        /* Read without the mutex, stopping this task during the read cannot leave it held */
+        pxEntry = prvImageCacheLoad(lfs_ops, pcPath, (xHasPath == pdPASS) ? acKeyPath : NULL,
+                                    (xHasHash != pdFALSE) ? aucDigest : NULL, (size_t)info.size);
+        if (pxEntry == NULL) {
+#ifdef MY_DEBUG
+            xil_printf("Image cache: failed to load %s\r\n", pcPath);
+#endif
+            return NULL;
+        }
+#ifdef MY_DEBUG
+        if (pxEntry->xHasHash != xHasHash) {
+            xil_printf("Image cache: digest attribute of %s does not match\r\n", pcPath);
+        }
+#endif
+
+        if (prvImageCacheLock() != pdPASS) {
+            vPortFree(pxEntry);
+            return NULL;
+        }
+        /* Another task may have cached the file meanwhile. A digest that did not match the
+         * contents keys the file by path, which was not looked up yet. */
+        pxCached = prvImageCacheFind(pxEntry->xHasHash, pxEntry->aucDigest, acKeyPath,
+                                     (size_t)info.size);
+        if (pxCached != NULL) {
+            vPortFree(pxEntry);
+            pxEntry = pxCached;
+            if (pxEntry->uxRefCount == 0) {
+                xIdleBytes -= prvImageCacheEntryBytes(pxEntry);
+            }
+        } else {
+            pxEntry->pxNext = pxImageCache;
+            pxImageCache = pxEntry;
+            xCacheStats.uxEntries++;
+            xCacheStats.xBytes += pxEntry->xSize;
+        }
+    }
+
+    if (pxEntry->uxRefCount++ == 0) {
+        xCacheStats.uxReferenced++;
+    }
+    pxEntry->ulLastUse = ++ulUseStamp;
+
+    prvImageCacheUnlock();
+
+    *ppucData = pxEntry->pucData;
+    *pxSize = pxEntry->xSize;
+    return pxEntry;
+}
+
+void vImageCacheRelease(ImageHandle_t xImage) {
+    if (xImage == NULL || prvImageCacheLock() != pdPASS) {
+        return;
+    }
+
+    configASSERT(xImage->uxRefCount > 0);
+    if (--xImage->uxRefCount == 0) {
+        xCacheStats.uxReferenced--;
+
+        if (xImage->xStale != pdFALSE) {
+            prvImageCacheFree(xImage);
+        } else if (xImage->xHasHash == pdFALSE) {
+            /* Path and size do not prove the file is unchanged, only keep such an image while
+             * someone uses it */
+            prvImageCacheUnlink(xImage);
+            xCacheStats.xBytes -= xImage->xSize;
+            xCacheStats.uxEntries--;
+            prvImageCacheFree(xImage);
+        } else {
+            xIdleBytes += prvImageCacheEntryBytes(xImage);
+            prvImageCacheBalance();
+        }
+    }
+
+    prvImageCacheUnlock();
+}
+
+void vImageCacheInvalidate(const char *pcPath) {
+    struct ImageCacheEntry  *pxEntry;
+    struct ImageCacheEntry **ppxLink;
+    size_t                   xLen;
+
+    if (pcPath == NULL || prvImageCacheLock() != pdPASS) {
+        return;
+    }
+
+    /* Drop the path itself and, for a directory, everything below it */
+    xLen = strlen(pcPath);
+    while (xLen > 1 && pcPath[xLen - 1] == '/') {
+        xLen--;
+    }
+    ppxLink = &pxImageCache;
+    while ((pxEntry = *ppxLink) != NULL) {
+        if (pxEntry->xHasHash == pdFALSE && strncmp(pxEntry->pcPath, pcPath, xLen) == 0 &&
+            (pxEntry->pcPath[xLen] == '\0' || pxEntry->pcPath[xLen] == '/')) {
+            /* Path keyed entries are only cached while referenced, the last release frees it */
+            *ppxLink = pxEntry->pxNext;
+            pxEntry->xStale = pdTRUE;
+            xCacheStats.xBytes -= pxEntry->xSize;
+            xCacheStats.uxEntries--;
+        } else {
+            ppxLink = &pxEntry->pxNext;
+        }
+    }
+
+    prvImageCacheUnlock();
+}
+
+ELF_PREPARED *pxImageCachePrepared(ImageHandle_t xImage) {
+    return (xImage != NULL) ? &xImage->xPrepared : NULL;
+}
+
+size_t xImageCacheTrim(size_t xBytes) {
+    size_t xFreed;
+
+    if (prvImageCacheLock() != pdPASS) {
+        return 0;
+    }
+    xFreed = prvImageCacheEvict(xBytes);
+    prvImageCacheUnlock();
+
+    return xFreed;
+}
+
+void vImageCacheGetStats(ImageCacheStats_t *pxStats) {
+    struct ImageCacheEntry *pxEntry;
+
+    if (pxStats == NULL || prvImageCacheLock() != pdPASS) {
+        return;
+    }
+    *pxStats = xCacheStats;
+    /* Programs are attached by the loader without the mutex, count them when asked */
+    pxStats->uxPrepared = 0;
+    pxStats->xPreparedBytes = 0;
+    for (pxEntry = pxImageCache; pxEntry != NULL; pxEntry = pxEntry->pxNext) {
+        if (pxEntry->xPrepared != NULL) {
+            pxStats->uxPrepared++;
+            pxStats->xPreparedBytes += elf_prepared_size(pxEntry->xPrepared);
+        }
+    }
+    prvImageCacheUnlock();
+}
+
+#endif /* configUSE_FILESYSTEM */
@@ -56,14 +56,26 @@ extern "C" {
     #define configUSE_CGROUPS 0
 #endif
 
-#ifndef configMAX_CGROUPS
-    #define configMAX_CGROUPS 8
+/* Number of cgroups the pool grows by the first time it runs out of free
+ * cgroups, every further growth doubles the size of the pool */
+#ifndef configCGROUP_POOL_CHUNK_SIZE
+    #define configCGROUP_POOL_CHUNK_SIZE 8
 #endif
 
 #ifndef configMAX_CGROUP_NAME_LEN
     #define configMAX_CGROUP_NAME_LEN 16
 #endif
 
+/* Data cache line size, cgroups are aligned to it */
+#ifndef configCGROUP_CACHE_LINE_SIZE
+    #define configCGROUP_CACHE_LINE_SIZE 64
+#endif
+
+/* Maximum number of levels in a cgroup tree, a top level cgroup is level 1 */
+#ifndef configCGROUP_MAX_DEPTH
+    #define configCGROUP_MAX_DEPTH 4
+#endif
+
 /* CGroup task item for tracking tasks in cgroups */
 typedef struct xCGROUP_TASK_ITEM {
     ListItem_t   xCGroupListItem; /* List item for cgroup membership */
@@ -73,50 +85,130 @@ typedef struct xCGROUP_TASK_ITEM {
 /* CGroup types */
 typedef void *CGroupHandle_t;
 
-/* Memory limits in bytes */
+/* Number of allocation size histogram buckets. Bucket 0 counts allocations up
+ * to 1 << CGROUP_MEMORY_HISTOGRAM_MIN_SHIFT bytes, every further bucket twice
+ * the size of the one before, and the last bucket everything larger. */
+#define CGROUP_MEMORY_HISTOGRAM_BUCKETS (12U)
+#define CGROUP_MEMORY_HISTOGRAM_MIN_SHIFT (4U)
+
+/* Memory limits in bytes, usage includes the usage of child cgroups */
 typedef struct xMEMORY_LIMITS {
-    UBaseType_t ulMemoryLimit; /* Maximum memory allowed (bytes) */
-    UBaseType_t ulMemoryUsed;  /* Current memory usage (bytes) */
-    UBaseType_t ulMemoryPeak;  /* Peak memory usage (bytes) */
+    UBaseType_t ulMemoryLimit;    /* Maximum memory allowed (bytes) */
+    UBaseType_t ulMemoryUsed;     /* Current memory usage (bytes) */
+    UBaseType_t ulMemoryPeak;     /* Peak memory usage (bytes) */
+    UBaseType_t ulEffectiveLimit; /* Lowest limit of this cgroup and its ancestors */
+    UBaseType_t ulSoftLimit;      /* High watermark that raises a pressure event */
+    UBaseType_t ulFailCount;      /* Allocations refused by a memory limit */
+    UBaseType_t ulHighEvents;     /* Number of times usage rose above ulSoftLimit */
+
+    /* Allocations charged directly to this cgroup, by size */
+    UBaseType_t ulSizeHistogram[CGROUP_MEMORY_HISTOGRAM_BUCKETS];
 } MemoryLimits_t;
 
-/* CPU limits - tick based quota enforcement */
+/* Memory pressure events, passed to the event callback and set as bits in the
+ * notification value of the event task */
+#define CGROUP_MEMORY_EVENT_HIGH (1U << 0) /* Usage rose above the soft limit */
+#define CGROUP_MEMORY_EVENT_MAX (1U << 1)  /* An allocation was refused by a limit */
+
+/* Memory pressure event callback, see xCGroupSetMemoryEventCallback() */
+typedef void (*CGroupMemoryEventCallback_t)(CGroupHandle_t xCGroup,
+                                            UBaseType_t    ulEvent,
+                                            UBaseType_t    ulMemoryUsed,
+                                            void          *pvContext);
+
+/* Receivers of the memory pressure events of a cgroup */
+typedef struct xMEMORY_EVENTS {
+    CGroupMemoryEventCallback_t pxCallback; /* Called on each event */
+    void                       *pvContext;  /* Passed to the callback */
+    TaskHandle_t                xTask;      /* Notified with the event bits */
+} MemoryEvents_t;
+
+/* CPU limits - quota per period bandwidth control. The members updated when
+ * runtime is charged come first, so they share as few cache lines as possible. */
 typedef struct xCPU_LIMITS {
-    UBaseType_t ulCpuQuota;         /* CPU time quota (percentage * 100, e.g., 5000 = 50%) */
-    UBaseType_t ulTicksUsed;        /* Number of ticks used in current window */
-    UBaseType_t ulTicksQuota;       /* Max number of ticks allowed per window */
-    UBaseType_t ulPenaltyTicksLeft; /* Remaining penalty ticks */
-    TickType_t  xWindowStartTime;   /* Start time of current window (in ticks) */
-    TickType_t  xWindowDuration;    /* Duration of time window (in ticks) */
+    uint64_t    ullCyclesUsed;     /* Counter cycles used in current period */
+    uint64_t    ullCyclesQuota;    /* Counter cycles allowed per period */
+    uint64_t    ullTotalCycles;    /* Counter cycles used since the cgroup was created */
+    uint64_t    ullVirtualRuntime; /* Cycles used, scaled by default weight / weight */
+    UBaseType_t ulCpuWeight;       /* Share of a contended priority level, like cpu.shares */
+    TickType_t  xWindowStartTime;  /* Start time of current period (in ticks) */
+    TickType_t  xWindowDuration;   /* Duration of the period (in ticks) */
+    UBaseType_t ulTicksUsed;       /* Number of ticks used in current period */
+    UBaseType_t ulTicksQuota;      /* Max number of ticks allowed per period */
+    UBaseType_t ulCpuQuota;        /* CPU time quota (percentage * 100, e.g., 5000 = 50%) */
+    UBaseType_t ulThrottleCount;   /* Number of periods in which the cgroup was throttled */
 } CpuLimits_t;
 
-/* CGroup structure */
+/* Ready tasks of a cgroup at one priority. Allocated the first time a task of
+ * the cgroup is added or set to the priority, freed with the cgroup. */
+typedef struct xCGROUP_RUN_QUEUE {
+    List_t      xReadyList;     /* Ready tasks, first so the list finds its queue */
+    UBaseType_t uxRunHeapIndex; /* Slot in the run heap of the priority */
+    UBaseType_t uxPriority;     /* Priority the queue belongs to */
+} CGroupRunQueue_t;
+
+/* CGroup structure, aligned so the members the scheduler uses share the
+ * fewest cache lines and no two cgroups share a line */
 typedef struct xCGROUP {
-    char           pcGroupName[configMAX_CGROUP_NAME_LEN]; /* CGroup name */
-    MemoryLimits_t xMemoryLimits;                          /* Memory constraints */
-    CpuLimits_t    xCpuLimits;                             /* CPU constraints */
-    List_t         xTaskList;                              /* List of tasks in this cgroup */
-    UBaseType_t    uxTaskCount;                            /* Number of tasks in cgroup */
-    BaseType_t     xActive;                                /* CGroup active flag */
-} CGroup_t;
+    /* Read or updated on every tick and context switch */
+    struct xCGROUP *pxParent;                               /* Parent, NULL at the top level */
+    BaseType_t      xThrottled;                             /* Quota used up in current period */
+    BaseType_t      xFrozen;                                /* Tasks held by the freezer */
+    CpuLimits_t     xCpuLimits;                             /* CPU constraints */
+    CGroupRunQueue_t *pxRunQueues[configMAX_PRIORITIES];    /* Ready tasks by priority */
+
+    /* Configuration, memory accounting and bookkeeping */
+    char            pcGroupName[configMAX_CGROUP_NAME_LEN]; /* CGroup name */
+    MemoryLimits_t  xMemoryLimits;                          /* Memory constraints */
+    MemoryEvents_t  xMemoryEvents;                          /* Memory pressure event receivers */
+    List_t          xTaskList;                              /* List of tasks in this cgroup */
+    List_t          xThrottledList;                         /* Tasks parked until refresh or thaw */
+    UBaseType_t     uxTaskCount;                            /* Number of tasks in cgroup */
+    BaseType_t      xActive;                                /* CGroup active flag */
+    struct xCGROUP *pxMemoryLimitParent;                    /* Nearest memory limited ancestor */
+    UBaseType_t     uxChildCount;                           /* Number of child cgroups */
+    UBaseType_t     uxDepth;                                /* Number of ancestors */
+    ListItem_t      xActiveListItem;                        /* Link in the active cgroup list */
+    struct xCGROUP *pxNextFree;                             /* Next free cgroup in the pool */
+    UBaseType_t     uxIndex;                                /* Index of the cgroup in the pool */
+    UBaseType_t     uxGeneration;                           /* Bumped when the cgroup is deleted */
+    ListItem_t      xPeriodListItem;                        /* Link in the period timer wheel */
+} __attribute__((aligned(configCGROUP_CACHE_LINE_SIZE))) CGroup_t;
 
 /*-----------------------------------------------------------
  * CPU TICK CONTROL MACROS
  *----------------------------------------------------------*/
 
-/* Default time window duration for CPU quota enforcement (in ticks) */
+/* Default bandwidth period for CPU quota enforcement (in ticks). A cgroup may
+ * run for ulCpuQuota / CGROUP_CPU_QUOTA_MAX of every period, after that its
+ * tasks are throttled until the period refreshes. */
 #ifndef configCGROUP_CPU_WINDOW_DURATION
-    #define configCGROUP_CPU_WINDOW_DURATION pdMS_TO_TICKS(1000) /* 1 second window */
+    #define configCGROUP_CPU_WINDOW_DURATION pdMS_TO_TICKS(1000) /* 1 second period */
 #endif
 
-/* Default penalty factor - how many ticks to penalize when quota exceeded */
-#ifndef configCGROUP_CPU_PENALTY_FACTOR
-    #define configCGROUP_CPU_PENALTY_FACTOR 2 /* Penalize 2x the excess ticks */
+/* Free running counter used to measure CPU time at context switches, and its
+ * frequency in Hz. Defaults to the ARM generic timer virtual count. */
+#ifndef configCGROUP_CYCLE_COUNTER
+    #define configCGROUP_CYCLE_COUNTER() ullCGroupReadCycleCounter()
+#endif
+
+#ifndef configCGROUP_CYCLE_FREQUENCY
+    #define configCGROUP_CYCLE_FREQUENCY() ullCGroupReadCycleFrequency()
 #endif
 
 /* Helper macros */
 #define CGROUP_NO_LIMIT ((UBaseType_t) - 1)
-#define CGROUP_CPU_QUOTA_MAX (1000U) /* 100% = 10000 */
+#define CGROUP_CPU_QUOTA_MAX (10000U) /* 100% = 10000 */
+
+/* Charge target that charges no cgroup, see xCGroupSetMemoryChargeTarget().
+ * Its index bits are zero, so it is never an issued handle. */
+#define CGROUP_CHARGE_NONE ((CGroupHandle_t)(~(uintptr_t)0xFFFFFFFFU))
+
+/* CPU weight range, tasks of the same priority are shared between cgroups in
+ * proportion to their weights instead of round robin per task */
+#define CGROUP_CPU_WEIGHT_MIN (2U)
+#define CGROUP_CPU_WEIGHT_DEFAULT (1024U)
+#define CGROUP_CPU_WEIGHT_MAX (262144U)
 
 /*-----------------------------------------------------------
  * CGROUP API FUNCTIONS
@@ -124,10 +216,37 @@ typedef struct xCGROUP {
 
 #if (configUSE_CGROUPS == 1)
 
+/**
+ * cgroup.h
+ * @brief Read the ARM generic timer virtual count
+ */
+static inline uint64_t ullCGroupReadCycleCounter(void) {
+    uint64_t ullValue;
+
+    __asm volatile("mrs %0, cntvct_el0" : "=r"(ullValue));
+    return ullValue;
+}
+
+/**
+ * cgroup.h
+ * @brief Read the ARM generic timer frequency in Hz
+ */
+static inline uint64_t ullCGroupReadCycleFrequency(void) {
+    uint64_t ullValue;
+
+    __asm volatile("mrs %0, cntfrq_el0" : "=r"(ullValue));
+    return ullValue;
+}
+
 /**
  * cgroup.h
  * @brief Create a new cgroup with specified resource limits
  *
+ * CGroups come from a pool that grows from the heap when it runs out, so the
+ * number of cgroups is only limited by memory. The returned handle carries a
+ * generation count, once the cgroup is deleted the handle is rejected by every
+ * cgroup API even if the cgroup is reused.
+ *
  * @param pcGroupName Name of the cgroup
  * @param ulMemoryLimit Maximum memory allowed (bytes), use CGROUP_NO_LIMIT for no limit, note that
  *                      memory limits are for all groups, including the kernel
@@ -141,13 +260,91 @@ xCGroupCreate(const char *const pcGroupName, UBaseType_t ulMemoryLimit, UBaseTyp
 
 /**
  * cgroup.h
- * @brief Delete a cgroup (must be empty)
+ * @brief Create a new cgroup below a parent cgroup
+ *
+ * Memory and CPU time used by the tasks of a child cgroup are charged to the
+ * child and to every ancestor, and an allocation or runtime is only allowed
+ * while it fits the limits of all of them. A child limit may be set higher
+ * than the parent limit, the lower one applies.
+ *
+ * @param xParent Handle to the parent cgroup, NULL for a top level cgroup
+ * @param pcGroupName Name of the cgroup
+ * @param ulMemoryLimit Maximum memory allowed (bytes), use CGROUP_NO_LIMIT for no limit
+ * @param ulCpuQuota CPU quota (percentage * 100), use CGROUP_CPU_QUOTA_MAX for no limit
+ * @return CGroup handle on success, NULL on failure or if the tree would be
+ *         deeper than configCGROUP_MAX_DEPTH
+ */
+CGroupHandle_t xCGroupCreateChild(CGroupHandle_t    xParent,
+                                  const char *const pcGroupName,
+                                  UBaseType_t       ulMemoryLimit,
+                                  UBaseType_t       ulCpuQuota);
+
+/**
+ * cgroup.h
+ * @brief Move a cgroup, with its children, below another parent
+ *
+ * The memory currently charged to the cgroup moves from its old ancestors to
+ * the new ones.
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param xParent Handle to the new parent cgroup, NULL to make it top level
+ * @return pdPASS on success, pdFAIL if the move would create a loop, exceed
+ *         configCGROUP_MAX_DEPTH or exceed a memory limit of the new parent
+ */
+BaseType_t xCGroupSetParent(CGroupHandle_t xCGroup, CGroupHandle_t xParent);
+
+/**
+ * cgroup.h
+ * @brief Get the parent of a cgroup
+ *
+ * @param xCGroup Handle to the cgroup
+ * @return Parent cgroup handle, or NULL for a top level cgroup
+ */
+CGroupHandle_t xCGroupGetParent(CGroupHandle_t xCGroup);
+
+/**
+ * cgroup.h
+ * @brief Delete a cgroup (must have no tasks and no child cgroups)
  *
  * @param xCGroup Handle to the cgroup
  * @return pdPASS on success, pdFAIL on failure
  */
 BaseType_t xCGroupDelete(CGroupHandle_t xCGroup);
 
+/**
+ * cgroup.h
+ * @brief Freeze a cgroup, holding every task of it and of its child cgroups
+ *
+ * Frozen tasks are taken off the ready lists the next time the scheduler
+ * would select them, so none of them runs once this returns. Blocked tasks
+ * are held when they next become ready. Tasks keep their state and resources.
+ *
+ * @param xCGroup Handle to the cgroup
+ * @return pdPASS on success, pdFAIL on failure
+ */
+BaseType_t xCGroupFreeze(CGroupHandle_t xCGroup);
+
+/**
+ * cgroup.h
+ * @brief Thaw a cgroup frozen with xCGroupFreeze()
+ *
+ * Held tasks are put back on the ready lists, unless the cgroup is also out
+ * of CPU quota or an ancestor is frozen.
+ *
+ * @param xCGroup Handle to the cgroup
+ * @return pdPASS on success, pdFAIL on failure
+ */
+BaseType_t xCGroupThaw(CGroupHandle_t xCGroup);
+
+/**
+ * cgroup.h
+ * @brief Check if a cgroup is frozen
+ *
+ * @param xCGroup Handle to the cgroup
+ * @return pdTRUE if the cgroup itself is frozen, pdFALSE otherwise
+ */
+BaseType_t xCGroupIsFrozen(CGroupHandle_t xCGroup);
+
 /**
  * cgroup.h
  * @brief Add a task to a cgroup
@@ -188,6 +385,111 @@ BaseType_t xCGroupCheckMemoryLimit(TaskHandle_t xTask, UBaseType_t ulSize);
  */
 BaseType_t xCGroupUpdateMemoryUsage(TaskHandle_t xTask, BaseType_t lMemoryDelta);
 
+/**
+ * cgroup.h
+ * @brief Get the cgroup a task's heap allocations are charged to
+ *
+ * That is the target set with xCGroupSetMemoryChargeTarget() while the task
+ * has one, none while it is CGROUP_CHARGE_NONE, and the task's own cgroup
+ * otherwise. The heap records the owner
+ * in each block, so a block is credited back to the cgroup it was charged to
+ * no matter which task frees it.
+ *
+ * @param xTask Handle to the task
+ * @return CGroup handle, or NULL if the allocations are not charged
+ */
+CGroupHandle_t xCGroupGetMemoryOwner(TaskHandle_t xTask);
+
+/**
+ * cgroup.h
+ * @brief Charge the calling task's heap allocations to another cgroup
+ *
+ * Used to charge objects created on behalf of a container, such as the stack
+ * and TCB of its task, to the container's cgroup, or to charge no cgroup for
+ * shared objects such as cached program images. Restore the returned target
+ * when done.
+ *
+ * @param xCGroup Handle to the cgroup, NULL to charge the task's own cgroup,
+ *                CGROUP_CHARGE_NONE to charge none
+ * @return The previous target
+ */
+CGroupHandle_t xCGroupSetMemoryChargeTarget(CGroupHandle_t xCGroup);
+
+/**
+ * cgroup.h
+ * @brief Check if a cgroup and its ancestors have room for an allocation
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param ulSize Size of memory to allocate
+ * @return pdTRUE if allowed or xCGroup is not a cgroup, pdFALSE if it would
+ *         exceed a limit
+ */
+BaseType_t xCGroupCheckMemoryCharge(CGroupHandle_t xCGroup, UBaseType_t ulSize);
+
+/**
+ * cgroup.h
+ * @brief Charge memory to a cgroup and its ancestors
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param ulSize Size in bytes
+ * @return pdPASS on success, pdFAIL if the cgroup no longer exists
+ */
+BaseType_t xCGroupChargeMemory(CGroupHandle_t xCGroup, UBaseType_t ulSize);
+
+/**
+ * cgroup.h
+ * @brief Give memory charged with xCGroupChargeMemory() back
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param ulSize Size in bytes
+ * @return pdPASS on success, pdFAIL if the cgroup was deleted since, its
+ *         usage was already given back by xCGroupDelete()
+ */
+BaseType_t xCGroupUnchargeMemory(CGroupHandle_t xCGroup, UBaseType_t ulSize);
+
+/**
+ * cgroup.h
+ * @brief Set the memory soft limit (high watermark) of a cgroup
+ *
+ * Allocations above the soft limit still succeed, but each time the usage of
+ * the cgroup rises above it a CGROUP_MEMORY_EVENT_HIGH event is raised, so the
+ * tasks of the cgroup can drop caches before the hard limit is reached.
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param ulSoftLimit Soft limit in bytes, CGROUP_NO_LIMIT to disable it
+ * @return pdPASS on success, pdFAIL on failure
+ */
+BaseType_t xCGroupSetMemorySoftLimit(CGroupHandle_t xCGroup, UBaseType_t ulSoftLimit);
+
+/**
+ * cgroup.h
+ * @brief Register a function called on memory pressure events of a cgroup
+ *
+ * The callback runs in the context of the allocating task from inside the
+ * heap with the scheduler suspended, so it must not block or allocate.
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param pxCallback Function to call, NULL to remove it
+ * @param pvContext Passed to the callback
+ * @return pdPASS on success, pdFAIL on failure
+ */
+BaseType_t xCGroupSetMemoryEventCallback(CGroupHandle_t              xCGroup,
+                                         CGroupMemoryEventCallback_t pxCallback,
+                                         void                       *pvContext);
+
+/**
+ * cgroup.h
+ * @brief Notify a task on memory pressure events of a cgroup
+ *
+ * The CGROUP_MEMORY_EVENT_* bits of each event are set in the notification
+ * value of the task, which can wait for them with xTaskNotifyWait().
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param xTask Task to notify, NULL to stop notifying
+ * @return pdPASS on success, pdFAIL on failure
+ */
+BaseType_t xCGroupSetMemoryEventTask(CGroupHandle_t xCGroup, TaskHandle_t xTask);
+
 /**
  * cgroup.h
  * @brief Get cgroup statistics
@@ -200,6 +502,28 @@ BaseType_t xCGroupUpdateMemoryUsage(TaskHandle_t xTask, BaseType_t lMemoryDelta)
 BaseType_t
 xCGroupGetStats(CGroupHandle_t xCGroup, MemoryLimits_t *pxMemoryLimits, CpuLimits_t *pxCpuLimits);
 
+/**
+ * cgroup.h
+ * @brief Get the CPU time used by a cgroup since it was created
+ *
+ * Measured with configCGROUP_CYCLE_COUNTER() when tasks are switched in and
+ * out, so short bursts between ticks are charged to the right cgroup.
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param pullCpuTimeUs Pointer to store the CPU time in microseconds
+ * @return pdPASS on success, pdFAIL on failure
+ */
+BaseType_t xCGroupGetCpuTime(CGroupHandle_t xCGroup, uint64_t *pullCpuTimeUs);
+
+/**
+ * cgroup.h
+ * @brief Convert configCGROUP_CYCLE_COUNTER() cycles to microseconds
+ *
+ * @param ullCycles Number of counter cycles
+ * @return Time in microseconds
+ */
+uint64_t ullCGroupCyclesToMicroseconds(uint64_t ullCycles);
+
 /**
  * cgroup.h
  * @brief Set memory limit for a cgroup
@@ -220,6 +544,21 @@ BaseType_t xCGroupSetMemoryLimit(CGroupHandle_t xCGroup, UBaseType_t ulMemoryLim
  */
 BaseType_t xCGroupSetCpuQuota(CGroupHandle_t xCGroup, UBaseType_t ulCpuQuota);
 
+/**
+ * cgroup.h
+ * @brief Set the CPU weight of a cgroup
+ *
+ * When ready tasks of several cgroups share the highest ready priority, the
+ * CPU is split between the cgroups in proportion to their weights, no matter
+ * how many tasks each cgroup has.
+ *
+ * @param xCGroup Handle to the cgroup
+ * @param ulCpuWeight Weight between CGROUP_CPU_WEIGHT_MIN and CGROUP_CPU_WEIGHT_MAX,
+ *                    CGROUP_CPU_WEIGHT_DEFAULT for new cgroups
+ * @return pdPASS on success, pdFAIL on failure
+ */
+BaseType_t xCGroupSetCpuWeight(CGroupHandle_t xCGroup, UBaseType_t ulCpuWeight);
+
 /**
  * cgroup.h
  * @brief Get the cgroup handle for a task
@@ -255,7 +594,15 @@ BaseType_t xCGroupResetMemoryStats(CGroupHandle_t xCGroup);
 
 /**
  * cgroup.h
- * @brief Get total memory usage across all cgroups
+ * @brief Get the number of cgroups that exist
+ *
+ * @return Number of cgroups
+ */
+UBaseType_t uxCGroupGetCount(void);
+
+/**
+ * cgroup.h
+ * @brief Get total memory usage across all top level cgroups
  *
  * @return Total memory usage in bytes
  */
@@ -267,47 +614,134 @@ UBaseType_t xCGroupGetTotalMemoryUsage(void);
  *----------------------------------------------------------*/
 
 /**
- * @brief Called by kernel on each tick to update cgroup time windows
- * This function is called from xTaskIncrementTick()
+ * @brief Called by kernel on each tick to charge the running cgroup and
+ * refresh the periods of the throttled cgroups that end in this tick
+ * This function is called from xTaskIncrementTick(), its cost does not depend
+ * on the number of cgroups
+ *
+ * @return pdTRUE if a context switch is required, pdFALSE otherwise
  */
-void prvCGroupUpdateTick(void);
+BaseType_t prvCGroupUpdateTick(void);
 
 /**
- * @brief Called by kernel when a task is switched out
- * This function is called from vTaskSwitchContext()
+ * @brief Called by kernel to charge CPU time to a task's cgroup
+ * This function is called from vTaskSwitchContext() when the task is switched
+ * out and from xTaskIncrementTick() while it keeps running
  *
- * @param xTask Handle to the task being switched out
+ * @param xTask Handle to the task that ran
+ * @param ullCycles Counter cycles the task ran for since it was last charged
  */
-void prvCGroupTaskSwitchOut(TaskHandle_t xTask);
+void prvCGroupChargeTask(TaskHandle_t xTask, uint64_t ullCycles);
 
 /**
  * @brief Called by kernel to check if a task can run based on cgroup limits
  * This function is called from vTaskSwitchContext()
  *
  * @param xTask Handle to the task to check
- * @return pdTRUE if task can run, pdFALSE if throttled by cgroup
+ * @return pdTRUE if task can run, pdFALSE if throttled or frozen by cgroup
  */
 BaseType_t prvCGroupCanTaskRun(TaskHandle_t xTask);
 
+/**
+ * @brief Get the list a task of a cgroup is parked on while throttled
+ * This function is called from vTaskSwitchContext()
+ *
+ * @param pxCGroupHandle Handle to the cgroup
+ * @return The throttled list of the cgroup or of the throttled or frozen
+ *         ancestor that stops it from running
+ */
+List_t *prvCGroupGetThrottledList(void *pxCGroupHandle);
+
+/**
+ * @brief Check if a list is the throttled list of a cgroup or an ancestor
+ * This function is called from xTaskSetCGroup()
+ *
+ * @param pxCGroupHandle Handle to the cgroup
+ * @param pxList List to check
+ * @return pdTRUE if a task on pxList is parked by the cgroup hierarchy
+ */
+BaseType_t prvCGroupIsThrottledList(void *pxCGroupHandle, const List_t *pxList);
+
+/**
+ * @brief Called by kernel when a task of a cgroup becomes ready
+ * This function is called from prvAddTaskToReadyList() with interrupts masked.
+ * The first ready task of a cgroup at a priority puts the cgroup in the run
+ * heap of that priority, O(log n) in the number of cgroups. A task at a
+ * priority the cgroup has no run queue for, such as one inherited from a
+ * mutex waiter, is not queued and keeps its plain round robin turn.
+ *
+ * @param pxCGroupHandle Handle to the cgroup of the task
+ * @param pxReadyItem The task's cgroup ready list item
+ * @param uxPriority Priority of the ready list the task was added to
+ */
+void prvCGroupTaskReady(void *pxCGroupHandle, ListItem_t *pxReadyItem, UBaseType_t uxPriority);
+
+/**
+ * @brief Called by kernel when a task no longer counts as ready for its cgroup
+ * This function is called from xTaskSetCGroup(), when a task is parked and
+ * for tasks found to have left the ready lists when picking. A cgroup without
+ * ready tasks at a priority leaves the run heap of that priority.
+ *
+ * @param pxCGroupHandle Handle to the cgroup of the task
+ * @param pxReadyItem The task's cgroup ready list item
+ */
+void prvCGroupTaskUnready(void *pxCGroupHandle, ListItem_t *pxReadyItem);
+
+/**
+ * @brief Called by kernel to share a priority level between cgroups by weight
+ * This function is called from vTaskSwitchContext() when the round robin
+ * selection is a task in a cgroup. It returns the ready tasks of the cgroup
+ * with the lowest virtual runtime at the priority in O(1).
+ *
+ * @param uxPriority Priority of the selected ready list
+ * @return Ready list items of the cgroup furthest behind its weighted share,
+ *         NULL if no cgroup has ready tasks at the priority
+ */
+List_t *prvCGroupGetRunList(UBaseType_t uxPriority);
+
+/**
+ * @brief Called by kernel before a task of a cgroup moves to a priority
+ * This function is called from vTaskPrioritySet() outside the critical
+ * section, so the run queue of the priority can be allocated.
+ *
+ * @param pxCGroupHandle Handle to the cgroup of the task, NULL is ignored
+ * @param uxPriority Priority the task moves to
+ */
+void prvCGroupReserveRunQueue(void *pxCGroupHandle, UBaseType_t uxPriority);
+
 #else /* configUSE_CGROUPS == 0 */
 
     /* When cgroups are disabled, provide empty macros */
     #define xCGroupCreate(pcGroupName, ulMemoryLimit, ulCpuQuota) NULL
+    #define xCGroupCreateChild(xParent, pcGroupName, ulMemoryLimit, ulCpuQuota) NULL
+    #define xCGroupSetParent(xCGroup, xParent) pdFAIL
+    #define xCGroupGetParent(xCGroup) NULL
     #define xCGroupDelete(xCGroup) pdFAIL
+    #define xCGroupFreeze(xCGroup) pdFAIL
+    #define xCGroupThaw(xCGroup) pdFAIL
+    #define xCGroupIsFrozen(xCGroup) pdFALSE
     #define xCGroupAddTask(xCGroup, xTask) pdFAIL
     #define xCGroupRemoveTask(xCGroup, xTask) pdFAIL
     #define xCGroupCheckMemoryLimit(xTask, ulSize) pdTRUE
     #define xCGroupUpdateMemoryUsage(xTask, lMemoryDelta) pdPASS
+    #define xCGroupGetMemoryOwner(xTask) NULL
+    #define xCGroupSetMemoryChargeTarget(xCGroup) NULL
+    #define xCGroupCheckMemoryCharge(xCGroup, ulSize) pdTRUE
+    #define xCGroupChargeMemory(xCGroup, ulSize) pdPASS
+    #define xCGroupUnchargeMemory(xCGroup, ulSize) pdPASS
     #define xCGroupGetStats(xCGroup, pxMemoryLimits, pxCpuLimits) pdFAIL
     #define xCGroupSetMemoryLimit(xCGroup, ulMemoryLimit) pdFAIL
+    #define xCGroupSetMemorySoftLimit(xCGroup, ulSoftLimit) pdFAIL
+    #define xCGroupSetMemoryEventCallback(xCGroup, pxCallback, pvContext) pdFAIL
+    #define xCGroupSetMemoryEventTask(xCGroup, xTask) pdFAIL
     #define xCGroupSetCpuQuota(xCGroup, ulCpuQuota) pdFAIL
+    #define xCGroupSetCpuWeight(xCGroup, ulCpuWeight) pdFAIL
     #define xCGroupGetTaskGroup(xTask) NULL
+    #define xCGroupGetCpuTime(xCGroup, pullCpuTimeUs) pdFAIL
 
     /* Internal kernel integration functions - empty when disabled */
-    #define prvCGroupUpdateTick()                                                                  \
-        do {                                                                                       \
-        } while (0)
-    #define prvCGroupTaskSwitchOut(xTask)                                                          \
+    #define prvCGroupUpdateTick() pdFALSE
+    #define prvCGroupChargeTask(xTask, ullCycles)                                                  \
         do {                                                                                       \
         } while (0)
     #define prvCGroupCanTaskRun(xTask) pdTRUE
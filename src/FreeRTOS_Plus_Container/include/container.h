@@ -47,22 +47,91 @@ typedef struct Container {
     IpcNamespaceHandle_t xIpcNamespace; /* IPC namespace for communication isolation */
 
     /* Container configuration */
-    uint32_t ulMemoryLimit; /* Memory limit in bytes (0 = no limit) */
-    uint32_t ulCpuQuota;    /* CPU quota percentage * 100 (e.g., 5000 = 50%) */
-
-    /* Synchronization for task startup */
-    SemaphoreHandle_t xReadySemaphore; /* Semaphore to signal task can proceed after isolation setup */
-
-    struct Container *pxNext;
+    uint32_t ulMemoryLimit;     /* Memory limit in bytes (0 = no limit) */
+    uint32_t ulMemorySoftLimit; /* Usage that raises a memory pressure event (0 = none) */
+    uint32_t ulCpuQuota;        /* CPU quota percentage * 100 (e.g., 5000 = 50%) */
+    uint32_t ulCpuWeight;       /* CPU weight against same priority containers (0 = default) */
+
+    /* Program image, acquired on the first start and kept for later starts */
+    const uint8_t *pucImage;   /* ELF file contents, NULL until the first start */
+    size_t         xImageSize; /* Size of pucImage in bytes */
+    void          *pvImage;    /* Image cache reference holding pucImage, see image_cache.h */
+
+    /* Blocks the program allocated with pvContainerMalloc(), freed when its task is gone */
+    struct ContainerAlloc *pxAllocations;
+
+    /* Parameters of the container task, freed when its task is gone */
+    void *pvTaskParams;
+
+    /* Exit reporting, fed by vApplicationTaskDeleteHook() and handled by the daemon */
+    ContainerState_t        eExitState;   /* State to enter once the task is gone */
+    BaseType_t              xExitPending; /* Task is gone, the daemon has not handled it yet */
+    struct Container       *pxNextExited; /* Next container on the pending exit list */
+    struct ContainerWaiter *pxWaiters;    /* Tasks blocked in xContainerWait() */
+
+    /* Registry links, maintained by container.c under the container mutex */
+    struct Container *pxNext;       /* All containers, most recently created first */
+    struct Container *pxPrev;       /* Previous container, so delete unlinks in O(1) */
+    struct Container *pxNextByID;   /* Next container in the same ID hash bucket */
+    struct Container *pxNextByName; /* Next container in the same name hash bucket */
+    uint32_t          ulNameHash;   /* Hash of pcContainerName */
 } Container_t;
 
 /* Container daemon task priority */
 #define CONTAINER_DAEMON_PRIORITY (tskIDLE_PRIORITY + 2)
 #define CONTAINER_DAEMON_STACK_SIZE (2048)
 
+/* Initial number of container registry hash buckets, must be a power of two */
+#define CONTAINER_REGISTRY_MIN_BUCKETS (16)
+
+/* Thread local storage slot holding the Container_t of a container task */
+#define CONTAINER_TLS_INDEX (0)
+
+/* Task notification index xContainerWait() blocks on */
+#define CONTAINER_WAIT_NOTIFY_INDEX (1)
+
+/* Pool of pre-created container tasks that xContainerStart() binds instead of creating a task.
+ * The pool is refilled by the container daemon, xContainerPoolSetSize() changes its size. */
+#ifndef CONTAINER_POOL_SIZE
+#define CONTAINER_POOL_SIZE (4)
+#endif
+#define CONTAINER_POOL_MAX_SLOTS (16)
+#define CONTAINER_POOL_STACK_SIZE (configMINIMAL_STACK_SIZE * 2) /* Largest stack a slot serves */
+#define CONTAINER_POOL_PRIORITY (tskIDLE_PRIORITY + 1)            /* Priority while parked */
+
+/* Memory limit of a container created without one: the stack and TCB of its task plus
+ * CONTAINER_DEFAULT_PROGRAM_MEMORY for the program image and the memory the program allocates.
+ * The loader's bookkeeping and the image cache copy are not charged to the container. */
+#ifndef CONTAINER_DEFAULT_PROGRAM_MEMORY
+#define CONTAINER_DEFAULT_PROGRAM_MEMORY (16U * 1024U)
+#endif
+#define CONTAINER_TASK_OVERHEAD (1024U) /* TCB and heap block headers of the container task */
+
+/* 1: containers load their program straight from the file on every start instead of sharing a
+ * copy held by the image cache. Saves the file-sized buffer at the cost of file reads per start. */
+#ifndef CONTAINER_STREAM_IMAGES
+#define CONTAINER_STREAM_IMAGES (0)
+#endif
+
+/* Shared runtime library loaded before the first container starts, when the file exists.
+ * Container programs link against its symbols instead of carrying their own copies. */
+#ifndef CONTAINER_RUNTIME_LIBRARY
+#define CONTAINER_RUNTIME_LIBRARY "/lib/libcrt.so"
+#endif
+
 /* Container manager functions */
 BaseType_t xContainerManagerInit(void);
 
+/* Load a shared runtime library from the file system, see elf_library_load(). Call it from a
+ * system task: the library stays loaded and its memory is charged to the caller. */
+BaseType_t xContainerLoadLibrary(const char *pcPath);
+
+/* Memory for container programs, the malloc and free of the syscall table. Blocks are tracked
+ * per container and freed once the container's task is gone; vContainerFree() ignores pointers
+ * that are not blocks of the caller's container. */
+void *pvContainerMalloc(size_t xSize);
+void  vContainerFree(void *pv);
+
 /* Basic container functions */
 BaseType_t xContainerCreate(const char *pcName,
                             const char *elfName,
@@ -80,7 +149,12 @@ BaseType_t xContainerCreateWithLimits(const char *pcName,
 
 BaseType_t   xContainerStart(uint32_t ulContainerID);
 BaseType_t   xContainerStop(uint32_t ulContainerID);
+BaseType_t   xContainerPause(uint32_t ulContainerID);
+BaseType_t   xContainerResume(uint32_t ulContainerID);
 BaseType_t   xContainerDelete(uint32_t ulContainerID);
+BaseType_t   xContainerWait(uint32_t ulContainerID, TickType_t xTicksToWait);
+BaseType_t   xContainerPoolSetSize(UBaseType_t uxSlots);
+UBaseType_t  uxContainerPoolGetFree(void);
 Container_t *pxContainerGetByID(uint32_t ulContainerID);
 Container_t *pxContainerGetByName(const char *pcName);
 uint32_t     ulContainerGetCount(void);
@@ -88,9 +162,12 @@ Container_t *pxContainerGetList(void);
 
 /* Container resource management */
 BaseType_t xContainerSetMemoryLimit(uint32_t ulContainerID, uint32_t ulMemoryLimit);
+BaseType_t xContainerSetMemorySoftLimit(uint32_t ulContainerID, uint32_t ulSoftLimit);
 BaseType_t xContainerSetCpuQuota(uint32_t ulContainerID, uint32_t ulCpuQuota);
+BaseType_t xContainerSetCpuWeight(uint32_t ulContainerID, uint32_t ulCpuWeight);
+BaseType_t xContainerSetParentCGroup(uint32_t ulContainerID, CGroupHandle_t xParent);
 BaseType_t
-xContainerGetStats(uint32_t ulContainerID, uint32_t *pulMemoryUsed, uint32_t *pulCpuUsage);
+xContainerGetStats(uint32_t ulContainerID, uint32_t *pulMemoryUsed, uint64_t *pullCpuTimeUs);
 
 /* Container daemon task */
 void vContainerDaemonTask(void *pvParameters);
@@ -105,6 +182,12 @@ xContainerStartCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *
 BaseType_t
 xContainerStopCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
 BaseType_t
+xContainerPauseCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+BaseType_t
+xContainerResumeCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+BaseType_t
+xContainerStatsCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+BaseType_t
 xContainerRunCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
 BaseType_t
 xContainerDeleteCommand(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
@@ -0,0 +1,124 @@
+/*
+ * Program image cache for FreeRTOS containers
+ * Copyright (C) 2025
+ *
+ * Keeps ELF files read from the file system in memory so that containers
+ * running the same program share one read-only copy, and later starts do not
+ * read the file again. Images are reference counted; images nobody references
+ * stay cached until the cache is over its size budget or the heap runs low.
+ * An image also keeps the relocated program its first start prepared, so
+ * later starts skip relocation, see elf_load_and_run_prepared().
+ */
+
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include "FreeRTOS.h"
+#include "elf_loader.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef configUSE_FILESYSTEM
+
+/* Bytes of unreferenced images the cache keeps, referenced images never count against it */
+#ifndef configIMAGE_CACHE_MAX_BYTES
+#define configIMAGE_CACHE_MAX_BYTES (512U * 1024U)
+#endif
+
+/* Free heap below which unreferenced images are dropped as soon as possible */
+#ifndef configIMAGE_CACHE_LOW_HEAP_BYTES
+#define configIMAGE_CACHE_LOW_HEAP_BYTES (64U * 1024U)
+#endif
+
+/* littlefs user attribute holding the SHA-256 digest of a file, written when images are unpacked.
+ * Container programs cannot set it. Files carrying it are cached by content so copies in different
+ * container roots share one image; the digest is checked against the data when the file is read
+ * and files whose digest does not match, like files without one, are cached by absolute path and
+ * size. */
+#define IMAGE_CACHE_ATTR_HASH (0x68U)
+
+/* Bytes of the digest in IMAGE_CACHE_ATTR_HASH */
+#define IMAGE_CACHE_DIGEST_LEN (32U)
+
+typedef struct ImageCacheEntry *ImageHandle_t;
+
+typedef struct {
+    UBaseType_t uxEntries;      /* Images in the cache */
+    UBaseType_t uxReferenced;   /* Images held by at least one user */
+    size_t      xBytes;         /* Bytes of image data in the cache */
+    uint32_t    ulHits;         /* Acquires served without reading the file */
+    uint32_t    ulMisses;       /* Acquires that read the file */
+    uint32_t    ulEvictions;    /* Images dropped to stay in budget or relieve the heap */
+    UBaseType_t uxPrepared;     /* Images holding a relocated program */
+    size_t      xPreparedBytes; /* Bytes of relocated programs */
+} ImageCacheStats_t;
+
+/**
+ * @brief Get a read-only view of a program file
+ *
+ * The path is resolved against the root of the calling task. The file is
+ * read only if no cached image matches it.
+ *
+ * @param pcPath Path of the file
+ * @param ppucData Receives the file contents, valid until the image is released
+ * @param pxSize Receives the file size
+ * @return Handle to pass to vImageCacheRelease(), NULL if the file cannot be read
+ */
+ImageHandle_t xImageCacheAcquire(const char *pcPath, const uint8_t **ppucData, size_t *pxSize);
+
+/**
+ * @brief Drop a reference taken with xImageCacheAcquire()
+ *
+ * @param xImage Image to release, NULL is ignored
+ */
+void vImageCacheRelease(ImageHandle_t xImage);
+
+/**
+ * @brief Stop serving cached copies of a file that is about to change
+ *
+ * Called by the file system before a file is opened for writing, removed or
+ * renamed. Images cached by path below pcPath are no longer found; tasks
+ * still holding them keep their copy until they release it. Images cached by
+ * a verified digest are not affected.
+ *
+ * @param pcPath Absolute path of the file or directory
+ */
+void vImageCacheInvalidate(const char *pcPath);
+
+/**
+ * @brief Get the slot holding the image's relocated program
+ *
+ * Pass it to elf_load_and_run_prepared() while holding a reference to the
+ * image. The first start fills it, the program is freed with the image and
+ * counts against the cache budget once the image is unreferenced.
+ *
+ * @param xImage Image from xImageCacheAcquire()
+ * @return Slot for the relocated program, NULL if xImage is NULL
+ */
+ELF_PREPARED *pxImageCachePrepared(ImageHandle_t xImage);
+
+/**
+ * @brief Drop unreferenced images, least recently used first
+ *
+ * @param xBytes Bytes to free, 0 drops every unreferenced image
+ * @return Bytes freed
+ */
+size_t xImageCacheTrim(size_t xBytes);
+
+/**
+ * @brief Digest file contents the way IMAGE_CACHE_ATTR_HASH expects
+ *
+ * @param pucData File contents
+ * @param xSize File size
+ * @param pucDigest Receives IMAGE_CACHE_DIGEST_LEN bytes of SHA-256 digest
+ */
+void vImageCacheDigest(const uint8_t *pucData, size_t xSize, uint8_t *pucDigest);
+
+/**
+ * @brief Get cache statistics
+ */
+void vImageCacheGetStats(ImageCacheStats_t *pxStats);
+
+#endif /* configUSE_FILESYSTEM */
+
+#endif /* IMAGE_CACHE_H */
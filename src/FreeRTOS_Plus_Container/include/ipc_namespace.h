@@ -81,6 +81,7 @@ typedef struct xIPC_OBJECT_ENTRY {
     char            pcObjectName[configMAX_TASK_NAME_LEN]; /* Object name for debugging */
     UBaseType_t     ulObjectId;                            /* Unique ID within namespace */
     IpcNamespaceHandle_t xNamespace;                       /* Owning namespace */
+    UBaseType_t          uxUseCount; /* Calls using the object, see xIpcNamespaceAcquireObject() */
 } IpcObjectEntry_t;
 
 /* IPC Namespace structure */
@@ -164,10 +165,11 @@ UBaseType_t ulIpcNamespaceRegisterObject(IpcNamespaceHandle_t xNamespace,
 /**
  * ipc_namespace.h
  * @brief Unregister an IPC object from a namespace
+ * Fails while the object is acquired, so the caller can delete the object once this succeeds
  *
  * @param xNamespace Handle to the namespace
  * @param pvIpcObject Pointer to the IPC object
- * @return pdPASS on success, pdFAIL on failure
+ * @return pdPASS on success, pdFAIL if not registered or in use
  */
 BaseType_t xIpcNamespaceUnregisterObject(IpcNamespaceHandle_t xNamespace, void *pvIpcObject);
 
@@ -184,6 +186,70 @@ void *pvIpcNamespaceFindObject(IpcNamespaceHandle_t xNamespace,
                                UBaseType_t          ulObjectId,
                                IpcObjectType_t     *pxObjectType);
 
+/**
+ * ipc_namespace.h
+ * @brief Find an IPC object by name and type within a namespace
+ * Names are compared over the configMAX_TASK_NAME_LEN - 1 characters an entry stores
+ *
+ * @param xNamespace Handle to the namespace
+ * @param pcObjectName Name the object was registered with
+ * @param xObjectType Type of the IPC object
+ * @return Pointer to the first matching IPC object, or NULL if not found
+ */
+void *pvIpcNamespaceFindObjectByName(IpcNamespaceHandle_t xNamespace,
+                                     const char *const    pcObjectName,
+                                     IpcObjectType_t      xObjectType);
+
+/**
+ * ipc_namespace.h
+ * @brief Check that an IPC object is registered in a namespace
+ * Unlike xIpcNamespaceCheckAccess() an unregistered object is refused, so the handle can come
+ * from untrusted code
+ *
+ * @param xNamespace Handle to the namespace
+ * @param pvIpcObject Pointer to the IPC object
+ * @param pxObjectType Pointer to store the object type (optional, can be NULL)
+ * @return pdPASS if the object is registered in xNamespace, pdFAIL otherwise
+ */
+BaseType_t xIpcNamespaceLookupObject(IpcNamespaceHandle_t xNamespace,
+                                     void                *pvIpcObject,
+                                     IpcObjectType_t     *pxObjectType);
+
+/**
+ * ipc_namespace.h
+ * @brief Acquire an IPC object for one call
+ * The object is checked like xIpcNamespaceLookupObject() and cannot be unregistered until
+ * vIpcNamespaceReleaseObject() is called, so the call may block on it
+ *
+ * @param xNamespace Handle to the namespace
+ * @param pvIpcObject Pointer to the IPC object
+ * @param xObjectType Type the object must have
+ * @return pdPASS if the object is registered in xNamespace with that type, pdFAIL otherwise
+ */
+BaseType_t xIpcNamespaceAcquireObject(IpcNamespaceHandle_t xNamespace,
+                                      void                *pvIpcObject,
+                                      IpcObjectType_t      xObjectType);
+
+/**
+ * ipc_namespace.h
+ * @brief Release an object acquired with xIpcNamespaceAcquireObject()
+ *
+ * @param xNamespace Handle to the namespace
+ * @param pvIpcObject Pointer to the IPC object
+ */
+void vIpcNamespaceReleaseObject(IpcNamespaceHandle_t xNamespace, void *pvIpcObject);
+
+/**
+ * ipc_namespace.h
+ * @brief Unregister and delete every IPC object in a namespace
+ * Call before xIpcNamespaceDelete() once no task uses the objects any more. Objects are deleted
+ * even when acquired, the tasks holding them must already be deleted
+ *
+ * @param xNamespace Handle to the namespace
+ * @return Number of objects deleted
+ */
+UBaseType_t uxIpcNamespaceDeleteObjects(IpcNamespaceHandle_t xNamespace);
+
 /**
  * ipc_namespace.h
  * @brief Check if a task has access to an IPC object
@@ -269,6 +335,13 @@ SemaphoreHandle_t xSemaphoreCreateMutexIsolated(const char *const pcMutexName);
     #define xIpcNamespaceCreate(name) NULL
     #define xIpcNamespaceDelete(ns) pdFAIL
     #define xIpcNamespaceCheckAccess(task, obj) pdTRUE
+    #define pvIpcNamespaceFindObjectByName(ns, name, type) NULL
+    #define xIpcNamespaceLookupObject(ns, obj, type) pdFAIL
+    #define xIpcNamespaceAcquireObject(ns, obj, type) pdFAIL
+    #define vIpcNamespaceReleaseObject(ns, obj)                                                    \
+        do {                                                                                       \
+        } while (0)
+    #define uxIpcNamespaceDeleteObjects(ns) 0U
     #define xQueueCreateIsolated(length, size, name) xQueueCreate(length, size)
     #define xSemaphoreCreateBinaryIsolated(name) xSemaphoreCreateBinary()
     #define xSemaphoreCreateMutexIsolated(name) xSemaphoreCreateMutex()
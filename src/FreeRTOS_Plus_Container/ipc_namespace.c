@@ -26,6 +26,7 @@
  */
 
 #include "FreeRTOS.h"
+#include "event_groups.h"
 #include "ipc_namespace.h"
 
 #if (configUSE_IPC_NAMESPACE == 1)
@@ -59,6 +60,7 @@ static UBaseType_t ulNextNamespaceId = 1U;
 
 static size_t            prvStrlen(const char *pcString);
 static void              prvStrcpy(char *pcDestination, const char *pcSource, size_t xMaxLength);
+static BaseType_t        prvNameMatches(const char *pcStored, const char *pcName);
 static BaseType_t        prvFindFreeNamespaceSlot(UBaseType_t *puxSlot);
 static BaseType_t        prvFindFreeObjectEntry(IpcObjectEntry_t **ppxEntry);
 static IpcObjectEntry_t *prvFindObjectEntry(IpcNamespaceHandle_t xNamespace, void *pvIpcObject);
@@ -92,6 +94,22 @@ static void prvStrcpy(char *pcDestination, const char *pcSource, size_t xMaxLeng
     }
 }
 
+/* Compare a name with an entry name, which prvStrcpy() truncated to configMAX_TASK_NAME_LEN */
+static BaseType_t prvNameMatches(const char *pcStored, const char *pcName) {
+    size_t xIndex;
+
+    for (xIndex = 0U; xIndex < (configMAX_TASK_NAME_LEN - 1U); xIndex++) {
+        if (pcStored[xIndex] != pcName[xIndex]) {
+            return pdFALSE;
+        }
+        if (pcStored[xIndex] == '\0') {
+            break;
+        }
+    }
+
+    return pdTRUE;
+}
+
 static BaseType_t prvFindFreeNamespaceSlot(UBaseType_t *puxSlot) {
     UBaseType_t ux;
 
@@ -256,6 +274,7 @@ UBaseType_t ulIpcNamespaceRegisterObject(IpcNamespaceHandle_t xNamespace,
         pxEntry->xObjectType = xObjectType;
         pxEntry->xNamespace = xNamespace;
         pxEntry->ulObjectId = pxNamespace->ulNextObjectId++;
+        pxEntry->uxUseCount = 0U;
         ulObjectId = pxEntry->ulObjectId;
 
         /* Copy object name */
@@ -292,7 +311,7 @@ BaseType_t xIpcNamespaceUnregisterObject(IpcNamespaceHandle_t xNamespace, void *
     portENTER_CRITICAL();
 
     pxEntry = prvFindObjectEntry(xNamespace, pvIpcObject);
-    if (pxEntry != NULL) {
+    if ((pxEntry != NULL) && (pxEntry->uxUseCount == 0U)) {
         /* Remove from namespace list */
         (void)uxListRemove(&(pxEntry->xNamespaceListItem));
 
@@ -346,6 +365,148 @@ void *pvIpcNamespaceFindObject(IpcNamespaceHandle_t xNamespace,
     return pvObject;
 }
 
+void *pvIpcNamespaceFindObjectByName(IpcNamespaceHandle_t xNamespace,
+                                     const char *const    pcObjectName,
+                                     IpcObjectType_t      xObjectType) {
+    IpcNamespace_t   *pxNamespace = (IpcNamespace_t *)xNamespace;
+    ListItem_t       *pxListItem;
+    IpcObjectEntry_t *pxEntry;
+    void             *pvObject = NULL;
+
+    if ((xNamespace == NULL) || (pxNamespace->xActive == pdFALSE) || (pcObjectName == NULL) ||
+        (pcObjectName[0] == '\0')) {
+        return NULL;
+    }
+
+    portENTER_CRITICAL();
+
+    if (!listLIST_IS_EMPTY(&(pxNamespace->xObjectList))) {
+        pxListItem = listGET_HEAD_ENTRY(&(pxNamespace->xObjectList));
+
+        do {
+            pxEntry = (IpcObjectEntry_t *)listGET_LIST_ITEM_OWNER(pxListItem);
+            if ((pxEntry->xObjectType == xObjectType) &&
+                (prvNameMatches(pxEntry->pcObjectName, pcObjectName) == pdTRUE)) {
+                pvObject = pxEntry->pvIpcObject;
+                break;
+            }
+            pxListItem = listGET_NEXT(pxListItem);
+        } while (pxListItem != listGET_END_MARKER(&(pxNamespace->xObjectList)));
+    }
+
+    portEXIT_CRITICAL();
+
+    return pvObject;
+}
+
+BaseType_t xIpcNamespaceLookupObject(IpcNamespaceHandle_t xNamespace,
+                                     void                *pvIpcObject,
+                                     IpcObjectType_t     *pxObjectType) {
+    IpcNamespace_t   *pxNamespace = (IpcNamespace_t *)xNamespace;
+    IpcObjectEntry_t *pxEntry;
+    BaseType_t        xResult = pdFAIL;
+
+    if ((xNamespace == NULL) || (pvIpcObject == NULL) || (pxNamespace->xActive == pdFALSE)) {
+        return pdFAIL;
+    }
+
+    portENTER_CRITICAL();
+
+    pxEntry = prvFindObjectEntry(xNamespace, pvIpcObject);
+    if (pxEntry != NULL) {
+        if (pxObjectType != NULL) {
+            *pxObjectType = pxEntry->xObjectType;
+        }
+        xResult = pdPASS;
+    }
+
+    portEXIT_CRITICAL();
+
+    return xResult;
+}
+
+BaseType_t xIpcNamespaceAcquireObject(IpcNamespaceHandle_t xNamespace,
+                                      void                *pvIpcObject,
+                                      IpcObjectType_t      xObjectType) {
+    IpcNamespace_t   *pxNamespace = (IpcNamespace_t *)xNamespace;
+    IpcObjectEntry_t *pxEntry;
+    BaseType_t        xResult = pdFAIL;
+
+    if ((xNamespace == NULL) || (pvIpcObject == NULL) || (pxNamespace->xActive == pdFALSE)) {
+        return pdFAIL;
+    }
+
+    portENTER_CRITICAL();
+
+    pxEntry = prvFindObjectEntry(xNamespace, pvIpcObject);
+    if ((pxEntry != NULL) && (pxEntry->xObjectType == xObjectType)) {
+        pxEntry->uxUseCount++;
+        xResult = pdPASS;
+    }
+
+    portEXIT_CRITICAL();
+
+    return xResult;
+}
+
+void vIpcNamespaceReleaseObject(IpcNamespaceHandle_t xNamespace, void *pvIpcObject) {
+    IpcObjectEntry_t *pxEntry;
+
+    if ((xNamespace == NULL) || (pvIpcObject == NULL)) {
+        return;
+    }
+
+    portENTER_CRITICAL();
+
+    /* The entry is gone if uxIpcNamespaceDeleteObjects() ran meanwhile */
+    pxEntry = prvFindObjectEntry(xNamespace, pvIpcObject);
+    if ((pxEntry != NULL) && (pxEntry->uxUseCount > 0U)) {
+        pxEntry->uxUseCount--;
+    }
+
+    portEXIT_CRITICAL();
+}
+
+UBaseType_t uxIpcNamespaceDeleteObjects(IpcNamespaceHandle_t xNamespace) {
+    IpcNamespace_t   *pxNamespace = (IpcNamespace_t *)xNamespace;
+    IpcObjectEntry_t *pxEntry;
+    void             *pvObject;
+    IpcObjectType_t   xObjectType;
+    UBaseType_t       uxDeleted = 0U;
+
+    if ((xNamespace == NULL) || (pxNamespace->xActive == pdFALSE)) {
+        return 0U;
+    }
+
+    for (;;) {
+        /* Unregister one entry at a time, the object is freed outside the critical section */
+        portENTER_CRITICAL();
+        if (listLIST_IS_EMPTY(&(pxNamespace->xObjectList))) {
+            portEXIT_CRITICAL();
+            break;
+        }
+        pxEntry = (IpcObjectEntry_t *)listGET_OWNER_OF_HEAD_ENTRY(&(pxNamespace->xObjectList));
+        (void)uxListRemove(&(pxEntry->xNamespaceListItem));
+        pvObject = pxEntry->pvIpcObject;
+        xObjectType = pxEntry->xObjectType;
+        pxEntry->pvIpcObject = NULL;
+        pxEntry->xNamespace = NULL;
+        pxEntry->uxUseCount = 0U;
+        pxNamespace->uxObjectCount--;
+        uxObjectEntryCount--;
+        portEXIT_CRITICAL();
+
+        if (xObjectType == IPC_TYPE_EVENT_GROUP) {
+            vEventGroupDelete((EventGroupHandle_t)pvObject);
+        } else {
+            vQueueDelete((QueueHandle_t)pvObject);
+        }
+        uxDeleted++;
+    }
+
+    return uxDeleted;
+}
+
 BaseType_t xIpcNamespaceCheckAccess(TaskHandle_t xTask, void *pvIpcObject) {
     IpcNamespaceHandle_t xTaskNamespace;
     IpcObjectEntry_t    *pxEntry;
@@ -0,0 +1,41 @@
+#ifndef FREERTOS_PLUS_ELF_EXPORT_H
+#define FREERTOS_PLUS_ELF_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 内核导出给 ELF 程序的符号
+// 符号表由 script/gen_export_table.py 根据 elf_exports.txt 生成 elf_export_table.c，
+// 按 GNU hash 分桶，加载时按哈希查找，不需要逐个比较名称
+
+typedef struct {
+    uint32_t    hash;    // elf_export_hash(name)
+    const char *name;    // 符号名称
+    const void *address; // 符号地址，未编译进内核的符号为 NULL；GOT 类重定位把此字段用作 GOT 表项
+} ELF_EXPORT;
+
+typedef struct {
+    uint32_t          bucket_count; // 桶数，2 的幂
+    const uint16_t   *buckets;      // 每个桶第一个符号的下标，共 bucket_count + 1 项
+    const ELF_EXPORT *symbols;      // 按桶排列的符号
+    size_t            symbol_count;
+} ELF_EXPORT_TABLE;
+
+extern const ELF_EXPORT_TABLE elf_export_table;
+
+/**
+ * 计算符号名称的 GNU hash（h = h * 33 + c，初值 5381）
+ * 必须与 script/gen_export_table.py 中的实现一致
+ * @param name 符号名称
+ * @return 哈希值
+ */
+uint32_t elf_export_hash(const char *name);
+
+/**
+ * 查找导出的符号，先查内核符号表，再查 elf_library_load() 加载的共享运行库
+ * @param name 符号名称
+ * @return 符号表项，未导出或未编译进内核时返回 NULL
+ */
+const ELF_EXPORT *elf_find_export(const char *name);
+
+#endif /* FREERTOS_PLUS_ELF_EXPORT_H */
@@ -0,0 +1,69 @@
+// 由 script/gen_export_table.py 根据 elf_exports.txt 生成，不要手动修改
+
+#include "elf_export.h"
+#include "FreeRTOS.h"
+#include "container.h"
+#include "syscall.h"
+#include "task.h"
+#include <string.h>
+
+#ifdef configUSE_FILESYSTEM
+#include "file_system.h"
+#endif
+
+extern void uart_puts(const char *str);
+
+static const uint16_t elf_export_buckets[33] = {
+    0, 1, 1, 1, 1, 4, 4, 5,
+    5, 5, 5, 6, 6, 8, 9, 9,
+    9, 11, 11, 11, 11, 12, 12, 13,
+    13, 14, 14, 14, 16, 17, 20, 21,
+    21,
+};
+
+static const ELF_EXPORT elf_export_symbols[21] = {
+    {0x8f82ab20U, "vContainerFree", (const void *)&vContainerFree},
+    {0x0d827524U, "memcmp", (const void *)&memcmp},
+#if defined(configUSE_FILESYSTEM)
+    {0x478b3904U, "pxGetLfsOps", (const void *)&pxGetLfsOps},
+#else
+    {0x478b3904U, "pxGetLfsOps", NULL},
+#endif
+    {0xe07b8284U, "xTaskGetTickCount", (const void *)&xTaskGetTickCount},
+    {0x82c13326U, "pvContainerMalloc", (const void *)&pvContainerMalloc},
+    {0x1c9396caU, "strcpy", (const void *)&strcpy},
+    {0x10e9d3acU, "uart_puts", (const void *)&uart_puts},
+    {0xaf0c3fccU, "strncmp", (const void *)&strncmp},
+    {0xaf0e70adU, "strrchr", (const void *)&strrchr},
+    {0x0d827590U, "memcpy", (const void *)&memcpy},
+    {0x0d82b830U, "memset", (const void *)&memset},
+#if defined(configUSE_FILESYSTEM)
+    {0xdf2af134U, "xTaskSetPwdPath", (const void *)&xTaskSetPwdPath},
+#else
+    {0xdf2af134U, "xTaskSetPwdPath", NULL},
+#endif
+#if defined(configUSE_FILESYSTEM)
+    {0xe4042736U, "pvTaskGetPwdPath", (const void *)&pvTaskGetPwdPath},
+#else
+    {0xe4042736U, "pvTaskGetPwdPath", NULL},
+#endif
+    {0xaf0c4038U, "strncpy", (const void *)&strncpy},
+    {0x1c9395bbU, "strchr", (const void *)&strchr},
+    {0xbdd69f1bU, "memmove", (const void *)&memmove},
+    {0x3144b4bcU, "freertos_syscalls", (const void *)&freertos_syscalls},
+    {0x1c93bb9dU, "strlen", (const void *)&strlen},
+#if INCLUDE_vTaskDelay == 1
+    {0x635c84fdU, "vTaskDelay", (const void *)&vTaskDelay},
+#else
+    {0x635c84fdU, "vTaskDelay", NULL},
+#endif
+    {0x740a9f7dU, "xPortGetFreeHeapSize", (const void *)&xPortGetFreeHeapSize},
+    {0x1c93965eU, "strcmp", (const void *)&strcmp},
+};
+
+const ELF_EXPORT_TABLE elf_export_table = {
+    .bucket_count = 32U,
+    .buckets = elf_export_buckets,
+    .symbols = elf_export_symbols,
+    .symbol_count = 21U,
+};
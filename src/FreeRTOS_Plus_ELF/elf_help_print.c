@@ -43,6 +43,12 @@ void print_error(int error_code) {
         case ELF_ERROR_RELOCATION_FAILED:
             xil_printf("Error: Relocation failed.\r\n");
             break;
+        case ELF_ERROR_LIBRARY_DATA:
+            xil_printf("Error: Shared library has writable data.\r\n");
+            break;
+        case ELF_ERROR_SYSCALL_ABI:
+            xil_printf("Error: Program needs a syscall ABI the kernel does not provide.\r\n");
+            break;
         default:
             xil_printf("Error: Unknown error code.\r\n");
             break;
@@ -202,17 +208,16 @@ void print_symbol(const Elf64_Sym sym, const Elf64_Shdr *strtab_hdr, const uint8
 /**
  * 输出所有加载到内存的代码段
  * @param context ELF文件加载上下文
- * @param section_memory
  */
 
-void print_code(Elf64_Ctx *context, uint8_t section_memory[MAX_SECTIONS * SECTION_MEMORY_SIZE]) {
+void print_code(Elf64_Ctx *context) {
     if (context == NULL) {
         xil_printf("Context is NULL.\r\n");
         return;
     }
 
     xil_printf("Loaded Sections:\r\n");
-    uint8_t *memory_start = context->memory_pool_index * ELF_MEMORY_SIZE + section_memory;
+    uint8_t *memory_start = context->image_memory;
     for (size_t i = 0; i < context->memory_size; i++) {
         if ((i + 1) % 4 == 0) {
             xil_printf("%02x %02x %02x %02x\r\n",
@@ -252,6 +257,7 @@ void print_context(const Elf64_Ctx *context) {
     xil_printf("Elf64_Ctx: {\r\n");
     xil_printf("  elf_data: %016llx\r\n", (unsigned long long)context->elf_data);
     xil_printf("  elf_size: %llx\r\n", (unsigned long long)context->elf_size);
+    xil_printf("  reader: %016llx\r\n", (unsigned long long)context->reader);
     xil_printf("  elf_hdr: %016llx\r\n", (unsigned long long)context->elf_hdr);
     xil_printf("  section_headers: %016llx\r\n", (unsigned long long)context->section_headers);
     xil_printf("  program_headers: %016llx\r\n", (unsigned long long)context->program_headers);
@@ -260,9 +266,9 @@ void print_context(const Elf64_Ctx *context) {
     xil_printf("  symtab_hdr: %016llx\r\n", (unsigned long long)context->symtab_hdr);
     xil_printf("  strtab_hdr: %016llx\r\n", (unsigned long long)context->strtab_hdr);
     xil_printf("  symtab: %016llx\r\n", (unsigned long long)context->symtab);
-    xil_printf("  strtab: %016llx\r\n", (unsigned long long)context->strtab);
     xil_printf("  rela: %016llx\r\n", (unsigned long long)context->rela);
-    xil_printf("  memory_pool_index: %d\r\n", context->memory_pool_index);
+    xil_printf("  image_memory: %016llx\r\n", (unsigned long long)context->image_memory);
+    xil_printf("  load_bias: %016llx\r\n", (unsigned long long)context->load_bias);
     xil_printf("  memory_size: %llx\r\n", (unsigned long long)context->memory_size);
     for (int i = 0; i < MAX_SECTIONS; i++) {
         xil_printf("  load_sections[%d]: %016llx\r\n", i, (unsigned long long)context->load_sections[i]);
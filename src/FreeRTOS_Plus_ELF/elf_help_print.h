@@ -1,9 +1,7 @@
 #ifndef ELF_HELP_PRINT_H
 #define ELF_HELP_PRINT_H
 
-// 静态内存池定义
 #define MAX_SECTIONS 16
-#define SECTION_MEMORY_SIZE (64 * 1024) // 每个段最大64KB
 
 #include "elf_loader.h"
 #include <stddef.h>
@@ -70,10 +68,9 @@ void print_symbol(const Elf64_Sym sym, const Elf64_Shdr *strtab_hdr, const uint8
 /**
  * 输出所有加载到内存的代码段
  * @param context ELF文件加载上下文
- * @param section_memory
  */
 
-void print_code(Elf64_Ctx *context, uint8_t section_memory[MAX_SECTIONS * SECTION_MEMORY_SIZE]);
+void print_code(Elf64_Ctx *context);
 
 /**
  * 打印错误信息
@@ -1,22 +1,269 @@
 #include "elf_loader.h"
 #include "FreeRTOS.h"
+#include "cgroup.h"
+#include "elf_export.h"
 #include "elf_help_print.h"
 #include "syscall.h"
+#include "task.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #ifdef DEBUG_ELF_LOADER
 #include "xil_printf.h"
 #endif
 
-extern FreeRTOSSyscalls_t freertos_syscalls;
-extern GOT_t              got;
+// 正在加载或执行的程序，每次加载单独分配上下文，链表只在临界区中修改
+static Elf64_Ctx *elf_ctx_list;
+
+// 累计的加载统计，只在临界区中修改
+static ELF_LOAD_STATS elf_load_stats;
+
+// 预处理镜像，结构体、fixups 和程序内存副本在同一块分配中
+// 基址按节的最大对齐分配；不足一页时页内偏移类重定位也与基址有关，一并记录
+struct Elf_Prepared {
+    uint32_t   layout;      // ELF 头部和节头表的哈希，确认镜像来自同一文件
+    size_t     image_size;  // 程序内存字节数
+    size_t     align;       // 程序内存的基址对齐
+    size_t     entry;       // main 相对基址的偏移
+    size_t     alloc_size;  // 整块分配的字节数
+    size_t     text_offset; // 可执行代码相对基址的范围
+    size_t     text_size;
+    size_t     fixup_count;
+    ELF_FIXUP *fixups;
+    uint8_t   *image;       // 重定位后、执行前的程序内存
+};
+
+// 一块 PLT 跳板，跳板地址在程序运行期间不变，块不重新分配
+struct Elf_Plt_Block {
+    ELF_PLT_BLOCK *next;
+    size_t         count;
+    ELF_PLT_ENTRY  entries[ELF_PLT_CHUNK];
+};
+
+// 共享运行库，加载后常驻内存，符号表项在程序运行期间不变
+// 链表只在临界区中从头部插入，节点不释放，查找符号时不需要加锁
+typedef struct Elf_Library ELF_LIBRARY;
+struct Elf_Library {
+    ELF_LIBRARY     *next;
+    char             name[ELF_LIBRARY_NAME_MAX];
+    uint8_t         *memory;      // 分配的程序内存
+    size_t           memory_size;
+    ELF_EXPORT_TABLE exports;     // 库中定义的全局符号，格式与内核符号表相同
+};
+
+static ELF_LIBRARY *volatile elf_library_list;
+
+// 延迟绑定入口，见 elf_plt.S
+extern void elf_plt_lazy_entry(void);
+Elf64_Addr  elf_plt_bind(Elf64_Addr *target);
 
-static uint64_t   elf_bits_map;
-static Elf64_Ctx  elf_ctxs[MAX_ELF];
-static Elf64_Addr elf_memory_addr[MAX_ELF] = {};
-static uint8_t    section_memory[ELF_MEMORY_SIZE * MAX_ELF];
+/**
+ * 读取 ARM 通用定时器计数（CNTVCT_EL0）
+ */
+static inline uint64_t elf_read_counter(void) {
+    uint64_t value;
+
+    __asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(value) : : "memory");
+    return value;
+}
+
+/**
+ * 从文件中读取数据
+ * @param context ELF文件加载上下文
+ * @param offset 文件偏移
+ * @param buf 输出缓冲区
+ * @param size 读取字节数
+ * @return 成功返回 ELF_SUCCESS，越界或读取失败返回 ELF_ERROR_READ
+ */
+static int elf_read(Elf64_Ctx *context, Elf64_Off offset, void *buf, size_t size) {
+    const ELF_READER *reader = context->reader;
+
+    if (reader == NULL || offset > context->elf_size || size > context->elf_size - offset) {
+        return ELF_ERROR_READ;
+    }
+    if (size == 0) {
+        return ELF_SUCCESS;
+    }
+    if (reader->read(reader->user, (size_t)offset, buf, size) != (int)size) {
+        return ELF_ERROR_READ;
+    }
+    return ELF_SUCCESS;
+}
+
+/**
+ * 结束读取，通知读取方可以释放文件（只通知一次）
+ * @param context ELF文件加载上下文
+ */
+static void elf_read_done(Elf64_Ctx *context) {
+    const ELF_READER *reader = context->reader;
+
+    context->reader = NULL;
+    if (reader != NULL && reader->done != NULL) {
+        reader->done(reader->user);
+    }
+}
+
+/**
+ * 内存中 ELF 文件的读取回调
+ */
+static int elf_memory_read(void *user, size_t offset, void *buf, size_t size) {
+    memcpy(buf, (const uint8_t *)user + offset, size);
+    return (int)size;
+}
+
+/**
+ * 检查对齐值，0 和 1 表示不要求对齐
+ * @return 有效返回对齐值，不是 2 的幂返回 0
+ */
+static Elf64_Xword elf_align(Elf64_Xword align) {
+    if (align <= 1) {
+        return 1;
+    }
+    return ((align & (align - 1)) == 0) ? align : 0;
+}
+
+/**
+ * 分配加载器自身使用的内存（上下文、节头表、GOT、PLT、fixups、预处理镜像）
+ * 这些内存不计入任何 cgroup，容器的内存限制只约束程序本身
+ * @param size 字节数
+ * @return 内存，失败返回 NULL
+ */
+static void *elf_alloc_uncharged(size_t size) {
+    CGroupHandle_t previous = xCGroupSetMemoryChargeTarget(CGROUP_CHARGE_NONE);
+    void          *memory = pvPortMalloc(size);
+
+    (void)xCGroupSetMemoryChargeTarget(previous);
+    return memory;
+}
+
+/**
+ * 分配程序内存
+ * 内存由执行程序的任务分配，计入该任务的 cgroup
+ * @param context ELF文件加载上下文
+ * @param size 字节数
+ * @param align 基址对齐，不超过 ELF_MAX_ALIGN
+ * @return 对齐后的基址，失败返回 NULL
+ */
+static uint8_t *alloc_image_memory(Elf64_Ctx *context, Elf64_Xword size, Elf64_Xword align) {
+    size_t   extra = (align > portBYTE_ALIGNMENT) ? (size_t)align - 1 : 0;
+    uint8_t *memory;
+
+    if (size == 0 || size > (Elf64_Xword)(SIZE_MAX - extra)) {
+        return NULL;
+    }
+
+    memory = (uint8_t *)pvPortMalloc((size_t)size + extra);
+    if (memory == NULL) {
+        return NULL;
+    }
+
+    context->image_memory = memory;
+    context->memory_size = (size_t)size + extra;
+    context->image_align = (align > portBYTE_ALIGNMENT) ? (size_t)align : portBYTE_ALIGNMENT;
+
+    return (uint8_t *)(((uintptr_t)memory + extra) & ~(uintptr_t)extra);
+}
+
+/**
+ * 把一段可执行代码加入需要同步指令缓存的范围
+ * @param context ELF文件加载上下文
+ * @param start 起始地址
+ * @param size 字节数
+ */
+static void elf_add_text(Elf64_Ctx *context, Elf64_Addr start, Elf64_Xword size) {
+    if (context->text_start == context->text_end) {
+        context->text_start = start;
+        context->text_end = start + size;
+        return;
+    }
+    if (start < context->text_start) {
+        context->text_start = start;
+    }
+    if (start + size > context->text_end) {
+        context->text_end = start + size;
+    }
+}
+
+/**
+ * 分配加载上下文并加入 elf_ctx_list
+ * 上下文不计入 cgroup，见 elf_alloc_uncharged
+ * @param reader 读取回调
+ * @param elf_data 内存中的 ELF 文件，流式加载时为 NULL
+ * @return 上下文，内存不足返回 NULL
+ */
+static Elf64_Ctx *elf_ctx_claim(const ELF_READER *reader, const uint8_t *elf_data) {
+    Elf64_Ctx *context = (Elf64_Ctx *)elf_alloc_uncharged(sizeof(Elf64_Ctx));
+
+    if (context == NULL) {
+        return NULL;
+    }
+
+    memset(context, 0, sizeof(Elf64_Ctx));
+    context->elf_data = elf_data;
+    context->elf_size = reader->size;
+    context->reader = reader;
+    context->owner = reader->owner;
+    context->result = ELF_NOT_RUN;
+    context->load_start = elf_read_counter();
+
+    taskENTER_CRITICAL();
+    context->next = elf_ctx_list;
+    elf_ctx_list = context;
+    taskEXIT_CRITICAL();
+
+    return context;
+}
 
+/**
+ * 从 elf_ctx_list 中移除上下文
+ * 移除后其他任务不再能访问该上下文
+ * @param context ELF文件加载上下文
+ */
+static void elf_ctx_unlink(Elf64_Ctx *context) {
+    Elf64_Ctx **link;
+
+    taskENTER_CRITICAL();
+    for (link = &elf_ctx_list; *link != NULL; link = &(*link)->next) {
+        if (*link == context) {
+            *link = context->next;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * 释放已移除的上下文及其程序内存
+ * @param context ELF文件加载上下文
+ */
+static void elf_ctx_free(Elf64_Ctx *context) {
+    if (context->image_memory != NULL) {
+        vPortFree(context->image_memory);
+    }
+    if (context->got != NULL) {
+        vPortFree(context->got);
+    }
+    if (context->fixups != NULL) {
+        vPortFree(context->fixups);
+    }
+    if (context->prepared != NULL) {
+        vPortFree(context->prepared);
+    }
+    while (context->plt_blocks != NULL) {
+        ELF_PLT_BLOCK *block = context->plt_blocks;
+
+        context->plt_blocks = block->next;
+        vPortFree(block);
+    }
+    if (context->plt != NULL) {
+        vPortFree(context->plt);
+    }
+    if (context->shdrs != NULL) {
+        vPortFree(context->shdrs);
+    }
+    vPortFree(context);
+}
 
 /**
  * 校验 ELF 文件头部
@@ -50,8 +297,8 @@ static int validate_elf_header(const Elf64_Ehdr *elf_hdr) {
         return ELF_ERROR_INVALID_VERSION;
     }
 
-    // 校验文件类型（可重定位文件）
-    if (elf_hdr->e_type != ET_REL && elf_hdr->e_type != ET_EXEC) {
+    // 校验文件类型（可重定位文件、可执行文件、位置无关可执行文件）
+    if (elf_hdr->e_type != ET_REL && elf_hdr->e_type != ET_EXEC && elf_hdr->e_type != ET_DYN) {
         return ELF_ERROR_INVALID_TYPE;
     }
 
@@ -90,14 +337,23 @@ static int parse_section_headers(Elf64_Ctx *context) {
         return ELF_ERROR_SECTION_NOT_FOUND;
     }
 
-    // 检查节头表是否超出文件范围
-    size_t section_table_size = (size_t)shnum * shentsize;
-    if (shoff + section_table_size > context->elf_size) {
-        return ELF_ERROR_SECTION_NOT_FOUND;
+    // 节头表和各节加载地址按节数一起分配，随上下文释放
+    context->shdrs = (Elf64_Shdr *)elf_alloc_uncharged((size_t)shnum *
+                                                       (sizeof(Elf64_Shdr) + sizeof(Elf64_Addr)));
+    if (context->shdrs == NULL) {
+#ifdef DEBUG_ELF_LOADER
+        xil_printf("Error: No memory for %d section headers\r\n", (int)shnum);
+#endif
+        return ELF_OOM;
     }
+    context->load_sections = (Elf64_Addr *)&context->shdrs[shnum];
+    memset(context->load_sections, 0, (size_t)shnum * sizeof(Elf64_Addr));
 
-    // 获取节头表指针
-    context->section_headers = (Elf64_Shdr *)(context->elf_data + shoff);
+    // 读取节头表，超出文件范围时失败
+    if (elf_read(context, shoff, context->shdrs, (size_t)shnum * shentsize) != ELF_SUCCESS) {
+        return ELF_ERROR_SECTION_NOT_FOUND;
+    }
+    context->section_headers = context->shdrs;
 
     return ELF_SUCCESS;
 }
@@ -120,7 +376,9 @@ static int get_section_string_table(Elf64_Ctx *context) {
 
     shstrtab_hdr = &context->section_headers[shstrndx];
 #ifdef DEBUG_ELF_LOADER
-    print_section_header(shstrtab_hdr, shstrtab_hdr, context->elf_data);
+    if (context->elf_data != NULL) {
+        print_section_header(shstrtab_hdr, shstrtab_hdr, context->elf_data);
+    }
     // 检查节字符串表是否为字符串表类型
 #endif
     if (shstrtab_hdr->sh_type != SHT_STRTAB) {
@@ -128,12 +386,16 @@ static int get_section_string_table(Elf64_Ctx *context) {
     }
 
     // 检查节字符串表是否超出文件范围
-    if (shstrtab_hdr->sh_offset + shstrtab_hdr->sh_size > context->elf_size) {
+    if (shstrtab_hdr->sh_offset > context->elf_size ||
+        shstrtab_hdr->sh_size > context->elf_size - shstrtab_hdr->sh_offset) {
         return ELF_ERROR_STRTAB_NOT_FOUND;
     }
 
+    // 节字符串表只用于调试输出，流式加载时不读取
     context->shstrtab_hdr = shstrtab_hdr;
-    context->shstrtab = (const char *)(context->elf_data + shstrtab_hdr->sh_offset);
+    context->shstrtab = (context->elf_data != NULL)
+                            ? (const char *)(context->elf_data + shstrtab_hdr->sh_offset)
+                            : NULL;
     return ELF_SUCCESS;
 }
 
@@ -169,102 +431,159 @@ static int find_symbol_tables(Elf64_Ctx *context) {
         return ELF_ERROR_STRTAB_NOT_FOUND;
     }
 
+    context->symtab_base = 0;
+    context->symtab_count = 0;
     return ELF_SUCCESS;
 }
 
 /**
- * 分配内存并加载段
- * @param elf_data ELF 文件数据指针
- * @param elf_size ELF 文件大小
- * @param section_headers 节头表指针
- * @param shnum 节头表条目数
- * @param loaded_sections 输出的已加载段指针数组
+ * 读取符号，符号表按 ELF_READ_CHUNK 个条目一块读入窗口
+ * @param context ELF文件加载上下文
+ * @param index 符号索引
+ * @param sym 输出的符号指针，下次读取符号前有效
  * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
  */
-static int relo_load_sections(Elf64_Ctx *context) {
-    const Elf64_Shdr *section_headers = context->section_headers;
-    Elf64_Addr        memory_offset = 0;
+static int read_symbol(Elf64_Ctx *context, size_t index, const Elf64_Sym **sym) {
+    const Elf64_Shdr *symtab_hdr = context->symtab_hdr;
+    size_t            sym_count = symtab_hdr->sh_size / sizeof(Elf64_Sym);
 
-    for (int i = 0; i < MAX_ELF; i++) {
-        if (elf_memory_addr[i] == (Elf64_Addr)NULL) {
-            context->memory_pool_index = i;
-            break;
+    if (index >= sym_count) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
+    }
+
+    if (index < context->symtab_base || index >= context->symtab_base + context->symtab_count) {
+        size_t count = sym_count - index;
+        if (count > ELF_READ_CHUNK) {
+            count = ELF_READ_CHUNK;
+        }
+
+        context->symtab_count = 0;
+        if (elf_read(context, symtab_hdr->sh_offset + index * sizeof(Elf64_Sym), context->symtab,
+                     count * sizeof(Elf64_Sym)) != ELF_SUCCESS) {
+            return ELF_ERROR_SYMTAB_NOT_FOUND;
         }
+        context->symtab_base = index;
+        context->symtab_count = count;
     }
 
-    for (int i = 0; i < context->elf_hdr->e_shnum; i++) {
-        const Elf64_Shdr *shdr = &section_headers[i];
+    *sym = &context->symtab[index - context->symtab_base];
+    return ELF_SUCCESS;
+}
 
-        // 只加载需要分配的段（SHF_ALLOC）
-        if (!(shdr->sh_flags & SHF_ALLOC)) {
-            continue;
+/**
+ * 读取符号名称
+ * @param context ELF文件加载上下文
+ * @param sym 符号
+ * @param name 输出缓冲区，长度为 ELF_SYMBOL_NAME_MAX
+ * @return 成功返回 ELF_SUCCESS，名称越界或过长返回 ELF_ERROR_STRTAB_NOT_FOUND
+ */
+static int read_symbol_name(Elf64_Ctx *context, const Elf64_Sym *sym, char *name) {
+    const Elf64_Shdr *strtab_hdr = context->strtab_hdr;
+    size_t            size;
+
+    if (sym->st_name >= strtab_hdr->sh_size) {
+        return ELF_ERROR_STRTAB_NOT_FOUND;
+    }
+
+    size = strtab_hdr->sh_size - sym->st_name;
+    if (size > ELF_SYMBOL_NAME_MAX) {
+        size = ELF_SYMBOL_NAME_MAX;
+    }
+    if (elf_read(context, strtab_hdr->sh_offset + sym->st_name, name, size) != ELF_SUCCESS) {
+        return ELF_ERROR_STRTAB_NOT_FOUND;
+    }
+
+    // 名称必须在读取的范围内结束
+    for (size_t i = 0; i < size; i++) {
+        if (name[i] == '\0') {
+            return ELF_SUCCESS;
         }
+    }
+    return ELF_ERROR_STRTAB_NOT_FOUND;
+}
+
+/**
+ * 分配内存并加载段
+ * 各段按 sh_addralign 对齐依次排列在一块按总大小分配的内存中
+ * @param context ELF文件加载上下文
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int relo_load_sections(Elf64_Ctx *context) {
+    const Elf64_Shdr *section_headers = context->section_headers;
+    Elf64_Addr       *load_sections = context->load_sections;
+    Elf64_Xword       memory_offset = 0;
+    Elf64_Xword       max_align = 1;
+    uint8_t          *base;
+
+    // 第一遍：按对齐要求计算各段偏移和总大小，偏移先记在 load_sections 中
+    for (int i = 0; i < context->elf_hdr->e_shnum; i++) {
+        const Elf64_Shdr *shdr = &section_headers[i];
 
-        // 跳过大小为0的段
-        if (shdr->sh_size == 0) {
+        // 只加载需要分配的非空段（SHF_ALLOC）
+        if (!(shdr->sh_flags & SHF_ALLOC) || shdr->sh_size == 0) {
             continue;
         }
 
-        // 检查段大小是否超过内存池限制
-        if (shdr->sh_size > ELF_MEMORY_SIZE) {
+        Elf64_Xword align = elf_align(shdr->sh_addralign);
+        if (align == 0 || align > ELF_MAX_ALIGN) {
 #ifdef DEBUG_ELF_LOADER
-            xil_printf("Section %llu size (%llu) exceeds maximum (%llu)\r\n",
-                (unsigned long long)i, (unsigned long long)shdr->sh_size,
-                (unsigned long long)ELF_MEMORY_SIZE);
+            xil_printf("Section %llu has unsupported alignment %llu\r\n", (unsigned long long)i,
+                (unsigned long long)shdr->sh_addralign);
 #endif
-            return ELF_ERROR_NULL_POINTER;
+            return ELF_ERROR_SECTION_NOT_FOUND;
         }
 
+        memory_offset = (memory_offset + align - 1) & ~(align - 1);
+        if (shdr->sh_size > SIZE_MAX - memory_offset) {
+            return ELF_OOM;
+        }
+        load_sections[i] = memory_offset;
+        memory_offset += shdr->sh_size;
+        if (align > max_align) {
+            max_align = align;
+        }
+    }
+
+    base = alloc_image_memory(context, memory_offset, max_align);
+    if (base == NULL) {
 #ifdef DEBUG_ELF_LOADER
-        print_context(context);
-        xil_printf("%llx\r\n", (unsigned long long)memory_offset);
-#endif
-        // 如果是PROGBITS段，从文件中复制数据
-        if (shdr->sh_type == SHT_PROGBITS) {
-            context->load_sections[i] =
-                (Elf64_Addr)(section_memory + context->memory_pool_index * ELF_MEMORY_SIZE +
-                             memory_offset);
-            if (shdr->sh_offset + shdr->sh_size > context->elf_size) {
-#ifdef DEBUG_ELF_LOADER
-                xil_printf("Section data exceeds file size for section %llu\r\n",
-                    (unsigned long long)i);
+        xil_printf("Failed to allocate %llu bytes for sections\r\n",
+            (unsigned long long)memory_offset);
 #endif
-                return ELF_ERROR_SECTION_NOT_FOUND;
-            }
+        return (memory_offset == 0) ? ELF_ERROR_SECTION_NOT_FOUND : ELF_OOM;
+    }
+    context->load_bias = (Elf64_Addr)base;
+    context->image_size = (size_t)memory_offset;
 
-            // 复制数据
-            uint8_t       *dest = (uint8_t *)context->load_sections[i];
-            const uint8_t *src = context->elf_data + shdr->sh_offset;
-            for (size_t j = 0; j < shdr->sh_size; j++) {
-                dest[j] = src[j];
-            }
-        } else if (shdr->sh_type == SHT_NOBITS) {
-            // BSS段，清零
-            uint8_t *dest = (uint8_t *)context->load_sections[i];
-            for (size_t j = 0; j < shdr->sh_size; j++) {
-                dest[j] = 0;
-            }
+    // 第二遍：读入各段内容，BSS 段清零
+    for (int i = 0; i < context->elf_hdr->e_shnum; i++) {
+        const Elf64_Shdr *shdr = &section_headers[i];
+
+        if (!(shdr->sh_flags & SHF_ALLOC) || shdr->sh_size == 0) {
+            continue;
         }
 
-        memory_offset += shdr->sh_size;
+        load_sections[i] += (Elf64_Addr)base;
+        uint8_t *dest = (uint8_t *)load_sections[i];
 
+        if (shdr->sh_flags & SHF_EXECINSTR) {
+            elf_add_text(context, (Elf64_Addr)dest, shdr->sh_size);
+        }
+
+        if (shdr->sh_type == SHT_NOBITS) {
+            memset(dest, 0, shdr->sh_size);
+        } else if (elf_read(context, shdr->sh_offset, dest, shdr->sh_size) != ELF_SUCCESS) {
+            // 直接读入目标地址
 #ifdef DEBUG_ELF_LOADER
-        // uart_puts("Loaded section ");
-        // uart_puthex(i);
-        // uart_puts(" at address ");
-        // uart_puthex((uint64_t)context->load_sections[i]);
-        // uart_puts(" size ");
-        // uart_puthex(shdr->sh_size);
-        // uart_puts("\r\n");
-        // print_section_header(shdr, context->shstrtab_hdr, context->elf_data);
+            xil_printf("Section data exceeds file size for section %llu\r\n",
+                (unsigned long long)i);
 #endif
+            return ELF_ERROR_SECTION_NOT_FOUND;
+        }
     }
 
-    context->memory_size = memory_offset;
 #ifdef DEBUG_ELF_LOADER
     print_context(context);
-    uart_puthex(memory_offset);
-    uart_putchar('\r\n');
 #endif
 
     return ELF_SUCCESS;
@@ -285,397 +604,1783 @@ static int strcmp_simple(const char *s1, const char *s2) {
 }
 
 /**
- * 解析外部符号
- * @param sym_name 符号名称
- * @return 符号地址，失败返回0
+ * 计算符号名称的 GNU hash
+ * @param name 符号名称
+ * @return 哈希值
+ */
+uint32_t elf_export_hash(const char *name) {
+    uint32_t h = 5381;
+
+    while (*name != '\0') {
+        h = h * 33 + (uint8_t)*name++;
+    }
+    return h;
+}
+
+/**
+ * 在一张符号表中查找符号，只比较同一个桶中哈希相同的符号
+ * @param table 符号表
+ * @param name 符号名称
+ * @param hash elf_export_hash(name)
+ * @return 符号表项，未找到返回 NULL
  */
-static Elf64_Addr resolve_external_symbol(const char *sym_name) {
-    // 比较字符串
-    for (size_t i = 0; i < got.num_entries; i++) {
-        if (strcmp_simple(got.entrys[i].name, sym_name) == 0) {
-            return (Elf64_Addr)(&got.entrys[i].address);
+static const ELF_EXPORT *find_in_table(const ELF_EXPORT_TABLE *table, const char *name,
+                                       uint32_t hash) {
+    uint32_t bucket = hash & (table->bucket_count - 1);
+
+    for (uint16_t i = table->buckets[bucket]; i < table->buckets[bucket + 1]; i++) {
+        const ELF_EXPORT *symbol = &table->symbols[i];
+        if (symbol->hash == hash && strcmp_simple(symbol->name, name) == 0) {
+            return symbol->address != NULL ? symbol : NULL;
         }
     }
-    return 0;
+    return NULL;
 }
 
+/**
+ * 查找符号，先查内核符号表，再按加载顺序从新到旧查共享运行库
+ * 库不能替换内核导出的符号
+ * @param name 符号名称
+ * @return 符号表项，未找到返回 NULL
+ */
+const ELF_EXPORT *elf_find_export(const char *name) {
+    uint32_t          hash = elf_export_hash(name);
+    const ELF_EXPORT *symbol = find_in_table(&elf_export_table, name, hash);
 
-/// S (when used on its own) is the address of the symbol.
-/// A is the addend for the relocation.
-/// P is the address of the place being relocated (derived from r_offset).
-/// X is the result of a relocation operation, before any masking or bit-selection operation is
-/// applied Page(expr) is the page address of the expression expr, defined as (expr & ~0xFFF). (This
-/// applies even if the machine page size supported by the platform has a different value.) GOT is
-/// the address of the Global Offset Table, the table of code and data addresses to be resolved at
-/// dynamic link time. The GOT and each entry in it must be, 64-bit aligned for ELF64 or 32-bit
-/// aligned for ELF32. GDAT(S+A) represents a pointer-sized entry in the GOT for address S+A. The
-/// entry will be relocated at run time with relocation R_<CLS>_GLOB_DAT(S+A). G(expr) is the
-/// address of the GOT entry for the expression expr. Delta(S) if S is a normal symbol, resolves to
-/// the difference between the static link address of S and the execution address of S. If S is the
-/// null symbol (ELF symbol index 0), resolves to the difference between the static link address of
-/// P and the execution address of P. Indirect(expr) represents the result of calling expr as a
-/// function. The result is the return value from the function that is returned in r0. The arguments
-/// passed to the function are defined by the platform ABI. [msb:lsb] is a bit-mask operation
-/// representing the selection of bits in a value. The bits selected range from lsb up to msb
-/// inclusive. For example, ‘bits [3:0]’ represents the bits under the mask 0x0000000F. When range
-/// checking is applied to a value, it is applied before the masking operation is performed.
+    for (const ELF_LIBRARY *library = elf_library_list; symbol == NULL && library != NULL;
+         library = library->next) {
+        symbol = find_in_table(&library->exports, name, hash);
+    }
+    return symbol;
+}
 
 /**
- * 应用单个重定位
- * @param context Elf文件加载上下文
- * @param target_section 目标段指针
- * @param rela_index 重定位条目索引
- * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ * 是否为通过 GOT 表项取符号地址的重定位
  */
-static int apply_relocation(Elf64_Ctx *context, Elf64_Addr target_section, int rela_index) {
-    const Elf64_Rela *rela = &context->rela[rela_index];
-    const Elf64_Shdr *symtab_hdr = context->symtab_hdr;
-    const Elf64_Sym  *symtab = context->symtab;
-    Elf64_Half        shnum = context->elf_hdr->e_shnum;
-    Elf64_Addr        reloc_addr = target_section + rela->r_offset;
-    Elf64_Xword       sym_idx = ELF64_R_SYM(rela->r_info);
-    Elf64_Xword       reloc_type = ELF64_R_TYPE(rela->r_info);
+static int is_got_relocation(Elf64_Xword reloc_type) {
+    return reloc_type == R_AARCH64_GOT_LD_PREL19 || reloc_type == R_AARCH64_LD64_GOTOFF_LO15 ||
+           reloc_type == R_AARCH64_ADR_GOT_PAGE || reloc_type == R_AARCH64_LD64_GOT_LO12_NC ||
+           reloc_type == R_AARCH64_LD64_GOTPAGE_LO15;
+}
 
-    if (sym_idx >= (symtab_hdr->sh_size / sizeof(Elf64_Sym))) {
-#ifdef DEBUG_ELF_LOADER
-        xil_printf("Invalid symbol index in relocation\r\n");
-#endif
-        return ELF_ERROR_RELOCATION_FAILED;
-    }
+/**
+ * 是否为按相对 GOT 基址的偏移取表项的重定位
+ * 这类重定位的表项必须在程序自己的 GOT 中，外部符号也不能使用内核符号表的表项
+ */
+static int is_got_offset_relocation(Elf64_Xword reloc_type) {
+    return reloc_type == R_AARCH64_LD64_GOTOFF_LO15 || reloc_type == R_AARCH64_LD64_GOTPAGE_LO15;
+}
 
-    const Elf64_Sym *sym = &symtab[sym_idx];
-#ifdef DEBUG_ELF_LOADER
-    print_symbol(*sym, context->strtab_hdr, context->elf_data);
-#endif
-    Elf64_Addr sym_value = 0;
+/**
+ * 解析外部符号
+ * GOT 类重定位返回内核符号表中保存符号地址的表项地址，其他重定位和 GOT 偏移类重定位返回符号地址
+ * @param sym_name 符号名称
+ * @param reloc_type 重定位类型
+ * @return 符号值，未找到返回 0
+ */
+static Elf64_Addr resolve_external_symbol(const char *sym_name, Elf64_Xword reloc_type) {
+    const ELF_EXPORT *symbol = elf_find_export(sym_name);
 
-    // 计算符号值
-    if (sym->st_shndx == SHN_UNDEF) {
-        // 外部符号，需要查找系统调用
-        if (sym->st_name < symtab_hdr->sh_size) {
-            const char *sym_name = context->strtab + sym->st_name;
-            sym_value = resolve_external_symbol(sym_name);
-            if (sym_value == 0) {
-#ifdef DEBUG_ELF_LOADER
-                xil_printf("Failed to resolve symbol: %s\r\n", sym_name);
-#endif
-                return ELF_ERROR_RELOCATION_FAILED;
-            }
-        }
-    } else if (sym->st_shndx < shnum && context->load_sections[sym->st_shndx] != 0) {
-        // 内部符号
-        sym_value = (Elf64_Addr)context->load_sections[sym->st_shndx] + sym->st_value;
-    } else {
-#ifdef DEBUG_ELF_LOADER
-        xil_printf("Invalid symbol section index\r\n");
-#endif
-        return ELF_ERROR_RELOCATION_FAILED;
+    if (symbol == NULL) {
+        return 0;
     }
-    // 应用重定位
-    switch (reloc_type) {
-        case R_AARCH64_CALL26: {
-            // S + A - P
-            // Set a CALL immediate field to bits [27:2] of X; check that -2^27 <= X < 2^27
-            Elf64_Addr S = sym_value;
-            Elf64_Addr A = (Elf64_Addr)rela->r_addend;
-            Elf64_Addr P = (Elf64_Addr)reloc_addr;
-            Elf64_Addr X = S + A - P;
-            // 检查范围
-            if ((int64_t)X < -(1 << 27) || (int64_t)X >= (1 << 27)) {
-                return ELF_ERROR_RELOCATION_FAILED;
-            } else {
-                // 修改指令
-                uint32_t *instr = (uint32_t *)reloc_addr;
-                uint32_t  imm26 = (uint32_t)((X >> 2) & 0x03FFFFFF);
-                *instr = (*instr & 0xFC000000) | imm26;
-            }
-        } break;
-        case R_AARCH64_ADR_PREL_LO21: {
-            // S + A - P
-            // Set an ADR immediate value to bits [20:0] of X; check that -2^20 <= X < 2^20
-            Elf64_Addr S = sym_value;
-            Elf64_Addr A = (Elf64_Addr)rela->r_addend;
-            Elf64_Addr P = (Elf64_Addr)reloc_addr;
-            Elf64_Addr X = S + A - P;
-            // 检查范围
-            if ((int64_t)X < -(1 << 20) || (int64_t)X >= (1 << 20)) {
-                return ELF_ERROR_RELOCATION_FAILED;
-            } else {
-                // 修改指令
-                uint32_t *instr = (uint32_t *)reloc_addr;
-                uint32_t  imm = (uint32_t)(X & 0x1FFFFF);
-                uint32_t  immlo = imm & 0x3;
-                uint32_t  immhi = (imm >> 2) & 0x7FFFF;
-                *instr = (*instr & 0x9F00001F) | (immlo << 29) | (immhi << 5);
-            }
-        } break;
-        case R_AARCH64_GOT_LD_PREL19: {
-            // print_symbol(*sym, strtab_hdr, elf_data);
-            // print_relocation_info(rela);
-            // G(GDAT(S))- P
-            // Set a load-literal immediate field[23:5] to bits [20:2] of X; check –2^20 <= X < 2^20
-            Elf64_Addr G_GDAT_S = sym_value;
-            Elf64_Addr P = (Elf64_Addr)reloc_addr;
-            Elf64_Addr X = G_GDAT_S - P;
-            // 检查范围
-            if ((int64_t)X < -(1 << 20) || (int64_t)X >= (1 << 20)) {
-                return ELF_ERROR_RELOCATION_FAILED;
-            } else {
-                // 修改指令
-                uint32_t *instr = (uint32_t *)reloc_addr;
-                uint32_t  imm = (uint32_t)(X & 0x1FFFFF);
-                uint32_t  imm19 = (imm >> 2) & 0x7FFFF;
-                *instr = (*instr & 0xFF00001F) | (imm19 << 5);
-            }
-        } break;
-        default:
-#ifdef DEBUG_ELF_LOADER
-            xil_printf("Unsupported relocation type: %llx\r\n", (unsigned long long)reloc_type);
-#endif
-            return ELF_ERROR_RELOCATION_FAILED;
+    if (is_got_relocation(reloc_type) && !is_got_offset_relocation(reloc_type)) {
+        return (Elf64_Addr)&symbol->address;
     }
-
-    return ELF_SUCCESS;
+    return (Elf64_Addr)symbol->address;
 }
 
 /**
- * 处理重定位
+ * 获取程序的 GOT，第一次需要时分配，每个符号一项
  * @param context ELF文件加载上下文
- * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ * @return GOT 基址，内存不足返回 0
  */
-static int process_relocations(Elf64_Ctx *context) {
-    const Elf64_Shdr *section_headers = context->section_headers;
-    Elf64_Half        shnum = context->elf_hdr->e_shnum;
-    for (int i = 0; i < shnum; i++) {
-        const Elf64_Shdr *shdr = &section_headers[i];
-
-        // 处理重定位段
-        if (shdr->sh_type == SHT_RELA) {
-#ifdef DEBUG_ELF_LOADER
-            print_section_header(shdr, context->shstrtab_hdr, context->elf_data);
-#endif
-            // sh_info字段指向要重定位的目标段
-            if (shdr->sh_info >= shnum || context->load_sections[shdr->sh_info] == 0) {
-#ifdef DEBUG_ELF_LOADER
-                xil_printf("Invalid target section for relocation\r\n");
-#endif
-                continue;
-            }
-
-            context->rela = (const Elf64_Rela *)(context->elf_data + shdr->sh_offset);
-            size_t rela_count = shdr->sh_size / shdr->sh_entsize;
-
-            for (size_t j = 0; j < rela_count; j++) {
-                int result = apply_relocation(context, context->load_sections[shdr->sh_info], j);
-                if (result != ELF_SUCCESS) {
-                    return result;
-                }
-            }
+static Elf64_Addr get_got_base(Elf64_Ctx *context) {
+    if (context->got == NULL) {
+        size_t count = context->symtab_hdr->sh_size / sizeof(Elf64_Sym);
+        context->got = (Elf64_Addr *)elf_alloc_uncharged(count * sizeof(Elf64_Addr));
+        if (context->got == NULL) {
+            return 0;
         }
+        memset(context->got, 0, count * sizeof(Elf64_Addr));
+        context->got_count = count;
     }
-
-    return ELF_SUCCESS;
+    return (Elf64_Addr)context->got;
 }
 
 /**
- * 查找并执行main函数
+ * 获取符号在程序 GOT 中的表项
  * @param context ELF文件加载上下文
- * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ * @param sym_idx 符号索引
+ * @param value 表项的值 S + A
+ * @return 表项地址，内存不足或同一符号的表项值不同时返回 0
  */
-static int find_and_execute_main(Elf64_Ctx *context) {
-    if (context->elf_hdr->e_type == ET_REL) {
-        const Elf64_Sym  *symtab = context->symtab;
-        const char       *strtab = context->strtab;
-        const Elf64_Shdr *symtab_hdr = context->symtab_hdr;
-        const Elf64_Addr *loaded_sections = context->load_sections;
-
-        size_t sym_count = symtab_hdr->sh_size / sizeof(Elf64_Sym);
-        for (size_t i = 0; i < sym_count; i++) {
-            const Elf64_Sym *sym = &symtab[i];
-
-            // 查找main函数
-            if (ELF64_ST_TYPE(sym->st_info) == STT_FUNC && sym->st_shndx != SHN_UNDEF &&
-                sym->st_name < symtab_hdr->sh_size) {
-
-                const char *sym_name = strtab + sym->st_name;
-                if (strcmp_simple(sym_name, "main") == 0) {
-                    // 找到main函数
-                    if (loaded_sections[sym->st_shndx] != 0) {
-                        void *main_addr =
-                            (void *)((uint8_t *)loaded_sections[sym->st_shndx] + sym->st_value);
-                        // 执行main函数
-                        int (*main_func)(void) = (int (*)(void))main_addr;
-                        context->result = main_func();
-                        return ELF_SUCCESS;
-                    }
+static Elf64_Addr get_got_entry(Elf64_Ctx *context, Elf64_Xword sym_idx, Elf64_Addr value) {
+    if (get_got_base(context) == 0 || sym_idx >= context->got_count) {
+        return 0;
+    }
+    if (context->got[sym_idx] == 0) {
+        context->got[sym_idx] = value;
+    } else if (context->got[sym_idx] != value) {
+        // 同一符号带不同加数的 GOT 引用，编译器不会生成
+        return 0;
+    }
+    return (Elf64_Addr)&context->got[sym_idx];
+}
+
+/**
+ * 是否为 B/BL 分支重定位
+ */
+static int is_call_relocation(Elf64_Xword reloc_type) {
+    return reloc_type == R_AARCH64_CALL26 || reloc_type == R_AARCH64_JUMP26;
+}
+
+#if (ELF_LAZY_BINDING == 1)
+/**
+ * 获取延迟绑定使用的符号名称
+ * 名称直接指向内存中 ELF 文件的字符串表，文件在程序运行期间一直有效；流式加载没有这样的
+ * 名称，不能延迟绑定
+ * @param context ELF文件加载上下文
+ * @param sym 符号
+ * @return 符号名称，不能延迟绑定时返回 NULL
+ */
+static const char *lazy_symbol_name(const Elf64_Ctx *context, const Elf64_Sym *sym) {
+    const Elf64_Shdr *strtab_hdr = context->strtab_hdr;
+    const char       *name;
+    size_t            size;
+
+    // 名称找不到时要在调用处结束任务，只有容器程序会被清理
+    if (context->elf_data == NULL || context->owner == NULL ||
+        strtab_hdr->sh_offset > context->elf_size ||
+        strtab_hdr->sh_size > context->elf_size - strtab_hdr->sh_offset ||
+        sym->st_name >= strtab_hdr->sh_size) {
+        return NULL;
+    }
+
+    name = (const char *)context->elf_data + strtab_hdr->sh_offset + sym->st_name;
+    size = strtab_hdr->sh_size - sym->st_name;
+    if (size > ELF_SYMBOL_NAME_MAX) {
+        size = ELF_SYMBOL_NAME_MAX;
+    }
+    return (memchr(name, '\0', size) != NULL) ? name : NULL;
+}
+#endif
+
+/**
+ * 获取 PLT 跳板，同一符号的同一目标共用一个跳板
+ * 跳板按块分配在堆上，程序运行期间不移动
+ * @param context ELF文件加载上下文
+ * @param sym_idx 符号索引
+ * @param name 延迟绑定的符号名称，直接跳转时为 NULL
+ * @param target 直接跳转的目标，延迟绑定时忽略
+ * @return 跳板地址，内存不足返回 0
+ */
+static Elf64_Addr get_plt_entry(Elf64_Ctx *context, Elf64_Xword sym_idx, const char *name,
+                                Elf64_Addr target) {
+    ELF_PLT_BLOCK *block = context->plt_blocks;
+    ELF_PLT_ENTRY *entry;
+
+    if (context->plt == NULL) {
+        size_t count = context->symtab_hdr->sh_size / sizeof(Elf64_Sym);
+        context->plt = (ELF_PLT_ENTRY **)elf_alloc_uncharged(count * sizeof(ELF_PLT_ENTRY *));
+        if (context->plt == NULL) {
+            return 0;
+        }
+        memset(context->plt, 0, count * sizeof(ELF_PLT_ENTRY *));
+        context->plt_count = count;
+    }
+    if (sym_idx >= context->plt_count) {
+        return 0;
+    }
+
+    entry = context->plt[sym_idx];
+    if (entry != NULL && entry->name == name && (name != NULL || entry->target == target)) {
+        return (Elf64_Addr)entry;
+    }
+
+    if (block == NULL || block->count == ELF_PLT_CHUNK) {
+        block = (ELF_PLT_BLOCK *)elf_alloc_uncharged(sizeof(ELF_PLT_BLOCK));
+        if (block == NULL) {
+            return 0;
+        }
+        block->count = 0;
+        block->next = context->plt_blocks;
+        context->plt_blocks = block;
+    }
+
+    entry = &block->entries[block->count++];
+    entry->code[0] = 0x10000091; // adr x17, target
+    entry->code[1] = 0xF9400230; // ldr x16, [x17]
+    entry->code[2] = 0xD61F0200; // br  x16
+    entry->code[3] = 0xD503201F; // nop
+    entry->target = (name != NULL) ? (Elf64_Addr)elf_plt_lazy_entry : target;
+    entry->name = name;
+
+    // 带加数的直接跳转可能对应不同目标，只登记第一个
+    if (context->plt[sym_idx] == NULL) {
+        context->plt[sym_idx] = entry;
+    }
+    return (Elf64_Addr)entry;
+}
+
+/**
+ * 延迟绑定：第一次经跳板调用时由 elf_plt_lazy_entry 调用，查找符号并改写跳板目标
+ * 符号不存在时程序无法继续，结束当前任务，程序内存由任务删除后的清理释放
+ * @param target 跳板的 target 字段
+ * @return 符号地址
+ */
+Elf64_Addr elf_plt_bind(Elf64_Addr *target) {
+    const ELF_PLT_ENTRY *entry =
+        (const ELF_PLT_ENTRY *)((uint8_t *)target - offsetof(ELF_PLT_ENTRY, target));
+    const ELF_EXPORT    *symbol = elf_find_export(entry->name);
+
+    if (symbol == NULL) {
+#ifdef DEBUG_ELF_LOADER
+        xil_printf("Failed to resolve symbol: %s\r\n", entry->name);
+#endif
+        print_error(ELF_ERROR_RELOCATION_FAILED);
+        vTaskDelete(NULL);
+        return 0;
+    }
+
+    // 8 字节对齐的单次写入，同一程序的多个任务同时绑定时写入的值相同
+    *target = (Elf64_Addr)symbol->address;
+    return *target;
+}
+
+/**
+ * 检查有符号值是否在 [-2^(bits-1), 2^(bits-1)) 范围内
+ */
+static int reloc_fits_signed(int64_t value, int bits) {
+    return value >= -((int64_t)1 << (bits - 1)) && value < ((int64_t)1 << (bits - 1));
+}
+
+/**
+ * 检查数据重定位的值，按有符号或无符号解释均可：[-2^(bits-1), 2^bits)
+ */
+static int reloc_fits_data(int64_t value, int bits) {
+    return value >= -((int64_t)1 << (bits - 1)) && value < ((int64_t)1 << bits);
+}
+
+/**
+ * 重定位修改的字节数
+ */
+static Elf64_Xword reloc_width(Elf64_Xword reloc_type) {
+    switch (reloc_type) {
+        case R_AARCH64_ABS64:
+        case R_AARCH64_PREL64:
+            return 8;
+        case R_AARCH64_ABS16:
+        case R_AARCH64_PREL16:
+            return 2;
+        default:
+            // 数据 ABS32/PREL32 和所有指令重定位
+            return 4;
+    }
+}
+
+/**
+ * 修改指令中 mask 对应的位
+ */
+static void patch_insn(Elf64_Addr addr, uint32_t mask, uint32_t value) {
+    uint32_t *insn = (uint32_t *)addr;
+    *insn = (*insn & ~mask) | (value & mask);
+}
+
+/**
+ * 修改 MOVZ/MOVN/MOVK 的 imm16 字段
+ * signed_form 为真时按值的符号把指令改为 MOVZ（非负）或 MOVN（负，写入取反后的值）
+ */
+static void patch_movw(Elf64_Addr addr, int64_t value, int shift, int signed_form) {
+    uint64_t imm = (uint64_t)value;
+    uint32_t opc = 0;
+
+    if (signed_form) {
+        if (value < 0) {
+            imm = ~imm;
+        } else {
+            opc = 0x40000000; // MOVZ
+        }
+        patch_insn(addr, 0x40000000 | 0x001FFFE0, opc | (uint32_t)(((imm >> shift) & 0xFFFF) << 5));
+    } else {
+        patch_insn(addr, 0x001FFFE0, (uint32_t)(((imm >> shift) & 0xFFFF) << 5));
+    }
+}
+
+/**
+ * 修改 ADR/ADRP 的 21 位立即数（immlo 在 [30:29]，immhi 在 [23:5]）
+ */
+static void patch_adr(Elf64_Addr addr, int64_t imm) {
+    uint32_t value = (uint32_t)imm & 0x1FFFFF;
+    patch_insn(addr, 0x60FFFFE0, ((value & 0x3) << 29) | ((value >> 2) << 5));
+}
+
+/**
+ * 按重定位类型计算并写入重定位结果
+ * 按 AArch64 ELF ABI 检查溢出和对齐，超出范围时返回错误而不是截断
+ * @param reloc_type 重定位类型
+ * @param P 修改位置
+ * @param S 符号值
+ * @param A 加数
+ * @param G GOT 类重定位的 GOT 表项地址
+ * @param GOT 程序 GOT 的基址，只有 GOT 偏移类重定位使用
+ * @return 成功返回 ELF_SUCCESS，失败返回 ELF_ERROR_RELOCATION_FAILED
+ */
+static int write_relocation(Elf64_Xword reloc_type, Elf64_Addr P, Elf64_Addr S, Elf64_Addr A,
+                            Elf64_Addr G, Elf64_Addr GOT) {
+    int64_t X;
+
+    if (reloc_width(reloc_type) == 4 && reloc_type != R_AARCH64_ABS32 &&
+        reloc_type != R_AARCH64_PREL32 && (P & 0x3) != 0) {
+        return ELF_ERROR_RELOCATION_FAILED;
+    }
+
+    // 应用重定位
+    switch (reloc_type) {
+        // 数据
+        case R_AARCH64_ABS64: {
+            uint64_t value = S + A;
+            memcpy((void *)P, &value, sizeof(value));
+        } break;
+        case R_AARCH64_ABS32:
+        case R_AARCH64_PREL32: {
+            X = (int64_t)(reloc_type == R_AARCH64_ABS32 ? S + A : S + A - P);
+            if (!reloc_fits_data(X, 32)) {
+                goto overflow;
+            }
+            uint32_t value = (uint32_t)X;
+            memcpy((void *)P, &value, sizeof(value));
+        } break;
+        case R_AARCH64_ABS16:
+        case R_AARCH64_PREL16: {
+            X = (int64_t)(reloc_type == R_AARCH64_ABS16 ? S + A : S + A - P);
+            if (!reloc_fits_data(X, 16)) {
+                goto overflow;
+            }
+            uint16_t value = (uint16_t)X;
+            memcpy((void *)P, &value, sizeof(value));
+        } break;
+        case R_AARCH64_PREL64: {
+            uint64_t value = S + A - P;
+            memcpy((void *)P, &value, sizeof(value));
+        } break;
+
+        // MOVW 绝对地址（large 代码模型）
+        case R_AARCH64_MOVW_UABS_G0:
+        case R_AARCH64_MOVW_UABS_G0_NC:
+        case R_AARCH64_MOVW_UABS_G1:
+        case R_AARCH64_MOVW_UABS_G1_NC:
+        case R_AARCH64_MOVW_UABS_G2:
+        case R_AARCH64_MOVW_UABS_G2_NC:
+        case R_AARCH64_MOVW_UABS_G3: {
+            int shift = (int)((reloc_type - R_AARCH64_MOVW_UABS_G0) / 2) * 16;
+            uint64_t value = S + A;
+            // 不带 _NC 的 G0/G1/G2 检查值的高位为 0
+            if ((reloc_type == R_AARCH64_MOVW_UABS_G0 || reloc_type == R_AARCH64_MOVW_UABS_G1 ||
+                 reloc_type == R_AARCH64_MOVW_UABS_G2) &&
+                (value >> (shift + 16)) != 0) {
+                goto overflow;
+            }
+            patch_movw(P, (int64_t)value, shift, 0);
+        } break;
+        case R_AARCH64_MOVW_SABS_G0:
+        case R_AARCH64_MOVW_SABS_G1:
+        case R_AARCH64_MOVW_SABS_G2: {
+            int shift = (int)(reloc_type - R_AARCH64_MOVW_SABS_G0) * 16;
+            X = (int64_t)(S + A);
+            if (!reloc_fits_signed(X, shift + 17)) {
+                goto overflow;
+            }
+            patch_movw(P, X, shift, 1);
+        } break;
+
+        // MOVW 相对地址
+        case R_AARCH64_MOVW_PREL_G0:
+        case R_AARCH64_MOVW_PREL_G1:
+        case R_AARCH64_MOVW_PREL_G2: {
+            int shift = (int)((reloc_type - R_AARCH64_MOVW_PREL_G0) / 2) * 16;
+            X = (int64_t)(S + A - P);
+            if (!reloc_fits_signed(X, shift + 17)) {
+                goto overflow;
+            }
+            patch_movw(P, X, shift, 1);
+        } break;
+        case R_AARCH64_MOVW_PREL_G0_NC:
+        case R_AARCH64_MOVW_PREL_G1_NC:
+        case R_AARCH64_MOVW_PREL_G2_NC: {
+            int shift = (int)((reloc_type - R_AARCH64_MOVW_PREL_G0_NC) / 2) * 16;
+            patch_movw(P, (int64_t)(S + A - P), shift, 0);
+        } break;
+        case R_AARCH64_MOVW_PREL_G3:
+            patch_movw(P, (int64_t)(S + A - P), 48, 1);
+            break;
+
+        // PC 相对寻址（tiny、small 代码模型）
+        case R_AARCH64_LD_PREL_LO19:
+        case R_AARCH64_CONDBR19:
+        case R_AARCH64_GOT_LD_PREL19: {
+            // 立即数字段 [23:5] 为 X 的 [20:2]，检查 -2^20 <= X < 2^20
+            X = (int64_t)((reloc_type == R_AARCH64_GOT_LD_PREL19 ? G : S + A) - P);
+            if (!reloc_fits_signed(X, 21) || (X & 0x3) != 0) {
+                goto overflow;
+            }
+            patch_insn(P, 0x00FFFFE0, (uint32_t)((X >> 2) & 0x7FFFF) << 5);
+        } break;
+        case R_AARCH64_ADR_PREL_LO21: {
+            X = (int64_t)(S + A - P);
+            if (!reloc_fits_signed(X, 21)) {
+                goto overflow;
+            }
+            patch_adr(P, X);
+        } break;
+        case R_AARCH64_ADR_PREL_PG_HI21:
+        case R_AARCH64_ADR_PREL_PG_HI21_NC:
+        case R_AARCH64_ADR_GOT_PAGE: {
+            // ADRP：Page(S + A) - Page(P)，检查 -2^32 <= X < 2^32
+            Elf64_Addr target = (reloc_type == R_AARCH64_ADR_GOT_PAGE) ? G : S + A;
+            X = (int64_t)((target & ~(Elf64_Addr)0xFFF) - (P & ~(Elf64_Addr)0xFFF));
+            if (reloc_type != R_AARCH64_ADR_PREL_PG_HI21_NC && !reloc_fits_signed(X, 33)) {
+                goto overflow;
+            }
+            patch_adr(P, X >> 12);
+        } break;
+        case R_AARCH64_ADD_ABS_LO12_NC:
+            patch_insn(P, 0x003FFC00, (uint32_t)((S + A) & 0xFFF) << 10);
+            break;
+        case R_AARCH64_LDST8_ABS_LO12_NC:
+        case R_AARCH64_LDST16_ABS_LO12_NC:
+        case R_AARCH64_LDST32_ABS_LO12_NC:
+        case R_AARCH64_LDST64_ABS_LO12_NC:
+        case R_AARCH64_LDST128_ABS_LO12_NC:
+        case R_AARCH64_LD64_GOT_LO12_NC: {
+            // 立即数按访问大小缩放，地址必须按访问大小对齐
+            int        scale = 0;
+            Elf64_Addr target = (reloc_type == R_AARCH64_LD64_GOT_LO12_NC) ? G : S + A;
+            if (reloc_type == R_AARCH64_LDST16_ABS_LO12_NC) {
+                scale = 1;
+            } else if (reloc_type == R_AARCH64_LDST32_ABS_LO12_NC) {
+                scale = 2;
+            } else if (reloc_type == R_AARCH64_LDST64_ABS_LO12_NC ||
+                       reloc_type == R_AARCH64_LD64_GOT_LO12_NC) {
+                scale = 3;
+            } else if (reloc_type == R_AARCH64_LDST128_ABS_LO12_NC) {
+                scale = 4;
+            }
+            if ((target & (((Elf64_Addr)1 << scale) - 1)) != 0) {
+                goto overflow;
+            }
+            patch_insn(P, 0x003FFC00, (uint32_t)((target & 0xFFF) >> scale) << 10);
+        } break;
+        case R_AARCH64_LD64_GOTOFF_LO15:
+        case R_AARCH64_LD64_GOTPAGE_LO15: {
+            // LDR 的立即数为表项相对 GOT（或 GOT 所在页）的偏移除以 8，检查 0 <= X < 2^15
+            Elf64_Addr base = (reloc_type == R_AARCH64_LD64_GOTPAGE_LO15)
+                                  ? (GOT & ~(Elf64_Addr)0xFFF)
+                                  : GOT;
+            X = (int64_t)(G - base);
+            if (GOT == 0 || X < 0 || X >= ((int64_t)1 << 15) || (X & 0x7) != 0) {
+                goto overflow;
+            }
+            patch_insn(P, 0x003FFC00, (uint32_t)(X >> 3) << 10);
+        } break;
+
+        // 分支
+        case R_AARCH64_TSTBR14: {
+            X = (int64_t)(S + A - P);
+            if (!reloc_fits_signed(X, 16) || (X & 0x3) != 0) {
+                goto overflow;
+            }
+            patch_insn(P, 0x0007FFE0, (uint32_t)((X >> 2) & 0x3FFF) << 5);
+        } break;
+        case R_AARCH64_JUMP26:
+        case R_AARCH64_CALL26: {
+            // 立即数为 X 的 [27:2]，检查 -2^27 <= X < 2^27
+            X = (int64_t)(S + A - P);
+            if (!reloc_fits_signed(X, 28) || (X & 0x3) != 0) {
+                goto overflow;
+            }
+            patch_insn(P, 0x03FFFFFF, (uint32_t)(X >> 2) & 0x03FFFFFF);
+        } break;
+        default:
+#ifdef DEBUG_ELF_LOADER
+            xil_printf("Unsupported relocation type: %llx\r\n", (unsigned long long)reloc_type);
+#endif
+            return ELF_ERROR_RELOCATION_FAILED;
+    }
+
+    return ELF_SUCCESS;
+
+overflow:
+#ifdef DEBUG_ELF_LOADER
+    xil_printf("Relocation %llu at %llx out of range\r\n", (unsigned long long)reloc_type,
+               (unsigned long long)P);
+#endif
+    return ELF_ERROR_RELOCATION_FAILED;
+}
+
+/**
+ * 放弃生成预处理镜像，本次加载照常进行
+ * @param context ELF文件加载上下文
+ */
+static void cancel_prepare(Elf64_Ctx *context) {
+    context->prepare = 0;
+    if (context->fixups != NULL) {
+        vPortFree(context->fixups);
+        context->fixups = NULL;
+    }
+    context->fixup_count = 0;
+    context->fixup_capacity = 0;
+}
+
+/**
+ * 程序基址移动整数个对齐单位后，重定位结果是否改变
+ * 程序内符号的 PC 相对重定位和外部符号的绝对地址重定位不变；基址按页对齐时页内偏移类也不变，
+ * 否则程序内符号的页内偏移和页地址重定位要重新计算
+ * @param reloc_type 重定位类型
+ * @param internal 符号是否在程序内
+ * @param page_aligned 基址是否按 ELF_MAX_ALIGN 对齐
+ * @return 需要按新基址重新计算返回 1，否则返回 0
+ */
+static int reloc_depends_on_base(Elf64_Xword reloc_type, int internal, int page_aligned) {
+    int pc_relative = 1;
+
+    switch (reloc_type) {
+        case R_AARCH64_ADD_ABS_LO12_NC:
+        case R_AARCH64_LDST8_ABS_LO12_NC:
+        case R_AARCH64_LDST16_ABS_LO12_NC:
+        case R_AARCH64_LDST32_ABS_LO12_NC:
+        case R_AARCH64_LDST64_ABS_LO12_NC:
+        case R_AARCH64_LDST128_ABS_LO12_NC:
+        case R_AARCH64_LD64_GOT_LO12_NC:
+            return internal && !page_aligned;
+        case R_AARCH64_ADR_PREL_PG_HI21:
+        case R_AARCH64_ADR_PREL_PG_HI21_NC:
+        case R_AARCH64_ADR_GOT_PAGE:
+            if (internal && !page_aligned) {
+                return 1;
+            }
+            break;
+        case R_AARCH64_ABS64:
+        case R_AARCH64_ABS32:
+        case R_AARCH64_ABS16:
+        case R_AARCH64_MOVW_UABS_G0:
+        case R_AARCH64_MOVW_UABS_G0_NC:
+        case R_AARCH64_MOVW_UABS_G1:
+        case R_AARCH64_MOVW_UABS_G1_NC:
+        case R_AARCH64_MOVW_UABS_G2:
+        case R_AARCH64_MOVW_UABS_G2_NC:
+        case R_AARCH64_MOVW_UABS_G3:
+        case R_AARCH64_MOVW_SABS_G0:
+        case R_AARCH64_MOVW_SABS_G1:
+        case R_AARCH64_MOVW_SABS_G2:
+            pc_relative = 0;
+            break;
+        default:
+            break;
+    }
+    return internal != pc_relative;
+}
+
+/**
+ * 记录与加载地址有关的重定位，内存不足时放弃生成预处理镜像
+ * @param context ELF文件加载上下文
+ * @param reloc_type 重定位类型
+ * @param P 修改位置
+ * @param value 符号值 S，GOT 类重定位为表项地址 G
+ * @param A 加数
+ * @param internal 符号是否在程序内
+ */
+static void record_fixup(Elf64_Ctx *context, Elf64_Xword reloc_type, Elf64_Addr P,
+                         Elf64_Addr value, Elf64_Addr A, int internal) {
+    ELF_FIXUP *fixup;
+
+    // 程序的 GOT 每次加载单独分配，不在程序内存中，无法随镜像复制
+    if ((internal && is_got_relocation(reloc_type)) || is_got_offset_relocation(reloc_type)) {
+        cancel_prepare(context);
+        return;
+    }
+
+    if (!reloc_depends_on_base(reloc_type, internal, context->image_align >= ELF_MAX_ALIGN)) {
+        return;
+    }
+
+    if (context->fixup_count == context->fixup_capacity) {
+        size_t     capacity = (context->fixup_capacity != 0) ? context->fixup_capacity * 2
+                                                                 : ELF_READ_CHUNK;
+        ELF_FIXUP *fixups = (ELF_FIXUP *)elf_alloc_uncharged(capacity * sizeof(ELF_FIXUP));
+
+        if (fixups == NULL) {
+            cancel_prepare(context);
+            return;
+        }
+        if (context->fixups != NULL) {
+            memcpy(fixups, context->fixups, context->fixup_count * sizeof(ELF_FIXUP));
+            vPortFree(context->fixups);
+        }
+        context->fixups = fixups;
+        context->fixup_capacity = capacity;
+    }
+
+    fixup = &context->fixups[context->fixup_count++];
+    fixup->offset = (uint32_t)(P - context->load_bias);
+    fixup->type = (uint16_t)reloc_type;
+    fixup->internal = (uint16_t)internal;
+    fixup->value = internal ? value - context->load_bias : value;
+    fixup->addend = (Elf64_Sxword)A;
+}
+
+/**
+ * 应用单个重定位
+ * 支持 GCC/Clang 在 tiny、small、large 代码模型下生成的静态重定位
+ * @param context Elf文件加载上下文
+ * @param target_section 目标段指针
+ * @param target_size 目标段大小
+ * @param rela 重定位条目
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int apply_relocation(Elf64_Ctx *context, Elf64_Addr target_section, Elf64_Xword target_size,
+                            const Elf64_Rela *rela) {
+    Elf64_Half       shnum = context->elf_hdr->e_shnum;
+    Elf64_Addr       P = target_section + rela->r_offset;
+    Elf64_Xword      sym_idx = ELF64_R_SYM(rela->r_info);
+    Elf64_Xword      reloc_type = ELF64_R_TYPE(rela->r_info);
+    Elf64_Addr       A = (Elf64_Addr)rela->r_addend;
+    Elf64_Addr       S = 0;
+    Elf64_Addr       G = 0;
+    Elf64_Addr       veneer = 0;
+    const Elf64_Sym *sym = NULL;
+
+    if (reloc_type == R_AARCH64_NONE || reloc_type == R_ARM_NONE) {
+        return ELF_SUCCESS;
+    }
+
+    // 修改位置必须在目标段内，指令必须 4 字节对齐
+    if (rela->r_offset > target_size || reloc_width(reloc_type) > target_size - rela->r_offset) {
+#ifdef DEBUG_ELF_LOADER
+        xil_printf("Relocation offset %llx outside target section\r\n",
+                   (unsigned long long)rela->r_offset);
+#endif
+        return ELF_ERROR_RELOCATION_FAILED;
+    }
+
+    if (read_symbol(context, sym_idx, &sym) != ELF_SUCCESS) {
+#ifdef DEBUG_ELF_LOADER
+        xil_printf("Invalid symbol index in relocation\r\n");
+#endif
+        return ELF_ERROR_RELOCATION_FAILED;
+    }
+
+#ifdef DEBUG_ELF_LOADER
+    if (context->elf_data != NULL) {
+        print_symbol(*sym, context->strtab_hdr, context->elf_data);
+    }
+#endif
+
+#if (ELF_LAZY_BINDING == 1)
+    // 对内核函数的调用指向延迟绑定的跳板，第一次调用时才查找符号
+    if (sym_idx != STN_UNDEF && sym->st_shndx == SHN_UNDEF && is_call_relocation(reloc_type) &&
+        A == 0) {
+        const char *name = lazy_symbol_name(context, sym);
+        if (name != NULL) {
+            veneer = get_plt_entry(context, sym_idx, name, 0);
+            if (veneer == 0) {
+                return ELF_OOM;
+            }
+        }
+    }
+#endif
+
+    // 计算符号值
+    if (veneer != 0) {
+        // 延迟绑定的调用跳转到跳板
+        S = veneer;
+    } else if (sym_idx == STN_UNDEF) {
+        // 0 号符号表示 S = 0，汇编器把对常量、绝对符号的重定位折叠成 0 号符号加加数
+        S = 0;
+    } else if (sym->st_shndx == SHN_UNDEF) {
+        // 外部符号，在内核符号表中查找；GOT 类重定位（偏移类除外）得到的是表项地址
+        char sym_name[ELF_SYMBOL_NAME_MAX];
+        if (read_symbol_name(context, sym, sym_name) != ELF_SUCCESS) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+        if (strcmp(sym_name, "_GLOBAL_OFFSET_TABLE_") == 0) {
+            // GOT 基址，GOT 不在程序内存中，无法随预处理镜像复制
+            S = get_got_base(context);
+            if (S == 0) {
+                return ELF_OOM;
+            }
+            cancel_prepare(context);
+        } else {
+            S = resolve_external_symbol(sym_name, reloc_type);
+        }
+        if (S == 0) {
+#ifdef DEBUG_ELF_LOADER
+            xil_printf("Failed to resolve symbol: %s\r\n", sym_name);
+#endif
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+        if (is_got_relocation(reloc_type) && !is_got_offset_relocation(reloc_type)) {
+            // 内核符号表的表项只能表示符号本身
+            if (A != 0) {
+                return ELF_ERROR_RELOCATION_FAILED;
+            }
+            G = S;
+        }
+    } else if (sym->st_shndx == SHN_ABS) {
+        S = sym->st_value;
+    } else if (sym->st_shndx < shnum && context->load_sections[sym->st_shndx] != 0) {
+        // 内部符号
+        S = (Elf64_Addr)context->load_sections[sym->st_shndx] + sym->st_value;
+    } else {
+#ifdef DEBUG_ELF_LOADER
+        xil_printf("Invalid symbol section index\r\n");
+#endif
+        return ELF_ERROR_RELOCATION_FAILED;
+    }
+
+    if (is_got_relocation(reloc_type) && G == 0) {
+        G = get_got_entry(context, sym_idx, S + A);
+        if (G == 0) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+    }
+
+    // 超出 B/BL ±128MB 范围的目标经跳板绝对跳转
+    if (veneer == 0 && is_call_relocation(reloc_type) &&
+        !reloc_fits_signed((int64_t)(S + A - P), 28)) {
+        veneer = get_plt_entry(context, sym_idx, NULL, S + A);
+        if (veneer == 0) {
+            return ELF_OOM;
+        }
+        S = veneer;
+        A = 0;
+    }
+
+    // 跳板在程序内存之外，不能随预处理镜像复制
+    if (veneer != 0 && context->prepare) {
+        cancel_prepare(context);
+    }
+
+    // 与加载地址有关的重定位记录下来，热启动时只重新计算这些
+    if (context->prepare) {
+        record_fixup(context, reloc_type, P, is_got_relocation(reloc_type) ? G : S, A,
+                     sym->st_shndx != SHN_UNDEF && sym->st_shndx != SHN_ABS);
+    }
+
+    return write_relocation(reloc_type, P, S, A, G, (Elf64_Addr)context->got);
+}
+
+/**
+ * 处理重定位
+ * @param context ELF文件加载上下文
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int process_relocations(Elf64_Ctx *context) {
+    const Elf64_Shdr *section_headers = context->section_headers;
+    Elf64_Half        shnum = context->elf_hdr->e_shnum;
+    for (int i = 0; i < shnum; i++) {
+        const Elf64_Shdr *shdr = &section_headers[i];
+
+        // 处理重定位段
+        if (shdr->sh_type == SHT_RELA) {
+#ifdef DEBUG_ELF_LOADER
+            if (context->elf_data != NULL) {
+                print_section_header(shdr, context->shstrtab_hdr, context->elf_data);
+            }
+#endif
+            // sh_info字段指向要重定位的目标段
+            if (shdr->sh_info >= shnum || context->load_sections[shdr->sh_info] == 0) {
+#ifdef DEBUG_ELF_LOADER
+                xil_printf("Invalid target section for relocation\r\n");
+#endif
+                continue;
+            }
+
+            if (shdr->sh_entsize != sizeof(Elf64_Rela)) {
+                return ELF_ERROR_RELOCATION_FAILED;
+            }
+            size_t rela_count = shdr->sh_size / sizeof(Elf64_Rela);
+
+            // 按 ELF_READ_CHUNK 个条目一块读取重定位表
+            for (size_t j = 0; j < rela_count; j += ELF_READ_CHUNK) {
+                size_t count = rela_count - j;
+                if (count > ELF_READ_CHUNK) {
+                    count = ELF_READ_CHUNK;
                 }
+                if (elf_read(context, shdr->sh_offset + j * sizeof(Elf64_Rela), context->rela,
+                             count * sizeof(Elf64_Rela)) != ELF_SUCCESS) {
+                    return ELF_ERROR_RELOCATION_FAILED;
+                }
+
+                for (size_t k = 0; k < count; k++) {
+                    int result = apply_relocation(context, context->load_sections[shdr->sh_info],
+                                                  section_headers[shdr->sh_info].sh_size,
+                                                  &context->rela[k]);
+                    if (result != ELF_SUCCESS) {
+                        return result;
+                    }
+                }
+            }
+        }
+    }
+
+    return ELF_SUCCESS;
+}
+
+/**
+ * 查找 ET_REL 程序的 main 函数
+ * @param context ELF文件加载上下文
+ * @param entry 输出 main 函数地址
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int find_main(Elf64_Ctx *context, Elf64_Addr *entry) {
+    const Elf64_Shdr *symtab_hdr = context->symtab_hdr;
+    const Elf64_Addr *loaded_sections = context->load_sections;
+    const Elf64_Sym  *sym = NULL;
+    char              sym_name[ELF_SYMBOL_NAME_MAX];
+
+    size_t sym_count = symtab_hdr->sh_size / sizeof(Elf64_Sym);
+    for (size_t i = 0; i < sym_count; i++) {
+        if (read_symbol(context, i, &sym) != ELF_SUCCESS) {
+            return ELF_ERROR_SYMTAB_NOT_FOUND;
+        }
+
+        // 查找main函数
+        if (ELF64_ST_TYPE(sym->st_info) == STT_FUNC && sym->st_shndx != SHN_UNDEF &&
+            sym->st_shndx < context->elf_hdr->e_shnum &&
+            read_symbol_name(context, sym, sym_name) == ELF_SUCCESS) {
+
+            if (strcmp_simple(sym_name, "main") == 0 && loaded_sections[sym->st_shndx] != 0) {
+                *entry = loaded_sections[sym->st_shndx] + sym->st_value;
+                return ELF_SUCCESS;
+            }
+        }
+    }
+#ifdef DEBUG_ELF_LOADER
+    xil_printf("Main function not found\r\n");
+#endif
+    return ELF_ERROR_SYMTAB_NOT_FOUND;
+}
+
+/**
+ * 同步指令缓存：按行把代码范围的 D-cache 清理到统一点，再使对应的 I-cache 行失效
+ * A53 的指令缓存不会看到数据缓存中新写入的指令，跳转到新加载的代码前必须调用
+ * 行大小从 CTR_EL0 读取
+ * @param start 起始地址
+ * @param end 结束地址（不含）
+ */
+static void elf_sync_icache(Elf64_Addr start, Elf64_Addr end) {
+    uint64_t   ctr;
+    Elf64_Addr line;
+    Elf64_Addr addr;
+
+    if (start >= end) {
+        return;
+    }
+    __asm volatile("mrs %0, ctr_el0" : "=r"(ctr));
+
+    // DminLine，CTR_EL0[19:16]，以字为单位的 log2
+    line = (Elf64_Addr)4 << ((ctr >> 16) & 0xF);
+    for (addr = start & ~(line - 1); addr < end; addr += line) {
+        __asm volatile("dc cvau, %0" : : "r"(addr) : "memory");
+    }
+    __asm volatile("dsb ish" : : : "memory");
+
+    // IminLine，CTR_EL0[3:0]
+    line = (Elf64_Addr)4 << (ctr & 0xF);
+    for (addr = start & ~(line - 1); addr < end; addr += line) {
+        __asm volatile("ic ivau, %0" : : "r"(addr) : "memory");
+    }
+    __asm volatile("dsb ish\n\tisb" : : : "memory");
+}
+
+/**
+ * 结束读取并执行程序，返回值保存在 context->result
+ * 执行前同步代码范围的指令缓存，并把本次加载计入加载统计
+ * @param context ELF文件加载上下文
+ * @param entry 入口地址
+ * @return ELF_SUCCESS
+ */
+static int run_entry(Elf64_Ctx *context, Elf64_Addr entry) {
+    int (*entry_func)(void) = (int (*)(void))entry;
+    uint64_t counts;
+
+    // 执行前结束读取，文件不必在程序运行期间保持打开
+    elf_read_done(context);
+    elf_sync_icache(context->text_start, context->text_end);
+    for (const ELF_PLT_BLOCK *block = context->plt_blocks; block != NULL; block = block->next) {
+        elf_sync_icache((Elf64_Addr)block->entries, (Elf64_Addr)&block->entries[block->count]);
+    }
+
+    counts = elf_read_counter() - context->load_start;
+    taskENTER_CRITICAL();
+    elf_load_stats.loads++;
+    elf_load_stats.bytes += context->image_size;
+    elf_load_stats.counts += counts;
+    taskEXIT_CRITICAL();
+#ifdef DEBUG_ELF_LOADER
+    xil_printf("Loaded %lu bytes in %lu counts\r\n", (unsigned long)context->image_size,
+               (unsigned long)counts);
+#endif
+
+    // 紧挨入口记录时间，之后只剩跳转
+    elf_load_stats.last_entry = elf_read_counter();
+    context->result = entry_func();
+    return ELF_SUCCESS;
+}
+
+/**
+ * 查找并执行main函数
+ * @param context ELF文件加载上下文
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int find_and_execute_main(Elf64_Ctx *context) {
+    Elf64_Addr entry;
+
+    if (context->elf_hdr->e_type == ET_REL) {
+        int result = find_main(context, &entry);
+        if (result != ELF_SUCCESS) {
+            return result;
+        }
+    } else if (context->elf_hdr->e_entry != 0) {
+        entry = context->elf_hdr->e_entry + context->load_bias;
+    } else {
+        return ELF_ERROR_STRTAB_NOT_FOUND;
+    }
+
+    return run_entry(context, entry);
+}
+
+/**
+ * 计算 ELF 头部和节头表的 FNV-1a 哈希，作为预处理镜像的布局哈希
+ * @param context ELF文件加载上下文，节头表已解析
+ * @return 哈希值
+ */
+static uint32_t layout_hash(const Elf64_Ctx *context) {
+    const uint8_t *bytes = (const uint8_t *)context->elf_hdr;
+    uint32_t       hash = 2166136261U;
+    size_t         i;
+
+    for (i = 0; i < sizeof(Elf64_Ehdr); i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    bytes = (const uint8_t *)context->section_headers;
+    for (i = 0; i < context->elf_hdr->e_shnum * sizeof(Elf64_Shdr); i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * 重定位完成后、执行前生成预处理镜像并存入 *slot
+ * 多个任务同时冷启动时只保留第一个存入的镜像；内存不足时不生成，不影响本次执行
+ * @param context ELF文件加载上下文
+ * @param entry main 函数地址
+ * @param slot 保存预处理镜像的位置
+ */
+static void save_prepared(Elf64_Ctx *context, Elf64_Addr entry, ELF_PREPARED *slot) {
+    size_t       fixup_bytes = context->fixup_count * sizeof(ELF_FIXUP);
+    size_t       size = sizeof(struct Elf_Prepared) + fixup_bytes + context->image_size;
+    ELF_PREPARED prepared;
+
+    // 分配后先挂在上下文上，任务在存入前被删除时随上下文释放
+    context->prepared = (ELF_PREPARED)elf_alloc_uncharged(size);
+    prepared = context->prepared;
+    if (prepared == NULL) {
+        return;
+    }
+
+    prepared->layout = layout_hash(context);
+    prepared->image_size = context->image_size;
+    prepared->align = context->image_align;
+    prepared->entry = (size_t)(entry - context->load_bias);
+    prepared->alloc_size = size;
+    prepared->text_offset = (size_t)(context->text_start - context->load_bias);
+    prepared->text_size = (size_t)(context->text_end - context->text_start);
+    prepared->fixup_count = context->fixup_count;
+    prepared->fixups = (ELF_FIXUP *)(prepared + 1);
+    prepared->image = (uint8_t *)prepared->fixups + fixup_bytes;
+    memcpy(prepared->fixups, context->fixups, fixup_bytes);
+    memcpy(prepared->image, (const void *)context->load_bias, context->image_size);
+
+    taskENTER_CRITICAL();
+    if (*slot == NULL) {
+        *slot = prepared;
+        context->prepared = NULL;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * 热启动：复制预处理镜像，只重新计算与加载地址有关的重定位，然后执行
+ * @param context ELF文件加载上下文
+ * @param prepared 预处理镜像，布局哈希已核对
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int run_prepared(Elf64_Ctx *context, ELF_PREPARED prepared) {
+    uint8_t   *base = alloc_image_memory(context, prepared->image_size, prepared->align);
+    Elf64_Addr S;
+
+    if (base == NULL) {
+        return ELF_OOM;
+    }
+    memcpy(base, prepared->image, prepared->image_size);
+    context->load_bias = (Elf64_Addr)base;
+    context->image_size = prepared->image_size;
+    context->text_start = (Elf64_Addr)base + prepared->text_offset;
+    context->text_end = context->text_start + prepared->text_size;
+
+    for (size_t i = 0; i < prepared->fixup_count; i++) {
+        const ELF_FIXUP *fixup = &prepared->fixups[i];
+
+        S = fixup->internal ? (Elf64_Addr)base + fixup->value : fixup->value;
+        // 引用程序 GOT 的重定位不会被记录，见 record_fixup
+        if (write_relocation(fixup->type, (Elf64_Addr)base + fixup->offset, S,
+                             (Elf64_Addr)fixup->addend, S, 0) != ELF_SUCCESS) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+    }
+
+    return run_entry(context, (Elf64_Addr)base + prepared->entry);
+}
+
+/**
+ * 解析程序头表并验证其有效性
+ * @param context ELF文件加载上下文
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int parse_program_headers(Elf64_Ctx *context) {
+    const Elf64_Ehdr *elf_hdr = context->elf_hdr;
+
+    // 检查是否有程序头表
+    if (context->elf_hdr->e_phnum == 0) {
+        context->program_headers = NULL;
+        return ELF_SUCCESS;
+    }
+
+    // 计算程序头表的文件偏移和大小
+    Elf64_Off  phoff = elf_hdr->e_phoff;
+    Elf64_Half phentsize = elf_hdr->e_phentsize;
+    Elf64_Half phnum = elf_hdr->e_phnum;
+
+    // 检查程序头表偏移是否有效
+    if (phoff == 0) {
+        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    }
+
+    // 检查程序头表条目大小是否正确
+    if (phentsize != sizeof(Elf64_Phdr)) {
+        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    }
+
+    // 检查程序头数量是否超过限制
+    if (phnum > MAX_ELF) {
+        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    }
+
+    // 读取程序头表，超出文件范围时失败
+    if (elf_read(context, phoff, context->phdrs, (size_t)phnum * phentsize) != ELF_SUCCESS) {
+        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    }
+    context->program_headers = context->phdrs;
+    return ELF_SUCCESS;
+}
+
+/**
+ * 加载可执行elf的section
+ * 按所有 PT_LOAD 段覆盖的地址范围分配内存，各段保持链接时的相对位置
+ * @param context ELF文件加载上下文
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int exec_load_sections(Elf64_Ctx *context) {
+    const Elf64_Phdr *program_headers = context->program_headers;
+    Elf64_Half        phnum = context->elf_hdr->e_phnum;
+    Elf64_Addr        vaddr_min = (Elf64_Addr)-1;
+    Elf64_Addr        vaddr_max = 0;
+    Elf64_Xword       align = 1;
+    uint8_t          *base;
+
+    // 第一遍：计算地址范围和对齐
+    for (int i = 0; i < phnum; i++) {
+        const Elf64_Phdr *phdr = &program_headers[i];
+
+        // 只加载需要分配的非空段（PT_LOAD）
+        if (phdr->p_type != PT_LOAD || phdr->p_memsz == 0) {
+            continue;
+        }
+
+        Elf64_Xword seg_align = elf_align(phdr->p_align);
+        if (phdr->p_filesz > phdr->p_memsz || seg_align == 0 ||
+            phdr->p_vaddr + phdr->p_memsz < phdr->p_vaddr) {
+            return ELF_ERROR_PROGRAM_NOT_FOUND;
+        }
+
+        if (seg_align > align) {
+            align = seg_align;
+        }
+        if (phdr->p_vaddr < vaddr_min) {
+            vaddr_min = phdr->p_vaddr;
+        }
+        if (phdr->p_vaddr + phdr->p_memsz > vaddr_max) {
+            vaddr_max = phdr->p_vaddr + phdr->p_memsz;
+        }
+    }
+
+    if (vaddr_min >= vaddr_max) {
+        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    }
+
+    // 超过一页的对齐只对按页映射有意义，基址按页对齐即可保持页内偏移
+    if (align > ELF_MAX_ALIGN) {
+        align = ELF_MAX_ALIGN;
+    }
+    vaddr_min &= ~(align - 1);
+
+    base = alloc_image_memory(context, vaddr_max - vaddr_min, align);
+    if (base == NULL) {
+        return ELF_OOM;
+    }
+    context->load_bias = (Elf64_Addr)base - vaddr_min;
+    context->image_size = (size_t)(vaddr_max - vaddr_min);
+
+    // 第二遍：将各段直接读入内存，p_memsz 超出 p_filesz 的部分（BSS）清零
+    for (int i = 0; i < phnum; i++) {
+        const Elf64_Phdr *phdr = &program_headers[i];
+
+        if (phdr->p_type != PT_LOAD || phdr->p_memsz == 0) {
+            continue;
+        }
+
+        uint8_t *dest = (uint8_t *)(phdr->p_vaddr + context->load_bias);
+        if (elf_read(context, phdr->p_offset, dest, phdr->p_filesz) != ELF_SUCCESS) {
+            return ELF_ERROR_PROGRAM_NOT_FOUND;
+        }
+        memset(dest + phdr->p_filesz, 0, phdr->p_memsz - phdr->p_filesz);
+        if (phdr->p_flags & PF_X) {
+            elf_add_text(context, (Elf64_Addr)dest, phdr->p_memsz);
+        }
+    }
+
+    return ELF_SUCCESS;
+}
+
+/**
+ * 将 ET_DYN 文件中的虚拟地址转换为加载后的地址
+ * @param context ELF文件加载上下文
+ * @param vaddr 虚拟地址
+ * @param size 访问的字节数
+ * @return 加载后的地址，不在程序内存范围内返回 NULL
+ */
+static void *dyn_addr(Elf64_Ctx *context, Elf64_Addr vaddr, Elf64_Xword size) {
+    Elf64_Addr addr = vaddr + context->load_bias;
+    Elf64_Addr start = (Elf64_Addr)context->image_memory;
+    Elf64_Addr end = start + context->memory_size;
+
+    if (addr < start || addr > end || size > end - addr) {
+        return NULL;
+    }
+    return (void *)addr;
+}
+
+/**
+ * 应用一张动态重定位表（DT_RELA 或 DT_JMPREL）
+ * @param context ELF文件加载上下文
+ * @param rela 重定位表（已加载到程序内存中）
+ * @param count 条目数
+ * @param symtab 动态符号表
+ * @param strtab 动态字符串表
+ * @param strsz 动态字符串表大小
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int apply_dynamic_relocations(Elf64_Ctx *context, const Elf64_Rela *rela, size_t count,
+                                     const Elf64_Sym *symtab, const char *strtab,
+                                     Elf64_Xword strsz) {
+    for (size_t i = 0; i < count; i++) {
+        Elf64_Xword type = ELF64_R_TYPE(rela[i].r_info);
+        Elf64_Xword sym_idx = ELF64_R_SYM(rela[i].r_info);
+        Elf64_Addr  value;
+        uint64_t   *where;
+
+        if (type == R_AARCH64_NONE) {
+            continue;
+        }
+
+        where = (uint64_t *)dyn_addr(context, rela[i].r_offset, sizeof(uint64_t));
+        if (where == NULL) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+
+        if (type == R_AARCH64_RELATIVE) {
+            // B + A
+            *where = context->load_bias + (Elf64_Addr)rela[i].r_addend;
+            continue;
+        }
+
+        if (type != R_AARCH64_GLOB_DAT && type != R_AARCH64_JUMP_SLOT &&
+            type != R_AARCH64_ABS64) {
+#ifdef DEBUG_ELF_LOADER
+            xil_printf("Unsupported dynamic relocation type: %llu\r\n", (unsigned long long)type);
+#endif
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+        if (symtab == NULL || sym_idx == 0) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+
+        // 符号表没有长度信息，符号必须位于程序内存中
+        const Elf64_Sym *sym = &symtab[sym_idx];
+        if (dyn_addr(context, (Elf64_Addr)sym - context->load_bias, sizeof(Elf64_Sym)) == NULL) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+
+        if (sym->st_shndx != SHN_UNDEF) {
+            // 程序自身定义的符号
+            value = sym->st_value + context->load_bias;
+        } else {
+            // 外部符号，在内核符号表中查找，未找到的弱符号为 0
+            const ELF_EXPORT *symbol = NULL;
+            if (strtab != NULL && sym->st_name < strsz &&
+                memchr(strtab + sym->st_name, '\0', strsz - sym->st_name) != NULL) {
+                symbol = elf_find_export(strtab + sym->st_name);
+            }
+            if (symbol != NULL) {
+                value = (Elf64_Addr)symbol->address;
+            } else if (ELF64_ST_BIND(sym->st_info) == STB_WEAK) {
+                value = 0;
+            } else {
+#ifdef DEBUG_ELF_LOADER
+                xil_printf("Failed to resolve dynamic symbol %u\r\n", (unsigned)sym_idx);
+#endif
+                return ELF_ERROR_RELOCATION_FAILED;
             }
         }
+
+        // GLOB_DAT、ABS64 为 S + A，JUMP_SLOT 为 S
+        if (type != R_AARCH64_JUMP_SLOT) {
+            value += (Elf64_Addr)rela[i].r_addend;
+        }
+        *where = value;
+    }
+
+    return ELF_SUCCESS;
+}
+
+/**
+ * 处理位置无关可执行文件的动态重定位
+ * 动态段、重定位表、动态符号表都位于已加载的段中，直接从程序内存读取
+ * 外部符号在内核符号表中查找，不加载其他共享库
+ * @param context ELF文件加载上下文
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+static int process_dynamic_relocations(Elf64_Ctx *context) {
+    const Elf64_Phdr *dynamic_phdr = NULL;
+    const Elf64_Dyn  *dyn;
+    Elf64_Addr        rela_addr = 0;
+    Elf64_Xword       rela_size = 0;
+    Elf64_Xword       rela_ent = sizeof(Elf64_Rela);
+    Elf64_Addr        jmprel_addr = 0;
+    Elf64_Xword       jmprel_size = 0;
+    Elf64_Xword       pltrel = DT_RELA;
+    Elf64_Addr        symtab_addr = 0;
+    Elf64_Addr        strtab_addr = 0;
+    Elf64_Xword       strsz = 0;
+    const Elf64_Rela *rela = NULL;
+    const Elf64_Rela *jmprel = NULL;
+    const Elf64_Sym  *symtab = NULL;
+    const char       *strtab = NULL;
+    size_t            dyn_count;
+    int               result;
+
+    for (int i = 0; i < context->elf_hdr->e_phnum; i++) {
+        if (context->program_headers[i].p_type == PT_DYNAMIC) {
+            dynamic_phdr = &context->program_headers[i];
+            break;
+        }
+    }
+    // 没有动态段的 ET_DYN 文件不需要重定位
+    if (dynamic_phdr == NULL) {
+        return ELF_SUCCESS;
+    }
+
+    dyn = (const Elf64_Dyn *)dyn_addr(context, dynamic_phdr->p_vaddr, dynamic_phdr->p_memsz);
+    if (dyn == NULL) {
+        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    }
+    dyn_count = dynamic_phdr->p_memsz / sizeof(Elf64_Dyn);
+
+    for (size_t i = 0; i < dyn_count && dyn[i].d_tag != DT_NULL; i++) {
+        switch (dyn[i].d_tag) {
+            case DT_RELA:
+                rela_addr = dyn[i].d_un.d_ptr;
+                break;
+            case DT_RELASZ:
+                rela_size = dyn[i].d_un.d_val;
+                break;
+            case DT_RELAENT:
+                rela_ent = dyn[i].d_un.d_val;
+                break;
+            case DT_JMPREL:
+                jmprel_addr = dyn[i].d_un.d_ptr;
+                break;
+            case DT_PLTRELSZ:
+                jmprel_size = dyn[i].d_un.d_val;
+                break;
+            case DT_PLTREL:
+                pltrel = dyn[i].d_un.d_val;
+                break;
+            case DT_SYMTAB:
+                symtab_addr = dyn[i].d_un.d_ptr;
+                break;
+            case DT_STRTAB:
+                strtab_addr = dyn[i].d_un.d_ptr;
+                break;
+            case DT_STRSZ:
+                strsz = dyn[i].d_un.d_val;
+                break;
+            case DT_REL:
+            case DT_RELSZ:
+                // AArch64 只使用 RELA
+                return ELF_ERROR_RELOCATION_FAILED;
+            default:
+                break;
+        }
+    }
+
+    if (rela_ent != sizeof(Elf64_Rela) || (jmprel_size != 0 && pltrel != DT_RELA)) {
+        return ELF_ERROR_RELOCATION_FAILED;
+    }
+
+    if (rela_size != 0) {
+        rela = (const Elf64_Rela *)dyn_addr(context, rela_addr, rela_size);
+        if (rela == NULL) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+    }
+    if (jmprel_size != 0) {
+        jmprel = (const Elf64_Rela *)dyn_addr(context, jmprel_addr, jmprel_size);
+        if (jmprel == NULL) {
+            return ELF_ERROR_RELOCATION_FAILED;
+        }
+    }
+    if (symtab_addr != 0) {
+        symtab = (const Elf64_Sym *)dyn_addr(context, symtab_addr, sizeof(Elf64_Sym));
+    }
+    if (strtab_addr != 0 && strsz != 0) {
+        strtab = (const char *)dyn_addr(context, strtab_addr, strsz);
+    }
+
+    result = apply_dynamic_relocations(context, rela, rela_size / sizeof(Elf64_Rela), symtab,
+                                       strtab, strsz);
+    if (result != ELF_SUCCESS) {
+        return result;
+    }
+    return apply_dynamic_relocations(context, jmprel, jmprel_size / sizeof(Elf64_Rela), symtab,
+                                     strtab, strsz);
+}
+
+/**
+ * 检查共享运行库没有可写数据
+ * 没有 MMU 时库代码按 PC 相对地址访问自己的数据，所有程序共用同一份，无法按程序分别实例化；
+ * 可写段只能位于 PT_GNU_RELRO 范围内（GOT、动态段，加载时写入后不再修改）
+ * @param context ELF文件加载上下文
+ * @return 成功返回 ELF_SUCCESS，库有可写数据返回 ELF_ERROR_LIBRARY_DATA
+ */
+static int check_library_segments(const Elf64_Ctx *context) {
+    const Elf64_Phdr *program_headers = context->program_headers;
+    Elf64_Half        phnum = context->elf_hdr->e_phnum;
+    Elf64_Addr        relro_start = 0;
+    Elf64_Addr        relro_end = 0;
+
+    for (int i = 0; i < phnum; i++) {
+        if (program_headers[i].p_type == PT_GNU_RELRO) {
+            relro_start = program_headers[i].p_vaddr;
+            relro_end = relro_start + program_headers[i].p_memsz;
+        } else if (program_headers[i].p_type == PT_TLS) {
+            return ELF_ERROR_LIBRARY_DATA;
+        }
+    }
+
+    for (int i = 0; i < phnum; i++) {
+        const Elf64_Phdr *phdr = &program_headers[i];
+
+        if (phdr->p_type != PT_LOAD || !(phdr->p_flags & PF_W) || phdr->p_memsz == 0) {
+            continue;
+        }
+        if (phdr->p_vaddr < relro_start || phdr->p_vaddr + phdr->p_memsz > relro_end) {
 #ifdef DEBUG_ELF_LOADER
-        xil_printf("Main function not found\r\n");
+            xil_printf("Library has writable data outside RELRO\r\n");
 #endif
+            return ELF_ERROR_LIBRARY_DATA;
+        }
+    }
+
+    return ELF_SUCCESS;
+}
+
+/**
+ * 计算动态符号表的符号数
+ * 动态段不记录符号数：DT_HASH 的 nchain 即符号数；只有 DT_GNU_HASH 时从各桶中最大的
+ * 起始符号沿链找到链尾
+ * @param context ELF文件加载上下文
+ * @param hash_addr DT_HASH，没有时为 0
+ * @param gnu_hash_addr DT_GNU_HASH，没有时为 0
+ * @param count 输出符号数
+ * @return 成功返回 ELF_SUCCESS，失败返回 ELF_ERROR_SYMTAB_NOT_FOUND
+ */
+static int dynamic_symbol_count(Elf64_Ctx *context, Elf64_Addr hash_addr,
+                                Elf64_Addr gnu_hash_addr, size_t *count) {
+    const uint32_t *header;
+    const uint32_t *buckets;
+    const uint32_t *chain;
+    Elf64_Addr      chain_addr;
+    uint32_t        last = 0;
+
+    if (hash_addr != 0) {
+        header = (const uint32_t *)dyn_addr(context, hash_addr, 2 * sizeof(uint32_t));
+        if (header == NULL) {
+            return ELF_ERROR_SYMTAB_NOT_FOUND;
+        }
+        *count = header[1];
+        return ELF_SUCCESS;
+    }
+    if (gnu_hash_addr == 0) {
         return ELF_ERROR_SYMTAB_NOT_FOUND;
-    } else {
-        if (context->elf_hdr->e_entry != 0) {
-            void *entry_addr =
-                (void *)(section_memory + context->memory_pool_index * ELF_MEMORY_SIZE +
-                         context->elf_hdr->e_entry);
-            // 执行入口函数
-            int (*entry_func)(void) = (int (*)(void))entry_addr;
-            context->result = entry_func();
-            return ELF_SUCCESS;
-        } else {
-            return ELF_ERROR_STRTAB_NOT_FOUND;
+    }
+
+    // nbuckets、symoffset、bloom_size、bloom_shift，之后是 bloom、buckets、chain
+    header = (const uint32_t *)dyn_addr(context, gnu_hash_addr, 4 * sizeof(uint32_t));
+    if (header == NULL) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
+    }
+    chain_addr = gnu_hash_addr + 4 * sizeof(uint32_t) + (Elf64_Addr)header[2] * sizeof(uint64_t);
+    buckets = (const uint32_t *)dyn_addr(context, chain_addr, header[0] * sizeof(uint32_t));
+    if (buckets == NULL) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
+    }
+    chain_addr += header[0] * sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < header[0]; i++) {
+        if (buckets[i] > last) {
+            last = buckets[i];
+        }
+    }
+    // 没有可哈希的符号
+    if (last < header[1]) {
+        *count = header[1];
+        return ELF_SUCCESS;
+    }
+
+    // 链尾的哈希值最低位为 1
+    for (;;) {
+        chain = (const uint32_t *)dyn_addr(
+            context, chain_addr + (Elf64_Addr)(last - header[1]) * sizeof(uint32_t),
+            sizeof(uint32_t));
+        if (chain == NULL) {
+            return ELF_ERROR_SYMTAB_NOT_FOUND;
         }
+        if (*chain & 1) {
+            break;
+        }
+        last++;
     }
+    *count = (size_t)last + 1;
+    return ELF_SUCCESS;
 }
 
 /**
- * 清理已加载的段
- * @param section_headers 节头表指针
- * @param shnum 节头表条目数
- * @param loaded_sections 已加载段指针数组
+ * 获取库导出的符号名称
+ * 只导出库中定义的全局、弱函数和数据对象
+ * @param context ELF文件加载上下文
+ * @param sym 动态符号
+ * @param strtab 动态字符串表
+ * @param strsz 动态字符串表大小
+ * @return 符号名称，不导出返回 NULL
  */
-static void cleanup_loaded_sections(int memory_used_index) {
-    elf_memory_addr[memory_used_index] = (Elf64_Addr)NULL;
+static const char *library_symbol_name(Elf64_Ctx *context, const Elf64_Sym *sym,
+                                       const char *strtab, Elf64_Xword strsz) {
+    unsigned char bind = ELF64_ST_BIND(sym->st_info);
+    unsigned char type = ELF64_ST_TYPE(sym->st_info);
+
+    if ((bind != STB_GLOBAL && bind != STB_WEAK) || (type != STT_FUNC && type != STT_OBJECT)) {
+        return NULL;
+    }
+    if (sym->st_shndx == SHN_UNDEF || sym->st_shndx >= SHN_LORESERVE ||
+        dyn_addr(context, sym->st_value, sym->st_size) == NULL) {
+        return NULL;
+    }
+    if (sym->st_name == 0 || sym->st_name >= strsz ||
+        memchr(strtab + sym->st_name, '\0', strsz - sym->st_name) == NULL) {
+        return NULL;
+    }
+    return strtab + sym->st_name;
 }
 
 /**
- * 解析程序头表并验证其有效性
+ * 按动态符号表生成库的符号表
+ * 库结构体、符号和桶在同一块分配中，符号名称指向已加载的动态字符串表
  * @param context ELF文件加载上下文
+ * @param name 库名称
+ * @param library 输出库，程序内存由调用方填入
  * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
  */
-static int parse_program_headers(Elf64_Ctx *context) {
-    const Elf64_Ehdr *elf_hdr = context->elf_hdr;
-
-    // 检查是否有程序头表
-    if (context->elf_hdr->e_phnum == 0) {
-        context->program_headers = NULL;
-        return ELF_SUCCESS;
+static int load_library_exports(Elf64_Ctx *context, const char *name, ELF_LIBRARY **library) {
+    const Elf64_Phdr *dynamic_phdr = NULL;
+    const Elf64_Dyn  *dyn;
+    Elf64_Addr        symtab_addr = 0;
+    Elf64_Addr        strtab_addr = 0;
+    Elf64_Addr        hash_addr = 0;
+    Elf64_Addr        gnu_hash_addr = 0;
+    Elf64_Xword       strsz = 0;
+    Elf64_Xword       syment = sizeof(Elf64_Sym);
+    const Elf64_Sym  *symtab;
+    const char       *strtab;
+    size_t            sym_count;
+    size_t            export_count = 0;
+    uint32_t          bucket_count = 1;
+    ELF_EXPORT       *exports;
+    uint16_t         *buckets;
+    ELF_LIBRARY      *result;
+    int               status;
+
+    for (int i = 0; i < context->elf_hdr->e_phnum; i++) {
+        if (context->program_headers[i].p_type == PT_DYNAMIC) {
+            dynamic_phdr = &context->program_headers[i];
+            break;
+        }
+    }
+    if (dynamic_phdr == NULL) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
+    }
+    dyn = (const Elf64_Dyn *)dyn_addr(context, dynamic_phdr->p_vaddr, dynamic_phdr->p_memsz);
+    if (dyn == NULL) {
+        return ELF_ERROR_PROGRAM_NOT_FOUND;
     }
 
-    // 计算程序头表的文件偏移和大小
-    Elf64_Off  phoff = elf_hdr->e_phoff;
-    Elf64_Half phentsize = elf_hdr->e_phentsize;
-    Elf64_Half phnum = elf_hdr->e_phnum;
+    for (size_t i = 0; i < dynamic_phdr->p_memsz / sizeof(Elf64_Dyn) && dyn[i].d_tag != DT_NULL;
+         i++) {
+        switch (dyn[i].d_tag) {
+            case DT_SYMTAB:
+                symtab_addr = dyn[i].d_un.d_ptr;
+                break;
+            case DT_STRTAB:
+                strtab_addr = dyn[i].d_un.d_ptr;
+                break;
+            case DT_STRSZ:
+                strsz = dyn[i].d_un.d_val;
+                break;
+            case DT_SYMENT:
+                syment = dyn[i].d_un.d_val;
+                break;
+            case DT_HASH:
+                hash_addr = dyn[i].d_un.d_ptr;
+                break;
+            case DT_GNU_HASH:
+                gnu_hash_addr = dyn[i].d_un.d_ptr;
+                break;
+            default:
+                break;
+        }
+    }
 
-    // 检查程序头表偏移是否有效
-    if (phoff == 0) {
-        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    if (symtab_addr == 0 || syment != sizeof(Elf64_Sym)) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
+    }
+    strtab = (strsz != 0) ? (const char *)dyn_addr(context, strtab_addr, strsz) : NULL;
+    if (strtab == NULL) {
+        return ELF_ERROR_STRTAB_NOT_FOUND;
+    }
+    status = dynamic_symbol_count(context, hash_addr, gnu_hash_addr, &sym_count);
+    if (status != ELF_SUCCESS) {
+        return status;
+    }
+    if (sym_count > SIZE_MAX / sizeof(Elf64_Sym)) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
+    }
+    symtab = (const Elf64_Sym *)dyn_addr(context, symtab_addr, sym_count * sizeof(Elf64_Sym));
+    if (symtab == NULL) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
     }
 
-    // 检查程序头表条目大小是否正确
-    if (phentsize != sizeof(Elf64_Phdr)) {
-        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    for (size_t i = 1; i < sym_count; i++) {
+        if (library_symbol_name(context, &symtab[i], strtab, strsz) != NULL) {
+            export_count++;
+        }
+    }
+    // 桶下标为 uint16_t
+    if (export_count > 0xFFFF) {
+        return ELF_ERROR_SYMTAB_NOT_FOUND;
+    }
+    while (bucket_count < export_count) {
+        bucket_count *= 2;
     }
 
-    // 检查程序头表是否超出文件范围
-    if (phoff + phentsize * phnum > context->elf_size) {
-        return ELF_ERROR_PROGRAM_NOT_FOUND;
+    result = (ELF_LIBRARY *)pvPortMalloc(sizeof(ELF_LIBRARY) + export_count * sizeof(ELF_EXPORT) +
+                                         (bucket_count + 1) * sizeof(uint16_t));
+    if (result == NULL) {
+        return ELF_OOM;
+    }
+    memset(result, 0, sizeof(ELF_LIBRARY));
+    strcpy(result->name, name);
+    exports = (ELF_EXPORT *)(result + 1);
+    buckets = (uint16_t *)(exports + export_count);
+    memset(buckets, 0, (bucket_count + 1) * sizeof(uint16_t));
+
+    // 按桶计数排序：先统计每个桶的符号数，前缀和为桶的起始下标，
+    // 放入符号时桶下标递增到下一个桶的起始，最后整体后移一项
+    for (size_t i = 1; i < sym_count; i++) {
+        const char *sym_name = library_symbol_name(context, &symtab[i], strtab, strsz);
+        if (sym_name != NULL) {
+            buckets[(elf_export_hash(sym_name) & (bucket_count - 1)) + 1]++;
+        }
     }
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        buckets[i + 1] += buckets[i];
+    }
+    for (size_t i = 1; i < sym_count; i++) {
+        const char *sym_name = library_symbol_name(context, &symtab[i], strtab, strsz);
+        if (sym_name != NULL) {
+            uint32_t    hash = elf_export_hash(sym_name);
+            ELF_EXPORT *symbol = &exports[buckets[hash & (bucket_count - 1)]++];
+
+            symbol->hash = hash;
+            symbol->name = sym_name;
+            symbol->address = (const void *)(symtab[i].st_value + context->load_bias);
+        }
+    }
+    for (uint32_t i = bucket_count; i > 0; i--) {
+        buckets[i] = buckets[i - 1];
+    }
+    buckets[0] = 0;
 
-    // 获取程序头表指针
-    context->program_headers = (const Elf64_Phdr *)(context->elf_data + phoff);
+    result->exports.bucket_count = bucket_count;
+    result->exports.buckets = buckets;
+    result->exports.symbols = exports;
+    result->exports.symbol_count = export_count;
+    *library = result;
     return ELF_SUCCESS;
 }
 
 /**
- * 加载可执行elf的section
- * @param context ELF文件加载上下文
+ * 按名称查找已加载的共享运行库
+ * @param name 库名称
+ * @return 库，未加载返回 NULL
  */
-
-static int exec_load_sections(Elf64_Ctx *context) {
-    const Elf64_Phdr *program_headers = context->program_headers;
-    Elf64_Half        phnum = context->elf_hdr->e_phnum;
-    Elf64_Addr        memory_offset = 0;
-
-    for (int i = 0; i < MAX_ELF; i++) {
-        if (elf_memory_addr[i] == (Elf64_Addr)NULL) {
-            context->memory_pool_index = i;
-            break;
+static ELF_LIBRARY *find_library(const char *name) {
+    for (ELF_LIBRARY *library = elf_library_list; library != NULL; library = library->next) {
+        if (strcmp_simple(library->name, name) == 0) {
+            return library;
         }
     }
+    return NULL;
+}
 
-    for (int i = 0; i < phnum; i++) {
-        const Elf64_Phdr *phdr = &program_headers[i];
-
-        // 只加载需要分配的段（PT_LOAD）
-        if (phdr->p_type != PT_LOAD) {
-            continue;
+/**
+ * 在文件的一段注释（note）中查找系统调用 ABI 声明
+ * @param context ELF文件加载上下文
+ * @param offset 注释的文件偏移
+ * @param size 注释的字节数
+ * @param abi 找到时写入声明的主、次版本号
+ * @return 找到返回 1，没有返回 0，读取失败返回 ELF_ERROR_READ
+ */
+static int find_abi_note(Elf64_Ctx *context, Elf64_Off offset, Elf64_Xword size, uint32_t abi[2]) {
+    while (size >= sizeof(Elf64_Nhdr)) {
+        Elf64_Nhdr  note;
+        char        name[sizeof(FREERTOS_NOTE_NAME)];
+        Elf64_Xword name_size;
+        Elf64_Xword desc_size;
+
+        if (elf_read(context, offset, &note, sizeof(note)) != ELF_SUCCESS) {
+            return ELF_ERROR_READ;
         }
-
-        // 跳过大小为0的段
-        if (phdr->p_memsz == 0) {
-            continue;
+        name_size = ((Elf64_Xword)note.n_namesz + 3) & ~(Elf64_Xword)3;
+        desc_size = ((Elf64_Xword)note.n_descsz + 3) & ~(Elf64_Xword)3;
+        // 格式不对的注释不属于任何声明，停止查找
+        if (name_size + desc_size > size - sizeof(note)) {
+            return 0;
         }
-
-        // 检查段大小是否超过内存池限制
-        if (phdr->p_memsz > ELF_MEMORY_SIZE) {
-            return ELF_OOM;
+        if (note.n_type == FREERTOS_NOTE_ABI && note.n_namesz == sizeof(name) &&
+            note.n_descsz == 2 * sizeof(uint32_t)) {
+            if (elf_read(context, offset + sizeof(note), name, sizeof(name)) != ELF_SUCCESS ||
+                elf_read(context, offset + sizeof(note) + name_size, abi, 2 * sizeof(uint32_t)) !=
+                    ELF_SUCCESS) {
+                return ELF_ERROR_READ;
+            }
+            if (memcmp(name, FREERTOS_NOTE_NAME, sizeof(name)) == 0) {
+                return 1;
+            }
         }
+        offset += sizeof(note) + name_size + desc_size;
+        size -= sizeof(note) + name_size + desc_size;
+    }
+    return 0;
+}
 
-        for (Elf64_Xword i = 0; i < phdr->p_filesz; i++) {
-            // 将 ELF 文件中的数据加载到内存中
-            uint8_t *dest = (uint8_t *)section_memory +
-                            context->memory_pool_index * ELF_MEMORY_SIZE + memory_offset + i;
-            *dest = context->elf_data[phdr->p_offset + i];
+/**
+ * 检查程序声明的系统调用 ABI 版本，见 FREERTOS_SYSCALL_ABI_NOTE()
+ * 可重定位文件查找 SHT_NOTE 节，其余查找 PT_NOTE 段，没有声明的程序按 1.0 处理
+ * 主版本与内核不同，或需要的次版本高于内核时拒绝加载
+ * @param context ELF文件加载上下文，节头表或程序头表已读取
+ * @return 成功返回 ELF_SUCCESS，版本不符返回 ELF_ERROR_SYSCALL_ABI，读取失败返回 ELF_ERROR_READ
+ */
+static int check_syscall_abi(Elf64_Ctx *context) {
+    uint32_t abi[2] = {1, 0};
+    int      found = 0;
+
+    if (context->section_headers != NULL) {
+        for (Elf64_Half i = 0; i < context->elf_hdr->e_shnum && found == 0; i++) {
+            const Elf64_Shdr *shdr = &context->section_headers[i];
+            if (shdr->sh_type == SHT_NOTE) {
+                found = find_abi_note(context, shdr->sh_offset, shdr->sh_size, abi);
+            }
+        }
+    } else if (context->program_headers != NULL) {
+        for (Elf64_Half i = 0; i < context->elf_hdr->e_phnum && found == 0; i++) {
+            const Elf64_Phdr *phdr = &context->program_headers[i];
+            if (phdr->p_type == PT_NOTE) {
+                found = find_abi_note(context, phdr->p_offset, phdr->p_filesz, abi);
+            }
         }
-        memory_offset += phdr->p_memsz;
     }
-    context->memory_size = memory_offset;
-
+    if (found < 0) {
+        return found;
+    }
+    if (abi[0] != FREERTOS_SYSCALL_ABI_MAJOR || abi[1] > FREERTOS_SYSCALL_ABI_MINOR) {
+#ifdef DEBUG_ELF_LOADER
+        xil_printf("Error: Program needs syscall ABI %u.%u, kernel provides %u.%u\r\n",
+                   (unsigned)abi[0], (unsigned)abi[1], (unsigned)FREERTOS_SYSCALL_ABI_MAJOR,
+                   (unsigned)FREERTOS_SYSCALL_ABI_MINOR);
+#endif
+        return ELF_ERROR_SYSCALL_ABI;
+    }
     return ELF_SUCCESS;
 }
 
 /**
- * 加载 ELF 文件并执行 main 函数
- * @param elf_data ELF 文件数据指针
- * @param elf_size ELF 文件大小
+ * 通过读取回调加载 ELF 文件并执行 main 函数
+ * @param reader 读取回调
+ * @param elf_data 内存中的 ELF 文件，仅用于调试输出，流式加载时为 NULL
+ * @param prepared 预处理镜像的保存位置，不使用时为 NULL
  * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
  */
-int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
+static int elf_run(const ELF_READER *reader, const uint8_t *elf_data, ELF_PREPARED *prepared) {
     int        result;
-    int        elf_ctx_index = 0;
-    Elf64_Ctx *context = NULL;
-    for (; elf_ctx_index < MAX_ELF; elf_ctx_index++) {
-        if ((elf_bits_map & (1 << elf_ctx_index)) == 0) {
-            elf_bits_map |= (1 << elf_ctx_index);
-            context = &elf_ctxs[elf_ctx_index];
-            context->elf_data = elf_data;
-            context->elf_size = elf_size;
-            context->elf_hdr = NULL;
-            context->section_headers = NULL;
-            context->program_headers = NULL;
-            context->shstrtab = NULL;
-            context->shstrtab_hdr = NULL;
-            context->symtab_hdr = NULL;
-            context->strtab_hdr = NULL;
-            context->symtab = NULL;
-            context->strtab = NULL;
-            context->rela = NULL;
-            context->memory_pool_index = -1;
-            for (int i = 0; i < MAX_ELF; i++) {
-                context->load_sections[i] = 0;
-            }
-            context->result = ELF_NOT_RUN;
-            break;
-        }
-    }
+    Elf64_Addr entry;
+    Elf64_Ctx *context = elf_ctx_claim(reader, elf_data);
 
-    // 检查输入参数
-    if (elf_data == NULL) {
-        result = ELF_ERROR_NULL_POINTER;
-        goto failed;
+    if (context == NULL) {
+        if (reader->done != NULL) {
+            reader->done(reader->user);
+        }
+        print_error(ELF_OOM);
+        return ELF_OOM;
     }
 
-    // 检查文件大小是否足够包含 ELF 头部
-    if (elf_size < sizeof(Elf64_Ehdr)) {
+    // 读取 ELF 头部，文件大小不足时失败
+    if (elf_read(context, 0, &context->ehdr, sizeof(Elf64_Ehdr)) != ELF_SUCCESS) {
         result = ELF_ERROR_INVALID_MAGIC;
         goto failed;
     }
-
-    // 获取 ELF 头部指针
-    context->elf_hdr = (Elf64_Ehdr *)elf_data;
+    context->elf_hdr = &context->ehdr;
 
     // 校验 ELF 头部
     result = validate_elf_header(context->elf_hdr);
@@ -706,6 +2411,21 @@ int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
             goto failed;
         }
 
+        result = check_syscall_abi(context);
+        if (result != ELF_SUCCESS) {
+            goto failed;
+        }
+
+        // 同一文件已有预处理镜像时跳过符号表和重定位表，布局不同时按普通方式加载
+        if (prepared != NULL && *prepared != NULL) {
+            if ((*prepared)->layout == layout_hash(context)) {
+                result = run_prepared(context, *prepared);
+                goto cleanup_sections;
+            }
+            prepared = NULL;
+        }
+        context->prepare = (prepared != NULL);
+
         // 获取节字符串表
         if (context->section_headers != NULL) {
             result = get_section_string_table(context);
@@ -713,7 +2433,7 @@ int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
                 goto failed;
             }
 
-            if (context->shstrtab != NULL) {
+            if (context->shstrtab_hdr != NULL) {
 #ifdef DEBUG_ELF_LOADER
                 xil_printf("Section string table loaded successfully.\r\n");
 #endif
@@ -734,20 +2454,22 @@ int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
         }
 
         if (context->symtab_hdr != NULL && context->strtab_hdr != NULL) {
-            context->symtab = (const Elf64_Sym *)(elf_data + context->symtab_hdr->sh_offset);
-            context->strtab = (const char *)(elf_data + context->strtab_hdr->sh_offset);
-
 #ifdef DEBUG_ELF_LOADER
             xil_printf("Symbol table and string table found.\r\n");
-            print_section_header(context->symtab_hdr, context->shstrtab_hdr, elf_data);
-            print_section_header(context->strtab_hdr, context->shstrtab_hdr, elf_data);
-            xil_printf("\r\n---\r\n");
-            for (Elf64_Xword i = 0; i < context->strtab_hdr->sh_size; i++) {
-                xil_printf("%c", context->strtab[i]);
-            }
-            xil_printf("\r\n---\r\n");
-            for (Elf64_Xword i = 0; i < context->symtab_hdr->sh_size / sizeof(Elf64_Sym); i++) {
-                print_symbol(context->symtab[i], context->strtab_hdr, elf_data);
+            if (elf_data != NULL) {
+                const Elf64_Sym *symtab =
+                    (const Elf64_Sym *)(elf_data + context->symtab_hdr->sh_offset);
+                const char *strtab = (const char *)(elf_data + context->strtab_hdr->sh_offset);
+                print_section_header(context->symtab_hdr, context->shstrtab_hdr, elf_data);
+                print_section_header(context->strtab_hdr, context->shstrtab_hdr, elf_data);
+                xil_printf("\r\n---\r\n");
+                for (Elf64_Xword i = 0; i < context->strtab_hdr->sh_size; i++) {
+                    xil_printf("%c", strtab[i]);
+                }
+                xil_printf("\r\n---\r\n");
+                for (Elf64_Xword i = 0; i < context->symtab_hdr->sh_size / sizeof(Elf64_Sym); i++) {
+                    print_symbol(symtab[i], context->strtab_hdr, elf_data);
+                }
             }
 #endif
 
@@ -760,18 +2482,6 @@ int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
             goto failed;
         }
 
-        // 检查段数量是否超过限制
-        if (context->elf_hdr->e_shnum > MAX_ELF) {
-
-#ifdef DEBUG_ELF_LOADER
-            xil_printf("Error: Too many sections (%d), maximum supported: %d\r\n",
-                (int)context->elf_hdr->e_shnum, MAX_ELF);
-#endif
-
-            result = ELF_ERROR_SECTION_NOT_FOUND;
-            goto failed;
-        }
-
         result = relo_load_sections(context);
         if (result != ELF_SUCCESS) {
             goto cleanup_sections;
@@ -784,18 +2494,25 @@ int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
         }
 
 #ifdef DEBUG_ELF_LOADER
-        print_code(context, section_memory);
+        print_code(context);
         print_context(context);
 #endif
 
-        // 查找并执行main函数
-        result = find_and_execute_main(context);
+        // 查找main函数，执行前保存预处理镜像，之后程序会修改自己的数据
+        result = find_main(context, &entry);
         if (result != ELF_SUCCESS) {
             goto cleanup_sections;
         }
-    } else if (context->elf_hdr->e_type == ET_EXEC) {
+        if (context->prepare) {
+            save_prepared(context, entry, prepared);
+        }
+        result = run_entry(context, entry);
+    } else if (context->elf_hdr->e_type == ET_EXEC || context->elf_hdr->e_type == ET_DYN) {
         // 解析程序头表
         result = parse_program_headers(context);
+        if (result == ELF_SUCCESS) {
+            result = check_syscall_abi(context);
+        }
         if (result != ELF_SUCCESS) {
             goto failed;
         }
@@ -809,8 +2526,15 @@ int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
         if (result != ELF_SUCCESS) {
             goto cleanup_sections;
         }
+        // 位置无关可执行文件按 PT_DYNAMIC 处理动态重定位
+        if (context->elf_hdr->e_type == ET_DYN) {
+            result = process_dynamic_relocations(context);
+            if (result != ELF_SUCCESS) {
+                goto cleanup_sections;
+            }
+        }
 #ifdef DEBUG_ELF_LOADER
-        print_code(context, section_memory);
+        print_code(context);
 #endif
         result = find_and_execute_main(context);
 
@@ -819,15 +2543,297 @@ int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
         }
     }
 cleanup_sections:
+    if (result == ELF_SUCCESS) {
+        result = context->result;
+        elf_ctx_unlink(context);
+        elf_ctx_free(context);
+        return result;
+    }
+
+failed:
+    elf_read_done(context);
     // 清理分配的内存
-    cleanup_loaded_sections(context->memory_pool_index);
+    elf_ctx_unlink(context);
+    elf_ctx_free(context);
+    print_error(result);
+    return result;
+}
+
+/**
+ * 加载 ELF 文件并执行 main 函数
+ * @param elf_data ELF 文件数据指针
+ * @param elf_size ELF 文件大小
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+int elf_load_and_run(const uint8_t *elf_data, size_t elf_size) {
+    return elf_load_and_run_owned(elf_data, elf_size, NULL);
+}
+
+/**
+ * 加载 ELF 文件并执行 main 函数，程序内存记在 owner 名下
+ * @param elf_data ELF 文件数据指针
+ * @param elf_size ELF 文件大小
+ * @param owner 程序内存的所有者，见 elf_release_owner()
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+int elf_load_and_run_owned(const uint8_t *elf_data, size_t elf_size, const void *owner) {
+    ELF_READER reader = {elf_memory_read, NULL, (void *)elf_data, elf_size, owner};
+
+    // 检查输入参数
+    if (elf_data == NULL) {
+        print_error(ELF_ERROR_NULL_POINTER);
+        return ELF_ERROR_NULL_POINTER;
+    }
+
+    return elf_run(&reader, elf_data, NULL);
+}
+
+/**
+ * 加载 ELF 文件并执行 main 函数，重复启动时复用预处理镜像
+ * 冷启动完整加载，重定位后把程序内存和与加载地址有关的重定位保存为预处理镜像；
+ * 热启动只复制镜像并按新基址重新计算这些重定位，不再读取符号表和重定位表
+ * 只支持 ET_REL 程序，使用模块内 GOT 的程序不生成预处理镜像
+ * @param elf_data ELF 文件数据指针
+ * @param elf_size ELF 文件大小
+ * @param owner 程序内存的所有者，见 elf_release_owner()
+ * @param prepared 预处理镜像的保存位置，初始为 NULL，同一文件的所有加载共用；NULL 时同
+ *                 elf_load_and_run_owned()
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+int elf_load_and_run_prepared(const uint8_t *elf_data, size_t elf_size, const void *owner,
+                              ELF_PREPARED *prepared) {
+    ELF_READER reader = {elf_memory_read, NULL, (void *)elf_data, elf_size, owner};
+
+    // 检查输入参数
+    if (elf_data == NULL) {
+        print_error(ELF_ERROR_NULL_POINTER);
+        return ELF_ERROR_NULL_POINTER;
+    }
+
+    return elf_run(&reader, elf_data, prepared);
+}
+
+/**
+ * 释放预处理镜像
+ * @param prepared 预处理镜像，NULL 时忽略
+ */
+void elf_prepared_free(ELF_PREPARED prepared) {
+    if (prepared != NULL) {
+        vPortFree(prepared);
+    }
+}
+
+/**
+ * 获取预处理镜像占用的字节数
+ * @param prepared 预处理镜像
+ * @return 字节数，NULL 返回 0
+ */
+size_t elf_prepared_size(ELF_PREPARED prepared) {
+    return (prepared != NULL) ? prepared->alloc_size : 0;
+}
+
+/**
+ * 通过读取回调流式加载 ELF 文件并执行 main 函数
+ * 头部和各段直接从文件读入，符号表和重定位表分块读取，
+ * 启动时的内存占用约为加载后的程序大小
+ * @param reader 读取回调，执行程序前或加载失败时调用 reader->done
+ * @return 成功返回 ELF_SUCCESS，失败返回相应错误码
+ */
+int elf_load_and_run_stream(const ELF_READER *reader) {
+    // 检查输入参数
+    if (reader == NULL || reader->read == NULL) {
+        print_error(ELF_ERROR_NULL_POINTER);
+        return ELF_ERROR_NULL_POINTER;
+    }
+
+    return elf_run(reader, NULL, NULL);
+}
+
+/**
+ * 释放 owner 名下的程序内存和加载上下文
+ * 执行程序的任务被删除时 elf_load_and_run 不会返回，由删除方调用此函数释放其内存
+ * @param owner 加载时传入的所有者
+ */
+void elf_release_owner(const void *owner) {
+    Elf64_Ctx *context;
+
+    if (owner == NULL) {
+        return;
+    }
+
+    do {
+        taskENTER_CRITICAL();
+        for (context = elf_ctx_list; context != NULL; context = context->next) {
+            if (context->owner == owner) {
+                break;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if (context != NULL) {
+            elf_ctx_unlink(context);
+            elf_ctx_free(context);
+        }
+    } while (context != NULL);
+}
+
+/**
+ * 获取当前加载的程序
+ * @param info 输出数组，可为 NULL
+ * @param max 数组长度
+ * @return 正在加载或执行的程序数，可能大于 max
+ */
+size_t elf_get_loads(ELF_LOAD_INFO *info, size_t max) {
+    const Elf64_Ctx *context;
+    size_t           count = 0;
+
+    taskENTER_CRITICAL();
+    for (context = elf_ctx_list; context != NULL; context = context->next) {
+        if (info != NULL && count < max) {
+            info[count].owner = context->owner;
+            info[count].memory = context->image_memory;
+            info[count].size = context->memory_size;
+        }
+        count++;
+    }
+    taskEXIT_CRITICAL();
+
+    return count;
+}
+
+/**
+ * 获取启动以来的累计加载统计
+ * @param stats 输出统计
+ */
+void elf_get_load_stats(ELF_LOAD_STATS *stats) {
+    if (stats == NULL) {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    *stats = elf_load_stats;
+    taskEXIT_CRITICAL();
+    __asm volatile("mrs %0, cntfrq_el0" : "=r"(stats->frequency));
+}
+
+/**
+ * 加载共享运行库
+ * 库按 PT_LOAD 段加载并处理动态重定位，库依赖的符号在内核符号表和先加载的库中查找；
+ * 之后加载的程序（包括延迟绑定）按 elf_find_export() 链接库中定义的全局符号。
+ * 库常驻内存不卸载，程序内存计入调用任务的 cgroup，应由系统任务而不是容器调用。
+ * 库必须没有可写数据，见 check_library_segments()，
+ * 按 -shared -fPIC -nostdlib -Wl,-z,now -Wl,-z,relro 链接
+ * @param name 库名称，同名的库只加载一次
+ * @param elf_data ELF 文件数据指针，加载后不再使用
+ * @param elf_size ELF 文件大小
+ * @return 成功或已加载返回 ELF_SUCCESS，失败返回相应错误码
+ */
+int elf_library_load(const char *name, const uint8_t *elf_data, size_t elf_size) {
+    ELF_READER   reader = {elf_memory_read, NULL, (void *)elf_data, elf_size, NULL};
+    ELF_LIBRARY *library = NULL;
+    ELF_LIBRARY *loaded;
+    Elf64_Ctx   *context;
+    int          result;
+
+    // 检查输入参数
+    if (name == NULL || elf_data == NULL || name[0] == '\0' ||
+        strnlen(name, ELF_LIBRARY_NAME_MAX) >= ELF_LIBRARY_NAME_MAX) {
+        print_error(ELF_ERROR_NULL_POINTER);
+        return ELF_ERROR_NULL_POINTER;
+    }
+    if (find_library(name) != NULL) {
+        return ELF_SUCCESS;
+    }
+
+    context = elf_ctx_claim(&reader, elf_data);
+    if (context == NULL) {
+        print_error(ELF_OOM);
+        return ELF_OOM;
+    }
+
+    if (elf_read(context, 0, &context->ehdr, sizeof(Elf64_Ehdr)) != ELF_SUCCESS) {
+        result = ELF_ERROR_INVALID_MAGIC;
+        goto failed;
+    }
+    context->elf_hdr = &context->ehdr;
+
+    result = validate_elf_header(context->elf_hdr);
+    if (result == ELF_SUCCESS && context->elf_hdr->e_type != ET_DYN) {
+        result = ELF_ERROR_INVALID_TYPE;
+    }
     if (result == ELF_SUCCESS) {
-        return context->result;
-    } else {
+        result = parse_program_headers(context);
+    }
+    if (result == ELF_SUCCESS) {
+        result = check_syscall_abi(context);
+    }
+    if (result == ELF_SUCCESS) {
+        result = check_library_segments(context);
+    }
+    if (result == ELF_SUCCESS) {
+        result = exec_load_sections(context);
+    }
+    if (result == ELF_SUCCESS) {
+        result = process_dynamic_relocations(context);
+    }
+    if (result == ELF_SUCCESS) {
+        result = load_library_exports(context, name, &library);
+    }
+    if (result != ELF_SUCCESS) {
         goto failed;
     }
 
+    elf_sync_icache(context->text_start, context->text_end);
+    elf_read_done(context);
+
+    // 程序内存转交给库，释放上下文时不再释放
+    library->memory = context->image_memory;
+    library->memory_size = context->memory_size;
+    context->image_memory = NULL;
+    elf_ctx_unlink(context);
+    elf_ctx_free(context);
+
+    // 同名的库可能同时在另一个任务中加载，只保留先加入链表的
+    taskENTER_CRITICAL();
+    loaded = find_library(name);
+    if (loaded == NULL) {
+        library->next = elf_library_list;
+        elf_library_list = library;
+    }
+    taskEXIT_CRITICAL();
+
+    if (loaded != NULL) {
+        vPortFree(library->memory);
+        vPortFree(library);
+    }
+    return ELF_SUCCESS;
+
 failed:
+    elf_read_done(context);
+    elf_ctx_unlink(context);
+    elf_ctx_free(context);
     print_error(result);
     return result;
-}
\ No newline at end of file
+}
+
+/**
+ * 获取已加载的共享运行库
+ * @param info 输出数组，可为 NULL
+ * @param max 数组长度
+ * @return 已加载的库数，可能大于 max
+ */
+size_t elf_get_libraries(ELF_LIBRARY_INFO *info, size_t max) {
+    size_t count = 0;
+
+    for (const ELF_LIBRARY *library = elf_library_list; library != NULL; library = library->next) {
+        if (info != NULL && count < max) {
+            info[count].name = library->name;
+            info[count].memory = library->memory;
+            info[count].size = library->memory_size;
+            info[count].symbols = library->exports.symbol_count;
+        }
+        count++;
+    }
+
+    return count;
+}
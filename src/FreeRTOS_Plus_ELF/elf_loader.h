@@ -31,6 +31,9 @@
 #define ELF_ERROR_STRTAB_NOT_FOUND -10
 #define ELF_ERROR_RELOCATION_FAILED -11
 #define ELF_ERROR_PROGRAM_NOT_FOUND -12
+#define ELF_ERROR_READ -13
+#define ELF_ERROR_LIBRARY_DATA -14
+#define ELF_ERROR_SYSCALL_ABI -15
 
 /* 64-bit ELF base types. */
 typedef uint64_t Elf64_Addr;
@@ -221,6 +224,13 @@ typedef struct elf64_shdr {
     Elf64_Xword sh_entsize;   /* Entry size if section holds table */
 } Elf64_Shdr;
 
+/* Note header in a SHT_NOTE section or PT_NOTE segment, name and desc follow padded to 4 bytes */
+typedef struct elf64_note {
+    Elf64_Word n_namesz; /* Name size */
+    Elf64_Word n_descsz; /* Content size */
+    Elf64_Word n_type;   /* Content type */
+} Elf64_Nhdr;
+
 #define EI_MAG0 0 /* e_ident[] indexes */
 #define EI_MAG1 1
 #define EI_MAG2 2
@@ -322,16 +332,107 @@ typedef struct elf64_shdr {
 #define R_AARCH64_LD64_GOT_LO12_NC 312
 #define R_AARCH64_LD64_GOTPAGE_LO15 313
 
+/* Dynamic relocations. */
+#define R_AARCH64_COPY 1024
+#define R_AARCH64_GLOB_DAT 1025
+#define R_AARCH64_JUMP_SLOT 1026
 #define R_AARCH64_RELATIVE 1027
 
+/* d_tag */
+#define DT_NULL 0
+#define DT_NEEDED 1
+#define DT_PLTRELSZ 2
+#define DT_PLTGOT 3
+#define DT_HASH 4
+#define DT_STRTAB 5
+#define DT_SYMTAB 6
+#define DT_RELA 7
+#define DT_RELASZ 8
+#define DT_RELAENT 9
+#define DT_STRSZ 10
+#define DT_SYMENT 11
+#define DT_REL 17
+#define DT_RELSZ 18
+#define DT_PLTREL 20
+#define DT_TEXTREL 22
+#define DT_JMPREL 23
+#define DT_FLAGS 30
+#define DT_GNU_HASH 0x6ffffef5
+#define DT_RELACOUNT 0x6ffffff9
+#define DT_FLAGS_1 0x6ffffffb
+
+typedef struct {
+    Elf64_Sxword d_tag; /* entry tag value */
+    union {
+        Elf64_Xword d_val;
+        Elf64_Addr  d_ptr;
+    } d_un;
+} Elf64_Dyn;
+
 
-// 静态内存池定义
+// 程序头的最大数量（同时加载的程序数不受限制，上下文按需分配）
+// 节头表按 e_shnum 分配，-O2、-ffunction-sections 编译的目标文件有几十上百个节
 #define MAX_ELF 16
-#define ELF_MEMORY_SIZE (64 * 1024) // 每个段最大64KB
+// 程序内存基址最大对齐（页大小），ADRP 等按页寻址的指令需要与链接时同页内偏移
+#define ELF_MAX_ALIGN 4096
+
+// 符号表、重定位表每次读取的条目数
+#define ELF_READ_CHUNK 16
+// 符号名称最大长度（含结尾的 '\0'）
+#define ELF_SYMBOL_NAME_MAX 64
+// 每块分配的 PLT 跳板数
+#define ELF_PLT_CHUNK 16
+// 共享运行库名称最大长度（含结尾的 '\0'）
+#define ELF_LIBRARY_NAME_MAX 64
+
+// 延迟绑定：为 1 时，容器程序对内核函数的 CALL26/JUMP26 调用经 PLT 跳板在第一次调用时
+// 才查找符号，加载时不再逐个解析；符号不存在时在调用处结束任务
+#ifndef ELF_LAZY_BINDING
+#define ELF_LAZY_BINDING 0
+#endif
+
+/**
+ * 读取回调：从文件偏移 offset 处读取 size 字节到 buf
+ * 成功返回读取的字节数，失败返回负数
+ */
+typedef int (*elf_read_fn)(void *user, size_t offset, void *buf, size_t size);
+
+typedef struct {
+    elf_read_fn read;              // 读取回调
+    void (*done)(void *user);      // 读取结束（执行程序前或加载失败时）调用，可为 NULL
+    void       *user;              // 回调参数
+    size_t      size;              // 文件大小
+    const void *owner;             // 程序内存的所有者，见 elf_release_owner()，可为 NULL
+} ELF_READER;
 
-typedef struct Elf_Load_Context {
-    const uint8_t    *elf_data;
+typedef struct Elf_Load_Context Elf64_Ctx;
+
+// 与加载地址有关的重定位，热启动时按新基址重新计算
+typedef struct {
+    uint32_t     offset;   // 修改位置相对程序基址的偏移
+    uint16_t     type;     // 重定位类型
+    uint16_t     internal; // value 为程序内地址（相对基址的偏移），否则为绝对地址
+    Elf64_Addr   value;    // 符号值 S，GOT 类重定位为表项地址 G
+    Elf64_Sxword addend;   // 加数 A
+} ELF_FIXUP;
+
+// 预处理镜像：重定位后、执行前的程序内存副本，见 elf_load_and_run_prepared()
+typedef struct Elf_Prepared *ELF_PREPARED;
+
+// PLT 跳板：adr x17, target; ldr x16, [x17]; br x16
+// 用于超出 ±128MB 的分支；延迟绑定的跳板 target 初始为解析入口，第一次调用时改为符号地址
+typedef struct {
+    uint32_t    code[4];
+    Elf64_Addr  target; // 跳转目标
+    const char *name;   // 延迟绑定的符号名称，指向内存中 ELF 文件的字符串表；直接跳转时为 NULL
+} ELF_PLT_ENTRY;
+
+typedef struct Elf_Plt_Block ELF_PLT_BLOCK;
+
+struct Elf_Load_Context {
+    const uint8_t    *elf_data;    // 内存中的 ELF 文件，流式加载时为 NULL
     size_t            elf_size;
+    const ELF_READER *reader;      // 读取结束后为 NULL
     const Elf64_Ehdr *elf_hdr;
     const Elf64_Shdr *section_headers;
     const Elf64_Phdr *program_headers;
@@ -339,20 +440,95 @@ typedef struct Elf_Load_Context {
     const Elf64_Shdr *shstrtab_hdr;
     const Elf64_Shdr *symtab_hdr;
     const Elf64_Shdr *strtab_hdr;
-    const Elf64_Sym  *symtab;
-    const char       *strtab;
-    const Elf64_Rela *rela;
-    int               memory_pool_index;
-    Elf64_Addr        load_sections[MAX_ELF];
+    Elf64_Ehdr        ehdr;                   // ELF 头部副本
+    Elf64_Shdr       *shdrs;                  // 节头表副本，按 e_shnum 分配
+    Elf64_Phdr        phdrs[MAX_ELF];         // 程序头表副本
+    Elf64_Sym         symtab[ELF_READ_CHUNK]; // 符号表读取窗口
+    size_t            symtab_base;            // 窗口中第一个符号的索引
+    size_t            symtab_count;           // 窗口中的符号数
+    Elf64_Rela        rela[ELF_READ_CHUNK];   // 当前处理的重定位条目
+    uint8_t          *image_memory;           // 程序内存，按程序头/节头大小分配
+    Elf64_Addr        load_bias;              // 运行地址减链接地址（ET_EXEC）
+    const void       *owner;                  // 程序内存的所有者
+    Elf64_Addr       *got;                    // 程序的 GOT，按符号索引，需要时分配
+    size_t            got_count;
+    int               prepare;                // 是否记录 fixups 以生成预处理镜像
+    ELF_FIXUP        *fixups;                 // 与加载地址有关的重定位
+    size_t            fixup_count;
+    size_t            fixup_capacity;
+    ELF_PREPARED      prepared;               // 已生成、还未交给调用方的预处理镜像
+    ELF_PLT_BLOCK    *plt_blocks;             // PLT 跳板，按块分配
+    ELF_PLT_ENTRY   **plt;                    // 按符号索引的跳板，需要时分配
+    size_t            plt_count;
+    Elf64_Addr       *load_sections;          // 各节加载地址，未加载的为 0，与 shdrs 一起分配
     size_t            memory_size;
+    size_t            image_size;             // 写入程序内存的字节数
+    size_t            image_align;            // 程序内存的基址对齐
+    Elf64_Addr        text_start;             // 可执行代码范围，执行前同步指令缓存
+    Elf64_Addr        text_end;
+    uint64_t          load_start;             // 开始加载时的计数器值
     int               result;
-} Elf64_Ctx;
+    Elf64_Ctx        *next;                   // 正在加载或执行的下一个程序
+};
 
 typedef struct {
     const uint8_t *elf_data;
     size_t         elf_size;
 } ELF_WRAP;
 
+typedef struct {
+    const void    *owner;  // 加载时传入的所有者
+    const uint8_t *memory; // 程序内存，尚未分配时为 NULL
+    size_t         size;   // 程序内存大小
+} ELF_LOAD_INFO;
+
+typedef struct {
+    const char    *name;    // 加载时传入的名称
+    const uint8_t *memory;  // 程序内存
+    size_t         size;    // 程序内存大小
+    size_t         symbols; // 导出的符号数
+} ELF_LIBRARY_INFO;
+
+typedef struct {
+    uint32_t loads;      // 执行到入口的加载次数
+    uint64_t bytes;      // 写入程序内存的字节数
+    uint64_t counts;     // 从开始加载到跳转入口的计数器计数，包括重定位和缓存维护
+    uint64_t frequency;  // 计数器频率（CNTFRQ_EL0），bytes * frequency / counts 为每秒字节数
+    uint64_t last_entry; // 最近一次跳转入口时的计数器值，用于测量启动到 main() 的延迟
+} ELF_LOAD_STATS;
+
 // 加载 ELF 文件并执行 main 函数
 int elf_load_and_run(const uint8_t *elf_data, size_t elf_size);
+
+// 同 elf_load_and_run，程序内存记在 owner 名下，程序被强行终止时用 elf_release_owner() 释放
+int elf_load_and_run_owned(const uint8_t *elf_data, size_t elf_size, const void *owner);
+
+// 通过读取回调流式加载 ELF 文件并执行 main 函数，不需要把整个文件读入内存
+int elf_load_and_run_stream(const ELF_READER *reader);
+
+// 同 elf_load_and_run_owned，*prepared 不为空时复制预处理镜像直接执行（热启动），
+// 为空时完整加载，ET_REL 程序重定位后生成预处理镜像存入 *prepared（冷启动）
+int elf_load_and_run_prepared(const uint8_t *elf_data, size_t elf_size, const void *owner,
+                              ELF_PREPARED *prepared);
+
+// 释放预处理镜像，调用方保证没有正在进行的加载使用它
+void elf_prepared_free(ELF_PREPARED prepared);
+
+// 预处理镜像占用的字节数，NULL 返回 0
+size_t elf_prepared_size(ELF_PREPARED prepared);
+
+// 释放 owner 名下仍未释放的程序内存，用于执行中被删除的任务；程序正常返回时内存已释放
+void elf_release_owner(const void *owner);
+
+// 获取正在加载或执行的程序，最多写入 max 项，返回程序总数
+size_t elf_get_loads(ELF_LOAD_INFO *info, size_t max);
+
+// 获取启动以来的累计加载统计
+void elf_get_load_stats(ELF_LOAD_STATS *stats);
+
+// 加载共享运行库（ET_DYN），同名的库只加载一次，之后加载的程序可以链接库中定义的全局符号
+int elf_library_load(const char *name, const uint8_t *elf_data, size_t elf_size);
+
+// 获取已加载的共享运行库，最多写入 max 项，返回库总数
+size_t elf_get_libraries(ELF_LIBRARY_INFO *info, size_t max);
 #endif // ELF_LOADER_H
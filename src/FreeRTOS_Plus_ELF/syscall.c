@@ -1,13 +1,251 @@
 #include "syscall.h"
 #include "FreeRTOS.h"
+#include "container.h"
+#include "ipc_namespace.h"
+#include "pid_namespace.h"
+#include "task.h"
+#include <stdint.h>
+#include <string.h>
 
 #ifdef configUSE_FILESYSTEM
-#include "task.h"
 #include "file_system.h"
 #endif
 
+#if (configTASK_NOTIFICATION_ARRAY_ENTRIES <= FREERTOS_SYSCALL_NOTIFY_INDEX)
+#error "configTASK_NOTIFICATION_ARRAY_ENTRIES has no entry for FREERTOS_SYSCALL_NOTIFY_INDEX"
+#endif
+
 extern void uart_puts(const char *str);
 
+// 参数来自程序，不能信任：FreeRTOS 对无效参数用 configASSERT 停机，这里先检查再调用
+
+/**
+ * 阻塞到 previous_wake_time + increment，并把该时间写回 previous_wake_time，用于固定周期执行
+ * @return 发生了阻塞返回 pdTRUE，已经过了该时间返回 pdFALSE
+ */
+static BaseType_t syscall_delay_until(TickType_t *previous_wake_time, TickType_t increment) {
+    if (previous_wake_time == NULL || increment == 0) {
+        return pdFALSE;
+    }
+    return xTaskDelayUntil(previous_wake_time, increment);
+}
+
+/**
+ * 调用者的虚拟 PID
+ * @return 虚拟 PID，不在 PID 命名空间中时返回 0
+ */
+static UBaseType_t syscall_get_pid(void) {
+    return xPidNamespaceGetTaskVirtualPid(xTaskGetCurrentTaskHandle());
+}
+
+/**
+ * 给调用者所在 PID 命名空间中的任务发送通知，对方用 notify_take 等待
+ * @param pid 虚拟 PID
+ * @return 成功返回 pdPASS，没有该任务或未启用 PID 命名空间返回 pdFAIL
+ */
+static BaseType_t syscall_notify_give(UBaseType_t pid) {
+#if (configUSE_PID_NAMESPACE == 1)
+    PidNamespaceHandle_t ns = xPidNamespaceGetTaskNamespace(xTaskGetCurrentTaskHandle());
+    TaskHandle_t         task;
+    BaseType_t           result = pdFAIL;
+
+    // 暂停调度，查找到通知之间目标任务不会被删除
+    vTaskSuspendAll();
+    task = xPidNamespaceFindTaskByVirtualPid(ns, pid);
+    if (task != NULL) {
+        result = xTaskNotifyGiveIndexed(task, FREERTOS_SYSCALL_NOTIFY_INDEX);
+    }
+    (void)xTaskResumeAll();
+    return result;
+#else
+    (void)pid;
+    return pdFAIL;
+#endif
+}
+
+/**
+ * 阻塞等待任务通知
+ * @param clear_on_exit pdTRUE 时返回前清零计数，pdFALSE 时减一
+ * @param timeout 最长等待的节拍数
+ * @return 返回前的通知计数，超时返回 0
+ */
+static uint32_t syscall_notify_take(BaseType_t clear_on_exit, TickType_t timeout) {
+    return ulTaskNotifyTakeIndexed(FREERTOS_SYSCALL_NOTIFY_INDEX, clear_on_exit, timeout);
+}
+
+#if (configUSE_IPC_NAMESPACE == 1)
+/**
+ * 调用者的 IPC 命名空间，不在任何命名空间中的任务属于根命名空间
+ */
+static IpcNamespaceHandle_t syscall_namespace(void) {
+    IpcNamespaceHandle_t ns = xIpcNamespaceGetTaskNamespace(NULL);
+
+    return (ns != NULL) ? ns : xIpcNamespaceGetRoot();
+}
+#endif
+
+/**
+ * 检查对象名称，NULL 表示匿名对象
+ * @return 名称可用返回 pdTRUE，过长或同一命名空间已有同名对象返回 pdFALSE
+ */
+static BaseType_t syscall_name_free(const char *name, IpcObjectType_t type) {
+    if (name == NULL) {
+        return pdTRUE;
+    }
+    if (strnlen(name, configMAX_TASK_NAME_LEN) >= configMAX_TASK_NAME_LEN) {
+        return pdFALSE;
+    }
+#if (configUSE_IPC_NAMESPACE == 1)
+    if (pvIpcNamespaceFindObjectByName(syscall_namespace(), name, type) != NULL) {
+        return pdFALSE;
+    }
+#else
+    (void)type;
+#endif
+    return pdTRUE;
+}
+
+/**
+ * 按名称打开调用者 IPC 命名空间中的对象
+ * @return 对象，没有找到或未启用 IPC 命名空间时返回 NULL
+ */
+static void *syscall_open(const char *name, IpcObjectType_t type) {
+#if (configUSE_IPC_NAMESPACE == 1)
+    return pvIpcNamespaceFindObjectByName(syscall_namespace(), name, type);
+#else
+    (void)name;
+    (void)type;
+    return NULL;
+#endif
+}
+
+/**
+ * 检查程序传入的句柄并在调用期间占用该对象，占用期间 ipc_delete 失败，对象不会被释放
+ * 成功后必须调用 syscall_release
+ * @return 句柄是调用者 IPC 命名空间中该类型的对象时返回 pdTRUE
+ */
+static BaseType_t syscall_acquire(void *object, IpcObjectType_t type) {
+#if (configUSE_IPC_NAMESPACE == 1)
+    return (xIpcNamespaceAcquireObject(syscall_namespace(), object, type) == pdPASS) ? pdTRUE
+                                                                                    : pdFALSE;
+#else
+    (void)type;
+    return (object != NULL) ? pdTRUE : pdFALSE;
+#endif
+}
+
+static void syscall_release(void *object) {
+#if (configUSE_IPC_NAMESPACE == 1)
+    vIpcNamespaceReleaseObject(syscall_namespace(), object);
+#else
+    (void)object;
+#endif
+}
+
+static QueueHandle_t syscall_queue_create(UBaseType_t length, UBaseType_t item_size,
+                                          const char *name) {
+    if (length == 0 || item_size == 0 || (size_t)item_size > SIZE_MAX / length ||
+        syscall_name_free(name, IPC_TYPE_QUEUE) != pdTRUE) {
+        return NULL;
+    }
+    return xQueueCreateIsolated(length, item_size, name);
+}
+
+static QueueHandle_t syscall_queue_open(const char *name) {
+    return (QueueHandle_t)syscall_open(name, IPC_TYPE_QUEUE);
+}
+
+static BaseType_t syscall_queue_send(QueueHandle_t queue, const void *item, TickType_t timeout) {
+    BaseType_t result;
+
+    if (item == NULL || syscall_acquire(queue, IPC_TYPE_QUEUE) != pdTRUE) {
+        return pdFAIL;
+    }
+    result = xQueueSend(queue, item, timeout);
+    syscall_release(queue);
+    return result;
+}
+
+static BaseType_t syscall_queue_receive(QueueHandle_t queue, void *buffer, TickType_t timeout) {
+    BaseType_t result;
+
+    if (buffer == NULL || syscall_acquire(queue, IPC_TYPE_QUEUE) != pdTRUE) {
+        return pdFAIL;
+    }
+    result = xQueueReceive(queue, buffer, timeout);
+    syscall_release(queue);
+    return result;
+}
+
+static SemaphoreHandle_t syscall_sem_create(UBaseType_t max_count, UBaseType_t initial_count,
+                                            const char *name) {
+    SemaphoreHandle_t sem;
+
+    if (max_count == 0 || initial_count > max_count ||
+        syscall_name_free(name, IPC_TYPE_SEMAPHORE) != pdTRUE) {
+        return NULL;
+    }
+    sem = xSemaphoreCreateCounting(max_count, initial_count);
+#if (configUSE_IPC_NAMESPACE == 1)
+    if (sem != NULL && ulIpcNamespaceRegisterObject(syscall_namespace(), (void *)sem,
+                                                    IPC_TYPE_SEMAPHORE, name) == 0U) {
+        vSemaphoreDelete(sem);
+        sem = NULL;
+    }
+#endif
+    return sem;
+}
+
+static SemaphoreHandle_t syscall_sem_open(const char *name) {
+    return (SemaphoreHandle_t)syscall_open(name, IPC_TYPE_SEMAPHORE);
+}
+
+static BaseType_t syscall_sem_take(SemaphoreHandle_t sem, TickType_t timeout) {
+    BaseType_t result;
+
+    if (syscall_acquire(sem, IPC_TYPE_SEMAPHORE) != pdTRUE) {
+        return pdFAIL;
+    }
+    result = xSemaphoreTake(sem, timeout);
+    syscall_release(sem);
+    return result;
+}
+
+static BaseType_t syscall_sem_give(SemaphoreHandle_t sem) {
+    BaseType_t result;
+
+    if (syscall_acquire(sem, IPC_TYPE_SEMAPHORE) != pdTRUE) {
+        return pdFAIL;
+    }
+    result = xSemaphoreGive(sem);
+    syscall_release(sem);
+    return result;
+}
+
+/**
+ * 删除队列或信号量
+ * 有任务正在使用（包括阻塞在该对象上）时注销失败，注销后其他调用找不到该对象，可以安全释放
+ * @return 成功返回 pdPASS，对象不存在或正被使用返回 pdFAIL
+ */
+static BaseType_t syscall_ipc_delete(void *object) {
+#if (configUSE_IPC_NAMESPACE == 1)
+    IpcNamespaceHandle_t ns = syscall_namespace();
+    IpcObjectType_t      type;
+
+    if (xIpcNamespaceLookupObject(ns, object, &type) != pdPASS ||
+        (type != IPC_TYPE_QUEUE && type != IPC_TYPE_SEMAPHORE) ||
+        xIpcNamespaceUnregisterObject(ns, object) != pdPASS) {
+        return pdFAIL;
+    }
+#else
+    if (object == NULL) {
+        return pdFAIL;
+    }
+#endif
+    vQueueDelete((QueueHandle_t)object);
+    return pdPASS;
+}
+
 // 定义全局的 FreeRTOS 系统调用实例，供外部程序使用
 FreeRTOSSyscalls_t freertos_syscalls = {
     .uart_puts = uart_puts,
@@ -15,7 +253,23 @@ FreeRTOSSyscalls_t freertos_syscalls = {
     .pwd = pvTaskGetPwdPath,
     .set_pwd = xTaskSetPwdPath,
 #endif
-    // 后续可以添加其他系统调用函数指针
+    .malloc = pvContainerMalloc,
+    .free = vContainerFree,
+    .get_tick_count = xTaskGetTickCount,
+    .delay = vTaskDelay,
+    .delay_until = syscall_delay_until,
+    .get_pid = syscall_get_pid,
+    .notify_give = syscall_notify_give,
+    .notify_take = syscall_notify_take,
+    .queue_create = syscall_queue_create,
+    .queue_open = syscall_queue_open,
+    .queue_send = syscall_queue_send,
+    .queue_receive = syscall_queue_receive,
+    .sem_create = syscall_sem_create,
+    .sem_open = syscall_sem_open,
+    .sem_take = syscall_sem_take,
+    .sem_give = syscall_sem_give,
+    .ipc_delete = syscall_ipc_delete,
 };
 
 FreeRTOS_GOT_t freertos_got __attribute__((section(".freertos_got"))) = {
@@ -25,5 +279,3 @@ FreeRTOS_GOT_t freertos_got __attribute__((section(".freertos_got"))) = {
 #endif
     // 后续可以添加其他全局偏移表项
 };
-
-GOT_t got = {.num_entries = 1, .entrys = {{"freertos_syscalls", (Elf64_Addr *)&freertos_syscalls}}};
\ No newline at end of file
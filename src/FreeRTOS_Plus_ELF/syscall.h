@@ -4,18 +4,58 @@
 #include "elf_loader.h"
 #include "stddef.h"
 #include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
 
 #ifdef configUSE_FILESYSTEM
 #include "file_system.h"
 #endif
 
+// 系统调用 ABI 版本
+// 表项只在末尾追加，追加时次版本加一；修改或删除已有表项时主版本加一，次版本归零
+// 1.0：uart_puts、pwd、set_pwd
+// 1.1：内存、延时、任务通知、队列和信号量
+#define FREERTOS_SYSCALL_ABI_MAJOR 1
+#define FREERTOS_SYSCALL_ABI_MINOR 1
+
+// 程序阻塞等待任务通知时使用的通知下标，0 留给内核，1 由 xContainerWait() 使用
+#define FREERTOS_SYSCALL_NOTIFY_INDEX 2
+
 typedef struct FreeRTOSSyscalls {
+    // 1.0，没有文件系统时 pwd、set_pwd 为 NULL，各表项的偏移不随配置变化
     void (*uart_puts)(const char* str);
-#ifdef configUSE_FILESYSTEM
     int (*pwd)(char* path);
     int (*set_pwd)(const char* path);
-#endif
     // System calls can use file system operations through LittleFSOps_t
+
+    // 1.1，内存计入容器的 cgroup 配额，容器任务结束后未释放的内存由内核回收
+    // free 只接受调用者所在容器分配的指针，其他指针被忽略
+    void* (*malloc)(size_t size);
+    void (*free)(void* ptr);
+
+    // 1.1，延时期间任务阻塞，不占用 CPU
+    TickType_t (*get_tick_count)(void);
+    void (*delay)(TickType_t ticks);
+    BaseType_t (*delay_until)(TickType_t* previous_wake_time, TickType_t increment);
+
+    // 1.1，任务通知，PID 为调用者所在 PID 命名空间中的虚拟 PID
+    UBaseType_t (*get_pid)(void);
+    BaseType_t (*notify_give)(UBaseType_t pid);
+    uint32_t (*notify_take)(BaseType_t clear_on_exit, TickType_t timeout);
+
+    // 1.1，队列和信号量创建在调用者的 IPC 命名空间中，同一命名空间的程序可以按名称打开
+    // 句柄只在创建它的命名空间中有效，命名空间随容器删除，其中的对象一并删除
+    QueueHandle_t (*queue_create)(UBaseType_t length, UBaseType_t item_size, const char* name);
+    QueueHandle_t (*queue_open)(const char* name);
+    BaseType_t (*queue_send)(QueueHandle_t queue, const void* item, TickType_t timeout);
+    BaseType_t (*queue_receive)(QueueHandle_t queue, void* buffer, TickType_t timeout);
+    SemaphoreHandle_t (*sem_create)(UBaseType_t max_count, UBaseType_t initial_count,
+                                    const char* name);
+    SemaphoreHandle_t (*sem_open)(const char* name);
+    BaseType_t (*sem_take)(SemaphoreHandle_t sem, TickType_t timeout);
+    BaseType_t (*sem_give)(SemaphoreHandle_t sem);
+    // 有任务正在使用或阻塞在对象上时删除失败，返回 pdFAIL，可以稍后重试
+    BaseType_t (*ipc_delete)(void* object);
 } FreeRTOSSyscalls_t;
 
 typedef struct FreeRTOS_GOT {
@@ -26,28 +66,35 @@ typedef struct FreeRTOS_GOT {
     // 可继续添加其他全局偏移表项
 } FreeRTOS_GOT_t;
 
-typedef struct GOT_Entry {
-    char       *name;    // 符号名称
-    Elf64_Addr *address; // 符号地址
-} GOT_Entry_t;
-
-typedef struct GOT {
-    size_t      num_entries;
-    GOT_Entry_t entrys[]; // GOT 表项的值
-} GOT_t;
-
-// 内核实现文件中（如某个.c文件）应有如下定义和初始化：
-// FreeRTOSSyscalls_t freertos_syscalls = {
-//     .xTaskCreate = xTaskCreate,
-//     // 其他系统调用初始化
-// };
-// GOT_t got = {
-//     .freertos_syscalls = (Elf64_Addr)&freertos_syscalls
-// };
+// 系统调用表，定义在 syscall.c 中
+// 重定位方案下程序可以直接链接此符号及 elf_exports.txt 中导出的其他内核函数
+extern FreeRTOSSyscalls_t freertos_syscalls;
 
 #define FREERTOS_SYSCALLS_GOT_ADDRESS 0x7fe00000
 
 // 使用非重定位方案时可以通过此函数获取系统调用结构体指针
 #define get_got() ((FreeRTOS_GOT_t *)FREERTOS_SYSCALLS_GOT_ADDRESS)
 
-#endif /* FREERTOS_PLUS_ELF_SYSCALL_H */
\ No newline at end of file
+// 程序中声明所需 ABI 版本的注释（note），名称为 FREERTOS_NOTE_NAME，类型为 FREERTOS_NOTE_ABI
+#define FREERTOS_NOTE_NAME "FreeRTOS"
+#define FREERTOS_NOTE_ABI 1
+
+typedef struct {
+    uint32_t namesz; // sizeof(FREERTOS_NOTE_NAME)
+    uint32_t descsz; // 8
+    uint32_t type;   // FREERTOS_NOTE_ABI
+    char     name[(sizeof(FREERTOS_NOTE_NAME) + 3) & ~3];
+    uint32_t major;
+    uint32_t minor;
+} FreeRTOSAbiNote_t;
+
+// 在程序的一个源文件中写 FREERTOS_SYSCALL_ABI_NOTE(); 声明编译时头文件的 ABI 版本
+// 加载器拒绝主版本与内核不同或次版本高于内核的程序，没有声明的程序按 1.0 处理
+// 以 .note 开头的节由汇编器标记为 SHT_NOTE，链接后位于 PT_NOTE 段中
+#define FREERTOS_SYSCALL_ABI_NOTE()                                                                \
+    __attribute__((section(".note.freertos.abi"), aligned(4), used))                              \
+    static const FreeRTOSAbiNote_t freertos_abi_note = {                                           \
+        sizeof(FREERTOS_NOTE_NAME), 8, FREERTOS_NOTE_ABI, FREERTOS_NOTE_NAME,                      \
+        FREERTOS_SYSCALL_ABI_MAJOR, FREERTOS_SYSCALL_ABI_MINOR}
+
+#endif /* FREERTOS_PLUS_ELF_SYSCALL_H */
@@ -51,6 +51,8 @@ set(USER_COMPILE_SOURCES
 "FreeRTOS_Plus_ELF/elf_help_print.c"
 "FreeRTOS_Plus_ELF/syscall.c"
 "FreeRTOS_Plus_ELF/elf_loader.c"
+"FreeRTOS_Plus_ELF/elf_plt.S"
+"FreeRTOS_Plus_ELF/elf_export_table.c"
 "FreeRTOS/portable/GCC/ARM_CA53/port.c"
 "FreeRTOS/portable/GCC/ARM_CA53/portASM.S"
 "FreeRTOS/portable/GCC/ARM_CA53/port_asm_vectors.S"
@@ -71,10 +73,15 @@ set(USER_COMPILE_SOURCES
 "FreeRTOS_Plus_Container/container.c"
 "FreeRTOS_Plus_Container/container_image.c"
 "FreeRTOS_Plus_Container/file_system.c"
+"FreeRTOS_Plus_Container/image_cache.c"
 "FreeRTOS_Plus_Container/ipc_namespace.c"
 "FreeRTOS_Plus_Container/pid_namespace.c"
 "FreeRTOS_Plus_Container/examples/container_example.c"
 "FreeRTOS_Plus_Container/examples/file_system_usage_example.c"
+"FreeRTOS_Plus_Container/examples/cgroup_benchmark.c"
+"FreeRTOS_Plus_Container/examples/container_benchmark.c"
+"FreeRTOS_Plus_Container/examples/container_stress.c"
+"FreeRTOS_Plus_Container/examples/elf_reloc_test.c"
 )
 
 # -----------------------------------------
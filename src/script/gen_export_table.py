@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+根据导出符号列表生成内核符号表
+
+输入：FreeRTOS_Plus_ELF/elf_exports.txt（格式见文件开头的注释）
+输出：FreeRTOS_Plus_ELF/elf_export_table.c
+
+符号按 GNU hash 分桶，桶数为不小于符号数的 2 的幂。
+桶 i 的符号为 symbols[buckets[i]] 到 symbols[buckets[i + 1] - 1]，
+加载器计算名称的哈希后只需比较一个桶中的符号。
+
+用法：python3 gen_export_table.py [导出列表] [输出文件]
+"""
+
+import os
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_INPUT = os.path.join(SCRIPT_DIR, "..", "FreeRTOS_Plus_ELF", "elf_exports.txt")
+DEFAULT_OUTPUT = os.path.join(SCRIPT_DIR, "..", "FreeRTOS_Plus_ELF", "elf_export_table.c")
+
+
+def gnu_hash(name):
+    """
+    GNU hash，与 elf_export_hash() 一致
+    """
+    h = 5381
+    for c in name.encode("ascii"):
+        h = (h * 33 + c) & 0xFFFFFFFF
+    return h
+
+
+def parse_exports(input_file):
+    """
+    读取导出列表
+
+    Returns:
+        (原样输出的行, [(符号名称, 条件或 None)])
+    """
+    preamble = []
+    symbols = []
+    names = set()
+
+    with open(input_file, "r", encoding="utf-8") as f:
+        for line_no, line in enumerate(f, 1):
+            line = line.rstrip("\n")
+            if line.startswith("%"):
+                preamble.append(line[1:])
+                continue
+
+            stripped = line.strip()
+            if not stripped or stripped.startswith("#"):
+                continue
+
+            parts = stripped.split(None, 1)
+            name = parts[0]
+            condition = parts[1].strip() if len(parts) > 1 else None
+
+            if not (name[0].isalpha() or name[0] == "_") or \
+                    not all(c.isalnum() or c == "_" for c in name):
+                print(f"错误：第 {line_no} 行符号名称无效: {name}", file=sys.stderr)
+                sys.exit(1)
+            if name in names:
+                print(f"错误：第 {line_no} 行符号重复: {name}", file=sys.stderr)
+                sys.exit(1)
+
+            names.add(name)
+            symbols.append((name, condition))
+
+    if not symbols:
+        print("错误：没有导出符号", file=sys.stderr)
+        sys.exit(1)
+    if len(symbols) > 0xFFFF:
+        print(f"错误：符号数量 {len(symbols)} 超过最大限制 65535", file=sys.stderr)
+        sys.exit(1)
+
+    return preamble, symbols
+
+
+def generate_table(input_file, output_file):
+    """
+    生成符号表源文件
+    """
+    preamble, symbols = parse_exports(input_file)
+
+    bucket_count = 1
+    while bucket_count < len(symbols):
+        bucket_count *= 2
+
+    # 按桶排序，桶内按哈希和名称排序，保证输出稳定
+    entries = sorted(((gnu_hash(name) & (bucket_count - 1), gnu_hash(name), name, condition)
+                      for name, condition in symbols))
+
+    buckets = [0] * (bucket_count + 1)
+    for bucket, _, _, _ in entries:
+        buckets[bucket + 1] += 1
+    for i in range(bucket_count):
+        buckets[i + 1] += buckets[i]
+
+    out = []
+    out.append("// 由 script/gen_export_table.py 根据 elf_exports.txt 生成，不要手动修改")
+    out.append("")
+    out.append('#include "elf_export.h"')
+    out.extend(preamble)
+    out.append("")
+    out.append(f"static const uint16_t elf_export_buckets[{bucket_count + 1}] = {{")
+    for i in range(0, bucket_count + 1, 8):
+        out.append("    " + ", ".join(str(b) for b in buckets[i:i + 8]) + ",")
+    out.append("};")
+    out.append("")
+    out.append(f"static const ELF_EXPORT elf_export_symbols[{len(entries)}] = {{")
+    for _, h, name, condition in entries:
+        if condition is None:
+            out.append(f'    {{0x{h:08x}U, "{name}", (const void *)&{name}}},')
+        else:
+            out.append(f"#if {condition}")
+            out.append(f'    {{0x{h:08x}U, "{name}", (const void *)&{name}}},')
+            out.append("#else")
+            out.append(f'    {{0x{h:08x}U, "{name}", NULL}},')
+            out.append("#endif")
+    out.append("};")
+    out.append("")
+    out.append("const ELF_EXPORT_TABLE elf_export_table = {")
+    out.append(f"    .bucket_count = {bucket_count}U,")
+    out.append("    .buckets = elf_export_buckets,")
+    out.append("    .symbols = elf_export_symbols,")
+    out.append(f"    .symbol_count = {len(entries)}U,")
+    out.append("};")
+
+    with open(output_file, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(out) + "\n")
+
+    print(f"符号数: {len(entries)}，桶数: {bucket_count}")
+    print(f"已生成: {output_file}")
+
+
+def main():
+    if len(sys.argv) > 3:
+        print("用法: python3 gen_export_table.py [导出列表] [输出文件]", file=sys.stderr)
+        sys.exit(1)
+
+    input_file = sys.argv[1] if len(sys.argv) > 1 else DEFAULT_INPUT
+    output_file = sys.argv[2] if len(sys.argv) > 2 else DEFAULT_OUTPUT
+
+    if not os.path.isfile(input_file):
+        print(f"错误：导出列表不存在: {input_file}", file=sys.stderr)
+        sys.exit(1)
+
+    generate_table(input_file, output_file)
+
+
+if __name__ == "__main__":
+    main()